@@ -10,27 +10,27 @@
 #include "imgui_sw.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <math.h>
 #include <vector>
 #include <SDL.h>
 
-struct ImGui_ImplSW_Data
-{
-    SDL_Window*  Window;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define IMGUI_SW_SSE2
+#include <emmintrin.h>
+#endif
 
-    ImGui_ImplSW_Data() { memset((void*)this, 0, sizeof(*this)); }
-};
-
-static ImGui_ImplSW_Data* ImGui_ImplSW_GetBackendData()
-{
-    return ImGui::GetCurrentContext() ? (ImGui_ImplSW_Data*)ImGui::GetIO().BackendRendererUserData : nullptr;
-}
+// the screen is split into tiles of this size.
+// draw commands are binned into every tile they touch, and tiles are rasterized independently.
+#define SW_TILE_SIZE 64
 
 struct PaintTarget
 {
   uint32_t *pixels;
   int width;
   int height;
+  // the tile being painted, [minX,maxX) x [minY,maxY)
+  int minX, minY, maxX, maxY;
 };
 
 // ----------------------------------------------------------------------------
@@ -201,96 +201,212 @@ inline uint8_t sample_font_texture(const SWTexture &texture, int x, int y)
 
 inline uint32_t sample_texture(const SWTexture &texture, int x, int y) { return texture.pixels[x + y]; }
 
-static void paint_uniform_rectangle(const PaintTarget &target,
-  const ImVec2 &min_f,
-  const ImVec2 &max_f,
-  const ColorInt &color)
+// ----------------------------------------------------------------------------
+// Primitives are collected from the draw lists and binned into tiles before painting.
+
+enum SWPrimType
 {
-  // don't if our rectangle is transparent
-  if (color.a==0) return;
+  SW_PRIM_RECT=0,
+  SW_PRIM_TEXTURED_RECT,
+  SW_PRIM_TRIANGLE
+};
 
-  // Integer bounding box [min, max):
-  int min_x_i = (int)(min_f.x + 0.5f);
-  int min_y_i = (int)(min_f.y + 0.5f);
-  int max_x_i = (int)(max_f.x + 0.5f);
-  int max_y_i = (int)(max_f.y + 0.5f);
+struct SWPrim
+{
+  int type;
+  // screen-space bounding box after clipping, [x0,x1) x [y0,y1)
+  int x0, y0, x1, y1;
+  const SWTexture* texture;
+  ColorInt color;
+  ImDrawVert v[3];
+};
+
+struct ImGui_ImplSW_Data
+{
+  SDL_Window* Window;
+  SDL_Surface* Surface;
+  bool SurfaceLocked;
+  uint32_t* Pixels;
+  int Width, Height;
+  int TilesX, TilesY;
+  uint32_t ClearColor;
+  bool Invalidated;
+
+  std::vector<SWPrim> Prims;
+  std::vector<std::vector<unsigned int>> TilePrims;
+  std::vector<uint64_t> TileHash;
+  std::vector<uint64_t> TilePrevHash;
+  std::vector<int> DirtyTiles;
+  std::vector<SDL_Rect> DirtyRects;
+  std::atomic<int> NextTile;
+
+  ImGui_ImplSW_Data():
+    Window(NULL),
+    Surface(NULL),
+    SurfaceLocked(false),
+    Pixels(NULL),
+    Width(0),
+    Height(0),
+    TilesX(0),
+    TilesY(0),
+    ClearColor(0xff000000),
+    Invalidated(true),
+    NextTile(0) {}
+};
+
+static ImGui_ImplSW_Data* ImGui_ImplSW_GetBackendData()
+{
+    return ImGui::GetCurrentContext() ? (ImGui_ImplSW_Data*)ImGui::GetIO().BackendRendererUserData : nullptr;
+}
 
-  // Clamp to render target:
-  min_x_i = std::max(min_x_i, 0);
-  min_y_i = std::max(min_y_i, 0);
-  max_x_i = std::min(max_x_i, target.width);
-  max_y_i = std::min(max_y_i, target.height);
+// ----------------------------------------------------------------------------
+// Span fills. These are the inner loops of rectangles and text.
+
+#ifdef IMGUI_SW_SSE2
+// blends a uniform color (0<alpha<255) over 4 pixels, keeping the target alpha.
+// this is exact: (source*alpha+target*(255-alpha)+255)>>8 never exceeds 16 bits.
+static inline __m128i blend4(__m128i target, __m128i srcTerm, __m128i invAlpha)
+{
+  const __m128i zero=_mm_setzero_si128();
+  const __m128i alphaMask=_mm_set1_epi32((int)0xff000000);
+  __m128i lo=_mm_unpacklo_epi8(target,zero);
+  __m128i hi=_mm_unpackhi_epi8(target,zero);
+  lo=_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo,invAlpha),srcTerm),8);
+  hi=_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi,invAlpha),srcTerm),8);
+  return _mm_or_si128(_mm_andnot_si128(alphaMask,_mm_packus_epi16(lo,hi)),_mm_and_si128(target,alphaMask));
+}
+
+static inline __m128i blend_src_term(const ColorInt &color)
+{
+  const short r=(short)(color.r*color.a+255);
+  const short g=(short)(color.g*color.a+255);
+  const short b=(short)(color.b*color.a+255);
+  return _mm_set_epi16(0,r,g,b,0,r,g,b);
+}
+#endif
+
+static inline void fill_span(uint32_t *pixels, int count, uint32_t color)
+{
+#ifdef IMGUI_SW_SSE2
+  const __m128i c=_mm_set1_epi32((int)color);
+  for (; count>=4; count-=4, pixels+=4) {
+    _mm_storeu_si128((__m128i*)pixels,c);
+  }
+#endif
+  for (; count>0; count--) *(pixels++)=color;
+}
 
+// paints a span of pixels with a uniform color
+static inline void paint_span(uint32_t *pixels, int count, const ColorInt &color)
+{
+  if (color.a==0) return;
   if (color.a==255) {
-    // fast path if alpha blending is not necessary
-    for (int y = min_y_i; y < max_y_i; ++y) {
-      uint32_t* target_pixel = &target.pixels[y * target.width + min_x_i - 1];
-      for (int x = min_x_i; x < max_x_i; ++x) {
-        ++target_pixel;
-        *target_pixel = color.u32;
-      }
-    }
-  } else {
-    // We often blend the same colors over and over again, so optimize for this (saves 25% total cpu):
-    uint32_t last_target_pixel = target.pixels[min_y_i * target.width + min_x_i];
-    const ColorInt* lastColorRef = (const ColorInt*)(&last_target_pixel);
-    uint32_t last_output = blend(*lastColorRef, color);
-
-    for (int y = min_y_i; y < max_y_i; ++y) {
-      uint32_t* target_pixel = &target.pixels[y * target.width + min_x_i - 1];
-      for (int x = min_x_i; x < max_x_i; ++x) {
-        ++target_pixel;
-        if (*target_pixel == last_target_pixel) {
-          *target_pixel = last_output;
-          continue;
-        }
-        last_target_pixel = *target_pixel;
-        const ColorInt* colorRef = (const ColorInt*)(target_pixel);
-        *target_pixel = blend(*colorRef, color);
-        last_output = *target_pixel;
-      }
+    fill_span(pixels,count,color.u32);
+    return;
+  }
+#ifdef IMGUI_SW_SSE2
+  const __m128i srcTerm=blend_src_term(color);
+  const __m128i invAlpha=_mm_set1_epi16(255-color.a);
+  for (; count>=4; count-=4, pixels+=4) {
+    _mm_storeu_si128((__m128i*)pixels,blend4(_mm_loadu_si128((const __m128i*)pixels),srcTerm,invAlpha));
+  }
+#endif
+  for (; count>0; count--, pixels++) {
+    *pixels=blend(*(const ColorInt*)pixels,color);
+  }
+}
+
+// paints a uniform color over the pixels whose font texel has the top bit set.
+// the font texture is all black or all white, so anti-aliasing is dropped.
+static inline void paint_span_masked(uint32_t *pixels, const uint8_t *texels, int count, const ColorInt &color)
+{
+  if (color.a==0) return;
+#ifdef IMGUI_SW_SSE2
+  const __m128i srcTerm=blend_src_term(color);
+  const __m128i invAlpha=_mm_set1_epi16(255-color.a);
+  const __m128i opaque=_mm_set1_epi32((int)color.u32);
+  for (; count>=4; count-=4, pixels+=4, texels+=4) {
+    int texel4;
+    memcpy(&texel4,texels,4);
+    if (!(texel4&0x80808080)) continue;
+    // spread each texel over a whole lane; its top bit ends up in the sign bit
+    __m128i mask=_mm_cvtsi32_si128(texel4);
+    mask=_mm_unpacklo_epi8(mask,mask);
+    mask=_mm_srai_epi32(_mm_unpacklo_epi16(mask,mask),31);
+
+    const __m128i target=_mm_loadu_si128((const __m128i*)pixels);
+    const __m128i painted=(color.a==255)?opaque:blend4(target,srcTerm,invAlpha);
+    _mm_storeu_si128((__m128i*)pixels,_mm_or_si128(_mm_and_si128(mask,painted),_mm_andnot_si128(mask,target)));
+  }
+#endif
+  for (; count>0; count--, pixels++, texels++) {
+    if (*texels&0x80) {
+      *pixels=blend(*(const ColorInt*)pixels,color);
     }
   }
 }
 
-static void paint_uniform_textured_rectangle(const PaintTarget &target,
-  const SWTexture &texture,
-  const ImVec4 &clip_rect,
-  const ImDrawVert &min_v,
-  const ImDrawVert &max_v)
+// paints texels tinted by a uniform color over a span of pixels
+static inline void paint_span_textured(uint32_t *pixels, const uint32_t *texels, int count, const ColorInt &color)
 {
-  const ImVec2 min_p = ImVec2(min_v.pos.x, min_v.pos.y);
-  const ImVec2 max_p = ImVec2(max_v.pos.x, max_v.pos.y);
+#ifdef IMGUI_SW_SSE2
+  const __m128i zero=_mm_setzero_si128();
+  const __m128i round=_mm_set1_epi16(255);
+  const __m128i alphaMask=_mm_set1_epi32((int)0xff000000);
+  const __m128i tint=_mm_set_epi16(color.a,color.r,color.g,color.b,color.a,color.r,color.g,color.b);
+  for (; count>=4; count-=4, pixels+=4, texels+=4) {
+    const __m128i target=_mm_loadu_si128((const __m128i*)pixels);
+    const __m128i texel=_mm_loadu_si128((const __m128i*)texels);
+    __m128i result[2];
+    for (int half=0; half<2; half++) {
+      const __m128i t=half?_mm_unpackhi_epi8(target,zero):_mm_unpacklo_epi8(target,zero);
+      __m128i src=half?_mm_unpackhi_epi8(texel,zero):_mm_unpacklo_epi8(texel,zero);
+      src=_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(src,tint),round),8);
+      const __m128i a=_mm_shufflehi_epi16(_mm_shufflelo_epi16(src,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3));
+      const __m128i ia=_mm_sub_epi16(round,a);
+      result[half]=_mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(src,a),_mm_mullo_epi16(t,ia)),round),8);
+    }
+    // like blend(): target alpha is kept, unless the source is opaque
+    const __m128i opaque=_mm_cmpeq_epi32(_mm_and_si128(_mm_packus_epi16(result[0],result[1]),alphaMask),alphaMask);
+    __m128i out=_mm_or_si128(_mm_andnot_si128(alphaMask,_mm_packus_epi16(result[0],result[1])),_mm_and_si128(target,alphaMask));
+    out=_mm_or_si128(out,_mm_and_si128(opaque,alphaMask));
+    _mm_storeu_si128((__m128i*)pixels,out);
+  }
+#endif
+  for (; count>0; count--, pixels++, texels++) {
+    ColorInt src_color(*texels);
+    src_color *= color;
+    *pixels = blend(*(const ColorInt*)pixels, src_color);
+  }
+}
 
-  float distanceX = max_p.x - min_p.x;
-  float distanceY = max_p.y - min_p.y;
-  if (distanceX == 0 || distanceY == 0) { return; }
+// ----------------------------------------------------------------------------
 
-  // Find bounding box:
-  float min_x_f = min_p.x;
-  float min_y_f = min_p.y;
-  float max_x_f = max_p.x;
-  float max_y_f = max_p.y;
+static void paint_uniform_rectangle(const PaintTarget &target, const SWPrim &prim)
+{
+  // Clamp to tile:
+  const int min_x_i = std::max(prim.x0, target.minX);
+  const int min_y_i = std::max(prim.y0, target.minY);
+  const int max_x_i = std::min(prim.x1, target.maxX);
+  const int max_y_i = std::min(prim.y1, target.maxY);
+  if (min_x_i >= max_x_i || min_y_i >= max_y_i) return;
 
-  // Clip against clip_rect:
-  min_x_f = std::max(min_x_f, clip_rect.x);
-  min_y_f = std::max(min_y_f, clip_rect.y);
-  max_x_f = std::min(max_x_f, clip_rect.z - 0.5f);
-  max_y_f = std::min(max_y_f, clip_rect.w - 0.5f);
+  for (int y = min_y_i; y < max_y_i; ++y) {
+    paint_span(&target.pixels[y * target.width + min_x_i], max_x_i - min_x_i, prim.color);
+  }
+}
 
-  // Integer bounding box [min, max):
-  int min_x_i = (int)(min_x_f);
-  int min_y_i = (int)(min_y_f);
-  int max_x_i = (int)(max_x_f + 1.0f);
-  int max_y_i = (int)(max_y_f + 1.0f);
+static void paint_uniform_textured_rectangle(const PaintTarget &target, const SWPrim &prim)
+{
+  const SWTexture &texture = *prim.texture;
+  const ImDrawVert &min_v = prim.v[0];
+  const ImDrawVert &max_v = prim.v[1];
 
-  // Clip against render target:
-  min_x_i = std::max(min_x_i, 0);
-  min_y_i = std::max(min_y_i, 0);
-  max_x_i = std::min(max_x_i, target.width);
-  max_y_i = std::min(max_y_i, target.height);
+  const float distanceX = max_v.pos.x - min_v.pos.x;
+  const float distanceY = max_v.pos.y - min_v.pos.y;
 
-  const auto topleft = ImVec2(min_x_i + 0.5f, min_y_i + 0.5f);
+  // Texture coordinates are set up for the whole rectangle, then skipped forward to the tile.
+  const auto topleft = ImVec2(prim.x0 + 0.5f, prim.y0 + 0.5f);
   const ImVec2 delta_uv_per_pixel = {
     (max_v.uv.x - min_v.uv.x) / distanceX,
     (max_v.uv.y - min_v.uv.y) / distanceY,
@@ -308,40 +424,43 @@ static void paint_uniform_textured_rectangle(const PaintTarget &target,
   if (startY<0) startY=0;
   if (startY>texture.height-1) startY=texture.height-1;
 
-  int currentX = startX;
-  int currentY = startY * texture.width;
-
-  float deltaX = delta_uv_per_pixel.x * texture.width;
-  float deltaY = delta_uv_per_pixel.y * texture.height;
+  const float deltaX = delta_uv_per_pixel.x * texture.width;
+  const float deltaY = delta_uv_per_pixel.y * texture.height;
 
-  const ColorInt colorRef = ColorInt::bgra(min_v.col);
+  // Clamp to tile:
+  const int min_x_i = std::max(prim.x0, target.minX);
+  const int min_y_i = std::max(prim.y0, target.minY);
+  const int max_x_i = std::min(prim.x1, target.maxX);
+  const int max_y_i = std::min(prim.y1, target.maxY);
+  if (min_x_i >= max_x_i || min_y_i >= max_y_i) return;
 
-  for (int y = min_y_i; y < max_y_i; ++y) {
-    currentX = startX;
-    uint32_t* target_pixel = &target.pixels[y * target.width - 1 + min_x_i];
-    for (int x = min_x_i; x < max_x_i; ++x) {
-      ++target_pixel;
-      const ColorInt* targetColorRef = (const ColorInt*)(target_pixel);
+  // texels advance by one per pixel until the edge of the texture
+  if (deltaX != 0) startX = std::min(startX + (min_x_i - prim.x0), texture.width - 1);
+  if (deltaY != 0) startY = std::min(startY + (min_y_i - prim.y0), texture.height - 1);
 
-      if (texture.isAlpha) {
-        uint8_t texel = sample_font_texture(texture, currentX, currentY);
-        if (deltaX != 0 && currentX < texture.width - 1) { currentX += 1; }
-
-        // The font texture is all black or all white, so optimize for this:
-        // anti-aliasing will be lost, but it doesn't matter
-        if (texel & 0x80) {
-          *target_pixel = blend(*targetColorRef, colorRef);
-        }
-        continue;
-
-      } else {
-        uint32_t texColor = sample_texture(texture, currentX, currentY);
-        auto src_color = ColorInt(texColor);
+  int currentY = startY * texture.width;
+  const int count = max_x_i - min_x_i;
+  // how many pixels of a row get their own texel
+  const int linear = (deltaX != 0) ? std::min(count, texture.width - startX) : 0;
 
-        if (deltaX != 0 && currentX < texture.width - 1) { currentX += 1; }
+  const ColorInt colorRef = prim.color;
 
-        src_color *= colorRef;
-        *target_pixel = blend(*targetColorRef, src_color);
+  for (int y = min_y_i; y < max_y_i; ++y) {
+    uint32_t* target_pixel = &target.pixels[y * target.width + min_x_i];
+
+    if (texture.isAlpha) {
+      const uint8_t* texRow = ((const uint8_t*)texture.pixels) + currentY;
+      paint_span_masked(target_pixel, texRow + startX, linear, colorRef);
+      // the rest of the row uses the last texel
+      if (linear < count && (texRow[std::min(startX + linear, texture.width - 1)] & 0x80)) {
+        paint_span(target_pixel + linear, count - linear, colorRef);
+      }
+    } else {
+      paint_span_textured(target_pixel, &texture.pixels[currentY + startX], linear, colorRef);
+      // the rest of the row uses the last texel
+      const uint32_t* lastTexel = &texture.pixels[currentY + std::min(startX + linear, texture.width - 1)];
+      for (int x = linear; x < count; ++x) {
+        paint_span_textured(target_pixel + x, lastTexel, 1, colorRef);
       }
     }
     if (deltaY != 0 && currentY < (texture.height - 1)*texture.width) { currentY += texture.width; }
@@ -359,44 +478,26 @@ static bool is_dominant_edge(ImVec2 edge)
 }
 
 // Handles triangles in any winding order (CW/CCW)
-static void paint_triangle(const PaintTarget &target,
-  const SWTexture *texture,
-  const ImVec4 &clip_rect,
-  const ImDrawVert &v0,
-  const ImDrawVert &v1,
-  const ImDrawVert &v2)
+static void paint_triangle(const PaintTarget &target, const SWPrim &prim)
 {
+  const SWTexture* texture = prim.texture;
+  const ImDrawVert &v0 = prim.v[0];
+  const ImDrawVert &v1 = prim.v[1];
+  const ImDrawVert &v2 = prim.v[2];
+
   const ImVec2 p0 = ImVec2(v0.pos.x, v0.pos.y);
   const ImVec2 p1 = ImVec2(v1.pos.x, v1.pos.y);
   const ImVec2 p2 = ImVec2(v2.pos.x, v2.pos.y);
 
   const auto rect_area = barycentric(p0, p1, p2);// Can be positive or negative depending on winding order
   if (rect_area == 0.0f) { return; }
-  // if (rect_area < 0.0f) { return paint_triangle(target, texture, clip_rect, v0, v2, v1); }
-
-  // Find bounding box:
-  float min_x_f = min3(p0.x, p1.x, p2.x);
-  float min_y_f = min3(p0.y, p1.y, p2.y);
-  float max_x_f = max3(p0.x, p1.x, p2.x);
-  float max_y_f = max3(p0.y, p1.y, p2.y);
-
-  // Clip against clip_rect:
-  min_x_f = std::max(min_x_f, clip_rect.x);
-  min_y_f = std::max(min_y_f, clip_rect.y);
-  max_x_f = std::min(max_x_f, clip_rect.z - 0.5f);
-  max_y_f = std::min(max_y_f, clip_rect.w - 0.5f);
 
-  // Integer bounding box [min, max):
-  int min_x_i = (int)(min_x_f);
-  int min_y_i = (int)(min_y_f);
-  int max_x_i = (int)(max_x_f + 1.0f);
-  int max_y_i = (int)(max_y_f + 1.0f);
-
-  // Clip against render target:
-  min_x_i = std::max(min_x_i, 0);
-  min_y_i = std::max(min_y_i, 0);
-  max_x_i = std::min(max_x_i, target.width);
-  max_y_i = std::min(max_y_i, target.height);
+  // Clamp to tile:
+  const int min_x_i = std::max(prim.x0, target.minX);
+  const int min_y_i = std::max(prim.y0, target.minY);
+  const int max_x_i = std::min(prim.x1, target.maxX);
+  const int max_y_i = std::min(prim.y1, target.maxY);
+  if (min_x_i >= max_x_i || min_y_i >= max_y_i) return;
 
   // ------------------------------------------------------------------------
   // Set up interpolation of barycentric coordinates:
@@ -530,7 +631,137 @@ static void paint_triangle(const PaintTarget &target,
   }
 }
 
-static void paint_draw_cmd(const PaintTarget &target,
+// ----------------------------------------------------------------------------
+// Binning
+
+static inline uint64_t hash_bytes(uint64_t hash, const void *data, size_t len)
+{
+  const unsigned char* bytes = (const unsigned char*)data;
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// appends a primitive and bins it into every tile its bounding box touches.
+// the bounding box is clamped to the render target here; the paint functions clamp it to the tile.
+static void bin_prim(ImGui_ImplSW_Data *bd, SWPrim &prim)
+{
+  prim.x0 = std::max(prim.x0, 0);
+  prim.y0 = std::max(prim.y0, 0);
+  prim.x1 = std::min(prim.x1, bd->Width);
+  prim.y1 = std::min(prim.y1, bd->Height);
+  if (prim.x0 >= prim.x1 || prim.y0 >= prim.y1) return;
+
+  // prims are zero-filled before being set up, so hashing the padding is deterministic
+  uint64_t hash = hash_bytes(0xcbf29ce484222325ULL, &prim, sizeof(SWPrim));
+  if (prim.texture) hash = hash_bytes(hash, &prim.texture->gen, sizeof(prim.texture->gen));
+
+  const unsigned int index = (unsigned int)bd->Prims.size();
+  bd->Prims.push_back(prim);
+
+  const int tx0 = prim.x0 / SW_TILE_SIZE;
+  const int ty0 = prim.y0 / SW_TILE_SIZE;
+  const int tx1 = (prim.x1 - 1) / SW_TILE_SIZE;
+  const int ty1 = (prim.y1 - 1) / SW_TILE_SIZE;
+  for (int ty = ty0; ty <= ty1; ty++) {
+    for (int tx = tx0; tx <= tx1; tx++) {
+      const int tile = ty * bd->TilesX + tx;
+      bd->TilePrims[tile].push_back(index);
+      bd->TileHash[tile] = ((bd->TileHash[tile] << 7) ^ (bd->TileHash[tile] >> 57) ^ hash) * 0x100000001b3ULL;
+    }
+  }
+}
+
+static void bin_uniform_rectangle(ImGui_ImplSW_Data *bd, const ImVec2 &min_f, const ImVec2 &max_f, const ColorInt &color)
+{
+  // don't if our rectangle is transparent
+  if (color.a==0) return;
+
+  SWPrim prim;
+  memset((void*)&prim, 0, sizeof(SWPrim));
+  prim.type = SW_PRIM_RECT;
+  prim.color = color;
+
+  // Integer bounding box [min, max):
+  prim.x0 = (int)(min_f.x + 0.5f);
+  prim.y0 = (int)(min_f.y + 0.5f);
+  prim.x1 = (int)(max_f.x + 0.5f);
+  prim.y1 = (int)(max_f.y + 0.5f);
+
+  bin_prim(bd, prim);
+}
+
+static void bin_uniform_textured_rectangle(ImGui_ImplSW_Data *bd,
+  const SWTexture &texture,
+  const ImVec4 &clip_rect,
+  const ImDrawVert &min_v,
+  const ImDrawVert &max_v)
+{
+  float distanceX = max_v.pos.x - min_v.pos.x;
+  float distanceY = max_v.pos.y - min_v.pos.y;
+  if (distanceX == 0 || distanceY == 0) { return; }
+
+  // Clip against clip_rect:
+  const float min_x_f = std::max(min_v.pos.x, clip_rect.x);
+  const float min_y_f = std::max(min_v.pos.y, clip_rect.y);
+  const float max_x_f = std::min(max_v.pos.x, clip_rect.z - 0.5f);
+  const float max_y_f = std::min(max_v.pos.y, clip_rect.w - 0.5f);
+
+  SWPrim prim;
+  memset((void*)&prim, 0, sizeof(SWPrim));
+  prim.type = SW_PRIM_TEXTURED_RECT;
+  prim.texture = &texture;
+  prim.color = ColorInt::bgra(min_v.col);
+  prim.v[0] = min_v;
+  prim.v[1] = max_v;
+
+  // Integer bounding box [min, max):
+  prim.x0 = (int)(min_x_f);
+  prim.y0 = (int)(min_y_f);
+  prim.x1 = (int)(max_x_f + 1.0f);
+  prim.y1 = (int)(max_y_f + 1.0f);
+
+  bin_prim(bd, prim);
+}
+
+static void bin_triangle(ImGui_ImplSW_Data *bd,
+  const SWTexture *texture,
+  const ImVec4 &clip_rect,
+  const ImDrawVert &v0,
+  const ImDrawVert &v1,
+  const ImDrawVert &v2)
+{
+  const ImVec2 p0 = ImVec2(v0.pos.x, v0.pos.y);
+  const ImVec2 p1 = ImVec2(v1.pos.x, v1.pos.y);
+  const ImVec2 p2 = ImVec2(v2.pos.x, v2.pos.y);
+
+  if (barycentric(p0, p1, p2) == 0.0f) { return; }
+
+  // Find bounding box and clip against clip_rect:
+  const float min_x_f = std::max(min3(p0.x, p1.x, p2.x), clip_rect.x);
+  const float min_y_f = std::max(min3(p0.y, p1.y, p2.y), clip_rect.y);
+  const float max_x_f = std::min(max3(p0.x, p1.x, p2.x), clip_rect.z - 0.5f);
+  const float max_y_f = std::min(max3(p0.y, p1.y, p2.y), clip_rect.w - 0.5f);
+
+  SWPrim prim;
+  memset((void*)&prim, 0, sizeof(SWPrim));
+  prim.type = SW_PRIM_TRIANGLE;
+  prim.texture = texture;
+  prim.v[0] = v0;
+  prim.v[1] = v1;
+  prim.v[2] = v2;
+
+  // Integer bounding box [min, max):
+  prim.x0 = (int)(min_x_f);
+  prim.y0 = (int)(min_y_f);
+  prim.x1 = (int)(max_x_f + 1.0f);
+  prim.y1 = (int)(max_y_f + 1.0f);
+
+  bin_prim(bd, prim);
+}
+
+static void bin_draw_cmd(ImGui_ImplSW_Data *bd,
   const ImDrawVert *vertices,
   const ImDrawIdx *idx_buffer,
   const ImDrawCmd &pcmd,
@@ -557,7 +788,7 @@ static void paint_draw_cmd(const PaintTarget &target,
         const bool has_texture = v0.uv != white_uv || v1.uv != white_uv || v2.uv != white_uv || v3.uv != white_uv;
 
         if (has_uniform_color && has_texture) {
-          paint_uniform_textured_rectangle(target, *texture, pcmd.ClipRect, v0, v2);
+          bin_uniform_textured_rectangle(bd, *texture, pcmd.ClipRect, v0, v2);
           i += 6;
           continue;
         }
@@ -600,8 +831,7 @@ static void paint_draw_cmd(const PaintTarget &target,
         }// Completely clipped
 
         if (has_uniform_color) {
-          const ColorInt colorRef = ColorInt::bgra(v0.col);
-          paint_uniform_rectangle(target, min, max, colorRef);
+          bin_uniform_rectangle(bd, min, max, ColorInt::bgra(v0.col));
           i += 6;
           continue;
         }
@@ -609,12 +839,12 @@ static void paint_draw_cmd(const PaintTarget &target,
     }
 
     const bool has_texture = (v0.uv != white_uv || v1.uv != white_uv || v2.uv != white_uv);
-    paint_triangle(target, has_texture ? texture : nullptr, pcmd.ClipRect, v0, v1, v2);
+    bin_triangle(bd, has_texture ? texture : nullptr, pcmd.ClipRect, v0, v1, v2);
     i += 3;
   }
 }
 
-static void paint_draw_list(const PaintTarget &target, const ImDrawList *cmd_list)
+static void bin_draw_list(ImGui_ImplSW_Data *bd, const ImDrawList *cmd_list)
 {
   const ImDrawIdx *idx_buffer = &cmd_list->IdxBuffer[0];
   const ImDrawVert *vertices = cmd_list->VtxBuffer.Data;
@@ -623,22 +853,39 @@ static void paint_draw_list(const PaintTarget &target, const ImDrawList *cmd_lis
   for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.size(); cmd_i++) {
     const ImDrawCmd &pcmd = cmd_list->CmdBuffer[cmd_i];
     if (pcmd.UserCallback) {
-      pcmd.UserCallback(cmd_list, &pcmd);
+      if (pcmd.UserCallback != ImDrawCallback_ResetRenderState) pcmd.UserCallback(cmd_list, &pcmd);
     } else {
-      paint_draw_cmd(target, vertices, idx_buffer, pcmd, white_uv);
+      bin_draw_cmd(bd, vertices, idx_buffer, pcmd, white_uv);
     }
     idx_buffer += pcmd.ElemCount;
   }
-  }
+}
 
-static void paint_imgui(uint32_t *pixels, ImDrawData *drawData, int fb_width, int fb_height)
+static void paint_tile(ImGui_ImplSW_Data *bd, int tile)
 {
-  if (fb_width <= 0 || fb_height <= 0) return;
-
-  PaintTarget target{ pixels, fb_width, fb_height };
+  const int tx = tile % bd->TilesX;
+  const int ty = tile / bd->TilesX;
+  PaintTarget target{ bd->Pixels, bd->Width, bd->Height,
+    tx * SW_TILE_SIZE, ty * SW_TILE_SIZE,
+    std::min((tx + 1) * SW_TILE_SIZE, bd->Width), std::min((ty + 1) * SW_TILE_SIZE, bd->Height) };
+
+  for (int y = target.minY; y < target.maxY; y++) {
+    fill_span(&target.pixels[y * target.width + target.minX], target.maxX - target.minX, bd->ClearColor);
+  }
 
-  for (int i = 0; i < drawData->CmdListsCount; ++i) {
-    paint_draw_list(target, drawData->CmdLists[i]);
+  for (unsigned int i: bd->TilePrims[tile]) {
+    const SWPrim& prim = bd->Prims[i];
+    switch (prim.type) {
+      case SW_PRIM_RECT:
+        paint_uniform_rectangle(target, prim);
+        break;
+      case SW_PRIM_TEXTURED_RECT:
+        paint_uniform_textured_rectangle(target, prim);
+        break;
+      case SW_PRIM_TRIANGLE:
+        paint_triangle(target, prim);
+        break;
+    }
   }
 }
 
@@ -681,10 +928,26 @@ void ImGui_ImplSW_NewFrame() {
   IM_ASSERT(bd != nullptr);
 }
 
-void ImGui_ImplSW_RenderDrawData(ImDrawData* draw_data) {
+void ImGui_ImplSW_SetClearColor(uint32_t color) {
+  ImGui_ImplSW_Data* bd = ImGui_ImplSW_GetBackendData();
+  IM_ASSERT(bd != nullptr);
+  bd->ClearColor = color;
+}
+
+void ImGui_ImplSW_Invalidate() {
+  ImGui_ImplSW_Data* bd = ImGui_ImplSW_GetBackendData();
+  IM_ASSERT(bd != nullptr);
+  bd->Invalidated = true;
+}
+
+int ImGui_ImplSW_PrepareDrawData(ImDrawData* draw_data) {
   ImGui_ImplSW_Data* bd = ImGui_ImplSW_GetBackendData();
   IM_ASSERT(bd != nullptr);
 
+  bd->DirtyTiles.clear();
+  bd->DirtyRects.clear();
+  bd->NextTile = 0;
+
   // update textures if needed
   if (draw_data->Textures!=NULL) {
     for (ImTextureData* i: *draw_data->Textures) {
@@ -693,17 +956,103 @@ void ImGui_ImplSW_RenderDrawData(ImDrawData* draw_data) {
   }
 
   SDL_Surface* surf = SDL_GetWindowSurface(bd->Window);
-  if (!surf) return;
+  if (!surf) return 0;
+  if (surf->w <= 0 || surf->h <= 0) return 0;
 
-  bool mustLock=SDL_MUSTLOCK(surf);
-  if (mustLock) {
-    if (SDL_LockSurface(surf)!=0) return;
+  if (SDL_MUSTLOCK(surf)) {
+    if (SDL_LockSurface(surf)!=0) return 0;
+    bd->SurfaceLocked = true;
   }
-  paint_imgui((uint32_t*)surf->pixels,draw_data,surf->w,surf->h);
-  // 0xAARRGGBB
-  if (mustLock) {
-    SDL_UnlockSurface(surf);
+  bd->Surface = surf;
+
+  // a different surface means none of the previous contents can be trusted
+  if (bd->Pixels != (uint32_t*)surf->pixels || bd->Width != surf->w || bd->Height != surf->h) {
+    bd->Pixels = (uint32_t*)surf->pixels;
+    bd->Width = surf->w;
+    bd->Height = surf->h;
+    bd->TilesX = (bd->Width + SW_TILE_SIZE - 1) / SW_TILE_SIZE;
+    bd->TilesY = (bd->Height + SW_TILE_SIZE - 1) / SW_TILE_SIZE;
+    bd->TilePrims.resize(bd->TilesX * bd->TilesY);
+    bd->TileHash.resize(bd->TilesX * bd->TilesY);
+    bd->TilePrevHash.resize(bd->TilesX * bd->TilesY);
+    bd->Invalidated = true;
+  }
+
+  const int tileCount = bd->TilesX * bd->TilesY;
+  const uint64_t clearHash = hash_bytes(0xcbf29ce484222325ULL, &bd->ClearColor, sizeof(bd->ClearColor));
+  bd->Prims.clear();
+  for (int i = 0; i < tileCount; i++) {
+    bd->TilePrims[i].clear();
+    bd->TileHash[i] = clearHash;
+  }
+
+  for (int i = 0; i < draw_data->CmdListsCount; ++i) {
+    bin_draw_list(bd, draw_data->CmdLists[i]);
   }
+
+  // only tiles whose primitives changed since the last frame get painted and presented
+  for (int i = 0; i < tileCount; i++) {
+    if (bd->Invalidated || bd->TileHash[i] != bd->TilePrevHash[i]) {
+      bd->DirtyTiles.push_back(i);
+    }
+    bd->TilePrevHash[i] = bd->TileHash[i];
+  }
+  bd->Invalidated = false;
+
+  // merge runs of dirty tiles in a row into rectangles
+  for (size_t i = 0; i < bd->DirtyTiles.size();) {
+    const int first = bd->DirtyTiles[i];
+    int last = first;
+    for (i++; i < bd->DirtyTiles.size(); i++) {
+      if (bd->DirtyTiles[i] != last + 1 || (bd->DirtyTiles[i] % bd->TilesX) == 0) break;
+      last = bd->DirtyTiles[i];
+    }
+    SDL_Rect rect;
+    rect.x = (first % bd->TilesX) * SW_TILE_SIZE;
+    rect.y = (first / bd->TilesX) * SW_TILE_SIZE;
+    rect.w = std::min(((last % bd->TilesX) + 1) * SW_TILE_SIZE, bd->Width) - rect.x;
+    rect.h = std::min(rect.y + SW_TILE_SIZE, bd->Height) - rect.y;
+    bd->DirtyRects.push_back(rect);
+  }
+
+  return (int)bd->DirtyTiles.size();
+}
+
+void ImGui_ImplSW_RasterizeTiles() {
+  ImGui_ImplSW_Data* bd = ImGui_ImplSW_GetBackendData();
+  IM_ASSERT(bd != nullptr);
+
+  const int count = (int)bd->DirtyTiles.size();
+  for (int i = bd->NextTile++; i < count; i = bd->NextTile++) {
+    paint_tile(bd, bd->DirtyTiles[i]);
+  }
+}
+
+void ImGui_ImplSW_FinishDrawData() {
+  ImGui_ImplSW_Data* bd = ImGui_ImplSW_GetBackendData();
+  IM_ASSERT(bd != nullptr);
+
+  if (bd->Surface != NULL && bd->SurfaceLocked) {
+    SDL_UnlockSurface(bd->Surface);
+  }
+  bd->Surface = NULL;
+  bd->SurfaceLocked = false;
+}
+
+int ImGui_ImplSW_GetDirtyRects(const SDL_Rect** rects) {
+  ImGui_ImplSW_Data* bd = ImGui_ImplSW_GetBackendData();
+  IM_ASSERT(bd != nullptr);
+
+  *rects = bd->DirtyRects.data();
+  return (int)bd->DirtyRects.size();
+}
+
+void ImGui_ImplSW_RenderDrawData(ImDrawData* draw_data) {
+  if (ImGui_ImplSW_PrepareDrawData(draw_data) > 0) {
+    ImGui_ImplSW_RasterizeTiles();
+  }
+  ImGui_ImplSW_FinishDrawData();
+  // 0xAARRGGBB
 }
 
 /// CREATE OBJECTS
@@ -715,10 +1064,19 @@ bool ImGui_ImplSW_CreateDeviceObjects() {
 void ImGui_ImplSW_DestroyDeviceObjects() {
 }
 
+// textures get a new generation whenever their contents change, so tiles using them are repainted.
+// the counter is global because a new texture may be allocated at the address of a deleted one.
+static std::atomic<unsigned int> textureGen(0);
+
+void ImGui_ImplSW_TouchTexture(SWTexture* tex) {
+  tex->gen=++textureGen;
+}
+
 void ImGui_ImplSW_UpdateTexture(ImTextureData* tex) {
   if (tex->Status==ImTextureStatus_WantCreate) {
     SWTexture* t=new SWTexture(tex->Width,tex->Height,tex->Format==ImTextureFormat_Alpha8);
     memcpy(t->pixels,tex->GetPixels(),tex->GetSizeInBytes());
+    ImGui_ImplSW_TouchTexture(t);
 
     tex->SetTexID((ImTextureID)t);
     tex->SetStatus(ImTextureStatus_OK);
@@ -775,6 +1133,7 @@ void ImGui_ImplSW_UpdateTexture(ImTextureData* tex) {
         i_y+=t->width;
       }
     }
+    ImGui_ImplSW_TouchTexture(t);
 
     tex->SetStatus(ImTextureStatus_OK);
   } else if (tex->Status==ImTextureStatus_WantDestroy && tex->UnusedFrames>0) {
@@ -17,6 +17,7 @@
 #include <cstdint>
 
 struct SDL_Window;
+struct SDL_Rect;
 struct ImDrawData;
 
 struct SWTexture
@@ -25,18 +26,22 @@ struct SWTexture
   int width;
   int height;
   bool managed, isAlpha;
+  // bumped by ImGui_ImplSW_TouchTexture() whenever the pixels change
+  unsigned int gen;
 
   SWTexture(uint32_t* pix, int w, int h, bool a=false):
     pixels(pix),
     width(w),
     height(h),
     managed(false),
-    isAlpha(a) {}
+    isAlpha(a),
+    gen(0) {}
   SWTexture(int w, int h, bool a=false):
     width(w),
     height(h),
     managed(true),
-    isAlpha(a) {
+    isAlpha(a),
+    gen(0) {
     pixels=new uint32_t[width*height];
     memset(pixels,0,width*height*sizeof(uint32_t));
   }
@@ -50,6 +55,22 @@ IMGUI_IMPL_API void     ImGui_ImplSW_Shutdown();
 IMGUI_IMPL_API void     ImGui_ImplSW_NewFrame();
 IMGUI_IMPL_API void     ImGui_ImplSW_RenderDrawData(ImDrawData* draw_data);
 
+// tiled rendering, for callers which want to paint tiles on several threads:
+// - PrepareDrawData() bins the draw data into tiles and returns how many tiles must be painted.
+// - RasterizeTiles() paints tiles until none are left. it may be called from several threads at once.
+// - FinishDrawData() must be called afterwards, even if PrepareDrawData() returned 0.
+// - GetDirtyRects() returns the areas which were painted (and therefore have to be presented).
+// tiles are cleared to the color set by SetClearColor() (0xAARRGGBB) before painting.
+IMGUI_IMPL_API int      ImGui_ImplSW_PrepareDrawData(ImDrawData* draw_data);
+IMGUI_IMPL_API void     ImGui_ImplSW_RasterizeTiles();
+IMGUI_IMPL_API void     ImGui_ImplSW_FinishDrawData();
+IMGUI_IMPL_API int      ImGui_ImplSW_GetDirtyRects(const SDL_Rect** rects);
+IMGUI_IMPL_API void     ImGui_ImplSW_SetClearColor(uint32_t color);
+// forces every tile to be painted on the next frame (e.g. after the window surface was drawn on)
+IMGUI_IMPL_API void     ImGui_ImplSW_Invalidate();
+// must be called after changing the pixels of a texture
+IMGUI_IMPL_API void     ImGui_ImplSW_TouchTexture(SWTexture* tex);
+
 // Called by Init/NewFrame/Shutdown
 IMGUI_IMPL_API bool     ImGui_ImplSW_CreateDeviceObjects();
 IMGUI_IMPL_API void     ImGui_ImplSW_DestroyDeviceObjects();
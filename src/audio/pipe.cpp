@@ -18,18 +18,239 @@
  */
 
 #include <string.h>
+#include <errno.h>
 #include "../ta-log.h"
 #include "pipe.h"
+#ifdef _WIN32
+#include <stdio.h>
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 void taPipeThread(void* inst) {
   TAAudioPipe* in=(TAAudioPipe*)inst;
   in->runThread();
 }
 
+static inline void putLE(unsigned char* buf, unsigned int val, int bytes) {
+  for (int i=0; i<bytes; i++) {
+    buf[i]=val&0xff;
+    val>>=8;
+  }
+}
+
+static inline void putBE(unsigned char* buf, unsigned int val, int bytes) {
+  for (int i=bytes-1; i>=0; i--) {
+    buf[i]=val&0xff;
+    val>>=8;
+  }
+}
+
+static inline float clampSample(float x) {
+  if (x<-1.0f) return -1.0f;
+  if (x>1.0f) return 1.0f;
+  return x;
+}
+
+static void convertS16(float** in, int chans, size_t frames, short* out) {
+  size_t j=0;
+#ifdef __SSE2__
+  const __m128 lo=_mm_set1_ps(-1.0f);
+  const __m128 hi=_mm_set1_ps(1.0f);
+  const __m128 scale=_mm_set1_ps(32767.0f);
+  if (chans==1) {
+    for (; j+8<=frames; j+=8) {
+      __m128i a=_mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&in[0][j]),lo),hi),scale));
+      __m128i b=_mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&in[0][j+4]),lo),hi),scale));
+      _mm_storeu_si128((__m128i*)&out[j],_mm_packs_epi32(a,b));
+    }
+  } else if (chans==2) {
+    for (; j+4<=frames; j+=4) {
+      __m128i l=_mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&in[0][j]),lo),hi),scale));
+      __m128i r=_mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&in[1][j]),lo),hi),scale));
+      _mm_storeu_si128((__m128i*)&out[j<<1],_mm_packs_epi32(_mm_unpacklo_epi32(l,r),_mm_unpackhi_epi32(l,r)));
+    }
+  }
+#endif
+  for (; j<frames; j++) {
+    for (int i=0; i<chans; i++) {
+      out[j*chans+i]=clampSample(in[i][j])*32767.0f;
+    }
+  }
+}
+
+static void convertF32(float** in, int chans, size_t frames, float* out) {
+  size_t j=0;
+#ifdef __SSE2__
+  const __m128 lo=_mm_set1_ps(-1.0f);
+  const __m128 hi=_mm_set1_ps(1.0f);
+  if (chans==1) {
+    for (; j+4<=frames; j+=4) {
+      _mm_storeu_ps(&out[j],_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&in[0][j]),lo),hi));
+    }
+  } else if (chans==2) {
+    for (; j+4<=frames; j+=4) {
+      __m128 l=_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&in[0][j]),lo),hi);
+      __m128 r=_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&in[1][j]),lo),hi);
+      _mm_storeu_ps(&out[j<<1],_mm_unpacklo_ps(l,r));
+      _mm_storeu_ps(&out[(j<<1)+4],_mm_unpackhi_ps(l,r));
+    }
+  }
+#endif
+  for (; j<frames; j++) {
+    for (int i=0; i<chans; i++) {
+      out[j*chans+i]=clampSample(in[i][j]);
+    }
+  }
+}
+
+// 24-bit samples are packed, so the byte order is chosen here
+static void convertS24(float** in, int chans, size_t frames, unsigned char* out, bool bigEndian) {
+  for (size_t j=0; j<frames; j++) {
+    for (int i=0; i<chans; i++) {
+      int val=clampSample(in[i][j])*8388607.0f;
+      if (bigEndian) {
+        putBE(out,val,3);
+      } else {
+        putLE(out,val,3);
+      }
+      out+=3;
+    }
+  }
+}
+
+static void swapBlock(unsigned char* buf, size_t len, size_t width) {
+  for (size_t i=0; i+width<=len; i+=width) {
+    for (size_t j=0; j<(width>>1); j++) {
+      unsigned char t=buf[i+j];
+      buf[i+j]=buf[i+width-1-j];
+      buf[i+width-1-j]=t;
+    }
+  }
+}
+
+void TAAudioPipe::setOptions(TAPipeFormat f, TAPipeHeader h, bool rt, int b) {
+  format=f;
+  header=h;
+  realTime=rt;
+  batch=b;
+  if (batch<1) batch=1;
+  if (batch>64) batch=64;
+}
+
+size_t TAAudioPipe::makeHeader(unsigned char* buf) {
+  unsigned int rate=desc.rate;
+  unsigned int chans=desc.outChans;
+  unsigned int bytesPerSample=frameSize/MAX(1,chans);
+  switch (header) {
+    case TA_PIPE_HEADER_WAV: {
+      // the stream has no end, so both sizes are set to the maximum
+      bool isFloat=(format==TA_PIPE_FORMAT_F32);
+      unsigned int fmtLen=isFloat?18:16;
+      memcpy(buf,"RIFF",4);
+      putLE(buf+4,0xffffffff,4);
+      memcpy(buf+8,"WAVEfmt ",8);
+      putLE(buf+16,fmtLen,4);
+      putLE(buf+20,isFloat?3:1,2);
+      putLE(buf+22,chans,2);
+      putLE(buf+24,rate,4);
+      putLE(buf+28,rate*frameSize,4);
+      putLE(buf+32,frameSize,2);
+      putLE(buf+34,bytesPerSample*8,2);
+      size_t pos=36;
+      if (isFloat) {
+        putLE(buf+pos,0,2);
+        pos+=2;
+      }
+      memcpy(buf+pos,"data",4);
+      putLE(buf+pos+4,0xffffffff,4);
+      return pos+8;
+    }
+    case TA_PIPE_HEADER_AU: {
+      unsigned int encoding=3;
+      if (format==TA_PIPE_FORMAT_S24) encoding=4;
+      if (format==TA_PIPE_FORMAT_F32) encoding=6;
+      memcpy(buf,".snd",4);
+      putBE(buf+4,24,4);
+      putBE(buf+8,0xffffffff,4);
+      putBE(buf+12,encoding,4);
+      putBE(buf+16,rate,4);
+      putBE(buf+20,chans,4);
+      return 24;
+    }
+    default:
+      break;
+  }
+  return 0;
+}
+
+void TAAudioPipe::flush() {
+  if (sbufPos==0 || broken) return;
+
+  unsigned char hbuf[64];
+  size_t hlen=0;
+  if (!headerWritten) {
+    hlen=makeHeader(hbuf);
+    headerWritten=true;
+  }
+
+  if (swapBytes && format!=TA_PIPE_FORMAT_S24) {
+    swapBlock(sbuf,sbufPos,(format==TA_PIPE_FORMAT_F32)?4:2);
+  }
+
+#ifdef _WIN32
+  if (hlen>0) fwrite(hbuf,1,hlen,stdout);
+  fwrite(sbuf,1,sbufPos,stdout);
+  fflush(stdout);
+#else
+  // header and data go out in one call. partial writes are resumed
+  struct iovec iov[2];
+  int iovFirst=0;
+  int iovCount=0;
+  if (hlen>0) {
+    iov[iovCount].iov_base=hbuf;
+    iov[iovCount++].iov_len=hlen;
+  }
+  iov[iovCount].iov_base=sbuf;
+  iov[iovCount++].iov_len=sbufPos;
+
+  while (iovFirst<iovCount) {
+    ssize_t written=writev(STDOUT_FILENO,&iov[iovFirst],iovCount-iovFirst);
+    if (written<0) {
+      if (errno==EINTR) continue;
+      logE("could not write to pipe! %s",strerror(errno));
+      broken=true;
+      break;
+    }
+    while (iovFirst<iovCount && (size_t)written>=iov[iovFirst].iov_len) {
+      written-=iov[iovFirst++].iov_len;
+    }
+    if (iovFirst<iovCount) {
+      iov[iovFirst].iov_base=(unsigned char*)iov[iovFirst].iov_base+written;
+      iov[iovFirst].iov_len-=written;
+    }
+  }
+#endif
+
+  framesWritten+=sbufPos/frameSize;
+  sbufPos=0;
+
+  if (realTime) {
+    std::this_thread::sleep_until(timeStart+std::chrono::microseconds((framesWritten*1000000ULL)/(unsigned long long)desc.rate));
+  }
+}
+
 void TAAudioPipe::runThread() {
-  while (running) {
-    onProcess((unsigned char*)sbuf,desc.bufsize);
+  timeStart=std::chrono::steady_clock::now();
+  framesWritten=0;
+  while (running && !broken) {
+    onProcess(sbuf+sbufPos,desc.bufsize);
   }
+  flush();
 }
 
 void TAAudioPipe::onProcess(unsigned char* buf, int nframes) {
@@ -37,20 +258,27 @@ void TAAudioPipe::onProcess(unsigned char* buf, int nframes) {
     if (midiIn!=NULL) midiIn->gather();
     audioProcCallback(audioProcCallbackUser,inBufs,outBufs,desc.inChans,desc.outChans,desc.bufsize);
   }
-  short* sb=(short*)buf;
 
-  if (sb==NULL) return;
+  if (buf==NULL) return;
 
-  for (size_t j=0; j<desc.bufsize; j++) {
-    for (size_t i=0; i<desc.outChans; i++) {
-      if (outBufs[i][j]<-1.0) outBufs[i][j]=-1.0;
-      if (outBufs[i][j]>1.0) outBufs[i][j]=1.0;
-      sb[j*desc.outChans+i]=outBufs[i][j]*32767.0;
-    }
+  switch (format) {
+    case TA_PIPE_FORMAT_S16:
+      convertS16(outBufs,desc.outChans,nframes,(short*)buf);
+      break;
+    case TA_PIPE_FORMAT_S24:
+#ifdef TA_BIG_ENDIAN
+      convertS24(outBufs,desc.outChans,nframes,buf,!swapBytes);
+#else
+      convertS24(outBufs,desc.outChans,nframes,buf,swapBytes);
+#endif
+      break;
+    case TA_PIPE_FORMAT_F32:
+      convertF32(outBufs,desc.outChans,nframes,(float*)buf);
+      break;
   }
 
-  fwrite(sb,2,desc.bufsize*desc.outChans,stdout);
-  fflush(stdout);
+  sbufPos+=nframes*frameSize;
+  if (sbufPos>=sbufLen) flush();
 }
 
 void* TAAudioPipe::getContext() {
@@ -121,13 +349,37 @@ bool TAAudioPipe::init(TAAudioDesc& request, TAAudioDesc& response) {
 
   logV("opening stdout for audio...");
 
+  switch (format) {
+    case TA_PIPE_FORMAT_S24:
+      frameSize=3*desc.outChans;
+      break;
+    case TA_PIPE_FORMAT_F32:
+      frameSize=4*desc.outChans;
+      break;
+    default:
+      frameSize=2*desc.outChans;
+      break;
+  }
+
+  // WAV is little-endian and AU is big-endian. raw output uses native order
+#ifdef TA_BIG_ENDIAN
+  swapBytes=(header==TA_PIPE_HEADER_WAV);
+#else
+  swapBytes=(header==TA_PIPE_HEADER_AU);
+#endif
+  headerWritten=false;
+  broken=false;
+
   if (desc.outChans>0) {
     outBufs=new float*[desc.outChans];
     for (int i=0; i<desc.outChans; i++) {
       outBufs[i]=new float[desc.bufsize];
     }
-      
-    sbuf=new short[desc.bufsize*desc.outChans];
+
+    // several buffers are gathered into one write
+    sbufLen=desc.bufsize*batch*frameSize;
+    sbufPos=0;
+    sbuf=new unsigned char[sbufLen];
   } else {
     sbuf=NULL;
   }
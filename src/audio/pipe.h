@@ -19,20 +19,70 @@
 
 #include "taAudio.h"
 #include <thread>
+#include <chrono>
+
+enum TAPipeFormat {
+  TA_PIPE_FORMAT_S16=0,
+  TA_PIPE_FORMAT_S24,
+  TA_PIPE_FORMAT_F32
+};
+
+enum TAPipeHeader {
+  TA_PIPE_HEADER_NONE=0,
+  TA_PIPE_HEADER_WAV,
+  TA_PIPE_HEADER_AU
+};
 
 class TAAudioPipe: public TAAudio {
   std::thread* outThread;
-  short* sbuf;
+  unsigned char* sbuf;
+  size_t sbufLen, sbufPos;
+  size_t frameSize;
+  unsigned long long framesWritten;
+  std::chrono::steady_clock::time_point timeStart;
+
+  TAPipeFormat format;
+  TAPipeHeader header;
+  bool realTime;
+  bool headerWritten;
+  bool swapBytes;
+  bool broken;
+  int batch;
+
+  size_t makeHeader(unsigned char* buf);
+  void flush();
 
   public:
     void runThread();
     void onProcess(unsigned char* buf, int nframes);
 
+    /**
+     * set output options. must be called before init().
+     * @param f sample format.
+     * @param h header to write before the audio data.
+     * @param rt whether to pace output in real time. otherwise output is
+     * produced as fast as the reader consumes it.
+     * @param b number of buffers to gather before writing.
+     */
+    void setOptions(TAPipeFormat f, TAPipeHeader h, bool rt, int b);
+
     void* getContext();
     bool quit();
     bool setRun(bool run);
     std::vector<String> listAudioDevices();
     bool init(TAAudioDesc& request, TAAudioDesc& response);
     TAAudioPipe():
-      sbuf(NULL) {}
+      outThread(NULL),
+      sbuf(NULL),
+      sbufLen(0),
+      sbufPos(0),
+      frameSize(0),
+      framesWritten(0),
+      format(TA_PIPE_FORMAT_S16),
+      header(TA_PIPE_HEADER_NONE),
+      realTime(false),
+      headerWritten(false),
+      swapBytes(false),
+      broken(false),
+      batch(1) {}
 };
@@ -0,0 +1,902 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "server.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include <errno.h>
+#include <string.h>
+#include <thread>
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#define SERVER_BUFSIZE 1024
+// inline whole-song renders are capped at an hour
+#define SERVER_MAX_SECONDS 3600
+#define SERVER_MAX_DEPTH 32
+
+// JSON
+
+static void skipSpace(const char*& p) {
+  while (*p==' ' || *p=='\t' || *p=='\r' || *p=='\n') p++;
+}
+
+static void appendUTF8(String& out, unsigned int c) {
+  if (c<0x80) {
+    out+=(char)c;
+  } else if (c<0x800) {
+    out+=(char)(0xc0|(c>>6));
+    out+=(char)(0x80|(c&0x3f));
+  } else if (c<0x10000) {
+    out+=(char)(0xe0|(c>>12));
+    out+=(char)(0x80|((c>>6)&0x3f));
+    out+=(char)(0x80|(c&0x3f));
+  } else {
+    out+=(char)(0xf0|(c>>18));
+    out+=(char)(0x80|((c>>12)&0x3f));
+    out+=(char)(0x80|((c>>6)&0x3f));
+    out+=(char)(0x80|(c&0x3f));
+  }
+}
+
+static bool parseHex4(const char*& p, unsigned int& out) {
+  out=0;
+  for (int i=0; i<4; i++) {
+    char c=*p++;
+    out<<=4;
+    if (c>='0' && c<='9') {
+      out|=c-'0';
+    } else if (c>='a' && c<='f') {
+      out|=c-'a'+10;
+    } else if (c>='A' && c<='F') {
+      out|=c-'A'+10;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool parseString(const char*& p, String& out) {
+  if (*p!='"') return false;
+  p++;
+  while (*p!='"') {
+    if (*p==0) return false;
+    if (*p!='\\') {
+      out+=*p++;
+      continue;
+    }
+    p++;
+    switch (*p++) {
+      case '"': out+='"'; break;
+      case '\\': out+='\\'; break;
+      case '/': out+='/'; break;
+      case 'b': out+='\b'; break;
+      case 'f': out+='\f'; break;
+      case 'n': out+='\n'; break;
+      case 'r': out+='\r'; break;
+      case 't': out+='\t'; break;
+      case 'u': {
+        unsigned int c;
+        if (!parseHex4(p,c)) return false;
+        // surrogate pair
+        if (c>=0xd800 && c<0xdc00 && p[0]=='\\' && p[1]=='u') {
+          unsigned int low;
+          p+=2;
+          if (!parseHex4(p,low)) return false;
+          c=0x10000+((c-0xd800)<<10)+(low-0xdc00);
+        }
+        appendUTF8(out,c);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  p++;
+  return true;
+}
+
+static bool parseValue(const char*& p, FurnaceServerValue& v, int depth) {
+  if (depth>SERVER_MAX_DEPTH) return false;
+  skipSpace(p);
+  switch (*p) {
+    case '{':
+      v.type=FurnaceServerValue::OBJECT;
+      p++;
+      skipSpace(p);
+      if (*p=='}') {
+        p++;
+        return true;
+      }
+      while (true) {
+        String key;
+        skipSpace(p);
+        if (!parseString(p,key)) return false;
+        skipSpace(p);
+        if (*p++!=':') return false;
+        if (!parseValue(p,v.obj[key],depth+1)) return false;
+        skipSpace(p);
+        if (*p=='}') {
+          p++;
+          return true;
+        }
+        if (*p++!=',') return false;
+      }
+      break;
+    case '[':
+      v.type=FurnaceServerValue::ARRAY;
+      p++;
+      skipSpace(p);
+      if (*p==']') {
+        p++;
+        return true;
+      }
+      while (true) {
+        v.arr.push_back(FurnaceServerValue());
+        if (!parseValue(p,v.arr.back(),depth+1)) return false;
+        skipSpace(p);
+        if (*p==']') {
+          p++;
+          return true;
+        }
+        if (*p++!=',') return false;
+      }
+      break;
+    case '"':
+      v.type=FurnaceServerValue::STRING;
+      return parseString(p,v.str);
+    case 't':
+      if (strncmp(p,"true",4)!=0) return false;
+      v.type=FurnaceServerValue::BOOL;
+      v.b=true;
+      p+=4;
+      return true;
+    case 'f':
+      if (strncmp(p,"false",5)!=0) return false;
+      v.type=FurnaceServerValue::BOOL;
+      v.b=false;
+      p+=5;
+      return true;
+    case 'n':
+      if (strncmp(p,"null",4)!=0) return false;
+      v.type=FurnaceServerValue::NONE;
+      p+=4;
+      return true;
+    default: {
+      char* end=NULL;
+      v.num=strtod(p,&end);
+      if (end==p) return false;
+      v.type=FurnaceServerValue::NUMBER;
+      p=end;
+      return true;
+    }
+  }
+  return false;
+}
+
+static String jsonEscape(const String& s) {
+  String ret;
+  ret.reserve(s.size()+2);
+  for (char i: s) {
+    switch (i) {
+      case '"': ret+="\\\""; break;
+      case '\\': ret+="\\\\"; break;
+      case '\n': ret+="\\n"; break;
+      case '\r': ret+="\\r"; break;
+      case '\t': ret+="\\t"; break;
+      default:
+        if ((unsigned char)i<0x20) {
+          ret+=fmt::sprintf("\\u%.4x",(int)(unsigned char)i);
+        } else {
+          ret+=i;
+        }
+        break;
+    }
+  }
+  return ret;
+}
+
+const FurnaceServerValue* FurnaceServerValue::get(const String& key) const {
+  if (type!=OBJECT) return NULL;
+  auto i=obj.find(key);
+  if (i==obj.end()) return NULL;
+  return &i->second;
+}
+
+String FurnaceServerValue::getString(const String& key, String fallback) const {
+  const FurnaceServerValue* v=get(key);
+  if (v==NULL || v->type!=STRING) return fallback;
+  return v->str;
+}
+
+double FurnaceServerValue::getNumber(const String& key, double fallback) const {
+  const FurnaceServerValue* v=get(key);
+  if (v==NULL || v->type!=NUMBER) return fallback;
+  return v->num;
+}
+
+bool FurnaceServerValue::getBool(const String& key, bool fallback) const {
+  const FurnaceServerValue* v=get(key);
+  if (v==NULL) return fallback;
+  if (v->type==BOOL) return v->b;
+  if (v->type==NUMBER) return v->num!=0.0;
+  return fallback;
+}
+
+// base64 (taDecodeBase64() drops zero bytes, so it can't be used for binary data)
+
+static const char* base64Chars="ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static String encodeBase64(const unsigned char* data, size_t len) {
+  String ret;
+  ret.reserve(((len+2)/3)*4);
+  for (size_t i=0; i<len; i+=3) {
+    unsigned int group=data[i]<<16;
+    if (i+1<len) group|=data[i+1]<<8;
+    if (i+2<len) group|=data[i+2];
+    ret+=base64Chars[(group>>18)&63];
+    ret+=base64Chars[(group>>12)&63];
+    ret+=(i+1<len)?base64Chars[(group>>6)&63]:'=';
+    ret+=(i+2<len)?base64Chars[group&63]:'=';
+  }
+  return ret;
+}
+
+static bool decodeBase64(const String& str, std::vector<unsigned char>& out) {
+  unsigned int group=0;
+  int bits=0;
+  out.reserve((str.size()/4)*3);
+  for (char c: str) {
+    int val;
+    if (c>='A' && c<='Z') {
+      val=c-'A';
+    } else if (c>='a' && c<='z') {
+      val=c-'a'+26;
+    } else if (c>='0' && c<='9') {
+      val=c-'0'+52;
+    } else if (c=='+') {
+      val=62;
+    } else if (c=='/') {
+      val=63;
+    } else if (c=='=') {
+      break;
+    } else {
+      return false;
+    }
+    group=(group<<6)|val;
+    bits+=6;
+    if (bits>=8) {
+      bits-=8;
+      out.push_back((group>>bits)&0xff);
+    }
+  }
+  return true;
+}
+
+static bool readWholeFile(const String& path, std::vector<unsigned char>& out) {
+  FILE* f=ps_fopen(path.c_str(),"rb");
+  if (f==NULL) return false;
+  unsigned char buf[4096];
+  size_t got;
+  while ((got=fread(buf,1,4096,f))>0) {
+    out.insert(out.end(),buf,buf+got);
+  }
+  fclose(f);
+  return true;
+}
+
+static bool writeWholeFile(const String& path, const unsigned char* data, size_t len) {
+  FILE* f=ps_fopen(path.c_str(),"wb");
+  if (f==NULL) return false;
+  bool ret=(fwrite(data,1,len,f)==len);
+  fclose(f);
+  return ret;
+}
+
+// server
+
+void FurnaceServer::bindEngine(DivEngine* eng) {
+  e=eng;
+}
+
+bool FurnaceServer::emit(const FurnaceServerValue& req, const unsigned char* data, size_t len, String& resp) {
+  String path=req.getString("output","");
+  if (!path.empty()) {
+    if (!writeWholeFile(path,data,len)) {
+      lastError=fmt::sprintf("could not write %s: %s",path,strerror(errno));
+      return false;
+    }
+    resp+=fmt::sprintf(",\"size\":%d,\"file\":\"%s\"",(int)len,jsonEscape(path));
+    return true;
+  }
+  resp+=fmt::sprintf(",\"size\":%d,\"data\":\"%s\"",(int)len,encodeBase64(data,len));
+  return true;
+}
+
+void FurnaceServer::stopRendering() {
+  if (rendering) {
+    e->stop();
+    rendering=false;
+  }
+}
+
+size_t FurnaceServer::render(std::vector<float>& out, size_t frames) {
+  if (!rendering) {
+    e->setOrder(seekOrder);
+    if (!e->playToRow(seekRow)) return 0;
+    rendering=true;
+  }
+
+  for (int i=0; i<2; i++) {
+    if (renderBuf[i].size()<SERVER_BUFSIZE) renderBuf[i].resize(SERVER_BUFSIZE);
+  }
+  float* bufs[2]={renderBuf[0].data(),renderBuf[1].data()};
+
+  size_t done=0;
+  out.reserve(out.size()+frames*2);
+  while (done<frames && e->isPlaying()) {
+    unsigned int n=MIN(SERVER_BUFSIZE,frames-done);
+    e->nextBuf(NULL,bufs,0,2,n);
+    for (unsigned int i=0; i<n; i++) {
+      out.push_back(bufs[0][i]);
+      out.push_back(bufs[1][i]);
+    }
+    done+=n;
+  }
+  return done;
+}
+
+bool FurnaceServer::opLoad(const FurnaceServerValue& req, String& resp) {
+  std::vector<unsigned char> data;
+  String name=req.getString("name","");
+  const FurnaceServerValue* inlineData=req.get("data");
+  if (inlineData!=NULL && inlineData->type==FurnaceServerValue::STRING) {
+    if (!decodeBase64(inlineData->str,data)) {
+      lastError="invalid base64 data";
+      return false;
+    }
+  } else {
+    String path=req.getString("path","");
+    if (path.empty()) {
+      lastError="no path or data given";
+      return false;
+    }
+    if (!readWholeFile(path,data)) {
+      lastError=fmt::sprintf("could not open %s: %s",path,strerror(errno));
+      return false;
+    }
+    if (name.empty()) name=path;
+  }
+  if (data.empty()) {
+    lastError="file is empty";
+    return false;
+  }
+
+  stopRendering();
+  // load() takes ownership of the buffer
+  unsigned char* buf=new unsigned char[data.size()];
+  memcpy(buf,data.data(),data.size());
+  if (!e->load(buf,data.size(),name.empty()?NULL:name.c_str())) {
+    lastError=e->getLastError();
+    return false;
+  }
+  seekOrder=0;
+  seekRow=0;
+  return opInfo(req,resp);
+}
+
+bool FurnaceServer::opSubSong(const FurnaceServerValue& req, String& resp) {
+  int index=req.getNumber("index",0);
+  if (index<0 || index>=(int)e->song.subsong.size()) {
+    lastError="invalid subsong";
+    return false;
+  }
+  stopRendering();
+  e->changeSongP(index);
+  seekOrder=0;
+  seekRow=0;
+  return true;
+}
+
+bool FurnaceServer::opSeek(const FurnaceServerValue& req, String& resp) {
+  stopRendering();
+  seekOrder=req.getNumber("order",0);
+  seekRow=req.getNumber("row",0);
+  return true;
+}
+
+bool FurnaceServer::opMute(const FurnaceServerValue& req, String& resp) {
+  const FurnaceServerValue* mask=req.get("mask");
+  if (mask==NULL || mask->type!=FurnaceServerValue::ARRAY) {
+    lastError="mask must be an array";
+    return false;
+  }
+  int chans=e->getTotalChannelCount();
+  for (int i=0; i<chans; i++) {
+    bool mute=false;
+    if (i<(int)mask->arr.size()) {
+      const FurnaceServerValue& v=mask->arr[i];
+      mute=(v.type==FurnaceServerValue::BOOL)?v.b:(v.num!=0.0);
+    }
+    e->muteChannel(i,mute);
+  }
+  return true;
+}
+
+bool FurnaceServer::opRender(const FurnaceServerValue& req, String& resp) {
+  double framesD=req.getNumber("frames",0);
+  if (framesD<1) {
+    lastError="frames must be positive";
+    return false;
+  }
+  size_t frames=(size_t)framesD;
+  if (frames>(size_t)e->getAudioDescGot().rate*SERVER_MAX_SECONDS) {
+    lastError="too many frames";
+    return false;
+  }
+  std::vector<float> out;
+  size_t done=render(out,frames);
+  resp+=fmt::sprintf(",\"frames\":%d,\"rate\":%d,\"playing\":%s",(int)done,(int)e->getAudioDescGot().rate,e->isPlaying()?"true":"false");
+  return emit(req,(const unsigned char*)out.data(),out.size()*sizeof(float),resp);
+}
+
+bool FurnaceServer::opAudio(const FurnaceServerValue& req, String& resp) {
+  int loops=req.getNumber("loops",0);
+  if (loops<0) loops=0;
+  stopRendering();
+
+  String path=req.getString("output","");
+  if (!path.empty()) {
+    // write an audio file using the regular exporter
+    DivAudioExportOptions opts;
+    String format=req.getString("format","s16");
+    if (format=="s16") {
+      opts.format=DIV_EXPORT_FORMAT_S16;
+    } else if (format=="f32") {
+      opts.format=DIV_EXPORT_FORMAT_F32;
+    } else if (format=="flac") {
+      opts.format=DIV_EXPORT_FORMAT_FLAC;
+    } else if (format=="opus") {
+      opts.format=DIV_EXPORT_FORMAT_OPUS;
+    } else {
+      lastError="invalid format";
+      return false;
+    }
+    opts.sampleRate=req.getNumber("rate",44100);
+    opts.loops=loops;
+    opts.fadeOut=req.getNumber("fadeOut",0.0);
+    for (int i=0; i<e->getTotalChannelCount(); i++) {
+      opts.channelMask[i]=!e->isChannelMuted(i);
+    }
+    if (!e->saveAudio(path.c_str(),opts)) {
+      lastError=e->getLastError();
+      return false;
+    }
+    e->waitAudioFile();
+    resp+=fmt::sprintf(",\"file\":\"%s\"",jsonEscape(path));
+    return true;
+  }
+
+  // render the whole song inline as interleaved stereo float
+  std::vector<float> out;
+  seekOrder=0;
+  seekRow=0;
+  size_t maxFrames=(size_t)e->getAudioDescGot().rate*SERVER_MAX_SECONDS;
+  size_t done=0;
+  e->setLoops(loops+1);
+  do {
+    done+=render(out,SERVER_BUFSIZE);
+  } while (rendering && e->isPlaying() && done<maxFrames);
+  stopRendering();
+  e->setLoops(-1);
+  resp+=fmt::sprintf(",\"frames\":%d,\"rate\":%d",(int)done,(int)e->getAudioDescGot().rate);
+  return emit(req,(const unsigned char*)out.data(),out.size()*sizeof(float),resp);
+}
+
+bool FurnaceServer::opVGM(const FurnaceServerValue& req, String& resp) {
+  stopRendering();
+  SafeWriter* w=e->saveVGM(NULL,req.getBool("loop",true),req.getNumber("version",0x171),false,req.getBool("direct",false));
+  if (w==NULL) {
+    lastError=e->getLastError();
+    return false;
+  }
+  bool ret=emit(req,w->getFinalBuf(),w->size(),resp);
+  w->finish();
+  delete w;
+  return ret;
+}
+
+bool FurnaceServer::opCommand(const FurnaceServerValue& req, String& resp) {
+  stopRendering();
+  DivCSOptions opts;
+  opts.longPointers=req.getBool("longPointers",false);
+  opts.bigEndian=req.getBool("bigEndian",false);
+  opts.noCmdCallOpt=req.getBool("noCmdCallOpt",false);
+  opts.noDelayCondense=req.getBool("noDelayCondense",false);
+  opts.noSubBlock=req.getBool("noSubBlock",false);
+  SafeWriter* w=e->saveCommand(NULL,opts);
+  if (w==NULL) {
+    lastError=e->getLastError();
+    return false;
+  }
+  bool ret=emit(req,w->getFinalBuf(),w->size(),resp);
+  w->finish();
+  delete w;
+  return ret;
+}
+
+bool FurnaceServer::opROM(const FurnaceServerValue& req, String& resp) {
+  stopRendering();
+  // pick the target by name or file extension
+  String target=req.getString("target","");
+  DivROMExportOptions romTarget=DIV_ROM_ABSTRACT;
+  for (int i=0; i<DIV_ROM_MAX; i++) {
+    DivROMExportOptions opt=(DivROMExportOptions)i;
+    if (!e->isROMExportViable(opt)) continue;
+    const DivROMExportDef* def=e->getROMExportDef(opt);
+    if (target.empty() || target==def->name || (def->fileExt!=NULL && target==def->fileExt)) {
+      romTarget=opt;
+      break;
+    }
+  }
+  if (romTarget==DIV_ROM_ABSTRACT) {
+    lastError="no matching ROM export target is available";
+    return false;
+  }
+
+  DivConfig conf;
+  const FurnaceServerValue* confV=req.get("conf");
+  if (confV!=NULL && confV->type==FurnaceServerValue::OBJECT) {
+    for (auto& i: confV->obj) {
+      if (i.second.type==FurnaceServerValue::STRING) {
+        conf.set(i.first,i.second.str);
+      } else if (i.second.type==FurnaceServerValue::BOOL) {
+        conf.set(i.first,i.second.b);
+      } else if (i.second.type==FurnaceServerValue::NUMBER) {
+        conf.set(i.first,(int)i.second.num);
+      }
+    }
+  }
+
+  DivROMExport* exp=e->buildROM(romTarget);
+  if (exp==NULL) {
+    lastError="could not create exporter";
+    return false;
+  }
+  exp->setConf(conf);
+  if (!exp->go(e)) {
+    delete exp;
+    lastError="could not begin exporting process";
+    return false;
+  }
+  exp->wait();
+  if (exp->hasFailed()) {
+    delete exp;
+    lastError=e->getLastError();
+    return false;
+  }
+
+  // multi-file exports go into the "output" directory, or inline as a list
+  bool ret=true;
+  bool multi=e->getROMExportDef(romTarget)->multiOutput;
+  String path=req.getString("output","");
+  resp+=fmt::sprintf(",\"target\":\"%s\",\"files\":[",jsonEscape(e->getROMExportDef(romTarget)->name));
+  bool first=true;
+  for (DivROMExportOutput& i: exp->getResult()) {
+    if (i.data==NULL) continue;
+    if (ret) {
+      String entry=fmt::sprintf("%s{\"name\":\"%s\"",first?"":",",jsonEscape(i.name));
+      if (path.empty()) {
+        entry+=fmt::sprintf(",\"size\":%d,\"data\":\"%s\"",(int)i.data->size(),encodeBase64(i.data->getFinalBuf(),i.data->size()));
+      } else {
+        String filePath=path;
+        if (multi) {
+          filePath+=DIR_SEPARATOR_STR;
+          filePath+=i.name;
+        }
+        if (writeWholeFile(filePath,i.data->getFinalBuf(),i.data->size())) {
+          entry+=fmt::sprintf(",\"size\":%d,\"file\":\"%s\"",(int)i.data->size(),jsonEscape(filePath));
+        } else {
+          lastError=fmt::sprintf("could not write %s: %s",filePath,strerror(errno));
+          ret=false;
+        }
+      }
+      resp+=entry+"}";
+      first=false;
+    }
+    i.data->finish();
+    delete i.data;
+    i.data=NULL;
+  }
+  resp+="]";
+  delete exp;
+  return ret;
+}
+
+bool FurnaceServer::opInfo(const FurnaceServerValue& req, String& resp) {
+  resp+=fmt::sprintf(",\"name\":\"%s\",\"author\":\"%s\",\"chans\":%d,\"subsongs\":%d,\"subsong\":%d,\"orders\":%d,\"systems\":[",
+    jsonEscape(e->song.name),
+    jsonEscape(e->song.author),
+    e->getTotalChannelCount(),
+    (int)e->song.subsong.size(),
+    (int)e->getCurrentSubSong(),
+    (int)e->curSubSong->ordersLen
+  );
+  for (int i=0; i<e->song.systemLen; i++) {
+    resp+=fmt::sprintf("%s\"%s\"",(i>0)?",":"",jsonEscape(e->getSystemName(e->song.system[i])));
+  }
+  // resident sample memory of each chip
+  resp+="],\"sampleMemory\":[";
+  for (int i=0; i<e->song.systemLen; i++) {
+    size_t resident=0;
+    DivDispatch* dispatch=e->getDispatch(i);
+    if (dispatch!=NULL) {
+      for (int j=0; j<4; j++) {
+        const DivMemoryComposition* mc=dispatch->getMemCompo(j);
+        if (mc==NULL) break;
+        resident+=mc->resident;
+      }
+    }
+    resp+=fmt::sprintf("%s%d",(i>0)?",":"",(int)resident);
+  }
+  resp+="]";
+  return true;
+}
+
+String FurnaceServer::handle(const String& line) {
+  FurnaceServerValue req;
+  const char* p=line.c_str();
+  bool valid=parseValue(p,req,0);
+  if (valid) {
+    skipSpace(p);
+    if (*p!=0) valid=false;
+  }
+  if (!valid || req.type!=FurnaceServerValue::OBJECT) {
+    return "{\"id\":null,\"ok\":false,\"error\":\"invalid request\"}";
+  }
+
+  // echo the request ID so that clients can match responses
+  String id="null";
+  const FurnaceServerValue* idV=req.get("id");
+  if (idV!=NULL) {
+    if (idV->type==FurnaceServerValue::NUMBER) {
+      id=fmt::sprintf("%.17g",idV->num);
+    } else if (idV->type==FurnaceServerValue::STRING) {
+      id="\""+jsonEscape(idV->str)+"\"";
+    }
+  }
+
+  String op=req.getString("op","");
+  String resp;
+  bool ok=false;
+  lastError="";
+  if (op=="load") {
+    ok=opLoad(req,resp);
+  } else if (op=="subsong") {
+    ok=opSubSong(req,resp);
+  } else if (op=="seek") {
+    ok=opSeek(req,resp);
+  } else if (op=="mute") {
+    ok=opMute(req,resp);
+  } else if (op=="render") {
+    ok=opRender(req,resp);
+  } else if (op=="audio") {
+    ok=opAudio(req,resp);
+  } else if (op=="vgm") {
+    ok=opVGM(req,resp);
+  } else if (op=="cmd") {
+    ok=opCommand(req,resp);
+  } else if (op=="rom") {
+    ok=opROM(req,resp);
+  } else if (op=="info") {
+    ok=opInfo(req,resp);
+  } else if (op=="quit") {
+    quit=true;
+    if (pool!=NULL) pool->stop();
+    ok=true;
+  } else {
+    lastError=fmt::sprintf("unknown op \"%s\"",op);
+  }
+
+  if (ok) {
+    return fmt::sprintf("{\"id\":%s,\"ok\":true%s}",id,resp);
+  }
+  return fmt::sprintf("{\"id\":%s,\"ok\":false,\"error\":\"%s\"}",id,jsonEscape(lastError));
+}
+
+void FurnaceServer::serveStream(FILE* in, FILE* out) {
+  char buf[4096];
+  String line;
+  while (!quit) {
+    if (fgets(buf,4096,in)==NULL) break;
+    line+=buf;
+    // long lines (inline data) arrive in pieces
+    if (line.back()!='\n' && !feof(in)) continue;
+    while (!line.empty() && (line.back()=='\n' || line.back()=='\r')) line.pop_back();
+    if (line.empty()) continue;
+
+    String resp=handle(line);
+    line="";
+    fputs(resp.c_str(),out);
+    fputc('\n',out);
+    fflush(out);
+  }
+}
+
+void FurnaceServerPool::stop() {
+#ifndef _WIN32
+  std::unique_lock<std::mutex> l(lock);
+  quit=true;
+  // wake up accept() and the sessions waiting for a request
+  if (sock>=0) shutdown(sock,SHUT_RDWR);
+  for (int i: active) {
+    shutdown(i,SHUT_RD);
+  }
+  canServe.notify_all();
+#endif
+}
+
+void FurnaceServer::serveClients() {
+#ifndef _WIN32
+  while (true) {
+    int client;
+    {
+      std::unique_lock<std::mutex> l(pool->lock);
+      while (pool->clients.empty() && !pool->quit) pool->canServe.wait(l);
+      if (pool->quit) break;
+      client=pool->clients.front();
+      pool->clients.pop_front();
+      pool->active.insert(client);
+    }
+
+    int clientOut=dup(client);
+    FILE* in=fdopen(client,"rb");
+    FILE* out=(clientOut<0)?NULL:fdopen(clientOut,"wb");
+    if (in==NULL || out==NULL) {
+      logE("could not open client stream!");
+    } else {
+      logD("client connected.");
+      serveStream(in,out);
+      logD("client disconnected.");
+    }
+
+    pool->lock.lock();
+    pool->active.erase(client);
+    pool->lock.unlock();
+    if (in!=NULL) fclose(in); else close(client);
+    if (out!=NULL) fclose(out); else if (clientOut>=0) close(clientOut);
+  }
+#endif
+}
+
+bool FurnaceServer::serve(const String& where, int workers) {
+  quit=false;
+  if (where=="stdio") {
+    logI("serving on standard input/output.");
+    serveStream(stdin,stdout);
+    return true;
+  }
+
+#ifdef _WIN32
+  logE("Unix sockets are not supported on Windows. use stdio instead.");
+  return false;
+#else
+  struct sockaddr_un addr;
+  if (where.size()>=sizeof(addr.sun_path)) {
+    logE("socket path is too long!");
+    return false;
+  }
+  int sock=socket(AF_UNIX,SOCK_STREAM,0);
+  if (sock<0) {
+    logE("could not create socket! (%s)",strerror(errno));
+    return false;
+  }
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family=AF_UNIX;
+  strncpy(addr.sun_path,where.c_str(),sizeof(addr.sun_path)-1);
+  unlink(where.c_str());
+  if (bind(sock,(struct sockaddr*)&addr,sizeof(addr))<0) {
+    logE("could not bind socket! (%s)",strerror(errno));
+    close(sock);
+    return false;
+  }
+  if (listen(sock,8)<0) {
+    logE("could not listen on socket! (%s)",strerror(errno));
+    close(sock);
+    unlink(where.c_str());
+    return false;
+  }
+  // a client going away shouldn't kill the server
+  signal(SIGPIPE,SIG_IGN);
+
+  // every worker has its own warm engine, so clients don't share songs or positions
+  if (workers<1) workers=MIN(16,std::thread::hardware_concurrency());
+  if (workers<1) workers=1;
+  FurnaceServerPool sharedPool;
+  sharedPool.sock=sock;
+  pool=&sharedPool;
+  std::vector<FurnaceServer*> servers;
+  servers.push_back(this);
+  for (int i=1; i<workers; i++) {
+    DivEngine* snap=e->createSnapshot();
+    if (snap==NULL) {
+      logW("could only create %d of %d engines. (%s)",i,workers,e->getLastError());
+      break;
+    }
+    // exports re-open audio output when done
+    snap->setAudio(DIV_AUDIO_DUMMY);
+    FurnaceServer* server=new FurnaceServer;
+    server->bindEngine(snap);
+    server->pool=&sharedPool;
+    servers.push_back(server);
+  }
+  std::vector<std::thread> threads;
+  for (FurnaceServer* i: servers) {
+    threads.push_back(std::thread([i]() {
+      i->serveClients();
+    }));
+  }
+  logI("serving on %s with %d engines.",where,(int)servers.size());
+
+  while (!sharedPool.quit) {
+    int client=accept(sock,NULL,NULL);
+    if (client<0) {
+      if (sharedPool.quit) break;
+      if (errno==EINTR) continue;
+      logE("could not accept connection! (%s)",strerror(errno));
+      sharedPool.stop();
+      break;
+    }
+    // connections wait here if all engines are busy
+    sharedPool.lock.lock();
+    sharedPool.clients.push_back(client);
+    sharedPool.canServe.notify_one();
+    sharedPool.lock.unlock();
+  }
+
+  for (std::thread& i: threads) {
+    i.join();
+  }
+  for (int i: sharedPool.clients) {
+    close(i);
+  }
+  for (size_t i=1; i<servers.size(); i++) {
+    DivEngine::destroySnapshot(servers[i]->e);
+    delete servers[i];
+  }
+  pool=NULL;
+
+  close(sock);
+  unlink(where.c_str());
+  return true;
+#endif
+}
+
+FurnaceServer::FurnaceServer():
+  e(NULL),
+  quit(false),
+  pool(NULL),
+  seekOrder(0),
+  seekRow(0),
+  rendering(false) {}
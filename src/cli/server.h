@@ -0,0 +1,126 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _FUR_SERVER_H
+#define _FUR_SERVER_H
+
+#include "../engine/engine.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+
+// a parsed JSON value (requests are small, so a plain tree is enough)
+struct FurnaceServerValue {
+  enum Type {
+    NONE=0,
+    BOOL,
+    NUMBER,
+    STRING,
+    ARRAY,
+    OBJECT
+  } type;
+  bool b;
+  double num;
+  String str;
+  std::vector<FurnaceServerValue> arr;
+  std::map<String,FurnaceServerValue> obj;
+
+  const FurnaceServerValue* get(const String& key) const;
+  String getString(const String& key, String fallback) const;
+  double getNumber(const String& key, double fallback) const;
+  bool getBool(const String& key, bool fallback) const;
+
+  FurnaceServerValue():
+    type(NONE),
+    b(false),
+    num(0.0) {}
+};
+
+// state shared by the workers of a socket server
+struct FurnaceServerPool {
+  int sock;
+  std::mutex lock;
+  std::condition_variable canServe;
+  // connections waiting for a worker
+  std::deque<int> clients;
+  // connections being served
+  std::set<int> active;
+  std::atomic<bool> quit;
+
+  // stop accepting connections and end every session after its current request.
+  void stop();
+
+  FurnaceServerPool():
+    sock(-1),
+    quit(false) {}
+};
+
+// headless render server.
+// reads one JSON request per line and writes one JSON response per line.
+// the engine stays initialized between requests, so start-up costs are only paid once.
+class FurnaceServer {
+  DivEngine* e;
+  bool quit;
+  // NULL when serving stdio
+  FurnaceServerPool* pool;
+  // position for the next render
+  int seekOrder, seekRow;
+  bool rendering;
+  std::vector<float> renderBuf[2];
+
+  // request handlers. each fills resp with extra fields (without braces).
+  bool opLoad(const FurnaceServerValue& req, String& resp);
+  bool opSubSong(const FurnaceServerValue& req, String& resp);
+  bool opSeek(const FurnaceServerValue& req, String& resp);
+  bool opMute(const FurnaceServerValue& req, String& resp);
+  bool opRender(const FurnaceServerValue& req, String& resp);
+  bool opAudio(const FurnaceServerValue& req, String& resp);
+  bool opVGM(const FurnaceServerValue& req, String& resp);
+  bool opCommand(const FurnaceServerValue& req, String& resp);
+  bool opROM(const FurnaceServerValue& req, String& resp);
+  bool opInfo(const FurnaceServerValue& req, String& resp);
+
+  // write data to the "output" path of the request, or append it inline (base64)
+  bool emit(const FurnaceServerValue& req, const unsigned char* data, size_t len, String& resp);
+  // render frames of interleaved stereo float audio
+  size_t render(std::vector<float>& out, size_t frames);
+  void stopRendering();
+  // worker thread of a socket server
+  void serveClients();
+
+  String lastError;
+
+  public:
+    void bindEngine(DivEngine* eng);
+    // handle a request line. returns the response line (without newline).
+    String handle(const String& line);
+    // serve requests from a pair of streams until EOF or a quit request.
+    void serveStream(FILE* in, FILE* out);
+    // serve on stdin/stdout ("stdio") or on a Unix socket at the given path.
+    // on a socket, up to workers clients are served at once, each by its own engine
+    // (a snapshot of the bound one). 0 means one per CPU core.
+    bool serve(const String& where, int workers=1);
+    FurnaceServer();
+};
+
+#endif
@@ -111,6 +111,7 @@ class DivCSPlayer {
 };
 
 struct DivCSProgress {
+  // count: number of ticks played during export
   int stage, count, total;
   int optStage, findTotal;
   int optCurrent, optTotal;
@@ -145,6 +146,26 @@ struct DivCSOptions {
     noSubBlock(false) {}
 };
 
+// result of DivEngine::profileCommandStream()
+struct DivCSProfile {
+  // cycles spent in fcsTick on every tick (including dispatch stubs)
+  std::vector<unsigned int> tickCycles;
+  // cycles spent on each channel, in total and at most in a single tick
+  std::vector<unsigned long long> chanTotal;
+  std::vector<unsigned int> chanMax;
+  // cycles spent in the loop around fcsDoChannel
+  unsigned long long overhead;
+  // cycles spent in dispatch stubs
+  unsigned long long stubTotal;
+  unsigned int initCycles;
+  unsigned int budget;
+  DivCSProfile():
+    overhead(0),
+    stubTotal(0),
+    initCycles(0),
+    budget(0) {}
+};
+
 // command stream utilities
 namespace DivCS {
   int getCmdLength(unsigned char ext);
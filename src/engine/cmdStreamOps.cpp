@@ -1361,7 +1361,7 @@ SafeWriter* DivEngine::saveCommand(DivCSProgress* progress, DivCSOptions options
         }
       }
     }
-    if (nextTick(false,true) || !playing) {
+    if (nextTick() || !playing) {
       done=true;
       break;
     }
@@ -1406,6 +1406,7 @@ SafeWriter* DivEngine::saveCommand(DivCSProgress* progress, DivCSOptions options
     }
     tick++;
   }
+  if (progress!=NULL) progress->count=tick;
   if (!playing || loopTick<0) {
     for (int i=0; i<chans; i++) {
       chanStream[i]->writeC(0xdf);
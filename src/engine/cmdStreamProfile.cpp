@@ -0,0 +1,238 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "engine.h"
+#include "cpu6502.h"
+#include "../ta-log.h"
+#include <algorithm>
+
+// give up on a tick after this many cycles (a channel is probably stuck)
+#define CS_PROFILE_MAX_CYCLES 10000000
+
+// parse a WLA-DX symbol file ([labels] "bank:address name", [definitions] "value name")
+static void parseSymbols(const String& text, std::unordered_map<String,unsigned int>& ret) {
+  size_t pos=0;
+  while (pos<text.size()) {
+    size_t end=text.find_first_of("\r\n",pos);
+    if (end==String::npos) end=text.size();
+    String line=text.substr(pos,end-pos);
+    pos=end+1;
+
+    size_t comment=line.find(';');
+    if (comment!=String::npos) line=line.substr(0,comment);
+    if (line.empty() || line[0]=='[') continue;
+
+    size_t space=line.find_first_of(" \t");
+    if (space==String::npos) continue;
+    String value=line.substr(0,space);
+    size_t nameBegin=line.find_first_not_of(" \t",space);
+    if (nameBegin==String::npos) continue;
+    size_t nameEnd=line.find_first_of(" \t",nameBegin);
+    String name=line.substr(nameBegin,(nameEnd==String::npos)?String::npos:(nameEnd-nameBegin));
+
+    size_t colon=value.find(':');
+    if (colon!=String::npos) value=value.substr(colon+1);
+    try {
+      ret[name]=std::stoul(value,NULL,16);
+    } catch (std::exception& e) {
+      continue;
+    }
+  }
+}
+
+bool DivEngine::profileCommandStream(const unsigned char* player, size_t playerLen, const String& symbols, const DivConfig& conf, DivCSProfile& result) {
+  std::unordered_map<String,unsigned int> sym;
+  parseSymbols(symbols,sym);
+
+  const char* required[]={
+    "fcsInit", "fcsTick", "fcsPtr", "FCS_MAX_CHAN", "fcsCmdTableLow", "fcsCmdTableHigh", NULL
+  };
+  for (int i=0; required[i]; i++) {
+    if (sym.find(required[i])==sym.end()) {
+      lastError=fmt::sprintf(_("symbol %s not found"),required[i]);
+      return false;
+    }
+  }
+  unsigned int fcsPtr=sym["fcsPtr"];
+  unsigned int playerChans=sym["FCS_MAX_CHAN"];
+  unsigned int doChannel=(sym.find("fcsDoChannel")!=sym.end())?sym["fcsDoChannel"]:0x10000;
+
+  unsigned int loadAddr=conf.getInt("loadAddr",0);
+  if (loadAddr+playerLen>65536) {
+    lastError=_("player does not fit in memory");
+    return false;
+  }
+
+  // export the stream in the format the player expects
+  DivCSOptions options;
+  options.longPointers=false;
+  options.bigEndian=false;
+  options.noCmdCallOpt=conf.getBool("noCmdCallOpt",false);
+  options.noDelayCondense=conf.getBool("noDelayCondense",false);
+  options.noSubBlock=conf.getBool("noSubBlock",false);
+  DivCSProgress progress;
+  SafeWriter* w=saveCommand(&progress,options);
+  if (w==NULL) {
+    lastError=_("could not write command stream!");
+    return false;
+  }
+  size_t streamLen=w->size();
+  unsigned int streamChans=chans;
+
+  if (streamChans!=playerChans) {
+    lastError=fmt::sprintf(_("player was built for %d channels, but the song has %d"),playerChans,streamChans);
+    w->finish();
+    delete w;
+    return false;
+  }
+  // the stub address must be free, so that it never gets executed by accident
+  unsigned int stubAddr=fcsPtr+streamLen;
+  if (stubAddr+2>65536) {
+    lastError=_("command stream does not fit in memory");
+    w->finish();
+    delete w;
+    return false;
+  }
+
+  DivCPU6502* cpu=new DivCPU6502;
+  memcpy(&cpu->mem[loadAddr],player,playerLen);
+  memcpy(&cpu->mem[fcsPtr],w->getFinalBuf(),streamLen);
+  w->finish();
+  delete w;
+
+  // max volume array
+  if (sym.find("fcsVolMax")!=sym.end()) {
+    unsigned int volMaxAddr=sym["fcsVolMax"];
+    for (int i=0; i<chans; i++) {
+      if (volMaxAddr+i*2+1>=65536) break;
+      int volMax=disCont[dispatchOfChan[i]].dispatch->dispatch(DivCommand(DIV_CMD_GET_VOLMAX,dispatchChanOfChan[i]));
+      cpu->mem[volMaxAddr+i*2]=CLAMP(volMax,0,255);
+      cpu->mem[volMaxAddr+i*2+1]=0;
+    }
+  }
+
+  // point every command at the stub. its cost is looked up from the command in Y.
+  unsigned int tableLow=sym["fcsCmdTableLow"];
+  unsigned int tableHigh=sym["fcsCmdTableHigh"];
+  if (tableLow==tableHigh) {
+    // a single table can only hold addresses of the form $XYXY
+    stubAddr=((stubAddr+0x100)&0xff00)|((stubAddr+0x100)>>8);
+    if (stubAddr+2>65536 || ((stubAddr>>8)!=(stubAddr&0xff))) {
+      lastError=_("no room for the dispatch stub");
+      delete cpu;
+      return false;
+    }
+  }
+  for (int i=0; i<256; i++) {
+    if (tableLow+i<65536) cpu->mem[tableLow+i]=stubAddr&0xff;
+    if (tableHigh+i<65536) cpu->mem[tableHigh+i]=stubAddr>>8;
+  }
+  unsigned int stubCycles[256];
+  int defaultStubCycles=conf.getInt("stubCycles",0);
+  for (int i=0; i<256; i++) {
+    stubCycles[i]=MAX(0,conf.getInt(fmt::sprintf("stubCycles%.2X",i),defaultStubCycles));
+  }
+  // the sentinel is where the profiled routine returns to
+  unsigned short sentinel=stubAddr+1;
+  int tickCycles=MAX(0,conf.getInt("tickCycles",0));
+
+  result=DivCSProfile();
+  result.budget=conf.getInt("budget",29780);
+  result.chanTotal.resize(chans,0);
+  result.chanMax.resize(chans,0);
+  std::vector<unsigned int> chanTick(chans,0);
+
+  cpu->s=0xff;
+  int ticks=conf.getInt("ticks",progress.count);
+  bool success=true;
+  for (int t=-1; t<ticks; t++) {
+    // t=-1 runs fcsInit
+    cpu->push((sentinel-1)>>8);
+    cpu->push((sentinel-1)&0xff);
+    cpu->pc=(t<0)?sym["fcsInit"]:sym["fcsTick"];
+    cpu->cycles=0;
+    int curChan=-1;
+    // stack pointer on entry to fcsDoChannel. its RTS brings the stack back here
+    int chanStack=-1;
+    unsigned long long lastCycles=0;
+    for (int i=0; i<chans; i++) chanTick[i]=0;
+
+    while (cpu->pc!=sentinel) {
+      bool leaveChan=false;
+      if (cpu->pc==stubAddr) {
+        // dispatch stub: charge its cost and return
+        unsigned int cost=stubCycles[cpu->y]+6;
+        cpu->cycles+=cost;
+        result.stubTotal+=cost;
+        // the channel routine may jump to the command instead of calling it
+        leaveChan=(curChan>=0 && cpu->s==chanStack);
+        unsigned short lo=cpu->pull();
+        unsigned short hi=cpu->pull();
+        cpu->pc=((hi<<8)|lo)+1;
+      } else {
+        if (cpu->pc==doChannel) {
+          curChan=cpu->x>>1;
+          chanStack=cpu->s;
+        }
+        // RTS back to fcsTick
+        leaveChan=(curChan>=0 && cpu->mem[cpu->pc]==0x60 && cpu->s==chanStack);
+        cpu->step();
+      }
+      if (curChan>=0 && curChan<chans) {
+        chanTick[curChan]+=cpu->cycles-lastCycles;
+      } else if (t>=0) {
+        result.overhead+=cpu->cycles-lastCycles;
+      }
+      lastCycles=cpu->cycles;
+      if (leaveChan) {
+        curChan=-1;
+        chanStack=-1;
+      }
+      if (cpu->jammed) {
+        lastError=fmt::sprintf(_("invalid opcode at $%.4x (tick %d)"),(unsigned short)(cpu->pc-1),t);
+        success=false;
+        break;
+      }
+      if (cpu->cycles>CS_PROFILE_MAX_CYCLES) {
+        lastError=fmt::sprintf(_("tick %d did not finish (channel %d)"),t,curChan);
+        success=false;
+        break;
+      }
+    }
+    if (!success) break;
+
+    if (t<0) {
+      result.initCycles=cpu->cycles;
+      if (cpu->a!=0) {
+        lastError=_("fcsInit failed");
+        success=false;
+        break;
+      }
+      continue;
+    }
+    result.tickCycles.push_back(cpu->cycles+tickCycles);
+    for (int i=0; i<chans; i++) {
+      result.chanTotal[i]+=chanTick[i];
+      if (chanTick[i]>result.chanMax[i]) result.chanMax[i]=chanTick[i];
+    }
+  }
+
+  delete cpu;
+  return success;
+}
@@ -0,0 +1,391 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "cpu6502.h"
+#include <string.h>
+
+#define FLAG_C 0x01
+#define FLAG_Z 0x02
+#define FLAG_I 0x04
+#define FLAG_D 0x08
+#define FLAG_B 0x10
+#define FLAG_U 0x20
+#define FLAG_V 0x40
+#define FLAG_N 0x80
+
+// page cross penalty
+#define CROSS(base,addr) if (penalty && (((base)^(addr))&0xff00)) extra++;
+
+unsigned char DivCPU6502::fetch() {
+  return mem[pc++];
+}
+
+unsigned short DivCPU6502::fetch16() {
+  unsigned short ret=mem[pc]|(mem[(unsigned short)(pc+1)]<<8);
+  pc+=2;
+  return ret;
+}
+
+unsigned short DivCPU6502::read16(unsigned short addr) {
+  return mem[addr]|(mem[(unsigned short)(addr+1)]<<8);
+}
+
+unsigned short DivCPU6502::read16ZP(unsigned char addr) {
+  return mem[addr]|(mem[(unsigned char)(addr+1)]<<8);
+}
+
+// JMP (ind) does not carry into the high byte
+unsigned short DivCPU6502::read16Bug(unsigned short addr) {
+  return mem[addr]|(mem[(addr&0xff00)|((addr+1)&0xff)]<<8);
+}
+
+unsigned short DivCPU6502::addrZPX() {
+  return (unsigned char)(fetch()+x);
+}
+
+unsigned short DivCPU6502::addrZPY() {
+  return (unsigned char)(fetch()+y);
+}
+
+unsigned short DivCPU6502::addrAbs() {
+  return fetch16();
+}
+
+unsigned short DivCPU6502::addrAbsX(bool penalty) {
+  unsigned short base=fetch16();
+  unsigned short ret=base+x;
+  CROSS(base,ret);
+  return ret;
+}
+
+unsigned short DivCPU6502::addrAbsY(bool penalty) {
+  unsigned short base=fetch16();
+  unsigned short ret=base+y;
+  CROSS(base,ret);
+  return ret;
+}
+
+unsigned short DivCPU6502::addrIndX() {
+  return read16ZP((unsigned char)(fetch()+x));
+}
+
+unsigned short DivCPU6502::addrIndY(bool penalty) {
+  unsigned short base=read16ZP(fetch());
+  unsigned short ret=base+y;
+  CROSS(base,ret);
+  return ret;
+}
+
+void DivCPU6502::setNZ(unsigned char val) {
+  p&=~(FLAG_N|FLAG_Z);
+  if (val==0) p|=FLAG_Z;
+  p|=val&FLAG_N;
+}
+
+void DivCPU6502::adc(unsigned char val) {
+  unsigned int carry=p&FLAG_C;
+  unsigned int sum=a+val+carry;
+  p&=~(FLAG_C|FLAG_V);
+  if (~(a^val)&(a^sum)&0x80) p|=FLAG_V;
+  if (p&FLAG_D) {
+    unsigned int lo=(a&15)+(val&15)+carry;
+    unsigned int hi=(a>>4)+(val>>4);
+    if (lo>9) {
+      lo+=6;
+      hi++;
+    }
+    if (hi>9) hi+=6;
+    if (hi>15) p|=FLAG_C;
+    a=((hi<<4)|(lo&15))&0xff;
+    setNZ(a);
+    return;
+  }
+  if (sum>0xff) p|=FLAG_C;
+  a=sum&0xff;
+  setNZ(a);
+}
+
+void DivCPU6502::sbc(unsigned char val) {
+  if (p&FLAG_D) {
+    unsigned int borrow=(p&FLAG_C)?0:1;
+    int lo=(a&15)-(val&15)-borrow;
+    int hi=(a>>4)-(val>>4);
+    unsigned int diff=a-val-borrow;
+    p&=~(FLAG_C|FLAG_V);
+    if ((a^val)&(a^diff)&0x80) p|=FLAG_V;
+    if (lo<0) {
+      lo-=6;
+      hi--;
+    }
+    if (hi<0) {
+      hi-=6;
+    } else {
+      p|=FLAG_C;
+    }
+    a=((hi<<4)|(lo&15))&0xff;
+    setNZ(a);
+    return;
+  }
+  adc(val^0xff);
+}
+
+void DivCPU6502::compare(unsigned char reg, unsigned char val) {
+  p&=~FLAG_C;
+  if (reg>=val) p|=FLAG_C;
+  setNZ(reg-val);
+}
+
+void DivCPU6502::branch(bool cond) {
+  signed char off=(signed char)fetch();
+  if (!cond) return;
+  unsigned short target=pc+off;
+  extra++;
+  if ((target^pc)&0xff00) extra++;
+  pc=target;
+}
+
+void DivCPU6502::push(unsigned char val) {
+  mem[0x100|s]=val;
+  s--;
+}
+
+unsigned char DivCPU6502::pull() {
+  s++;
+  return mem[0x100|s];
+}
+
+// read-modify-write helpers
+#define RMW(addr,op) { \
+  unsigned short _a=(addr); \
+  unsigned char _v=mem[_a]; \
+  op; \
+  mem[_a]=_v; \
+}
+
+#define OP_ASL p=(p&~FLAG_C)|(_v>>7); _v<<=1; setNZ(_v);
+#define OP_LSR p=(p&~FLAG_C)|(_v&1); _v>>=1; setNZ(_v);
+#define OP_ROL { unsigned char _c=p&FLAG_C; p=(p&~FLAG_C)|(_v>>7); _v=(_v<<1)|_c; setNZ(_v); }
+#define OP_ROR { unsigned char _c=(p&FLAG_C)<<7; p=(p&~FLAG_C)|(_v&1); _v=(_v>>1)|_c; setNZ(_v); }
+#define OP_INC _v++; setNZ(_v);
+#define OP_DEC _v--; setNZ(_v);
+
+// the eight addressing modes of the ALU group, with their cycle counts
+#define ALU_GROUP(base,op) \
+  case base|0x09: { unsigned char _v=fetch(); op; ret=2; break; } \
+  case base|0x05: { unsigned char _v=mem[fetch()]; op; ret=3; break; } \
+  case base|0x15: { unsigned char _v=mem[addrZPX()]; op; ret=4; break; } \
+  case base|0x0d: { unsigned char _v=mem[addrAbs()]; op; ret=4; break; } \
+  case base|0x1d: { unsigned char _v=mem[addrAbsX(true)]; op; ret=4; break; } \
+  case base|0x19: { unsigned char _v=mem[addrAbsY(true)]; op; ret=4; break; } \
+  case base|0x01: { unsigned char _v=mem[addrIndX()]; op; ret=6; break; } \
+  case base|0x11: { unsigned char _v=mem[addrIndY(true)]; op; ret=5; break; }
+
+// the five addressing modes of the shift group
+#define SHIFT_GROUP(base,op) \
+  case base|0x0a: { unsigned char _v=a; op; a=_v; ret=2; break; } \
+  case base|0x06: RMW(fetch(),op); ret=5; break; \
+  case base|0x16: RMW(addrZPX(),op); ret=6; break; \
+  case base|0x0e: RMW(addrAbs(),op); ret=6; break; \
+  case base|0x1e: RMW(addrAbsX(false),op); ret=7; break;
+
+int DivCPU6502::step() {
+  unsigned char op=fetch();
+  int ret=2;
+  extra=0;
+
+  switch (op) {
+    ALU_GROUP(0x00,a|=_v; setNZ(a))
+    ALU_GROUP(0x20,a&=_v; setNZ(a))
+    ALU_GROUP(0x40,a^=_v; setNZ(a))
+    ALU_GROUP(0x60,adc(_v))
+    ALU_GROUP(0xa0,a=_v; setNZ(a))
+    ALU_GROUP(0xc0,compare(a,_v))
+    ALU_GROUP(0xe0,sbc(_v))
+
+    // STA
+    case 0x85: mem[fetch()]=a; ret=3; break;
+    case 0x95: mem[addrZPX()]=a; ret=4; break;
+    case 0x8d: mem[addrAbs()]=a; ret=4; break;
+    case 0x9d: mem[addrAbsX(false)]=a; ret=5; break;
+    case 0x99: mem[addrAbsY(false)]=a; ret=5; break;
+    case 0x81: mem[addrIndX()]=a; ret=6; break;
+    case 0x91: mem[addrIndY(false)]=a; ret=6; break;
+
+    SHIFT_GROUP(0x00,OP_ASL)
+    SHIFT_GROUP(0x20,OP_ROL)
+    SHIFT_GROUP(0x40,OP_LSR)
+    SHIFT_GROUP(0x60,OP_ROR)
+
+    // INC/DEC
+    case 0xe6: RMW(fetch(),OP_INC); ret=5; break;
+    case 0xf6: RMW(addrZPX(),OP_INC); ret=6; break;
+    case 0xee: RMW(addrAbs(),OP_INC); ret=6; break;
+    case 0xfe: RMW(addrAbsX(false),OP_INC); ret=7; break;
+    case 0xc6: RMW(fetch(),OP_DEC); ret=5; break;
+    case 0xd6: RMW(addrZPX(),OP_DEC); ret=6; break;
+    case 0xce: RMW(addrAbs(),OP_DEC); ret=6; break;
+    case 0xde: RMW(addrAbsX(false),OP_DEC); ret=7; break;
+
+    // LDX/LDY
+    case 0xa2: x=fetch(); setNZ(x); ret=2; break;
+    case 0xa6: x=mem[fetch()]; setNZ(x); ret=3; break;
+    case 0xb6: x=mem[addrZPY()]; setNZ(x); ret=4; break;
+    case 0xae: x=mem[addrAbs()]; setNZ(x); ret=4; break;
+    case 0xbe: x=mem[addrAbsY(true)]; setNZ(x); ret=4; break;
+    case 0xa0: y=fetch(); setNZ(y); ret=2; break;
+    case 0xa4: y=mem[fetch()]; setNZ(y); ret=3; break;
+    case 0xb4: y=mem[addrZPX()]; setNZ(y); ret=4; break;
+    case 0xac: y=mem[addrAbs()]; setNZ(y); ret=4; break;
+    case 0xbc: y=mem[addrAbsX(true)]; setNZ(y); ret=4; break;
+
+    // STX/STY
+    case 0x86: mem[fetch()]=x; ret=3; break;
+    case 0x96: mem[addrZPY()]=x; ret=4; break;
+    case 0x8e: mem[addrAbs()]=x; ret=4; break;
+    case 0x84: mem[fetch()]=y; ret=3; break;
+    case 0x94: mem[addrZPX()]=y; ret=4; break;
+    case 0x8c: mem[addrAbs()]=y; ret=4; break;
+
+    // CPX/CPY
+    case 0xe0: compare(x,fetch()); ret=2; break;
+    case 0xe4: compare(x,mem[fetch()]); ret=3; break;
+    case 0xec: compare(x,mem[addrAbs()]); ret=4; break;
+    case 0xc0: compare(y,fetch()); ret=2; break;
+    case 0xc4: compare(y,mem[fetch()]); ret=3; break;
+    case 0xcc: compare(y,mem[addrAbs()]); ret=4; break;
+
+    // BIT
+    case 0x24: case 0x2c: {
+      unsigned char v=(op==0x24)?mem[fetch()]:mem[addrAbs()];
+      p&=~(FLAG_N|FLAG_V|FLAG_Z);
+      p|=v&(FLAG_N|FLAG_V);
+      if ((a&v)==0) p|=FLAG_Z;
+      ret=(op==0x24)?3:4;
+      break;
+    }
+
+    // branches
+    case 0x10: branch(!(p&FLAG_N)); break;
+    case 0x30: branch(p&FLAG_N); break;
+    case 0x50: branch(!(p&FLAG_V)); break;
+    case 0x70: branch(p&FLAG_V); break;
+    case 0x90: branch(!(p&FLAG_C)); break;
+    case 0xb0: branch(p&FLAG_C); break;
+    case 0xd0: branch(!(p&FLAG_Z)); break;
+    case 0xf0: branch(p&FLAG_Z); break;
+
+    // jumps
+    case 0x4c: pc=fetch16(); ret=3; break;
+    case 0x6c: pc=read16Bug(fetch16()); ret=5; break;
+    case 0x20: {
+      unsigned short target=fetch16();
+      pc--;
+      push(pc>>8);
+      push(pc&0xff);
+      pc=target;
+      ret=6;
+      break;
+    }
+    case 0x60: {
+      unsigned short lo=pull();
+      unsigned short hi=pull();
+      pc=((hi<<8)|lo)+1;
+      ret=6;
+      break;
+    }
+    case 0x40: {
+      p=(pull()&~FLAG_B)|FLAG_U;
+      unsigned short lo=pull();
+      unsigned short hi=pull();
+      pc=(hi<<8)|lo;
+      ret=6;
+      break;
+    }
+    case 0x00: {
+      pc++;
+      push(pc>>8);
+      push(pc&0xff);
+      push(p|FLAG_B|FLAG_U);
+      p|=FLAG_I;
+      pc=read16(0xfffe);
+      ret=7;
+      break;
+    }
+
+    // stack
+    case 0x48: push(a); ret=3; break;
+    case 0x08: push(p|FLAG_B|FLAG_U); ret=3; break;
+    case 0x68: a=pull(); setNZ(a); ret=4; break;
+    case 0x28: p=(pull()&~FLAG_B)|FLAG_U; ret=4; break;
+
+    // transfers
+    case 0xaa: x=a; setNZ(x); break;
+    case 0x8a: a=x; setNZ(a); break;
+    case 0xa8: y=a; setNZ(y); break;
+    case 0x98: a=y; setNZ(a); break;
+    case 0xba: x=s; setNZ(x); break;
+    case 0x9a: s=x; break;
+    case 0xe8: x++; setNZ(x); break;
+    case 0xc8: y++; setNZ(y); break;
+    case 0xca: x--; setNZ(x); break;
+    case 0x88: y--; setNZ(y); break;
+
+    // flags
+    case 0x18: p&=~FLAG_C; break;
+    case 0x38: p|=FLAG_C; break;
+    case 0x58: p&=~FLAG_I; break;
+    case 0x78: p|=FLAG_I; break;
+    case 0xb8: p&=~FLAG_V; break;
+    case 0xd8: p&=~FLAG_D; break;
+    case 0xf8: p|=FLAG_D; break;
+    case 0xea: break;
+
+    default:
+      jammed=true;
+      break;
+  }
+
+  ret+=extra;
+  cycles+=ret;
+  return ret;
+}
+
+void DivCPU6502::reset() {
+  pc=read16(0xfffc);
+  a=0;
+  x=0;
+  y=0;
+  s=0xfd;
+  p=FLAG_I|FLAG_U;
+  cycles=0;
+  jammed=false;
+}
+
+DivCPU6502::DivCPU6502():
+  extra(0),
+  pc(0),
+  a(0),
+  x(0),
+  y(0),
+  s(0xfd),
+  p(FLAG_I|FLAG_U),
+  cycles(0),
+  jammed(false) {
+  memset(mem,0,65536);
+}
@@ -0,0 +1,73 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CPU6502_H
+#define _CPU6502_H
+
+#include <stdint.h>
+
+// a minimal NMOS 6502 interpreter with 64K of flat RAM.
+// only counts cycles - there is no bus timing or hardware.
+// used to measure the cost of the command stream player.
+class DivCPU6502 {
+  unsigned short addrZPX();
+  unsigned short addrZPY();
+  unsigned short addrAbs();
+  unsigned short addrAbsX(bool penalty);
+  unsigned short addrAbsY(bool penalty);
+  unsigned short addrIndX();
+  unsigned short addrIndY(bool penalty);
+  void setNZ(unsigned char val);
+  void adc(unsigned char val);
+  void sbc(unsigned char val);
+  void compare(unsigned char reg, unsigned char val);
+  void branch(bool cond);
+  unsigned char fetch();
+  unsigned short fetch16();
+  unsigned short read16(unsigned short addr);
+  unsigned short read16ZP(unsigned char addr);
+  unsigned short read16Bug(unsigned short addr);
+
+  int extra;
+
+  public:
+    unsigned char mem[65536];
+    unsigned short pc;
+    unsigned char a, x, y, s, p;
+    uint64_t cycles;
+    // set when an undocumented opcode is executed
+    bool jammed;
+
+    void push(unsigned char val);
+    unsigned char pull();
+
+    /**
+     * execute one instruction.
+     * @return the number of cycles it took.
+     */
+    int step();
+
+    /**
+     * reset registers (memory is left untouched).
+     */
+    void reset();
+    DivCPU6502();
+};
+
+#endif
@@ -630,12 +630,15 @@ struct DivMemoryComposition {
   String name;
   size_t capacity;
   size_t used;
+  // bytes of the memory actually resident (0 if not tracked)
+  size_t resident;
   const unsigned char* memory;
   DivMemoryWaveView waveformView;
   DivMemoryComposition():
     name(""),
     capacity(0),
     used(0),
+    resident(0),
     memory(NULL),
     waveformView(DIV_MEMORY_WAVE_NONE) {}
 };
@@ -710,7 +713,7 @@ class DivDispatch {
 
     /**
      * ticks this dispatch.
-     * @param sysTick whether the engine has ticked (if not then this may be a sub-tick used in low-latency mode).
+     * @param sysTick whether the engine has ticked (if not then this is a low-latency mode sub-tick which only follows live notes).
      */
     virtual void tick(bool sysTick=true);
 
@@ -884,6 +887,26 @@ class DivDispatch {
      */
     virtual bool hasAcquireDirect();
 
+    /**
+     * check whether the chip is idle.
+     * a chip is idle if every channel is off and, until the next register write,
+     * acquire() would produce a constant output and change no state other than
+     * what skipIdle() advances (e.g. counters, LFO and phases) and the
+     * oscilloscope buffers.
+     * platforms which cannot guarantee this must return false (the default).
+     * @return whether the chip is idle.
+     */
+    virtual bool isIdle();
+
+    /**
+     * advance an idle chip by len samples without rendering it.
+     * this must leave the chip in the same state acquire() would have, so
+     * that the output after the next register write is unchanged.
+     * only called while isIdle() is true. the output buffers are not touched.
+     * @param len the number of samples.
+     */
+    virtual void skipIdle(size_t len);
+
     /**
      * get minimum chip clock.
      * @return clock in Hz, or 0 if custom clocks are not supported.
@@ -155,6 +155,27 @@ void DivDispatchContainer::grow(size_t size) {
 void DivDispatchContainer::acquire(size_t count) {
   CHECK_MISSING_BUFS;
 
+  std::chrono::steady_clock::time_point timeStart;
+  if (measureTime) timeStart=std::chrono::steady_clock::now();
+
+  // an idle chip outputs a constant value until the next register write.
+  // one normal run brings the output to that value, after which the core is
+  // skipped until the dispatch reports activity again.
+  idleRun=false;
+  if (idleSkip && !dispatch->hasAcquireDirect() && !dcOffCompensation) {
+    if (dispatch->isIdle()) {
+      if (wasIdle) {
+        dispatch->skipIdle(count);
+        idleRun=true;
+        if (measureTime) acquireTime+=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-timeStart).count();
+        return;
+      }
+      wasIdle=true;
+    } else {
+      wasIdle=false;
+    }
+  }
+
   if (dispatch->hasAcquireDirect()) {
     dispatch->acquireDirect(bb,count);
   } else {
@@ -171,6 +192,90 @@ void DivDispatchContainer::acquire(size_t count) {
     }
     dispatch->acquire(bbInMapped,count);
   }
+  if (measureTime) acquireTime+=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-timeStart).count();
+}
+
+bool DivDispatchContainer::setLowCost(DivSystem sys, DivDispatch* which) {
+  switch (sys) {
+    case DIV_SYSTEM_YM2612:
+    case DIV_SYSTEM_YM2612_EXT:
+    case DIV_SYSTEM_YM2612_CSM:
+    case DIV_SYSTEM_YM2612_DUALPCM:
+    case DIV_SYSTEM_YM2612_DUALPCM_EXT:
+      // ymfm
+      if (which!=NULL) ((DivPlatformGenesis*)which)->setYMFM(1);
+      return true;
+    case DIV_SYSTEM_SMS:
+      if (which!=NULL) ((DivPlatformSMS*)which)->setNuked(false);
+      return true;
+    case DIV_SYSTEM_GB:
+      if (which!=NULL) ((DivPlatformGB*)which)->setCoreQuality(0);
+      return true;
+    case DIV_SYSTEM_C64_6581:
+    case DIV_SYSTEM_C64_PCM:
+    case DIV_SYSTEM_C64_8580:
+      // dSID
+      if (which!=NULL) {
+        ((DivPlatformC64*)which)->setCore(2);
+        ((DivPlatformC64*)which)->setCoreQuality(0);
+      }
+      return true;
+    case DIV_SYSTEM_YM2151:
+      if (which!=NULL) ((DivPlatformArcade*)which)->setYMFM(true);
+      return true;
+    case DIV_SYSTEM_YM2610:
+    case DIV_SYSTEM_YM2610_FULL:
+    case DIV_SYSTEM_YM2610_EXT:
+    case DIV_SYSTEM_YM2610_FULL_EXT:
+    case DIV_SYSTEM_YM2610_CSM:
+    case DIV_SYSTEM_YM2610B:
+    case DIV_SYSTEM_YM2610B_EXT:
+    case DIV_SYSTEM_YM2610B_CSM:
+    case DIV_SYSTEM_YM2203:
+    case DIV_SYSTEM_YM2203_EXT:
+    case DIV_SYSTEM_YM2203_CSM:
+    case DIV_SYSTEM_YM2608:
+    case DIV_SYSTEM_YM2608_EXT:
+    case DIV_SYSTEM_YM2608_CSM:
+      // ymfm only
+      if (which!=NULL) ((DivPlatformOPN*)which)->setCombo(0);
+      return true;
+    case DIV_SYSTEM_OPLL:
+    case DIV_SYSTEM_OPLL_DRUMS:
+    case DIV_SYSTEM_VRC7:
+      // emu2413
+      if (which!=NULL) ((DivPlatformOPLL*)which)->setCore(1);
+      return true;
+    case DIV_SYSTEM_OPL:
+    case DIV_SYSTEM_OPL_DRUMS:
+    case DIV_SYSTEM_OPL2:
+    case DIV_SYSTEM_OPL2_DRUMS:
+    case DIV_SYSTEM_OPL3:
+    case DIV_SYSTEM_OPL3_DRUMS:
+    case DIV_SYSTEM_Y8950:
+    case DIV_SYSTEM_Y8950_DRUMS:
+    case DIV_SYSTEM_OPL4:
+    case DIV_SYSTEM_OPL4_DRUMS:
+      // ymfm
+      if (which!=NULL) ((DivPlatformOPL*)which)->setCore(1);
+      return true;
+    case DIV_SYSTEM_AY8910:
+      // MAME
+      if (which!=NULL) ((DivPlatformAY8910*)which)->setCore(0);
+      return true;
+    case DIV_SYSTEM_SAA1099:
+      if (which!=NULL) ((DivPlatformSAA1099*)which)->setCoreQuality(0);
+      return true;
+    case DIV_SYSTEM_ESFM:
+      if (which!=NULL) ((DivPlatformESFM*)which)->setFast(true);
+      return true;
+    case DIV_SYSTEM_POWERNOISE:
+      if (which!=NULL) ((DivPlatformPowerNoise*)which)->setCoreQuality(0);
+      return true;
+    default:
+      break;
+  }
+  return false;
 }
 
 void DivDispatchContainer::flush(size_t offset, size_t count) {
@@ -185,7 +290,7 @@ void DivDispatchContainer::flush(size_t offset, size_t count) {
 void DivDispatchContainer::fillBuf(size_t runtotal, size_t offset, size_t size) {
   CHECK_MISSING_BUFS;
 
-  if (!dispatch->hasAcquireDirect()) {
+  if (!dispatch->hasAcquireDirect() && !idleRun) {
     if (dcOffCompensation && runtotal>0) {
       dcOffCompensation=false;
       if (hiPass) {
@@ -222,6 +327,8 @@ void DivDispatchContainer::clear() {
     temp[i]=0;
     prevSample[i]=0;
   }
+  wasIdle=false;
+  idleRun=false;
 
   if (dispatch->getDCOffRequired() && hiPass) {
     dcOffCompensation=true;
@@ -799,6 +906,8 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       dispatch=new DivPlatformDummy;
       break;
   }
+  // substitute a cheaper core if requested by the load governor
+  if (lowCost) setLowCost(sys,dispatch);
   dispatch->init(eng,chanCount,gotRate,flags);
 
   // initialize output buffers
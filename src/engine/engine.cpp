@@ -26,6 +26,7 @@
 #include "workPool.h"
 #include "../ta-log.h"
 #include "../fileutils.h"
+#include "../startupProfile.h"
 #ifdef HAVE_SDL2
 #include "../audio/sdlAudio.h"
 #endif
@@ -198,14 +199,69 @@ const char* DivEngine::getEffectDesc(unsigned char effect, int chan, bool notNul
   return notNull?_("Invalid effect"):NULL;
 }
 
+bool DivEngine::subSongHasEffects(const unsigned char* effects, int count) {
+  songIndex.refresh(song,chans);
+  for (int i=0; i<count; i++) {
+    if (songIndex.isUsed(DIV_INDEX_EFFECT,effects[i],song,curSubSongIndex)) return true;
+  }
+  return false;
+}
+
+// effects which change the order of playback
+static const unsigned char walkEffects[2]={
+  0x0b, 0x0d
+};
+
+// effects which change the order of playback or the row length
+static const unsigned char lengthEffects[8]={
+  0x09, 0x0b, 0x0d, 0x0f, 0xf0, 0xfd, 0xfe, 0xff
+};
+
 void DivEngine::walkSong(int& loopOrder, int& loopRow, int& loopEnd) {
   if (curSubSong!=NULL) {
+    // without jumps the song plays straight through and never loops
+    if (!subSongHasEffects(walkEffects,2)) {
+      loopOrder=0;
+      loopRow=0;
+      loopEnd=-1;
+      return;
+    }
     curSubSong->walk(loopOrder,loopRow,loopEnd,chans,song.jumpTreatment,song.ignoreJumpAtEnd);
   }
 }
 
 void DivEngine::findSongLength(int loopOrder, int loopRow, double fadeoutLen, int& rowsForFadeout, bool& hasFFxx, std::vector<int>& orders, int& length) {
   if (curSubSong!=NULL) {
+    // without jumps or speed changes every order is played in full at the same row length
+    if (!subSongHasEffects(lengthEffects,8)) {
+      int patLen=curSubSong->patLen;
+      length=0;
+      hasFFxx=false;
+      rowsForFadeout=0;
+      for (int i=0; i<curSubSong->ordersLen; i++) {
+        orders.push_back(patLen);
+        length+=patLen;
+      }
+
+      // count the rows past the loop point which fit in the fadeout
+      int rowsAfterLoop=0;
+      for (int i=MAX(loopOrder,0); i<curSubSong->ordersLen; i++) {
+        if (i==loopOrder) {
+          rowsAfterLoop+=MAX(0,patLen-1-loopRow);
+        } else {
+          rowsAfterLoop+=patLen;
+        }
+      }
+      if (fadeoutLen>0.0) {
+        float secondsPerRow=calcRowLenInSeconds(curSubSong->speeds,curSubSong->hz,curSubSong->virtualTempoN,curSubSong->virtualTempoD,curSubSong->timeBase);
+        double curLen=0.0;
+        while (rowsForFadeout<rowsAfterLoop && curLen<=fadeoutLen) {
+          curLen+=secondsPerRow;
+          rowsForFadeout++;
+        }
+      }
+      return;
+    }
     curSubSong->findLength(loopOrder,loopRow,fadeoutLen,rowsForFadeout,hasFFxx,orders,song.grooves,length,chans,song.jumpTreatment,song.ignoreJumpAtEnd);
   }
 }
@@ -222,11 +278,21 @@ double DivEngine::benchmarkPlayback() {
   remainingLoops=1;
   playSub(false);
 
+  // per-chip time (acquireTime is reset at the beginning of every buffer)
+  uint64_t chipTime[DIV_MAX_CHIPS];
+  memset(chipTime,0,DIV_MAX_CHIPS*sizeof(uint64_t));
+  for (int i=0; i<song.systemLen; i++) {
+    disCont[i].measureTime=true;
+  }
+
   std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
 
   // benchmark
   while (playing) {
     nextBuf(NULL,outBuf,0,2,EXPORT_BUFSIZE);
+    for (int i=0; i<song.systemLen; i++) {
+      chipTime[i]+=disCont[i].acquireTime;
+    }
   }
 
   std::chrono::high_resolution_clock::time_point timeEnd=std::chrono::high_resolution_clock::now();
@@ -234,6 +300,11 @@ double DivEngine::benchmarkPlayback() {
   delete[] outBuf[0];
   delete[] outBuf[1];
 
+  for (int i=0; i<song.systemLen; i++) {
+    disCont[i].measureTime=loadGovernor;
+    printf("[CHIP %d] %s: %fs\n",i+1,getSystemName(song.system[i]),(double)chipTime[i]/1000000000.0);
+  }
+
   double t=(double)(std::chrono::duration_cast<std::chrono::microseconds>(timeEnd-timeStart).count())/1000000.0;
   printf("[RESULT] %fs\n",t);
   return t;
@@ -267,6 +338,42 @@ double DivEngine::benchmarkSeek() {
   return tAvg;
 }
 
+double DivEngine::benchmarkROMExport(DivROMExportOptions which, DivConfig& conf) {
+  DivROMExport* exp=buildROM(which);
+  if (exp==NULL) {
+    logE("could not create exporter!");
+    return 0.0;
+  }
+  exp->setConf(conf);
+
+  std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
+
+  // benchmark
+  if (!exp->go(this)) {
+    logE("could not begin exporting process!");
+    delete exp;
+    return 0.0;
+  }
+  exp->wait();
+
+  std::chrono::high_resolution_clock::time_point timeEnd=std::chrono::high_resolution_clock::now();
+
+  size_t totalSize=0;
+  if (exp->hasFailed()) {
+    logE("ROM export failed! (%s)",getLastError());
+  }
+  for (DivROMExportOutput& i: exp->getResult()) {
+    totalSize+=i.data->size();
+    i.data->finish();
+    delete i.data;
+  }
+  delete exp;
+
+  double t=(double)(std::chrono::duration_cast<std::chrono::microseconds>(timeEnd-timeStart).count())/1000000.0;
+  printf("[RESULT] %fs (%d bytes)\n",t,(int)totalSize);
+  return t;
+}
+
 void DivEngine::notifyInsChange(int ins) {
   BUSY_BEGIN;
   for (int i=0; i<song.systemLen; i++) {
@@ -283,6 +390,14 @@ void DivEngine::notifyWaveChange(int wave) {
   BUSY_END;
 }
 
+void DivEngine::notifyPatternChange(int subsong, int chan, int pat) {
+  songIndex.markDirty(subsong,chan,pat);
+}
+
+void DivEngine::notifyAllPatternsChange() {
+  songIndex.markAllDirty();
+}
+
 int DivEngine::loadSampleROM(String path, ssize_t expectedSize, unsigned char*& ret) {
   ret=NULL;
   if (path.empty()) {
@@ -374,11 +489,27 @@ int DivEngine::loadSampleROMs() {
 }
 
 void DivEngine::renderSamplesP(int whichSample) {
+  // a single sample can be rendered without holding the engine
+  if (whichSample>=0) {
+    if (editSample(whichSample,[](DivSample*) -> bool {
+      return true;
+    })) return;
+  }
   BUSY_BEGIN;
   renderSamples(whichSample);
   BUSY_END;
 }
 
+struct DivSampleRenderJob {
+  DivSong* song;
+  unsigned int formatMask;
+};
+
+static void _renderSample(void* arg, unsigned int i) {
+  DivSampleRenderJob* job=(DivSampleRenderJob*)arg;
+  job->song->sample[i]->render(job->formatMask);
+}
+
 void DivEngine::renderSamples(int whichSample) {
   sPreview.sample=-1;
   sPreview.pos=0;
@@ -396,9 +527,27 @@ void DivEngine::renderSamples(int whichSample) {
 
   // step 1: render samples
   if (whichSample==-1) {
+    // samples are independent of each other, so large sets render in parallel
+    std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
+    size_t totalSamples=0;
     for (int i=0; i<song.sampleLen; i++) {
-      song.sample[i]->render(formatMask);
+      totalSamples+=song.sample[i]->samples;
     }
+    unsigned int threads=0;
+    if (song.sampleLen>1 && totalSamples>=262144) {
+      threads=MIN(16,MIN((unsigned int)song.sampleLen,std::thread::hardware_concurrency()));
+      if (threads<2) threads=0;
+    }
+    DivSampleRenderJob job;
+    job.song=&song;
+    job.formatMask=formatMask;
+    {
+      DivWorkPool pool(threads);
+      threads=pool.getThreads();
+      pool.parallelFor(song.sampleLen,_renderSample,&job);
+    }
+    std::chrono::high_resolution_clock::time_point timeEnd=std::chrono::high_resolution_clock::now();
+    logD("rendered %d samples in %dµs (%d threads)",song.sampleLen,(int)std::chrono::duration_cast<std::chrono::microseconds>(timeEnd-timeStart).count(),threads);
   } else if (whichSample>=0 && whichSample<song.sampleLen) {
     song.sample[whichSample]->render(formatMask);
   }
@@ -411,6 +560,243 @@ void DivEngine::renderSamples(int whichSample) {
   }
 }
 
+DivSample* DivEngine::beginSampleEdit(int index) {
+  collectAssets();
+  if (index<0 || index>=(int)song.sample.size()) return NULL;
+  if (isSampleJobRunning(index)) return NULL;
+
+  // edits are chained on top of a pending edit (if any)
+  DivSample* prev=getLatestSample(index);
+  DivSample* next=new DivSample;
+  if (!next->copyFrom(prev)) {
+    delete next;
+    return NULL;
+  }
+  next->takeHistory(prev);
+  return next;
+}
+
+void DivEngine::commitSampleEdit(int index, DivSample* prev, DivSample* next) {
+  // keep the undo history of the song within the limit.
+  // the oldest steps of the sample with the largest history go first.
+  int histCount=(int)song.sample.size();
+  std::vector<size_t> histMem(histCount);
+  size_t histTotal=0;
+  for (int i=0; i<histCount; i++) {
+    histMem[i]=(i==index)?next->getHistoryMemory():getLatestSample(i)->getHistoryMemory();
+    histTotal+=histMem[i];
+  }
+  while (histTotal>sampleUndoLimit) {
+    int largest=0;
+    for (int i=1; i<histCount; i++) {
+      if (histMem[i]>histMem[largest]) largest=i;
+    }
+    if (histMem[largest]==0) break;
+    DivSample* s=(largest==index)?next:getLatestSample(largest);
+    // don't drop the step which was just made
+    if ((largest==index && s->undoHist.size()<=1) || !s->dropOldestHistory()) {
+      histTotal-=histMem[largest];
+      histMem[largest]=0;
+      continue;
+    }
+    size_t newMem=s->getHistoryMemory();
+    histTotal-=histMem[largest]-newMem;
+    histMem[largest]=newMem;
+  }
+
+  assetSwapLock.lock();
+  retiredSamples.reserve(retiredSamples.size()+pendingSampleSwaps.size()+1);
+  pendingSampleSwaps.push_back(DivAssetSwap(index,prev,next));
+  assetSwapTime=std::chrono::steady_clock::now();
+  assetSwapsPending=true;
+  assetSwapLock.unlock();
+}
+
+bool DivEngine::editSample(int index, const std::function<bool(DivSample*)>& what) {
+  DivSample* next=beginSampleEdit(index);
+  if (next==NULL) return false;
+  DivSample* prev=getLatestSample(index);
+
+  if (!what(next)) {
+    prev->takeHistory(next);
+    delete next;
+    return false;
+  }
+  next->render(getSampleFormatMask());
+
+  commitSampleEdit(index,prev,next);
+  return true;
+}
+
+bool DivEngine::editSampleAsync(int index, const String& name, const std::function<bool(DivSample*)>& what) {
+  if (sampleJob!=NULL) return false;
+  DivSample* next=beginSampleEdit(index);
+  if (next==NULL) return false;
+
+  sampleJob=new DivSampleJob(index,getLatestSample(index),next,name);
+  next->progress=&sampleJob->progress;
+  DivSampleJob* job=sampleJob;
+  unsigned int formatMask=getSampleFormatMask();
+  job->thread=new std::thread([job,what,formatMask]() {
+    job->result=what(job->next);
+    if (job->result && !job->progress.cancel) {
+      job->next->render(formatMask);
+    }
+    job->done=true;
+  });
+  return true;
+}
+
+bool DivEngine::pollSampleJob() {
+  if (sampleJob==NULL) return false;
+  if (!sampleJob->done) return false;
+
+  DivSampleJob* job=sampleJob;
+  sampleJob=NULL;
+  if (job->thread->joinable()) job->thread->join();
+  delete job->thread;
+  job->next->progress=NULL;
+
+  bool ret=false;
+  // the sample may have been deleted or replaced in the meantime
+  bool valid=(job->index<(int)song.sample.size() && getLatestSample(job->index)->serial==job->prevSerial);
+  if (job->result && !job->progress.cancel && valid) {
+    commitSampleEdit(job->index,job->prev,job->next);
+    ret=true;
+  } else {
+    if (valid) {
+      job->prev->takeHistory(job->next);
+    } else {
+      logW("discarding stale edit of sample %d",job->index);
+    }
+    delete job->next;
+  }
+  delete job;
+  return ret;
+}
+
+bool DivEngine::isSampleJobRunning(int index) {
+  if (sampleJob==NULL) return false;
+  return (index<0 || sampleJob->index==index);
+}
+
+float DivEngine::getSampleJobProgress() {
+  if (sampleJob==NULL) return 0.0f;
+  return sampleJob->progress.amount;
+}
+
+String DivEngine::getSampleJobName() {
+  if (sampleJob==NULL) return "";
+  return sampleJob->name;
+}
+
+void DivEngine::cancelSampleJob() {
+  if (sampleJob==NULL) return;
+  sampleJob->progress.cancel=true;
+}
+
+void DivEngine::stopSampleJob() {
+  if (sampleJob==NULL) return;
+  sampleJob->progress.cancel=true;
+  sampleJob->thread->join();
+  pollSampleJob();
+}
+
+bool DivEngine::swapPendingAssets() {
+  bool swapped=false;
+  for (DivAssetSwap& i: pendingSampleSwaps) {
+    if (i.index>=0 && i.index<(int)song.sample.size() && song.sample[i.index]==i.prev) {
+      song.sample[i.index]=i.next;
+      retiredSamples.push_back(i.prev);
+      swapped=true;
+    } else {
+      // the sample was moved or deleted in the meantime
+      logW("discarding stale edit of sample %d",i.index);
+      retiredSamples.push_back(i.next);
+    }
+  }
+  pendingSampleSwaps.clear();
+  assetSwapsPending=false;
+  return swapped;
+}
+
+void DivEngine::applyAssetSwaps() {
+  if (!assetSwapsPending) return;
+  // never wait for the editor or a save in progress here.
+  // the save may be reading the samples we would retire.
+  if (!saveLock.try_lock()) return;
+  if (!assetSwapLock.try_lock()) {
+    saveLock.unlock();
+    return;
+  }
+
+  bool swapped=swapPendingAssets();
+  assetSwapLock.unlock();
+  saveLock.unlock();
+
+  if (swapped) renderSamples(-2);
+}
+
+void DivEngine::flushAssetSwaps() {
+  if (!assetSwapsPending) return;
+  saveLock.lock();
+  assetSwapLock.lock();
+  bool swapped=swapPendingAssets();
+  assetSwapLock.unlock();
+  saveLock.unlock();
+
+  if (swapped) renderSamples(-2);
+}
+
+DivSample* DivEngine::getLatestSample(int index) {
+  assetSwapLock.lock();
+  DivSample* ret=song.sample[index];
+  // follow the chain of pending edits like swapPendingAssets() does.
+  // stale ones (the sample was moved or deleted) are skipped.
+  for (DivAssetSwap& i: pendingSampleSwaps) {
+    if (i.index==index && i.prev==ret) ret=i.next;
+  }
+  assetSwapLock.unlock();
+  return ret;
+}
+
+size_t DivEngine::getSampleHistoryMemory() {
+  size_t ret=0;
+  for (DivSample* i: song.sample) {
+    ret+=i->getHistoryMemory();
+  }
+  return ret;
+}
+
+size_t DivEngine::getSampleHistoryLimit() {
+  return sampleUndoLimit;
+}
+
+bool DivEngine::collectAssets() {
+  if (assetSwapsPending) {
+    assetSwapLock.lock();
+    bool late=(std::chrono::steady_clock::now()-assetSwapTime)>std::chrono::milliseconds(100);
+    assetSwapLock.unlock();
+    if (late) {
+      BUSY_BEGIN;
+      flushAssetSwaps();
+      BUSY_END;
+    }
+  }
+
+  // retired samples are out of the song, but don't free them under a save
+  if (!saveLock.try_lock()) return false;
+  assetSwapLock.lock();
+  bool ret=!retiredSamples.empty();
+  for (DivSample* i: retiredSamples) {
+    delete i;
+  }
+  retiredSamples.clear();
+  assetSwapLock.unlock();
+  saveLock.unlock();
+  return ret;
+}
+
 String DivEngine::decodeSysDesc(String desc) {
   DivConfig newDesc;
   bool hasVal=false;
@@ -539,6 +925,7 @@ void DivEngine::createNew(const char* description, String sysName, bool inBase64
   saveLock.lock();
   song.unload();
   song=DivSong();
+  songIndex.markAllDirty();
   changeSong(0);
   if (description!=NULL) {
     initSongWithDesc(description,inBase64);
@@ -564,6 +951,7 @@ void DivEngine::createNewFromDefaults() {
   saveLock.lock();
   song.unload();
   song=DivSong();
+  songIndex.markAllDirty();
   changeSong(0);
 
   String preset=getConfString("initialSys2","");
@@ -610,6 +998,9 @@ void DivEngine::swapChannels(int src, int dest) {
     DivPattern* prev=curPat[src].data[i];
     curPat[src].data[i]=curPat[dest].data[i];
     curPat[dest].data[i]=prev;
+
+    songIndex.markDirty(curSubSongIndex,src,i);
+    songIndex.markDirty(curSubSongIndex,dest,i);
   }
 
   curPat[src].effectCols^=curPat[dest].effectCols;
@@ -638,6 +1029,7 @@ void DivEngine::stompChannel(int ch) {
   logV("stomping channel %d",ch);
   for (int i=0; i<DIV_MAX_PATTERNS; i++) {
     curOrders->ord[ch][i]=0;
+    songIndex.markDirty(curSubSongIndex,ch,i);
   }
   curPat[ch].wipePatterns();
   curPat[ch].effectCols=1;
@@ -812,6 +1204,7 @@ int DivEngine::duplicateSubSong(int index) {
       DivPattern* origPat=theOrig->pat[i].getPattern(j,false);
       DivPattern* copyPat=theCopy->pat[i].getPattern(j,true);
       origPat->copyOn(copyPat);
+      songIndex.markDirty(song.subsong.size(),i,j);
     }
   }
 
@@ -830,6 +1223,7 @@ bool DivEngine::removeSubSong(int index) {
   song.subsong[index]->clearData();
   delete song.subsong[index];
   song.subsong.erase(song.subsong.begin()+index);
+  songIndex.markAllDirty();
   changeSong(0);
   saveLock.unlock();
   BUSY_END;
@@ -850,6 +1244,7 @@ void DivEngine::moveSubSongUp(size_t index) {
   DivSubSong* prev=song.subsong[index-1];
   song.subsong[index-1]=song.subsong[index];
   song.subsong[index]=prev;
+  songIndex.markAllDirty();
 
   saveLock.unlock();
   BUSY_END;
@@ -869,6 +1264,7 @@ void DivEngine::moveSubSongDown(size_t index) {
   DivSubSong* prev=song.subsong[index+1];
   song.subsong[index+1]=song.subsong[index];
   song.subsong[index]=prev;
+  songIndex.markAllDirty();
 
   saveLock.unlock();
   BUSY_END;
@@ -878,6 +1274,7 @@ void DivEngine::clearSubSongs() {
   BUSY_BEGIN;
   saveLock.lock();
   song.clearSongData();
+  songIndex.markAllDirty();
   changeSong(0);
   curOrder=0;
   prevOrder=0;
@@ -885,25 +1282,21 @@ void DivEngine::clearSubSongs() {
   BUSY_END;
 }
 
+DivSongIndex& DivEngine::getSongIndex() {
+  songIndex.refresh(song,chans);
+  return songIndex;
+}
+
 void DivEngine::delUnusedIns() {
   BUSY_BEGIN;
   saveLock.lock();
 
   bool isUsed[256];
-  memset(isUsed,0,256*sizeof(bool));
 
   // scan
-  for (int i=0; i<chans; i++) {
-    for (size_t j=0; j<song.subsong.size(); j++) {
-      for (int k=0; k<DIV_MAX_PATTERNS; k++) {
-        if (song.subsong[j]->pat[i].data[k]==NULL) continue;
-        for (int l=0; l<song.subsong[j]->patLen; l++) {
-          if (song.subsong[j]->pat[i].data[k]->data[l][2]>=0 && song.subsong[j]->pat[i].data[k]->data[l][2]<256) {
-            isUsed[song.subsong[j]->pat[i].data[k]->data[l][2]]=true;
-          }
-        }
-      }
-    }
+  songIndex.refresh(song,chans);
+  for (int i=0; i<256; i++) {
+    isUsed[i]=songIndex.isUsed(DIV_INDEX_INS,i,song);
   }
   
   // delete
@@ -1081,6 +1474,7 @@ bool DivEngine::changeSystem(int index, DivSystem which, bool preserveOrder) {
 
   song.system[index]=which;
   song.systemFlags[index].clear();
+  songIndex.markAllDirty();
   recalcChans();
   saveLock.unlock();
   BUSY_END;
@@ -1110,6 +1504,7 @@ bool DivEngine::addSystem(DivSystem which) {
   song.systemPan[song.systemLen]=0;
   song.systemPanFR[song.systemLen]=0;
   song.systemFlags[song.systemLen++].clear();
+  songIndex.markAllDirty();
   recalcChans();
   saveLock.unlock();
   BUSY_END;
@@ -1164,6 +1559,7 @@ bool DivEngine::duplicateSystem(int index, bool pat, bool end) {
   song.systemPan[song.systemLen]=song.systemPan[index];
   song.systemPanFR[song.systemLen]=song.systemPanFR[index];
   song.systemFlags[song.systemLen++]=song.systemFlags[index];
+  songIndex.markAllDirty();
   recalcChans();
   saveLock.unlock();
   BUSY_END;
@@ -1235,6 +1631,7 @@ bool DivEngine::duplicateSystem(int index, bool pat, bool end) {
       swapSystemUnsafe(i,i-1,false);
     }
 
+    songIndex.markAllDirty();
     recalcChans();
     saveLock.unlock();
     BUSY_END;
@@ -1290,6 +1687,7 @@ bool DivEngine::removeSystem(int index, bool preserveOrder) {
     song.systemPanFR[i]=song.systemPanFR[i+1];
     song.systemFlags[i]=song.systemFlags[i+1];
   }
+  songIndex.markAllDirty();
   recalcChans();
   saveLock.unlock();
   BUSY_END;
@@ -1442,6 +1840,7 @@ bool DivEngine::swapSystem(int src, int dest, bool preserveOrder) {
 
   swapSystemUnsafe(src,dest,preserveOrder);
 
+  songIndex.markAllDirty();
   recalcChans();
   saveLock.unlock();
   BUSY_END;
@@ -1482,7 +1881,6 @@ String DivEngine::getPlaybackDebugInfo() {
     "curRow: %d\n"
     "prevRow: %d\n"
     "ticks: %d\n"
-    "subticks: %d\n"
     "totalLoops: %d\n"
     "lastLoopPos: %d\n"
     "nextSpeed: %d\n"
@@ -1508,7 +1906,7 @@ String DivEngine::getPlaybackDebugInfo() {
     "tempoAccum: %d\n"
     "totalProcessed: %d\n"
     "bufferPos: %d\n",
-    curOrder,prevOrder,curRow,prevRow,ticks,subticks,totalLoops,lastLoopPos,nextSpeed,divider,cycles,clockDrift,
+    curOrder,prevOrder,curRow,prevRow,ticks,totalLoops,lastLoopPos,nextSpeed,divider,cycles,clockDrift,
     midiClockCycles,midiClockDrift,midiTimeCycles,midiTimeDrift,changeOrd,changePos,totalSeconds,totalTicks,
     totalTicksR,curMidiClock,curMidiTime,totalCmds,lastCmds,cmdsPerSecond,globalPitch,
     (int)extValue,(int)tempoAccum,(int)totalProcessed,(int)bufferPos
@@ -1742,7 +2140,6 @@ void DivEngine::playSub(bool preserveDrift, int goalRow) {
   }
   if (!preserveDrift) {
     ticks=1;
-    subticks=1;
     prevOrder=curOrder;
     prevRow=curRow;
     prevSpeed=nextSpeed;
@@ -2477,6 +2874,10 @@ bool DivEngine::isPlaying() {
   return (playing && !freelance);
 }
 
+bool DivEngine::isInputSubTick() {
+  return inputSubTick;
+}
+
 bool DivEngine::isRunning() {
   return playing;
 }
@@ -2686,16 +3087,18 @@ void DivEngine::delInstrumentUnsafe(int index) {
     delete song.ins[index];
     song.ins.erase(song.ins.begin()+index);
     song.insLen=song.ins.size();
-    for (int i=0; i<chans; i++) {
-      for (size_t j=0; j<song.subsong.size(); j++) {
-        for (int k=0; k<DIV_MAX_PATTERNS; k++) {
-          if (song.subsong[j]->pat[i].data[k]==NULL) continue;
-          for (int l=0; l<song.subsong[j]->patLen; l++) {
-            if (song.subsong[j]->pat[i].data[k]->data[l][2]>index) {
-              song.subsong[j]->pat[i].data[k]->data[l][2]--;
-            }
-          }
-        }
+
+    // renumber the instruments after this one
+    std::vector<DivSongIndexLoc> locs;
+    songIndex.refresh(song,chans);
+    for (int i=index+1; i<256; i++) {
+      locs.clear();
+      songIndex.find(DIV_INDEX_INS,i,-1,locs);
+      for (DivSongIndexLoc& j: locs) {
+        DivSubSong* sub=song.subsong[j.subsong];
+        if (j.row>=sub->patLen) continue;
+        sub->pat[j.chan].data[j.pat]->data[j.row][2]--;
+        songIndex.replace(DIV_INDEX_INS,i,i-1,j);
       }
     }
     removeAsset(song.insDir,index);
@@ -3054,6 +3457,7 @@ void DivEngine::deepCloneOrder(int pos, bool where) {
         DivPattern* oldPat=curPat[i].getPattern(origOrd,false);
         DivPattern* pat=curPat[i].getPattern(j,true);
         memcpy(pat->data,oldPat->data,DIV_MAX_ROWS*DIV_MAX_COLS*sizeof(short));
+        songIndex.markDirty(curSubSongIndex,i,j);
         logD("found at %d",j);
         didNotFind=false;
         break;
@@ -3154,19 +3558,22 @@ void DivEngine::moveOrderDown(int& pos) {
 }
 
 void DivEngine::exchangeIns(int one, int two) {
-  for (int i=0; i<chans; i++) {
-    for (size_t j=0; j<song.subsong.size(); j++) {
-      for (int k=0; k<DIV_MAX_PATTERNS; k++) {
-        if (song.subsong[j]->pat[i].data[k]==NULL) continue;
-        for (int l=0; l<song.subsong[j]->patLen; l++) {
-          if (song.subsong[j]->pat[i].data[k]->data[l][2]==one) {
-            song.subsong[j]->pat[i].data[k]->data[l][2]=two;
-          } else if (song.subsong[j]->pat[i].data[k]->data[l][2]==two) {
-            song.subsong[j]->pat[i].data[k]->data[l][2]=one;
-          }
-        }
-      }
-    }
+  if (one==two) return;
+  std::vector<DivSongIndexLoc> locsOne, locsTwo;
+  songIndex.refresh(song,chans);
+  songIndex.find(DIV_INDEX_INS,one,-1,locsOne);
+  songIndex.find(DIV_INDEX_INS,two,-1,locsTwo);
+  for (DivSongIndexLoc& i: locsOne) {
+    DivSubSong* sub=song.subsong[i.subsong];
+    if (i.row>=sub->patLen) continue;
+    sub->pat[i.chan].data[i.pat]->data[i.row][2]=two;
+    songIndex.replace(DIV_INDEX_INS,one,two,i);
+  }
+  for (DivSongIndexLoc& i: locsTwo) {
+    DivSubSong* sub=song.subsong[i.subsong];
+    if (i.row>=sub->patLen) continue;
+    sub->pat[i.chan].data[i.pat]->data[i.row][2]=one;
+    songIndex.replace(DIV_INDEX_INS,two,one,i);
   }
 }
 
@@ -3601,6 +4008,12 @@ void DivEngine::setAudio(DivAudioEngines which) {
   audioEngine=which;
 }
 
+void DivEngine::setPipeOptions(int format, int header, int realTime) {
+  if (format>=0) pipeFormat=format;
+  if (header>=0) pipeHeader=header;
+  if (realTime>=0) pipeRealTime=realTime;
+}
+
 void DivEngine::setView(DivStatusView which) {
   view=which;
 }
@@ -3627,6 +4040,74 @@ void DivEngine::setConsoleMode(bool enable, bool statusOut) {
   disableStatusOut=!statusOut;
 }
 
+void DivEngine::swapDispatchCore(int sys, bool lowCost) {
+  if (sys<0 || sys>=song.systemLen) return;
+  logI("load governor: chip %d (%s) now using its %s core",sys+1,getSystemName(song.system[sys]),lowCost?"cheapest":"configured");
+
+  disCont[sys].quit();
+  disCont[sys].lowCost=lowCost;
+  disCont[sys].init(song.system[sys],this,getChannelCount(song.system[sys]),got.rate,song.systemFlags[sys]);
+  disCont[sys].setRates(got.rate);
+  disCont[sys].setQuality(lowQuality,dcHiPass);
+  disCont[sys].dispatch->renderSamples(sys);
+
+  // carry the channel state over.
+  // seeking would reset every chip and cause a glitch.
+  DivDispatch* disp=disCont[sys].dispatch;
+  for (int i=0; i<chans; i++) {
+    if (dispatchOfChan[i]!=sys) continue;
+    int dch=dispatchChanOfChan[i];
+    disp->muteChannel(dch,isMuted[i]);
+    if (!playing || freelance) continue;
+    if (chan[i].lastIns>=0) disp->dispatch(DivCommand(DIV_CMD_INSTRUMENT,dch,chan[i].lastIns,1));
+    disp->dispatch(DivCommand(DIV_CMD_VOLUME,dch,chan[i].volume>>8));
+    disp->dispatch(DivCommand(DIV_CMD_PANNING,dch,chan[i].panL,chan[i].panR));
+    if (chan[i].keyOn && !chan[i].releasing && chan[i].note!=-1) {
+      disp->dispatch(DivCommand(DIV_CMD_NOTE_ON,dch,chan[i].note));
+      disp->dispatch(DivCommand(DIV_CMD_PITCH,dch,chan[i].pitch));
+    }
+  }
+}
+
+bool DivEngine::isChipSilent(int sys) {
+  for (int i=0; i<chans; i++) {
+    if (dispatchOfChan[i]!=sys) continue;
+    if (chan[i].keyOn && !chan[i].releasing) return false;
+  }
+  return true;
+}
+
+bool DivEngine::updateLoadGovernor() {
+  int req=governorRequest.exchange(-1);
+  if (req>=0) {
+    governorPending=req;
+    governorPendingTime=std::chrono::steady_clock::now();
+  }
+  if (governorPending<0) return false;
+  bool ret=false;
+  BUSY_BEGIN;
+  int sys=governorPending>>1;
+  bool lowCost=governorPending&1;
+  if (sys<song.systemLen && disCont[sys].dispatch!=NULL && disCont[sys].lowCost!=lowCost && !exporting) {
+    // wait for the chip to go silent, but not forever (the audio is breaking up)
+    bool late=(std::chrono::steady_clock::now()-governorPendingTime)>std::chrono::seconds(2);
+    if (!playing || isChipSilent(sys) || late) {
+      swapDispatchCore(sys,lowCost);
+      governorPending=-1;
+      ret=true;
+    }
+  } else {
+    governorPending=-1;
+  }
+  BUSY_END;
+  return ret;
+}
+
+bool DivEngine::isLowCostCore(int sys) {
+  if (sys<0 || sys>=song.systemLen) return false;
+  return disCont[sys].lowCost;
+}
+
 bool DivEngine::switchMaster(bool full) {
   logI("switching output...");
   deinitAudioBackend(true);
@@ -3715,6 +4196,7 @@ void DivEngine::lockSave(const std::function<void()>& what) {
 
 void DivEngine::lockEngine(const std::function<void()>& what) {
   BUSY_BEGIN;
+  flushAssetSwaps();
   saveLock.lock();
   what();
   saveLock.unlock();
@@ -3778,6 +4260,7 @@ void DivEngine::initDispatch(bool isRender) {
     disCont[i].init(song.system[i],this,getChannelCount(song.system[i]),got.rate,song.systemFlags[i],isRender);
     disCont[i].setRates(got.rate);
     disCont[i].setQuality(lowQuality,dcHiPass);
+    disCont[i].idleSkip=getConfInt("idleChipSkip",1);
   }
   if (song.patchbayAuto) {
     saveLock.lock();
@@ -3789,11 +4272,19 @@ void DivEngine::initDispatch(bool isRender) {
 }
 
 void DivEngine::quitDispatch() {
+  stopSampleJob();
   BUSY_BEGIN;
+  // commit pending edits before the song goes away
+  flushAssetSwaps();
   logV("terminating dispatch...");
   for (int i=0; i<song.systemLen; i++) {
     disCont[i].quit();
+    disCont[i].lowCost=false;
   }
+  governorRequest=-1;
+  governorOver=0;
+  governorUnder=0;
+  governorHold=0;
   cycles=0;
   clockDrift=0;
   midiClockCycles=0;
@@ -3860,6 +4351,11 @@ bool DivEngine::initAudioBackend() {
   forceMono=getConfInt("forceMono",0);
   clampSamples=getConfInt("clampSamples",0);
   lowLatency=getConfInt("lowLatency",0);
+  loadGovernor=getConfInt("loadGovernor",0);
+  for (int i=0; i<DIV_MAX_CHIPS; i++) {
+    disCont[i].measureTime=loadGovernor;
+  }
+  sampleUndoLimit=(size_t)MAX(1,getConfInt("sampleUndoMemory",256))<<20;
   metroVol=(float)(getConfInt("metroVol",100))/100.0f;
   previewVol=(float)(getConfInt("sampleVol",50))/100.0f;
   midiOutClock=getConfInt("midiOutClock",0);
@@ -3914,9 +4410,17 @@ bool DivEngine::initAudioBackend() {
       output=new TAAudio;
 #endif
       break;
-    case DIV_AUDIO_PIPE:
-      output=new TAAudioPipe;
+    case DIV_AUDIO_PIPE: {
+      TAAudioPipe* pipeOut=new TAAudioPipe;
+      pipeOut->setOptions(
+        (TAPipeFormat)CLAMP((pipeFormat>=0)?pipeFormat:getConfInt("pipeFormat",0),0,2),
+        (TAPipeHeader)CLAMP((pipeHeader>=0)?pipeHeader:getConfInt("pipeHeader",0),0,2),
+        (pipeRealTime>=0)?pipeRealTime:getConfInt("pipeRealTime",0),
+        getConfInt("pipeBatch",4)
+      );
+      output=pipeOut;
       break;
+    }
     case DIV_AUDIO_DUMMY:
       output=new TAAudio;
       break;
@@ -4039,10 +4543,16 @@ bool DivEngine::preInit(bool noSafeMode) {
   logI("Furnace version " DIV_VERSION ".");
 
   // register systems
-  if (!systemsRegistered) registerSystems();
+  if (!systemsRegistered) {
+    StartupProfileScope profile("register systems");
+    registerSystems();
+  }
 
   // register ROM exports
-  if (!romExportsRegistered) registerROMExports();
+  if (!romExportsRegistered) {
+    StartupProfileScope profile("register ROM exports");
+    registerROMExports();
+  }
 
   // TODO: re-enable with a better approach
   // see issue #1581
@@ -4097,8 +4607,109 @@ void DivEngine::everythingOK() {
   */
 }
 
+short DivEngine::vibTable[64];
+short DivEngine::tremTable[128];
+int DivEngine::reversePitchTable[4096];
+int DivEngine::pitchTable[4096];
+bool DivEngine::tablesReady=false;
+
+bool DivEngine::initRenderState() {
+  logV("creating blip_buf");
+
+  samp_bb=blip_new(32768);
+  if (samp_bb==NULL) {
+    logE("not enough memory!");
+    return false;
+  }
+  blip_set_dc(samp_bb,0);
+
+  samp_bbOut=new short[32768];
+
+  samp_bbIn=new short[32768];
+  samp_bbInLen=32768;
+
+  metroBuf=new float[8192];
+  metroBufLen=8192;
+
+  logV("setting blip rate of samp_bb (%f)",got.rate);
+  
+  blip_set_rates(samp_bb,44100,got.rate);
+
+  if (!tablesReady) {
+    StartupProfileScope profile("lookup tables");
+    for (int i=0; i<64; i++) {
+      vibTable[i]=127*sin(((double)i/64.0)*(2*M_PI));
+    }
+    for (int i=0; i<128; i++) {
+      tremTable[i]=255*0.5*(1.0-cos(((double)i/128.0)*(2*M_PI)));
+    }
+    for (int i=0; i<4096; i++) {
+      reversePitchTable[i]=round(1024.0*pow(2.0,(2048.0-(double)i)/(12.0*128.0)));
+      pitchTable[i]=round(1024.0*pow(2.0,((double)i-2048.0)/(12.0*128.0)));
+    }
+    tablesReady=true;
+  }
+
+  for (int i=0; i<DIV_MAX_CHANS; i++) {
+    isMuted[i]=0;
+    keyHit[i]=false;
+  }
+  return true;
+}
+
+DivEngine* DivEngine::createSnapshot() {
+  // the .fur writer already copies every part of the song
+  SafeWriter* w=saveFur(true);
+  if (w==NULL) return NULL;
+  size_t len=w->size();
+  unsigned char* data=new unsigned char[len];
+  memcpy(data,w->getFinalBuf(),len);
+  w->finish();
+  delete w;
+
+  DivEngine* snap=new DivEngine;
+  snap->conf=conf;
+  snap->systemsRegistered=true;
+  snap->romExportsRegistered=true;
+  snap->hasLoadedSomething=true;
+  snap->got=got;
+  if (snap->got.rate<=0) snap->got.rate=44100;
+
+  // loadFur() takes ownership of data
+  if (!snap->loadFur(data,len)) {
+    logE("could not create snapshot! (%s)",snap->lastError);
+    lastError=snap->lastError;
+    delete snap;
+    return NULL;
+  }
+  snap->changeSong(curSubSongIndex);
+  snap->loadSampleROMs();
+  if (!snap->initRenderState()) {
+    lastError="not enough memory";
+    snap->song.unload();
+    delete snap;
+    return NULL;
+  }
+  snap->initDispatch();
+  snap->renderSamples();
+  snap->reset();
+  snap->active=true;
+  return snap;
+}
+
+void DivEngine::destroySnapshot(DivEngine* snap) {
+  if (snap==NULL) return;
+  snap->quit(false);
+  if (snap->samp_bb!=NULL) blip_delete(snap->samp_bb);
+  delete[] snap->samp_bbOut;
+  delete[] snap->samp_bbIn;
+  delete snap;
+}
+
 bool DivEngine::init() {
+  startupProfileBegin("sample ROMs");
   loadSampleROMs();
+  startupProfileEnd();
 
   // set default system preset
   if (!hasLoadedSomething) {
@@ -4126,51 +4737,22 @@ bool DivEngine::init() {
 
   // init the rest of engine
   bool haveAudio=false;
+  startupProfileBegin("audio backend");
   if (!initAudioBackend()) {
     logE("no audio output available!");
   } else {
     haveAudio=true;
   }
+  startupProfileEnd();
 
-  logV("creating blip_buf");
-
-  samp_bb=blip_new(32768);
-  if (samp_bb==NULL) {
-    logE("not enough memory!");
-    return false;
-  }
-  blip_set_dc(samp_bb,0);
-
-  samp_bbOut=new short[32768];
-
-  samp_bbIn=new short[32768];
-  samp_bbInLen=32768;
-
-  metroBuf=new float[8192];
-  metroBufLen=8192;
-
-  logV("setting blip rate of samp_bb (%f)",got.rate);
-  
-  blip_set_rates(samp_bb,44100,got.rate);
-
-  for (int i=0; i<64; i++) {
-    vibTable[i]=127*sin(((double)i/64.0)*(2*M_PI));
-  }
-  for (int i=0; i<128; i++) {
-    tremTable[i]=255*0.5*(1.0-cos(((double)i/128.0)*(2*M_PI)));
-  }
-  for (int i=0; i<4096; i++) {
-    reversePitchTable[i]=round(1024.0*pow(2.0,(2048.0-(double)i)/(12.0*128.0)));
-    pitchTable[i]=round(1024.0*pow(2.0,((double)i-2048.0)/(12.0*128.0)));
-  }
-
-  for (int i=0; i<DIV_MAX_CHANS; i++) {
-    isMuted[i]=0;
-    keyHit[i]=false;
-  }
+  if (!initRenderState()) return false;
 
+  startupProfileBegin("dispatch");
   initDispatch();
+  startupProfileEnd();
+  startupProfileBegin("render samples");
   renderSamples();
+  startupProfileEnd();
   reset();
   active=true;
 
@@ -4192,6 +4774,7 @@ bool DivEngine::init() {
 bool DivEngine::quit(bool saveConfig) {
   deinitAudioBackend();
   quitDispatch();
+  collectAssets();
   if (saveConfig) {
     logI("saving config.");
     saveConf();
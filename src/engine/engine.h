@@ -22,6 +22,7 @@
 #include "config.h"
 #include "instrument.h"
 #include "song.h"
+#include "songIndex.h"
 #include "dispatch.h"
 #include "effect.h"
 #include "export.h"
@@ -30,6 +31,7 @@
 #include "cmdStream.h"
 #include "../audio/taAudio.h"
 #include "blip_buf.h"
+#include <chrono>
 #include <functional>
 #include <initializer_list>
 #include <thread>
@@ -103,7 +105,10 @@ enum DivMIDIModes {
 
 enum DivAudioExportFormats {
   DIV_EXPORT_FORMAT_S16=0,
-  DIV_EXPORT_FORMAT_F32
+  DIV_EXPORT_FORMAT_F32,
+  // these require libsndfile with external codecs
+  DIV_EXPORT_FORMAT_FLAC,
+  DIV_EXPORT_FORMAT_OPUS
 };
 
 struct DivAudioExportOptions {
@@ -130,6 +135,34 @@ struct DivAudioExportOptions {
   }
 };
 
+// patchbay sources: chip outputs (DIV_MAX_OUTPUTS per chip), sample preview and metronome
+#define DIV_PATCH_PREVIEW (DIV_MAX_CHIPS*DIV_MAX_OUTPUTS)
+#define DIV_PATCH_METRONOME (DIV_PATCH_PREVIEW+1)
+#define DIV_PATCH_SOURCES (DIV_PATCH_PREVIEW+2)
+
+// the patchbay compiled into a gain matrix.
+// rebuilt when the patchbay, a volume or a panning changes.
+struct DivPatchbayMatrix {
+  // gain of every source in every output
+  float gain[DIV_MAX_OUTPUTS][DIV_PATCH_SOURCES];
+  // sources with non-zero gain in every output
+  unsigned short active[DIV_MAX_OUTPUTS][DIV_PATCH_SOURCES];
+  int activeLen[DIV_MAX_OUTPUTS];
+  // what the matrix was compiled from
+  std::vector<unsigned int> patchbay;
+  float params[DIV_MAX_CHIPS*5+1];
+  int systemLen, outChans;
+  bool valid;
+  DivPatchbayMatrix():
+    systemLen(0),
+    outChans(0),
+    valid(false) {
+    memset(gain,0,sizeof(gain));
+    memset(activeLen,0,sizeof(activeLen));
+    memset(params,0,sizeof(params));
+  }
+};
+
 struct DivChannelState {
   std::vector<DivDelayedCommand> delayed;
   int note, oldNote, lastIns, pitch, portaSpeed, portaNote;
@@ -252,7 +285,16 @@ struct DivDispatchContainer {
   short* bbIn[DIV_MAX_OUTPUTS];
   short* bbOut[DIV_MAX_OUTPUTS];
   bool lowQuality, dcOffCompensation, hiPass;
+  // use the cheapest core (set by the load governor)
+  bool lowCost;
+  // fast-forward the chip while it is idle
+  // wasIdle: the last acquire() ran normally while idle, so the output is at its idle level
+  // idleRun: the last acquire() was skipped, so fillBuf() has nothing to scan
+  bool idleSkip, wasIdle, idleRun;
   double rateMemory;
+  // time spent in acquire() in nanoseconds. only measured if measureTime is set
+  uint64_t acquireTime;
+  bool measureTime;
 
   // used in multi-thread
   int cycles;
@@ -267,6 +309,8 @@ struct DivDispatchContainer {
   void clear();
   void init(DivSystem sys, DivEngine* eng, int chanCount, double gotRate, const DivConfig& flags, bool isRender=false);
   void quit();
+  // switch a dispatch (before init) to the cheapest core. if NULL, only check whether one exists.
+  static bool setLowCost(DivSystem sys, DivDispatch* which);
   DivDispatchContainer():
     dispatch(NULL),
     bbInLen(0),
@@ -277,7 +321,13 @@ struct DivDispatchContainer {
     lowQuality(false),
     dcOffCompensation(false),
     hiPass(true),
+    lowCost(false),
+    idleSkip(true),
+    wasIdle(false),
+    idleRun(false),
     rateMemory(0.0),
+    acquireTime(0),
+    measureTime(false),
     cycles(0),
     size(0) {
     memset(bb,0,DIV_MAX_OUTPUTS*sizeof(blip_buffer_t*));
@@ -332,6 +382,23 @@ struct DivDoNotHandleEffect {
 
 typedef std::unordered_map<unsigned char,const EffectHandler> EffectHandlerMap;
 
+// an effect of a pattern row, with its per-system handlers already looked up
+struct DivRowEffect {
+  const EffectHandler* handler;
+  const EffectHandler* postHandler;
+  const EffectHandler* preHandler;
+  short effect;
+  unsigned char val;
+};
+
+// the non-empty effects of a channel's row, decoded once per row
+struct DivRowProgram {
+  DivRowEffect fx[DIV_MAX_EFFECTS];
+  unsigned char fxLen;
+  DivRowProgram():
+    fxLen(0) {}
+};
+
 struct DivSysDef {
   const char* name;
   const char* nameJ;
@@ -354,6 +421,10 @@ struct DivSysDef {
   const EffectHandlerMap effectHandlers;
   const EffectHandlerMap postEffectHandlers;
   const EffectHandlerMap preEffectHandlers;
+  // flat lookup tables for the maps above (NULL if not handled)
+  const EffectHandler* effectHandlerTable[256];
+  const EffectHandler* postEffectHandlerTable[256];
+  const EffectHandler* preEffectHandlerTable[256];
   DivSysDef(
     const char* sysName, const char* sysNameJ, unsigned char fileID, unsigned char fileID_DMF, int chans,
     bool isFMChip, bool isSTDChip, unsigned int vgmVer, bool compound, unsigned int formatMask, unsigned short waveWid, unsigned short waveHei,
@@ -390,6 +461,13 @@ struct DivSysDef {
       chanInsType[i][1]=DIV_INS_NULL;
     }
 
+    memset(effectHandlerTable,0,256*sizeof(void*));
+    memset(postEffectHandlerTable,0,256*sizeof(void*));
+    memset(preEffectHandlerTable,0,256*sizeof(void*));
+    for (auto& i: effectHandlers) effectHandlerTable[i.first]=&i.second;
+    for (auto& i: postEffectHandlers) postEffectHandlerTable[i.first]=&i.second;
+    for (auto& i: preEffectHandlers) preEffectHandlerTable[i.first]=&i.second;
+
     int index=0;
     for (const char* i: chNames) {
       chanNames[index++]=i;
@@ -465,6 +543,8 @@ class DivEngine {
   bool midiIsDirect;
   bool midiIsDirectProgram;
   bool lowLatency;
+  bool inputSubTick;
+  bool loadGovernor;
   bool systemsRegistered;
   bool romExportsRegistered;
   bool hasLoadedSomething;
@@ -475,7 +555,7 @@ class DivEngine {
   int midiOutTimeRate;
   float midiVolExp;
   int softLockCount;
-  int subticks, ticks, curRow, curOrder, prevRow, prevOrder, remainingLoops, totalLoops, lastLoopPos, exportLoopCount, curExportChan, nextSpeed, prevSpeed, elapsedBars, elapsedBeats, curSpeed;
+  int ticks, curRow, curOrder, prevRow, prevOrder, remainingLoops, totalLoops, lastLoopPos, exportLoopCount, curExportChan, nextSpeed, prevSpeed, elapsedBars, elapsedBeats, curSpeed;
   size_t curSubSongIndex;
   size_t bufferPos;
   double divider;
@@ -496,6 +576,8 @@ class DivEngine {
   DivStatusView view;
   DivHaltPositions haltOn;
   DivChannelState chan[DIV_MAX_CHANS];
+  DivRowProgram rowProgram[DIV_MAX_CHANS];
+  DivSongIndex songIndex;
   DivAudioEngines audioEngine;
   DivAudioExportModes exportMode;
   DivAudioExportFormats exportFormat;
@@ -503,6 +585,8 @@ class DivEngine {
   bool isFadingOut;
   int exportOutputs;
   bool exportChannelMask[DIV_MAX_CHANS];
+  std::atomic<int> exportQueued;
+  std::atomic<size_t> exportFramesWritten;
   DivConfig conf;
   FixedQueue<DivNoteEvent,8192> pendingNotes;
   // bitfield
@@ -547,10 +631,12 @@ class DivEngine {
       dir(false) {}
   } sPreview;
 
-  short vibTable[64];
-  short tremTable[128];
-  int reversePitchTable[4096];
-  int pitchTable[4096];
+  // lookup tables are shared by every instance and computed once
+  static short vibTable[64];
+  static short tremTable[128];
+  static int reversePitchTable[4096];
+  static int pitchTable[4096];
+  static bool tablesReady;
   short effectSlotMap[4096];
   int midiBaseChan;
   bool midiPoly;
@@ -570,12 +656,66 @@ class DivEngine {
   float metroAmp;
   float metroVol;
   float previewVol;
+  DivPatchbayMatrix patchMatrix;
 
   size_t totalProcessed;
+  size_t sampleUndoLimit;
 
   unsigned int renderPoolThreads;
   DivWorkPool* renderPool;
 
+  // pipe backend options (-1 means use configuration)
+  int pipeFormat, pipeHeader, pipeRealTime;
+
+  // copy-on-write asset edits
+  // a new version is published by the editor and picked up by the audio thread
+  // at the next buffer boundary. the old version is retired and freed later.
+  struct DivAssetSwap {
+    int index;
+    DivSample* prev;
+    DivSample* next;
+    DivAssetSwap(int i, DivSample* p, DivSample* n):
+      index(i),
+      prev(p),
+      next(n) {}
+  };
+  std::mutex assetSwapLock;
+  std::vector<DivAssetSwap> pendingSampleSwaps;
+  std::vector<DivSample*> retiredSamples;
+  std::atomic<bool> assetSwapsPending;
+  std::chrono::steady_clock::time_point assetSwapTime;
+
+  // background sample edit (see editSampleAsync())
+  struct DivSampleJob {
+    int index;
+    DivSample* prev;
+    // serial of prev (prev may be freed and its address reused while the job runs)
+    unsigned int prevSerial;
+    DivSample* next;
+    String name;
+    std::thread* thread;
+    std::atomic<bool> done;
+    bool result;
+    DivSampleProgress progress;
+    DivSampleJob(int i, DivSample* p, DivSample* n, const String& nm):
+      index(i),
+      prev(p),
+      prevSerial(p->serial),
+      next(n),
+      name(nm),
+      thread(NULL),
+      done(false),
+      result(false) {}
+  };
+  DivSampleJob* sampleJob;
+
+  // load governor state. the audio thread requests a core swap (chip<<1|lowCost),
+  // which is carried out by updateLoadGovernor() once the chip is silent.
+  int governorOver, governorUnder, governorHold;
+  std::atomic<int> governorRequest;
+  int governorPending;
+  std::chrono::steady_clock::time_point governorPendingTime;
+
   // MIDI stuff
   std::function<int(const TAMidiMessage&)> midiCallback=[](const TAMidiMessage&) -> int {return -3;};
 
@@ -585,10 +725,15 @@ class DivEngine {
   void nextRow();
   void performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write, int streamOff, double* loopTimer, double* loopFreq, int* loopSample, bool* sampleDir, bool isSecond, int* pendingFreq, int* playingSample, int* setPos, unsigned int* sampleOff8, unsigned int* sampleLen8, size_t bankOffset, bool directStream, bool* sampleStoppable, bool dpcm07, DivDispatch** writeNES, int rateCorrection);
   // returns true if end of song.
-  bool nextTick(bool noAccum=false, bool inhibitLowLat=false);
-  bool perSystemEffect(int ch, unsigned char effect, unsigned char effectVal);
-  bool perSystemPostEffect(int ch, unsigned char effect, unsigned char effectVal);
-  bool perSystemPreEffect(int ch, unsigned char effect, unsigned char effectVal);
+  bool nextTick(bool noAccum=false);
+  // send pending live notes to the dispatches.
+  void processPendingNotes();
+  // low-latency mode: apply pending live notes in the middle of a tick.
+  void nextSubTick();
+  // decode the effects of a pattern row into prog
+  void compileRow(int ch, DivPattern* pat, int row, DivRowProgram& prog);
+  // run a per-system effect handler. returns false if handler is NULL, or notHandledResult if the handler rejects the effect.
+  bool runEffectHandler(int ch, const EffectHandler* handler, unsigned char effect, unsigned char effectVal, bool notHandledResult);
   void recalcChans();
   void reset();
   void playSub(bool preserveDrift, int goalRow=0);
@@ -600,6 +745,7 @@ class DivEngine {
 
   bool loadDMF(unsigned char* file, size_t len);
   bool loadFur(unsigned char* file, size_t len, int variantID=0);
+  bool initRenderState();
   bool loadMod(unsigned char* file, size_t len);
   bool loadS3M(unsigned char* file, size_t len);
   bool loadXM(unsigned char* file, size_t len);
@@ -644,6 +790,9 @@ class DivEngine {
   void registerROMExports();
   void initSongWithDesc(const char* description, bool inBase64=true, bool oldVol=false);
 
+  // whether the current subsong contains any of the given effects (looked up in the song index)
+  bool subSongHasEffects(const unsigned char* effects, int count);
+
   void exchangeIns(int one, int two);
   void exchangeWave(int one, int two);
   void exchangeSample(int one, int two);
@@ -654,6 +803,30 @@ class DivEngine {
   // recalculate patchbay (UNSAFE)
   void recalcPatchbay();
 
+  // rebuild the patchbay gain matrix if anything it depends on has changed (UNSAFE)
+  void updatePatchbayMatrix(int outChans);
+
+  // apply pending copy-on-write asset edits (UNSAFE)
+  void applyAssetSwaps();
+  // same as above, but waits for a save in progress (UNSAFE)
+  void flushAssetSwaps();
+  // swap pending assets in. saveLock and assetSwapLock must be held (UNSAFE)
+  bool swapPendingAssets();
+
+  // check the audio load and request a core swap if necessary (UNSAFE)
+  void runLoadGovernor(size_t size);
+
+  // copy-on-write helpers. the first one returns a private copy of a sample, taking its history.
+  DivSample* beginSampleEdit(int index);
+  void commitSampleEdit(int index, DivSample* prev, DivSample* next);
+  // cancel the background sample edit and wait for it
+  void stopSampleJob();
+
+  // re-create a chip with its configured or its cheapest core, carrying the channel state over (UNSAFE)
+  void swapDispatchCore(int sys, bool lowCost);
+  // whether no channel of a chip is playing a note (UNSAFE)
+  bool isChipSilent(int sys);
+
   // change song (UNSAFE)
   void changeSong(size_t songIndex);
 
@@ -692,7 +865,6 @@ class DivEngine {
     float* oscBuf[DIV_MAX_OUTPUTS];
     float oscSize;
     int oscReadPos, oscWritePos;
-    int tickMult;
     int lastNBIns, lastNBOuts, lastNBSize;
     std::atomic<size_t> processTime;
 
@@ -733,10 +905,18 @@ class DivEngine {
     SafeWriter* saveTiuna(const bool* sysToExport, const char* baseLabel, int firstBankSize, int otherBankSize);
     // dump command stream.
     SafeWriter* saveCommand(DivCSProgress* progress=NULL, DivCSOptions options=DivCSOptions());
+    // measure the cost of playing the command stream with the 6502 player.
+    // player is a binary of src/asm/6502/stream.s, and symbols is its WLA-DX symbol file.
+    // returns false and sets lastError on failure.
+    bool profileCommandStream(const unsigned char* player, size_t playerLen, const String& symbols, const DivConfig& conf, DivCSProfile& result);
     // export to text
     SafeWriter* saveText(bool separatePatterns=true);
     // export to an audio file
     bool saveAudio(const char* path, DivAudioExportOptions options);
+    // get file extension of an audio export format
+    static const char* getAudioExportExt(DivAudioExportFormats format);
+    // check whether an audio export format is supported by this build, with the given channel count (and rate, if not 0)
+    static bool isAudioExportFormatAvailable(DivAudioExportFormats format, int rate=0, int chans=2);
     // wait for audio export to finish
     void waitAudioFile();
     // stop audio file export
@@ -747,6 +927,10 @@ class DivEngine {
     void notifyInsChange(int ins);
     // notify wavetable change
     void notifyWaveChange(int wave);
+    // notify pattern change (contents edited, or pattern created/deleted)
+    void notifyPatternChange(int subsong, int chan, int pat);
+    // notify change of many patterns at once (patterns moved, optimized or wiped)
+    void notifyAllPatternsChange();
 
     // dispatch a command
     int dispatchCmd(DivCommand c);
@@ -766,6 +950,8 @@ class DivEngine {
     // benchmark (returns time in seconds)
     double benchmarkPlayback();
     double benchmarkSeek();
+    // benchmark a ROM export (returns time in seconds)
+    double benchmarkROMExport(DivROMExportOptions which, DivConfig& conf);
 
     // returns the minimum VGM version which may carry the specified system, or 0 if none.
     int minVGMVersion(DivSystem which);
@@ -1014,6 +1200,10 @@ class DivEngine {
     // is playing
     bool isPlaying();
 
+    // whether the current tick is a low-latency input sub-tick.
+    // macros and other per-tick sequences must not advance during one.
+    bool isInputSubTick();
+
     // is running
     bool isRunning();
 
@@ -1041,6 +1231,9 @@ class DivEngine {
     // get fadeout state
     bool getIsFadingOut();
 
+    // get how many blocks are waiting to be written, and how many seconds have been written
+    void getExportQueue(int& queued, int& capacity, double& written);
+
     // add instrument
     int addInstrument(int refChan=0, DivInstrumentType fallbackType=DIV_INS_STD);
 
@@ -1195,6 +1388,9 @@ class DivEngine {
     // set the audio system.
     void setAudio(DivAudioEngines which);
 
+    // set pipe backend options. -1 leaves an option unchanged.
+    void setPipeOptions(int format, int header, int realTime);
+
     // set the view mode.
     void setView(DivStatusView which);
 
@@ -1256,9 +1452,59 @@ class DivEngine {
     // values for whichSample
     // -2: don't render anything - just update chip sample memory
     // -1: render all samples
-    // >=0: render specific sample
+    // >=0: render specific sample (copy-on-write - see editSample())
     void renderSamplesP(int whichSample=-1);
 
+    // copy-on-write sample edit
+    // `what` runs on a private copy of the sample without locking the engine.
+    // if it returns true, the copy is rendered and swapped in at the next buffer boundary.
+    // undo history moves to the new version, so call prepareUndo() on the copy.
+    // returns false if the sample does not exist or `what` failed.
+    bool editSample(int index, const std::function<bool(DivSample*)>& what);
+
+    // background sample edit.
+    // like editSample(), but `what` runs on a separate thread and may report progress
+    // through DivSample::setProgress(). only one job may run at a time, and the sample
+    // cannot be edited until it finishes.
+    // returns false if the sample does not exist or another job is running.
+    bool editSampleAsync(int index, const String& name, const std::function<bool(DivSample*)>& what);
+
+    // check on the background sample edit. call this regularly from the thread which started it.
+    // returns true once the job finished and its result was published.
+    bool pollSampleJob();
+
+    // whether a background sample edit is running (on a specific sample if index>=0).
+    bool isSampleJobRunning(int index=-1);
+
+    // get progress (0 to 1) and name of the background sample edit.
+    float getSampleJobProgress();
+    String getSampleJobName();
+
+    // request cancellation of the background sample edit.
+    void cancelSampleJob();
+
+    // free asset versions retired by the audio thread.
+    // also applies edits which the audio thread did not pick up in time (e.g. no audio output).
+    // returns true if any edit was applied since the last call.
+    bool collectAssets();
+
+    // get the newest version of a sample, which may not have been picked up by the audio thread yet.
+    // editors shall use this instead of song.sample.
+    DivSample* getLatestSample(int index);
+
+    // get the memory used by the undo history of all samples.
+    size_t getSampleHistoryMemory();
+
+    // get the sample undo history memory limit in bytes.
+    size_t getSampleHistoryLimit();
+
+    // carry out core swaps requested by the load governor.
+    // returns true if a chip was swapped.
+    bool updateLoadGovernor();
+
+    // whether the load governor has put a chip on its cheapest core
+    bool isLowCostCore(int sys);
+
     // public swap channels
     void swapChannelsP(int src, int dest);
 
@@ -1282,6 +1528,8 @@ class DivEngine {
     void clearSubSongs();
 
     // optimize assets
+    // get the song content index, brought up to date with the song
+    DivSongIndex& getSongIndex();
     void delUnusedIns();
     void delUnusedWaves();
     void delUnusedSamples();
@@ -1380,6 +1628,15 @@ class DivEngine {
     // initialize the engine.
     bool init();
 
+    // create a copy of this engine holding a snapshot of the current song.
+    // the copy has no audio output and its own dispatches, so an export may
+    // run on it from another thread while this engine keeps playing.
+    // returns NULL on failure. free it with destroySnapshot().
+    DivEngine* createSnapshot();
+
+    // free an engine created by createSnapshot().
+    static void destroySnapshot(DivEngine* snap);
+
     // confirm that the engine is running (delete safe mode file).
     void everythingOK();
 
@@ -1419,6 +1676,8 @@ class DivEngine {
       midiIsDirect(false),
       midiIsDirectProgram(false),
       lowLatency(false),
+      inputSubTick(false),
+      loadGovernor(false),
       systemsRegistered(false),
       romExportsRegistered(false),
       hasLoadedSomething(false),
@@ -1429,7 +1688,6 @@ class DivEngine {
       midiOutTimeRate(0),
       midiVolExp(2.0f), // General MIDI standard
       softLockCount(0),
-      subticks(0),
       ticks(0),
       curRow(0),
       curOrder(0),
@@ -1482,6 +1740,8 @@ class DivEngine {
       exportFadeOut(0.0),
       isFadingOut(false),
       exportOutputs(2),
+      exportQueued(0),
+      exportFramesWritten(0),
       cmdStreamInt(NULL),
       midiBaseChan(0),
       midiPoly(true),
@@ -1503,15 +1763,25 @@ class DivEngine {
       metroVol(1.0f),
       previewVol(1.0f),
       totalProcessed(0),
+      sampleUndoLimit(256<<20),
       renderPoolThreads(0),
       renderPool(NULL),
+      pipeFormat(-1),
+      pipeHeader(-1),
+      pipeRealTime(-1),
+      assetSwapsPending(false),
+      sampleJob(NULL),
+      governorOver(0),
+      governorUnder(0),
+      governorHold(0),
+      governorRequest(-1),
+      governorPending(-1),
       curOrders(NULL),
       curPat(NULL),
       tempIns(NULL),
       oscSize(1),
       oscReadPos(0),
       oscWritePos(0),
-      tickMult(1),
       lastNBIns(0),
       lastNBOuts(0),
       lastNBSize(0),
@@ -1525,21 +1795,15 @@ class DivEngine {
       memset(dispatchChanOfChan,0,DIV_MAX_CHANS*sizeof(int));
       memset(dispatchOfChan,0,DIV_MAX_CHANS*sizeof(int));
       memset(sysOfChan,0,DIV_MAX_CHANS*sizeof(int));
-      memset(vibTable,0,64*sizeof(short));
-      memset(tremTable,0,128*sizeof(short));
-      memset(reversePitchTable,0,4096*sizeof(int));
-      memset(pitchTable,0,4096*sizeof(int));
       memset(effectSlotMap,-1,4096*sizeof(short));
-      memset(sysDefs,0,DIV_MAX_CHIP_DEFS*sizeof(void*));
-      memset(romExportDefs,0,DIV_ROM_MAX*sizeof(void*));
       memset(walked,0,8192);
       memset(oscBuf,0,DIV_MAX_OUTPUTS*(sizeof(float*)));
       memset(exportChannelMask,1,DIV_MAX_CHANS*sizeof(bool));
 
-      for (int i=0; i<DIV_MAX_CHIP_DEFS; i++) {
-        sysFileMapFur[i]=DIV_SYSTEM_NULL;
-        sysFileMapDMF[i]=DIV_SYSTEM_NULL;
-      }
+      // sysDefs, romExportDefs, the file maps and the lookup tables are static
+      // and shared by every instance (including snapshots), so they are not
+      // reset here.
+      // static storage starts out zeroed (NULL/DIV_SYSTEM_NULL).
 
       changeSong(0);
     }
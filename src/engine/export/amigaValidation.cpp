@@ -102,7 +102,7 @@ void DivExportAmigaValidation::run() {
         //writeLoop=true;
       }
     }
-    if (e->nextTick(false,true)) {
+    if (e->nextTick(false)) {
       done=true;
       amiga->getRegisterWrites().clear();
       if (lastTick!=songTick) {
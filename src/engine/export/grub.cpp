@@ -109,7 +109,7 @@ void DivExportGRUB::run() {
       w->writeText(fmt::sprintf("%d",tempo)); // write tempo
 
     while (!done) {
-      if (e->nextTick(false,true) || !e->playing) {
+      if (e->nextTick(false) || !e->playing) {
         done=true;
       }
 
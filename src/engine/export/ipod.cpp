@@ -106,7 +106,7 @@ void DivExportiPod::run() {
     int wait_ms = 0;
 
     while (!done) {
-      if (e->nextTick(false,true) || !e->playing) {
+      if (e->nextTick(false) || !e->playing) {
         done=true;
       }
 
@@ -19,11 +19,13 @@
 
 #include "tiuna.h"
 #include "../engine.h"
+#include "../workPool.h"
 #include "../ta-log.h"
 #include <fmt/printf.h>
 #include <algorithm>
 #include <map>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 struct TiunaNew {
@@ -124,6 +126,107 @@ struct TiunaMatches {
     ticks(0) {}
 };
 
+static size_t hashCmd(const TiunaBytes& c) {
+  size_t ret=c.ch;
+  ret=ret*31+c.ticks;
+  ret=ret*31+c.size;
+  for (int i=0; i<c.size; i++) {
+    ret=ret*31+c.buf[i];
+  }
+  return ret;
+}
+
+// finds the best match for a range of positions.
+// candidates are the positions of every command, grouped by command.
+struct TiunaSearchJob {
+  const std::vector<TiunaBytes>* cmds;
+  const std::vector<std::vector<int>>* candidates;
+  const int* bucketOf;
+  const bool* processed;
+  std::vector<TiunaMatches>* results;
+  const int* work;
+  int workSize, chunks;
+
+  void search(int i, TiunaMatches& matches) {
+    const std::vector<TiunaBytes>& renderedCmds=*cmds;
+    const std::vector<int>& cand=(*candidates)[bucketOf[i]];
+    int cmdSize=renderedCmds.size();
+    std::vector<TiunaMatch> match;
+    int ch=renderedCmds[i].ch;
+    int next=i+1;
+    // positions in between can't match (k=0), so only visit the identical ones
+    for (auto it=std::upper_bound(cand.begin(),cand.end(),i); it!=cand.end(); it++) {
+      int j=*it;
+      if (j<next) continue;
+      int k=0;
+      int ticks=0;
+      int size=0;
+      while (
+        (i+k)<j && (i+k)<cmdSize && (j+k)<cmdSize &&
+        (ticks+renderedCmds[i+k].ticks)<=256 &&
+        // match runs can't cross channels
+        // as channel end command would be insterted there later
+        renderedCmds[i+k].ch==ch &&
+        renderedCmds[j+k].ch==ch &&
+        renderedCmds[i+k]==renderedCmds[j+k] &&
+        !processed[i+k] && !processed[j+k]
+      ) {
+        ticks+=renderedCmds[i+k].ticks;
+        size+=renderedCmds[i+k].size;
+        k++;
+      }
+      if (size>2) match.push_back(TiunaMatch(j,j+k,size,0));
+      if (k==0) k++;
+      next=j+k;
+    }
+    matches=TiunaMatches();
+    if (match.empty()) return;
+    // find a length that results in most bytes saved
+    int curSize=0;
+    int curLength=1;
+    int curTicks=0;
+    while (true) {
+      int bytesSaved=-4;
+      bool found=false;
+      for (const TiunaMatch& j: match) {
+        if ((j.endPos-j.pos)>=curLength) {
+          if (!found) {
+            found=true;
+            curSize+=renderedCmds[i+curLength-1].size;
+            curTicks+=renderedCmds[i+curLength-1].ticks;
+          }
+          bytesSaved+=curSize-2;
+        }
+      }
+      if (!found) break;
+      if (bytesSaved>matches.bytesSaved) {
+        matches.length=curLength;
+        matches.bytesSaved=bytesSaved;
+        matches.ticks=curTicks;
+      }
+      curLength++;
+    }
+    if (matches.bytesSaved>0) {
+      matches.pos.push_back(i);
+      for (const TiunaMatch& j: match) {
+        if ((j.endPos-j.pos)>=matches.length) {
+          matches.pos.push_back(j.pos);
+        }
+      }
+    }
+  }
+
+  // search one of the chunks the work list is split into
+  static void run(void* arg, unsigned int index) {
+    TiunaSearchJob* job=(TiunaSearchJob*)arg;
+    int begin=((long long)job->workSize*index)/job->chunks;
+    int end=((long long)job->workSize*(index+1))/job->chunks;
+    for (int i=begin; i<end; i++) {
+      job->search(job->work[i],(*job->results)[job->work[i]]);
+    }
+  }
+};
+
 static void writeCmd(std::vector<TiunaBytes>& cmds, TiunaCmd& cmd, unsigned char ch, int& lastWait, int fromTick, int toTick) {
   while (fromTick<toTick) {
     int val=MIN(toTick-fromTick,256);
@@ -255,7 +358,7 @@ void DivExportTiuna::run() {
       //     last[i].vol=-1;
       //   }
       // }
-      if (e->nextTick(false,true) || !e->playing) {
+      if (e->nextTick(false) || !e->playing) {
         // stopped=!playing;
         done=true;
         break;
@@ -375,11 +478,59 @@ void DivExportTiuna::run() {
   int lastMaxPMVal=100000;
   logAppendf("max cmId: %d",maxCmId);
   logAppendf("commands: %d",cmdSize);
+
+  // index identical commands, so that only positions which may start a match are visited
+  logAppend("indexing commands...");
+  std::vector<std::vector<int>> buckets;
+  std::vector<int> bucketOf(cmdSize,0);
+  std::unordered_map<size_t,std::vector<int>> bucketsOfHash;
+  for (int i=0; i<cmdSize; i++) {
+    std::vector<int>& sameHash=bucketsOfHash[hashCmd(renderedCmds[i])];
+    int b=-1;
+    for (int j: sameHash) {
+      const TiunaBytes& other=renderedCmds[buckets[j][0]];
+      if (other.ch==renderedCmds[i].ch && other==renderedCmds[i]) {
+        b=j;
+        break;
+      }
+    }
+    if (b<0) {
+      b=buckets.size();
+      buckets.push_back(std::vector<int>());
+      sameHash.push_back(b);
+    }
+    buckets[b].push_back(i);
+    bucketOf[i]=b;
+  }
+  bucketsOfHash.clear();
+  logAppendf("distinct commands: %d",(int)buckets.size());
+
+  // best match for every position. only dirty positions are evaluated again.
+  std::vector<TiunaMatches> potentialMatches(cmdSize);
+  std::vector<unsigned char> dirty(cmdSize,1);
+  std::vector<int> touched(buckets.size(),-1);
+  std::vector<int> work;
+  work.reserve(cmdSize);
+  int processedCount=0;
+
+  int threads=conf.getInt("threads",0);
+  if (threads<1) threads=std::thread::hardware_concurrency();
+  if (threads>64) threads=64;
+  DivWorkPool* pool=new DivWorkPool(threads>1?threads:0);
+  TiunaSearchJob job;
+  job.cmds=&renderedCmds;
+  job.candidates=&buckets;
+  job.bucketOf=bucketOf.data();
+  job.processed=processed;
+  job.results=&potentialMatches;
+  logAppendf("using %d threads",MAX(1,threads));
+
   while (firstBankSize>768 && cmId<maxCmId) {
     if (mustAbort) {
       logAppend("aborted!");
       failed=true;
       running=false;
+      delete pool;
       delete[] processed;
       return;
     }
@@ -388,103 +539,71 @@ void DivExportTiuna::run() {
     progress[0].amount=theOtherSide+(1.0-theOtherSide)*((float)cmId/(float)maxCmId);
 
     logAppendf("start CM %04x...",cmId);
-    std::map<int,TiunaMatches> potentialMatches;
-    for (int i=0; i<cmdSize-1;) {
-      // continue and skip if it's part of previous confirmed matches
-      while (i<cmdSize-1 && processed[i]) i++;
-      if (i>=cmdSize-1) break;
-      progress[1].amount=(float)i/(float)(cmdSize-1);
-      std::vector<TiunaMatch> match;
-      int ch=renderedCmds[i].ch;
-      for (int j=i+1; j<cmdSize;) {
-        if (processed[i]) break;
-        //while (j<cmdSize && processed[i]) j++;
-        if (j>=cmdSize) break;
-        int k=0;
-        int ticks=0;
-        int size=0;
-        while (
-          (i+k)<j && (i+k)<cmdSize && (j+k)<cmdSize &&
-          (ticks+renderedCmds[i+k].ticks)<=256 &&
-          // match runs can't cross channels
-          // as channel end command would be insterted there later
-          renderedCmds[i+k].ch==ch &&
-          renderedCmds[j+k].ch==ch &&
-          renderedCmds[i+k]==renderedCmds[j+k] &&
-          !processed[i+k] && !processed[j+k]
-        ) {
-          ticks+=renderedCmds[i+k].ticks;
-          size+=renderedCmds[i+k].size;
-          k++;
-        }
-        if (size>2) match.push_back(TiunaMatch(j,j+k,size,0));
-        if (k==0) k++;
-        j+=k;
-      }
-      if (match.empty()) {
-        i++;
-        continue;
-      }
-      // find a length that results in most bytes saved
-      TiunaMatches matches;
-      int curSize=0;
-      int curLength=1;
-      int curTicks=0;
-      while (true) {
-        int bytesSaved=-4;
-        bool found=false;
-        for (const TiunaMatch& j: match) {
-          if ((j.endPos-j.pos)>=curLength) {
-            if (!found) {
-              found=true;
-              curSize+=renderedCmds[i+curLength-1].size;
-              curTicks+=renderedCmds[i+curLength-1].ticks;
-            }
-            bytesSaved+=curSize-2;
-          }
-        }
-        if (!found) break;
-        if (bytesSaved>matches.bytesSaved) {
-          matches.length=curLength;
-          matches.bytesSaved=bytesSaved;
-          matches.ticks=curTicks;
-        }
-        curLength++;
-      }
-      if (matches.bytesSaved>0) {
-        matches.pos.push_back(i);
-        for (const TiunaMatch& j: match) {
-          if ((j.endPos-j.pos)>=matches.length) {
-            matches.pos.push_back(j.pos);
-          }
-        }
-        potentialMatches[i]=matches;
+    work.clear();
+    for (int i=0; i<cmdSize-1; i++) {
+      if (dirty[i] && !processed[i]) work.push_back(i);
+      dirty[i]=0;
+    }
+    job.work=work.data();
+    job.workSize=work.size();
+    job.chunks=MIN(256,MAX(1,(int)work.size()/64));
+    pool->parallelFor(job.chunks,TiunaSearchJob::run,&job);
+
+    int maxPMIdx=-1;
+    int maxPMVal=0;
+    for (int i=0; i<cmdSize-1; i++) {
+      if (processed[i]) continue;
+      if (potentialMatches[i].bytesSaved>maxPMVal) {
+        maxPMVal=potentialMatches[i].bytesSaved;
+        maxPMIdx=i;
       }
-      i++;
     }
-    if (potentialMatches.empty()) {
+    if (maxPMIdx<0) {
       logAppend("potentialMatches is empty");
       break;
     }
-    int maxPMIdx=0;
-    int maxPMVal=0;
-    for (const auto& i: potentialMatches) {
-      if (i.second.bytesSaved>maxPMVal) {
-        maxPMVal=i.second.bytesSaved;
-        maxPMIdx=i.first;
-      }
-    }
     int maxPMLen=potentialMatches[maxPMIdx].length;
-    for (const int i: potentialMatches[maxPMIdx].pos) {
+    std::vector<int> matchPos=potentialMatches[maxPMIdx].pos;
+    for (const int i: matchPos) {
       confirmedMatches.push_back({i,i+maxPMLen,0,cmId});
       memset(processed+i,1,maxPMLen);
-      //std::fill(processed.begin()+i,processed.begin()+(i+maxPMLen),true);
+      processedCount+=maxPMLen;
     }
+
+    // invalidate every position whose search may have read one of the newly processed commands.
+    // a match run is at most 256 commands long (every command is at least one tick long),
+    // so only runs starting up to 256 commands before a processed one are affected.
+    for (const int i: matchPos) {
+      for (int j=MAX(0,i-256); j<i+maxPMLen; j++) {
+        dirty[j]=1;
+        if (touched[bucketOf[j]]<j) touched[bucketOf[j]]=j;
+      }
+    }
+    for (size_t b=0; b<buckets.size(); b++) {
+      if (touched[b]<0) continue;
+      for (int i: buckets[b]) {
+        if (i>=touched[b]) break;
+        dirty[i]=1;
+      }
+      touched[b]=-1;
+    }
+    for (const int i: matchPos) {
+      for (int j=i; j<i+maxPMLen; j++) {
+        std::vector<int>& bucket=buckets[bucketOf[j]];
+        if (bucket.empty()) continue;
+        bucket.erase(std::remove_if(bucket.begin(),bucket.end(),[processed](int k) {
+          return processed[k];
+        }),bucket.end());
+      }
+    }
+
     callTicks.push_back(potentialMatches[maxPMIdx].ticks);
-    logAppendf("CM %04x added: pos=%d,len=%d,matches=%d,saved=%d",cmId,maxPMIdx,maxPMLen,potentialMatches[maxPMIdx].pos.size(),maxPMVal);
+    logAppendf("CM %04x added: pos=%d,len=%d,matches=%d,saved=%d",cmId,maxPMIdx,maxPMLen,matchPos.size(),maxPMVal);
+    progress[1].amount=(float)processedCount/(float)MAX(1,cmdSize);
     lastMaxPMVal=maxPMVal;
     cmId++;
   }
+  delete pool;
   progress[0].amount=1.0f;
   progress[1].amount=1.0f;
   logAppend("generating data...");
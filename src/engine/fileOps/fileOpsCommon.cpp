@@ -18,6 +18,47 @@
  */
 
 #include "fileOpsCommon.h"
+#include "../workPool.h"
+#include <thread>
+
+// below this amount of sample data, starting threads costs more than it saves
+#define DIV_DECODE_THREAD_THRESHOLD 262144
+
+void DivSampleDecoder::push(const DivSampleDecodeJob& job) {
+  jobs.push_back(job);
+  totalLen+=job.len;
+}
+
+static void _decodeSample(void* arg, unsigned int i) {
+  DivSampleDecoder* dec=(DivSampleDecoder*)arg;
+  dec->decode(dec->jobs[i]);
+}
+
+void DivSampleDecoder::run() {
+  std::chrono::high_resolution_clock::time_point timeHeaders=std::chrono::high_resolution_clock::now();
+
+  unsigned int threads=0;
+  if (jobs.size()>1 && totalLen>=DIV_DECODE_THREAD_THRESHOLD) {
+    threads=MIN(16,MIN((unsigned int)jobs.size(),std::thread::hardware_concurrency()));
+    if (threads<2) threads=0;
+  }
+  {
+    DivWorkPool pool(threads);
+    threads=pool.getThreads();
+    pool.parallelFor(jobs.size(),_decodeSample,this);
+  }
+
+  std::chrono::high_resolution_clock::time_point timeEnd=std::chrono::high_resolution_clock::now();
+  logI("%s: headers read in %dµs, %d samples decoded in %dµs (%d threads)",
+    format,
+    (int)std::chrono::duration_cast<std::chrono::microseconds>(timeHeaders-timeStart).count(),
+    (int)jobs.size(),
+    (int)std::chrono::duration_cast<std::chrono::microseconds>(timeEnd-timeHeaders).count(),
+    threads
+  );
+  jobs.clear();
+  totalLen=0;
+}
 
 bool DivEngine::load(unsigned char* f, size_t slen, const char* nameHint) {
   unsigned char* file;
@@ -31,6 +72,9 @@ bool DivEngine::load(unsigned char* f, size_t slen, const char* nameHint) {
 
   if (!systemsRegistered) registerSystems();
 
+  // the song is about to be replaced
+  songIndex.markAllDirty();
+
   // step 0: get extension of file
   String extS;
   if (nameHint!=NULL) {
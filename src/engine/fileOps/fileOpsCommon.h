@@ -22,6 +22,7 @@
 #include "../../ta-log.h"
 #include <zlib.h>
 #include <fmt/printf.h>
+#include <chrono>
 
 #define DIV_READ_SIZE 131072
 
@@ -64,6 +65,51 @@ enum DivFurVariants: int {
   DIV_FUR_VARIANT_B=1,
 };
 
+// deferred sample decoding
+// importers read every sample header first and queue the payloads here.
+// run() then decodes them in parallel. each job only touches its own sample,
+// so the result does not depend on the order in which jobs run.
+struct DivSampleDecodeJob {
+  DivSample* sample;
+  const unsigned char* data;
+  size_t len;
+  unsigned char flags;
+  unsigned char convert;
+  unsigned char vol;
+  DivSampleDecodeJob(DivSample* s, const unsigned char* d, size_t l, unsigned char f, unsigned char c, unsigned char v):
+    sample(s),
+    data(d),
+    len(l),
+    flags(f),
+    convert(c),
+    vol(v) {}
+};
+
+static inline short readShortLE(const unsigned char* data, size_t& pos) {
+  short ret=data[pos]|(data[pos+1]<<8);
+  pos+=2;
+  return ret;
+}
+
+struct DivSampleDecoder {
+  const char* format;
+  void (*decode)(DivSampleDecodeJob&);
+  std::vector<DivSampleDecodeJob> jobs;
+  size_t totalLen;
+  std::chrono::high_resolution_clock::time_point timeStart;
+
+  void push(const DivSampleDecodeJob& job);
+  // decode all queued samples and log the time spent in each stage.
+  // decode functions must not throw.
+  void run();
+
+  DivSampleDecoder(const char* f, void (*d)(DivSampleDecodeJob&)):
+    format(f),
+    decode(d),
+    totalLen(0),
+    timeStart(std::chrono::high_resolution_clock::now()) {}
+};
+
 // MIDI-related
 struct midibank_t {
   String name;
@@ -164,9 +164,133 @@ void readEnvelope(SafeReader& reader, DivInstrument* ins, int env) {
   }
 }
 
+// decodes the payload of a single sample. runs on a worker thread.
+static void decodeITSample(DivSampleDecodeJob& job) {
+  DivSample* s=job.sample;
+  SafeReader reader=SafeReader(job.data,job.len);
+  unsigned char flags=job.flags;
+  unsigned char convert=job.convert;
+  unsigned char sampleVol=job.vol;
+
+  logV("reading sample data (%d)",s->samples);
+
+  if (flags&8) { // compressed sample
+    unsigned int ret=0;
+    logV("decompression begin... (%d)",s->samples);
+    if (flags&4) {
+      logW("STEREO!");
+      if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+        logV("16-bit");
+        short* outData=new short[s->samples*2];
+        ret=it_decompress16(outData,s->samples,job.data,job.len,(convert&4)?1:0,(flags&4)?2:1);
+        for (unsigned int i=0; i<s->samples; i++) {
+          s->data16[i]=(outData[i<<1]+outData[1+(i<<1)])>>1;
+        }
+        delete[] outData;
+      } else {
+        logV("8-bit");
+        signed char* outData=new signed char[s->samples*2];
+        ret=it_decompress8(outData,s->samples,job.data,job.len,(convert&4)?1:0,(flags&4)?2:1);
+        for (unsigned int i=0; i<s->samples; i++) {
+          s->data8[i]=(outData[i<<1]+outData[1+(i<<1)])>>1;
+        }
+        delete[] outData;
+      }
+    } else {
+      if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+        logV("16-bit");
+        ret=it_decompress16(s->data16,s->samples,job.data,job.len,(convert&4)?1:0,(flags&4)?2:1);
+      } else {
+        logV("8-bit");
+        ret=it_decompress8(s->data8,s->samples,job.data,job.len,(convert&4)?1:0,(flags&4)?2:1);
+      }
+    }
+    logV("got: %d",ret);
+  } else {
+    try {
+      if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+        if (flags&4) { // downmix stereo
+          for (unsigned int i=0; i<s->samples; i++) {
+            short l;
+            if (convert&2) {
+              l=reader.readS_BE();
+            } else {
+              l=reader.readS();
+            }
+            if (!(convert&1)) {
+              l^=0x8000;
+            }
+            s->data16[i]=l;
+          }
+          for (unsigned int i=0; i<s->samples; i++) {
+            short r;
+            if (convert&2) {
+              r=reader.readS_BE();
+            } else {
+              r=reader.readS();
+            }
+            if (!(convert&1)) {
+              r^=0x8000;
+            }
+            s->data16[i]=(s->data16[i]+r)>>1;
+          }
+        } else {
+          for (unsigned int i=0; i<s->samples; i++) {
+            if (convert&2) {
+              s->data16[i]=reader.readS_BE()^((convert&1)?0:0x8000);
+            } else {
+              s->data16[i]=reader.readS()^((convert&1)?0:0x8000);
+            }
+          }
+        }
+      } else {
+        if (flags&4) { // downmix stereo
+          for (unsigned int i=0; i<s->samples; i++) {
+            signed char l=reader.readC();
+            if (!(convert&1)) {
+              l^=0x80;
+            }
+            s->data8[i]=l;
+          }
+          for (unsigned int i=0; i<s->samples; i++) {
+            signed char r=reader.readC();
+            if (!(convert&1)) {
+              r^=0x80;
+            }
+            s->data8[i]=(s->data8[i]+r)>>1;
+          }
+        } else {
+          for (unsigned int i=0; i<s->samples; i++) {
+            s->data8[i]=reader.readC()^((convert&1)?0:0x80);
+          }
+        }
+      }
+    } catch (EndOfFileException& e) {
+      logW("premature end of file...");
+    }
+  }
+
+  // scale sample if necessary
+  if (s->samples>0) {
+    if (sampleVol>64) sampleVol=64;
+    if (sampleVol<64) {
+      // convert to 16-bit
+      if (s->depth==DIV_SAMPLE_DEPTH_8BIT) {
+        s->convert(DIV_SAMPLE_DEPTH_16BIT,0);
+      }
+
+      // then scale
+      for (unsigned int i=0; i<s->samples; i++) {
+        s->data16[i]=(s->data16[i]*sampleVol)>>6;
+      }
+    }
+  }
+}
+
 bool DivEngine::loadIT(unsigned char* file, size_t len) {
   struct InvalidHeaderException {};
   bool success=false;
+  DivSampleDecoder decoder("IT",decodeITSample);
   char magic[4];
 
   unsigned char chanPan[64];
@@ -639,118 +763,8 @@ bool DivEngine::loadIT(unsigned char* file, size_t len) {
         logD("seek not needed...");
       }
 
-      logV("reading sample data (%d)",s->samples);
-
-      if (flags&8) { // compressed sample
-        unsigned int ret=0;
-        logV("decompression begin... (%d)",s->samples);
-        if (flags&4) {
-          logW("STEREO!");
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            logV("16-bit");
-            short* outData=new short[s->samples*2];
-            ret=it_decompress16(outData,s->samples,&file[reader.tell()],len-reader.tell(),(convert&4)?1:0,(flags&4)?2:1);
-            for (unsigned int i=0; i<s->samples; i++) {
-              s->data16[i]=(outData[i<<1]+outData[1+(i<<1)])>>1;
-            }
-            delete[] outData;
-          } else {
-            logV("8-bit");
-            signed char* outData=new signed char[s->samples*2];
-            ret=it_decompress8(outData,s->samples,&file[reader.tell()],len-reader.tell(),(convert&4)?1:0,(flags&4)?2:1);
-            for (unsigned int i=0; i<s->samples; i++) {
-              s->data8[i]=(outData[i<<1]+outData[1+(i<<1)])>>1;
-            }
-            delete[] outData;
-          }
-        } else {
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            logV("16-bit");
-            ret=it_decompress16(s->data16,s->samples,&file[reader.tell()],len-reader.tell(),(convert&4)?1:0,(flags&4)?2:1);
-          } else {
-            logV("8-bit");
-            ret=it_decompress8(s->data8,s->samples,&file[reader.tell()],len-reader.tell(),(convert&4)?1:0,(flags&4)?2:1);
-          }
-        }
-        logV("got: %d",ret);
-      } else {
-        try {
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            if (flags&4) { // downmix stereo
-              for (unsigned int i=0; i<s->samples; i++) {
-                short l;
-                if (convert&2) {
-                  l=reader.readS_BE();
-                } else {
-                  l=reader.readS();
-                }
-                if (!(convert&1)) {
-                  l^=0x8000;
-                }
-                s->data16[i]=l;
-              }
-              for (unsigned int i=0; i<s->samples; i++) {
-                short r;
-                if (convert&2) {
-                  r=reader.readS_BE();
-                } else {
-                  r=reader.readS();
-                }
-                if (!(convert&1)) {
-                  r^=0x8000;
-                }
-                s->data16[i]=(s->data16[i]+r)>>1;
-              }
-            } else {
-              for (unsigned int i=0; i<s->samples; i++) {
-                if (convert&2) {
-                  s->data16[i]=reader.readS_BE()^((convert&1)?0:0x8000);
-                } else {
-                  s->data16[i]=reader.readS()^((convert&1)?0:0x8000);
-                }
-              }
-            }
-          } else {
-            if (flags&4) { // downmix stereo
-              for (unsigned int i=0; i<s->samples; i++) {
-                signed char l=reader.readC();
-                if (!(convert&1)) {
-                  l^=0x80;
-                }
-                s->data8[i]=l;
-              }
-              for (unsigned int i=0; i<s->samples; i++) {
-                signed char r=reader.readC();
-                if (!(convert&1)) {
-                  r^=0x80;
-                }
-                s->data8[i]=(s->data8[i]+r)>>1;
-              }
-            } else {
-              for (unsigned int i=0; i<s->samples; i++) {
-                s->data8[i]=reader.readC()^((convert&1)?0:0x80);
-              }
-            }
-          }
-        } catch (EndOfFileException& e) {
-          logW("premature end of file...");
-        }
-      }
-
-      // scale sample if necessary
       if (s->samples>0) {
-        if (sampleVol>64) sampleVol=64;
-        if (sampleVol<64) {
-          // convert to 16-bit
-          if (s->depth==DIV_SAMPLE_DEPTH_8BIT) {
-            s->convert(DIV_SAMPLE_DEPTH_16BIT,0);
-          }
-
-          // then scale
-          for (unsigned int i=0; i<s->samples; i++) {
-            s->data16[i]=(s->data16[i]*sampleVol)>>6;
-          }
-        }
+        decoder.push(DivSampleDecodeJob(s,&file[dataPtr],len-dataPtr,flags,convert,sampleVol));
       }
 
       // does the song not use instruments?
@@ -766,6 +780,8 @@ bool DivEngine::loadIT(unsigned char* file, size_t len) {
       ds.sample.push_back(s);
     }
 
+    decoder.run();
+
     // scan pattern data for effect use
     int maxChan=0;
     for (int i=0; i<patCount; i++) {
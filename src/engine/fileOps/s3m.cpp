@@ -33,9 +33,69 @@ static void readSbiOpData(sbi_t& sbi, SafeReader& reader) {
   sbi.FeedConnect = reader.readC();
 }
 
+// decodes the payload of a single sample. runs on a worker thread.
+static void decodeS3MSample(DivSampleDecodeJob& job) {
+  DivSample* s=job.sample;
+  unsigned char flags=job.flags;
+  bool signedSamples=job.convert;
+  size_t pos=0;
+
+  if (flags&2) {
+    // downmix stereo
+    if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+      for (unsigned int i=0; i<s->samples; i++) {
+        short l=readShortLE(job.data,pos);
+        if (!signedSamples) {
+          l^=0x8000;
+        }
+        s->data16[i]=l;
+      }
+      for (unsigned int i=0; i<s->samples; i++) {
+        short r=readShortLE(job.data,pos);
+        if (!signedSamples) {
+          r^=0x8000;
+        }
+        s->data16[i]=(s->data16[i]+r)>>1;
+      }
+    } else {
+      for (unsigned int i=0; i<s->samples; i++) {
+        signed char l=(signed char)job.data[pos++];
+        if (!signedSamples) {
+          l^=0x80;
+        }
+        s->data8[i]=l;
+      }
+      for (unsigned int i=0; i<s->samples; i++) {
+        signed char r=(signed char)job.data[pos++];
+        if (!signedSamples) {
+          r^=0x80;
+        }
+        s->data8[i]=(s->data8[i]+r)>>1;
+      }
+    }
+  } else {
+    if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+      for (unsigned int i=0; i<s->samples; i++) {
+        s->data16[i]=readShortLE(job.data,pos);
+        if (!signedSamples) {
+          s->data16[i]^=0x8000;
+        }
+      }
+    } else {
+      for (unsigned int i=0; i<s->samples; i++) {
+        s->data8[i]=(signed char)job.data[pos++];
+        if (!signedSamples) {
+          s->data8[i]^=0x80;
+        }
+      }
+    }
+  }
+}
+
 bool DivEngine::loadS3M(unsigned char* file, size_t len) {
   struct InvalidHeaderException {};
   bool success=false;
+  DivSampleDecoder decoder("S3M",decodeS3MSample);
   bool opl2=!getConfInt("s3mOPL3",0);
   char magic[4]={0,0,0,0};
   SafeReader reader=SafeReader(file,len);
@@ -504,55 +564,13 @@ bool DivEngine::loadS3M(unsigned char* file, size_t len) {
           return false;
         }
 
-        if (flags&2) {
-          // downmix stereo
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            for (unsigned int i=0; i<s->samples; i++) {
-              short l=reader.readS();
-              if (!signedSamples) {
-                l^=0x8000;
-              }
-              s->data16[i]=l;
-            }
-            for (unsigned int i=0; i<s->samples; i++) {
-              short r=reader.readS();
-              if (!signedSamples) {
-                r^=0x8000;
-              }
-              s->data16[i]=(s->data16[i]+r)>>1;
-            }
-          } else {
-            for (unsigned int i=0; i<s->samples; i++) {
-              signed char l=reader.readC();
-              if (!signedSamples) {
-                l^=0x80;
-              }
-              s->data8[i]=l;
-            }
-            for (unsigned int i=0; i<s->samples; i++) {
-              signed char r=reader.readC();
-              if (!signedSamples) {
-                r^=0x80;
-              }
-              s->data8[i]=(s->data8[i]+r)>>1;
-            }
-          }
-        } else {
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            for (unsigned int i=0; i<s->samples; i++) {
-              s->data16[i]=reader.readS();
-              if (!signedSamples) {
-                s->data16[i]^=0x8000;
-              }
-            }
-          } else {
-            for (unsigned int i=0; i<s->samples; i++) {
-              s->data8[i]=reader.readC();
-              if (!signedSamples) {
-                s->data8[i]^=0x80;
-              }
-            }
-          }
+        // queue sample data
+        size_t dataLen=(size_t)s->samples*((s->depth==DIV_SAMPLE_DEPTH_16BIT)?2:1)*((flags&2)?2:1);
+        if (dataLen>len-memSeg) {
+          throw EndOfFileException(&reader,reader.size());
+        }
+        if (s->samples>0) {
+          decoder.push(DivSampleDecodeJob(s,&file[memSeg],dataLen,flags,signedSamples,0));
         }
 
         ins->amiga.initSample=ds.sample.size();
@@ -637,6 +655,8 @@ bool DivEngine::loadS3M(unsigned char* file, size_t len) {
     }
     ds.sampleLen=ds.sample.size();
 
+    decoder.run();
+
     // scan pattern data for effect use
     for (int i=0; i<patCount; i++) {
       logV("scanning pattern %d...",i);
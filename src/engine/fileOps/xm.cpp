@@ -167,9 +167,29 @@ void readEnvelope(DivInstrument* ins, int env, unsigned char flags, unsigned cha
   delete[] samplePan; \
   delete[] noteMap;
 
+// delta-decodes the payload of a single sample. runs on a worker thread.
+static void decodeXMSample(DivSampleDecodeJob& job) {
+  DivSample* s=job.sample;
+  size_t pos=0;
+  if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+    short next=0;
+    for (unsigned int i=0; i<s->samples; i++) {
+      next+=readShortLE(job.data,pos);
+      s->data16[i]=next;
+    }
+  } else {
+    signed char next=0;
+    for (unsigned int i=0; i<s->samples; i++) {
+      next+=(signed char)job.data[i];
+      s->data8[i]=next;
+    }
+  }
+}
+
 bool DivEngine::loadXM(unsigned char* file, size_t len) {
   struct InvalidHeaderException {};
   bool success=false;
+  DivSampleDecoder decoder("XM",decodeXMSample);
   char magic[32];
   unsigned char* sampleVol=new unsigned char[256*256];
   unsigned char* samplePan=new unsigned char[256*256];
@@ -699,20 +719,15 @@ bool DivEngine::loadXM(unsigned char* file, size_t len) {
         for (int j=0; j<sampleCount; j++) {
           DivSample* s=toAdd[j];
 
-          // load sample data
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            short next=0;
-            for (unsigned int i=0; i<s->samples; i++) {
-              next+=reader.readS();
-              s->data16[i]=next;
-            }
-          } else {
-            signed char next=0;
-            for (unsigned int i=0; i<s->samples; i++) {
-              next+=reader.readC();
-              s->data8[i]=next;
-            }
+          // queue sample data and skip past it
+          size_t dataLen=(size_t)s->samples*((s->depth==DIV_SAMPLE_DEPTH_16BIT)?2:1);
+          if (dataLen>len-reader.tell()) {
+            throw EndOfFileException(&reader,reader.size());
           }
+          if (s->samples>0) {
+            decoder.push(DivSampleDecodeJob(s,&file[reader.tell()],dataLen,0,0,0));
+          }
+          reader.seek(dataLen,SEEK_CUR);
         }
 
         for (DivSample* i: toAdd) {
@@ -732,6 +747,8 @@ bool DivEngine::loadXM(unsigned char* file, size_t len) {
       ds.ins.push_back(ins);
     }
 
+    decoder.run();
+
     if (!reader.seek(patBegin,SEEK_SET)) {
       logE("premature end of file!");
       lastError="incomplete file";
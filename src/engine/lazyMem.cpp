@@ -0,0 +1,131 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "lazyMem.h"
+#include "../ta-log.h"
+#include <string.h>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// buffers which fell back to new[] because the system refused to map them
+static std::mutex heapLock;
+static std::unordered_set<void*> heapBlocks;
+
+static bool isHeapBlock(void* ptr) {
+  std::lock_guard<std::mutex> lock(heapLock);
+  return heapBlocks.find(ptr)!=heapBlocks.end();
+}
+
+// like before lazy allocation, this throws if there is no memory at all
+static unsigned char* heapAlloc(size_t size) {
+  logW("could not map %d bytes of sample memory! falling back to regular allocation.",(int)size);
+  unsigned char* ret=new unsigned char[size];
+  memset(ret,0,size);
+  std::lock_guard<std::mutex> lock(heapLock);
+  heapBlocks.insert(ret);
+  return ret;
+}
+
+#ifndef _WIN32
+static size_t pageSize() {
+  static size_t size=0;
+  if (size==0) {
+    long s=sysconf(_SC_PAGESIZE);
+    size=(s>0)?s:4096;
+  }
+  return size;
+}
+#endif
+
+unsigned char* DivLazyMem::alloc(size_t size) {
+  if (size==0) return NULL;
+#ifdef _WIN32
+  // commit charge is taken, but pages only enter the working set when touched
+  void* ret=VirtualAlloc(NULL,size,MEM_RESERVE|MEM_COMMIT,PAGE_READWRITE);
+  if (ret==NULL) return heapAlloc(size);
+  return (unsigned char*)ret;
+#else
+  void* ret=mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+  if (ret==MAP_FAILED) return heapAlloc(size);
+  return (unsigned char*)ret;
+#endif
+}
+
+void DivLazyMem::free(void* ptr, size_t size) {
+  if (ptr==NULL) return;
+  heapLock.lock();
+  bool isHeap=heapBlocks.erase(ptr)>0;
+  heapLock.unlock();
+  if (isHeap) {
+    delete[] (unsigned char*)ptr;
+    return;
+  }
+#ifdef _WIN32
+  VirtualFree(ptr,0,MEM_RELEASE);
+#else
+  munmap(ptr,size);
+#endif
+}
+
+void DivLazyMem::clear(void* ptr, size_t size) {
+  if (ptr==NULL) return;
+  if (isHeapBlock(ptr)) {
+    memset(ptr,0,size);
+    return;
+  }
+#ifdef _WIN32
+  // decommitting and committing again yields fresh zero pages
+  if (VirtualFree(ptr,size,MEM_DECOMMIT) && VirtualAlloc(ptr,size,MEM_COMMIT,PAGE_READWRITE)!=NULL) return;
+#else
+  // mapping over the buffer replaces written pages with fresh zero pages.
+  // MADV_DONTNEED isn't used as it doesn't zero on every platform.
+  if (mmap(ptr,size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED,-1,0)!=MAP_FAILED) return;
+#endif
+  logW("could not release sample memory pages!");
+  memset(ptr,0,size);
+}
+
+size_t DivLazyMem::resident(const void* ptr, size_t size) {
+  if (ptr==NULL) return 0;
+  if (isHeapBlock((void*)ptr)) return size;
+#ifdef _WIN32
+  return size;
+#else
+  size_t page=pageSize();
+  size_t pages=(size+page-1)/page;
+#ifdef __linux__
+  std::vector<unsigned char> vec(pages);
+#else
+  std::vector<char> vec(pages);
+#endif
+  if (mincore((void*)ptr,size,vec.data())!=0) return size;
+  size_t ret=0;
+  for (size_t i=0; i<pages; i++) {
+    if (vec[i]&1) ret+=page;
+  }
+  return (ret>size)?size:ret;
+#endif
+}
@@ -0,0 +1,41 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _LAZYMEM_H
+#define _LAZYMEM_H
+
+#include <stddef.h>
+
+// lazily committed memory for sample ROMs/RAMs.
+// the address space is reserved up front, but pages only take up physical memory once
+// they are written to. untouched pages read as zero.
+namespace DivLazyMem {
+  // reserve zeroed memory. falls back to new[] (which throws on failure) if the memory can't be mapped.
+  // returns NULL only if size is 0.
+  unsigned char* alloc(size_t size);
+  // free memory returned by alloc().
+  void free(void* ptr, size_t size);
+  // zero the whole buffer and give written pages back to the system.
+  void clear(void* ptr, size_t size);
+  // get how many bytes of the buffer are resident in physical memory.
+  // returns size if this can't be determined.
+  size_t resident(const void* ptr, size_t size);
+};
+
+#endif
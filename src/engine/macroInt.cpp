@@ -177,18 +177,13 @@ void DivMacroStruct::doMacro(DivInstrumentMacro& source, bool released, bool tic
 void DivMacroInt::next() {
   if (ins==NULL) return;
   // run macros
+  // on an input sub-tick, only a macro which has just been started takes its first step
+  bool tick=(subTick>0 || e==NULL || !e->isInputSubTick());
+  subTick=0;
   // TODO: potentially get rid of list to avoid allocations
-  subTick--;
   for (size_t i=0; i<macroListLen; i++) {
     if (macroList[i]!=NULL && macroSource[i]!=NULL) {
-      macroList[i]->doMacro(*macroSource[i],released,subTick==0);
-    }
-  }
-  if (subTick<=0) {
-    if (e==NULL) {
-      subTick=1;
-    } else {
-      subTick=e->tickMult;
+      macroList[i]->doMacro(*macroSource[i],released,tick);
     }
   }
 }
@@ -66,6 +66,7 @@ class DivMacroInt {
   DivMacroStruct* macroList[128];
   DivInstrumentMacro* macroSource[128];
   size_t macroListLen;
+  // 1 until the first step after init()
   int subTick;
   bool released;
   public:
@@ -137,6 +137,13 @@ bool DivDispatch::hasAcquireDirect() {
   return false;
 }
 
+bool DivDispatch::isIdle() {
+  return false;
+}
+
+void DivDispatch::skipIdle(size_t len) {
+}
+
 bool DivDispatch::getWantPreNote() {
   return false;
 }
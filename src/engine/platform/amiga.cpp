@@ -20,6 +20,7 @@
 #define _USE_MATH_DEFINES
 #include "amiga.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -1005,7 +1006,7 @@ const DivMemoryComposition* DivPlatformAmiga::getMemCompo(int index) {
 }
 
 void DivPlatformAmiga::renderSamples(int sysID) {
-  memset(sampleMem,0,2097152);
+  DivLazyMem::clear(sampleMem,2097152);
   memset(sampleOff,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -1046,6 +1047,7 @@ void DivPlatformAmiga::renderSamples(int sysID) {
 
   memCompo.capacity=1<<chipMem;
   memCompo.used=sampleMemLen;
+  memCompo.resident=DivLazyMem::resident(sampleMem,2097152);
 }
 
 int DivPlatformAmiga::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
@@ -1068,7 +1070,7 @@ int DivPlatformAmiga::init(DivEngine* p, int channels, int sugRate, const DivCon
     }
   }
 
-  sampleMem=new unsigned char[2097152];
+  sampleMem=DivLazyMem::alloc(2097152);
   sampleMemLen=0;
 
   setFlags(flags);
@@ -1077,7 +1079,7 @@ int DivPlatformAmiga::init(DivEngine* p, int channels, int sugRate, const DivCon
 }
 
 void DivPlatformAmiga::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,2097152);
   for (int i=0; i<4; i++) {
     delete oscBuf[i];
   }
@@ -161,6 +161,23 @@ void DivPlatformArcade::acquire(short** buf, size_t len) {
   }
 }
 
+bool DivPlatformArcade::isIdle() {
+  // only the ymfm core can be skipped
+  if (!useYMFM) return false;
+  if (!writes.empty()) return false;
+  return fm_ymfm->debug_engine()->is_idle();
+}
+
+void DivPlatformArcade::skipIdle(size_t len) {
+  fm_ymfm->debug_engine()->skip_idle(len);
+
+  // the oscilloscopes keep the last value
+  for (int i=0; i<8; i++) {
+    oscBuf[i]->begin(len);
+    oscBuf[i]->end(len);
+  }
+}
+
 static unsigned char noteMap[12]={
   0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14
 };
@@ -65,6 +65,8 @@ class DivPlatformArcade: public DivPlatformOPM {
     friend void putDispatchChip(void*,int);
   public:
     void acquire(short** buf, size_t len);
+    bool isIdle();
+    void skipIdle(size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
     DivDispatchOscBuffer* getOscBuffer(int chan);
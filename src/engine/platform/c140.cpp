@@ -19,6 +19,7 @@
 
 #include "c140.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -612,7 +613,7 @@ const DivMemoryComposition* DivPlatformC140::getMemCompo(int index) {
 }
 
 void DivPlatformC140::renderSamples(int sysID) {
-  memset(sampleMem,0,is219?524288:16777216);
+  DivLazyMem::clear(sampleMem,is219?524288:16777216);
   memset(sampleOff,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -732,6 +733,7 @@ void DivPlatformC140::renderSamples(int sysID) {
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=getSampleMemCapacity(0);
+  memCompo.resident=DivLazyMem::resident(sampleMem,is219?524288:16777216);
 }
 
 void DivPlatformC140::set219(bool is_219) {
@@ -780,7 +782,7 @@ int DivPlatformC140::init(DivEngine* p, int channels, int sugRate, const DivConf
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[is219?524288:16777216];
+  sampleMem=DivLazyMem::alloc(is219?524288:16777216);
   sampleMemLen=0;
   if (is219) {
     c219_init(&c219);
@@ -796,7 +798,7 @@ int DivPlatformC140::init(DivEngine* p, int channels, int sugRate, const DivConf
 }
 
 void DivPlatformC140::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,is219?524288:16777216);
   for (int i=0; i<totalChans; i++) {
     delete oscBuf[i];
   }
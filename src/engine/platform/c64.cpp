@@ -137,12 +137,16 @@ void DivPlatformC64::processDAC(int sRate) {
   if (didWrite && !isMuted[3]) updateVolume();
 }
 
+// longest run of samples clocked at once
+#define C64_MAX_RUN 256
+
 void DivPlatformC64::acquire(short** buf, size_t len) {
   int dcOff=(sidCore)?0:sid->get_dc(0);
+  int taps[4*(C64_MAX_RUN/4+1)];
   for (int i=0; i<4; i++) {
     oscBuf[i]->begin(len);
   }
-  for (size_t i=0; i<len; i++) {
+  for (size_t i=0; i<len;) {
     // run PCM
     pcmCycle+=lineRate;
     while (pcmCycle>=(rate*2)) {
@@ -163,42 +167,89 @@ void DivPlatformC64::acquire(short** buf, size_t len) {
       regPool[w.addr&0x1f]=w.val;
       writes.pop();
     }
+
+    // one write is applied per sample. once they are done, clock
+    // everything up to the next PCM step in one go.
+    size_t run=1;
+    if (writes.empty()) {
+      run=MIN(len-i,C64_MAX_RUN);
+      if (chan[3].sample>=0) {
+        size_t untilPCM=(size_t)((rate*2-pcmCycle+lineRate-1)/lineRate);
+        if (run>untilPCM) run=untilPCM;
+        pcmCycle+=(run-1)*lineRate;
+      } else {
+        // PCM steps do nothing without a sample
+        pcmCycle=(pcmCycle+(run-1)*lineRate)%(rate*2);
+      }
+    }
+
     if (sidCore==2) {
-      double o=dSID_render(sid_d);
-      buf[0][i]=32767*CLAMP(o,-1.0,1.0);
-      if (++writeOscBuf>=4) {
-        writeOscBuf=0;
-        oscBuf[0]->putSample(i,sid_d->lastOut[0]);
-        oscBuf[1]->putSample(i,sid_d->lastOut[1]);
-        oscBuf[2]->putSample(i,sid_d->lastOut[2]);
-        oscBuf[3]->putSample(i,isMuted[3]?0:(chan[3].pcmOut<<11));
+      for (size_t j=i; j<i+run; j++) {
+        double o=dSID_render(sid_d);
+        buf[0][j]=32767*CLAMP(o,-1.0,1.0);
+        if (++writeOscBuf>=4) {
+          writeOscBuf=0;
+          oscBuf[0]->putSample(j,sid_d->lastOut[0]);
+          oscBuf[1]->putSample(j,sid_d->lastOut[1]);
+          oscBuf[2]->putSample(j,sid_d->lastOut[2]);
+          oscBuf[3]->putSample(j,isMuted[3]?0:(chan[3].pcmOut<<11));
+        }
       }
     } else if (sidCore==1) {
-      sid_fp->clock(4,&buf[0][i]);
-      if (++writeOscBuf>=4) {
-        writeOscBuf=0;
-        oscBuf[0]->putSample(i,runFakeFilter(0,(sid_fp->lastChanOut[0]-dcOff)>>5));
-        oscBuf[1]->putSample(i,runFakeFilter(1,(sid_fp->lastChanOut[1]-dcOff)>>5));
-        oscBuf[2]->putSample(i,runFakeFilter(2,(sid_fp->lastChanOut[2]-dcOff)>>5));
-        oscBuf[3]->putSample(i,isMuted[3]?0:(chan[3].pcmOut<<11));
+      int tapCount=0;
+      sid_fp->clockTapped(run*4,&buf[0][i],taps,4,writeOscBuf,tapCount);
+      for (int t=0; t<tapCount; t++) {
+        const int* tap=&taps[t<<2];
+        oscBuf[0]->putSample(i+tap[0],runFakeFilter(0,(tap[1]-dcOff)>>5));
+        oscBuf[1]->putSample(i+tap[0],runFakeFilter(1,(tap[2]-dcOff)>>5));
+        oscBuf[2]->putSample(i+tap[0],runFakeFilter(2,(tap[3]-dcOff)>>5));
+        oscBuf[3]->putSample(i+tap[0],isMuted[3]?0:(chan[3].pcmOut<<11));
       }
     } else {
-      sid->clock();
-      buf[0][i]=sid->output();
-      if (++writeOscBuf>=16) {
-        writeOscBuf=0;
-        oscBuf[0]->putSample(i,runFakeFilter(0,(sid->last_chan_out[0]-dcOff)>>5));
-        oscBuf[1]->putSample(i,runFakeFilter(1,(sid->last_chan_out[1]-dcOff)>>5));
-        oscBuf[2]->putSample(i,runFakeFilter(2,(sid->last_chan_out[2]-dcOff)>>5));
-        oscBuf[3]->putSample(i,isMuted[3]?0:(chan[3].pcmOut<<11));
+      int tapCount=0;
+      sid->clockTapped(run,&buf[0][i],taps,16,writeOscBuf,tapCount);
+      for (int t=0; t<tapCount; t++) {
+        const int* tap=&taps[t<<2];
+        oscBuf[0]->putSample(i+tap[0],runFakeFilter(0,(tap[1]-dcOff)>>5));
+        oscBuf[1]->putSample(i+tap[0],runFakeFilter(1,(tap[2]-dcOff)>>5));
+        oscBuf[2]->putSample(i+tap[0],runFakeFilter(2,(tap[3]-dcOff)>>5));
+        oscBuf[3]->putSample(i+tap[0],isMuted[3]?0:(chan[3].pcmOut<<11));
       }
     }
+    i+=run;
   }
   for (int i=0; i<4; i++) {
     oscBuf[i]->end(len);
   }
 }
 
+bool DivPlatformC64::isIdle() {
+  // dSID can't be skipped, and the PCM channel writes the volume register
+  if (sidCore==2 || chan[3].sample>=0) return false;
+  if (!writes.empty()) return false;
+  if (sidCore==1) return sid_fp->isIdle();
+  return sid->isIdle();
+}
+
+void DivPlatformC64::skipIdle(size_t len) {
+  // PCM steps do nothing without a sample
+  pcmCycle=(int)(((size_t)pcmCycle+len*lineRate)%(rate*2));
+
+  if (sidCore==1) {
+    sid_fp->clockIdle(len*4);
+    writeOscBuf=(writeOscBuf+len)%4;
+  } else {
+    sid->clockIdle(len);
+    writeOscBuf=(writeOscBuf+len)%16;
+  }
+
+  // the oscilloscopes keep the last value
+  for (int i=0; i<4; i++) {
+    oscBuf[i]->begin(len);
+    oscBuf[i]->end(len);
+  }
+}
+
 void DivPlatformC64::updateFilter() {
   rWrite(0x15,filtCut&7);
   rWrite(0x16,filtCut>>3);
@@ -114,6 +114,8 @@ class DivPlatformC64: public DivDispatch {
   void updateVolume();
   public:
     void acquire(short** buf, size_t len);
+    bool isIdle();
+    void skipIdle(size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
     DivDispatchOscBuffer* getOscBuffer(int chan);
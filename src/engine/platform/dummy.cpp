@@ -54,6 +54,21 @@ void DivPlatformDummy::acquire(short** buf, size_t len) {
   }
 }
 
+bool DivPlatformDummy::isIdle() {
+  for (int i=0; i<chans; i++) {
+    if (chan[i].active) return false;
+  }
+  return true;
+}
+
+void DivPlatformDummy::skipIdle(size_t len) {
+  for (int i=0; i<chans; i++) {
+    oscBuf[i]->begin(len);
+    oscBuf[i]->putSample(0,0);
+    oscBuf[i]->end(len);
+  }
+}
+
 void DivPlatformDummy::muteChannel(int ch, bool mute) {
   isMuted[ch]=mute;
 }
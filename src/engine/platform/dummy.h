@@ -38,6 +38,8 @@ class DivPlatformDummy: public DivDispatch {
   friend void putDispatchChan(void*,int,int);
   public:
     void acquire(short** buf, size_t len);
+    bool isIdle();
+    void skipIdle(size_t len);
     void muteChannel(int ch, bool mute);
     int dispatch(DivCommand c);
     void notifyInsDeletion(void* ins);
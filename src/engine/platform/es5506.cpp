@@ -19,6 +19,7 @@
 
 #include "es5506.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -1445,7 +1446,7 @@ const DivMemoryComposition* DivPlatformES5506::getMemCompo(int index) {
 }
 
 void DivPlatformES5506::renderSamples(int sysID) {
-  memset(sampleMem,0,getSampleMemCapacity());
+  DivLazyMem::clear(sampleMem,getSampleMemCapacity());
   memset(sampleOffES5506,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -1492,10 +1493,11 @@ void DivPlatformES5506::renderSamples(int sysID) {
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=16777216;
+  memCompo.resident=DivLazyMem::resident(sampleMem,getSampleMemCapacity());
 }
 
 int DivPlatformES5506::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
-  sampleMem=new signed short[getSampleMemCapacity()/sizeof(short)];
+  sampleMem=(signed short*)DivLazyMem::alloc(getSampleMemCapacity());
   sampleMemLen=0;
   parent=p;
   dumpWrites=false;
@@ -1515,7 +1517,7 @@ int DivPlatformES5506::init(DivEngine* p, int channels, int sugRate, const DivCo
 }
 
 void DivPlatformES5506::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,getSampleMemCapacity());
   for (int i=0; i<32; i++) {
     delete oscBuf[i];
   }
@@ -94,8 +94,11 @@ class DivOPNInterface: public ymfm::ymfm_interface {
   public:
     void clock(int cycles=144);
     void ymfm_set_timer(uint32_t tnum, int32_t duration_in_clocks);
+    bool timersStopped() { return setA<0 && setB<0; }
     DivOPNInterface():
       ymfm::ymfm_interface(),
+      setA(-1),
+      setB(-1),
       countA(0),
       countB(0) {}
 };
@@ -19,6 +19,7 @@
 
 #include "ga20.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -488,7 +489,7 @@ const DivMemoryComposition* DivPlatformGA20::getMemCompo(int index) {
 }
 
 void DivPlatformGA20::renderSamples(int sysID) {
-  memset(sampleMem,0x00,getSampleMemCapacity());
+  DivLazyMem::clear(sampleMem,getSampleMemCapacity());
   memset(sampleOffGA20,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -530,6 +531,7 @@ void DivPlatformGA20::renderSamples(int sysID) {
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=1048576;
+  memCompo.resident=DivLazyMem::resident(sampleMem,getSampleMemCapacity());
 }
 
 int DivPlatformGA20::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
@@ -541,7 +543,7 @@ int DivPlatformGA20::init(DivEngine* p, int channels, int sugRate, const DivConf
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[getSampleMemCapacity()];
+  sampleMem=DivLazyMem::alloc(getSampleMemCapacity());
   sampleMemLen=0;
   setFlags(flags);
   ga20BufLen=65536;
@@ -552,7 +554,7 @@ int DivPlatformGA20::init(DivEngine* p, int channels, int sugRate, const DivConf
 }
 
 void DivPlatformGA20::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,getSampleMemCapacity());
   for (int i=0; i<4; i++) {
     delete[] ga20Buf[i];
     delete oscBuf[i];
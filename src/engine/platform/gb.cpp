@@ -268,7 +268,7 @@ void DivPlatformGB::tick(bool sysTick) {
       }
     }
     // run hardware sequence
-    if (chan[i].active) {
+    if (chan[i].active && (!parent->isInputSubTick() || chan[i].hwSeqDelay<=0)) {
       if (--chan[i].hwSeqDelay<=0) {
         chan[i].hwSeqDelay=0;
         DivInstrument* ins=parent->getIns(chan[i].ins,DIV_INS_GB);
@@ -291,7 +291,7 @@ void DivPlatformGB::tick(bool sysTick) {
               chan[i].sweepChanged=true;
               break;
             case DivInstrumentGB::DIV_GB_HWCMD_WAIT:
-              chan[i].hwSeqDelay=(data+1)*parent->tickMult;
+              chan[i].hwSeqDelay=data+1;
               leave=true;
               break;
             case DivInstrumentGB::DIV_GB_HWCMD_WAIT_REL:
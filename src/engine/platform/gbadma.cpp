@@ -20,6 +20,7 @@
 #define _USE_MATH_DEFINES
 #include "gbadma.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../filter.h"
 #include <math.h>
 
@@ -108,6 +109,19 @@ void DivPlatformGBADMA::acquire(short** buf, size_t len) {
   }
 }
 
+bool DivPlatformGBADMA::isIdle() {
+  return !chan[0].active && !chan[1].active;
+}
+
+void DivPlatformGBADMA::skipIdle(size_t len) {
+  for (int i=0; i<2; i++) {
+    chan[i].audDat=0;
+    oscBuf[i]->begin(len);
+    oscBuf[i]->putSample(0,0);
+    oscBuf[i]->end(len);
+  }
+}
+
 void DivPlatformGBADMA::tick(bool sysTick) {
   for (int i=0; i<2; i++) {
     DivInstrument* ins=parent->getIns(chan[i].ins,DIV_INS_AMIGA);
@@ -462,7 +476,7 @@ const DivMemoryComposition* DivPlatformGBADMA::getMemCompo(int index) {
 
 void DivPlatformGBADMA::renderSamples(int sysID) {
   size_t maxPos=getSampleMemCapacity();
-  memset(sampleMem,0,maxPos);
+  DivLazyMem::clear(sampleMem,maxPos);
   memset(sampleOff,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
   romMemCompo.entries.clear();
@@ -493,6 +507,7 @@ void DivPlatformGBADMA::renderSamples(int sysID) {
   }
   sampleMemLen=memPos;
   romMemCompo.used=sampleMemLen;
+  romMemCompo.resident=DivLazyMem::resident(sampleMem,getSampleMemCapacity());
 }
 
 void DivPlatformGBADMA::setFlags(const DivConfig& flags) {
@@ -520,7 +535,7 @@ int DivPlatformGBADMA::init(DivEngine* p, int channels, int sugRate, const DivCo
     oscBuf[i]=new DivDispatchOscBuffer;
     wtMemCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_WAVE_RAM, fmt::sprintf("Channel %d",i),-1,i*256,i*256));
   }
-  sampleMem=new signed char[getSampleMemCapacity()];
+  sampleMem=(signed char*)DivLazyMem::alloc(getSampleMemCapacity());
   sampleMemLen=0;
   romMemCompo=DivMemoryComposition();
   romMemCompo.name="Sample ROM";
@@ -530,7 +545,7 @@ int DivPlatformGBADMA::init(DivEngine* p, int channels, int sugRate, const DivCo
 }
 
 void DivPlatformGBADMA::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,getSampleMemCapacity());
   for (int i=0; i<2; i++) {
     delete oscBuf[i];
   }
@@ -70,6 +70,8 @@ class DivPlatformGBADMA: public DivDispatch {
 
   public:
     void acquire(short** buf, size_t len);
+    bool isIdle();
+    void skipIdle(size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
     DivDispatchOscBuffer* getOscBuffer(int chan);
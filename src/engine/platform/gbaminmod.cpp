@@ -19,6 +19,7 @@
 
 #include "gbaminmod.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -689,7 +690,7 @@ const DivMemoryComposition* DivPlatformGBAMinMod::getMemCompo(int index) {
 
 void DivPlatformGBAMinMod::renderSamples(int sysID) {
   size_t maxPos=getSampleMemCapacity();
-  memset(sampleMem,0,maxPos);
+  DivLazyMem::clear(sampleMem,maxPos);
   memset(sampleOff,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
   romMemCompo.entries.clear();
@@ -727,6 +728,7 @@ void DivPlatformGBAMinMod::renderSamples(int sysID) {
   }
   sampleMemLen=memPos;
   romMemCompo.used=sampleMemLen;
+  romMemCompo.resident=DivLazyMem::resident(sampleMem,getSampleMemCapacity());
 }
 
 void DivPlatformGBAMinMod::setFlags(const DivConfig& flags) {
@@ -762,7 +764,7 @@ int DivPlatformGBAMinMod::init(DivEngine* p, int channels, int sugRate, const Di
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new signed char[getSampleMemCapacity()];
+  sampleMem=(signed char*)DivLazyMem::alloc(getSampleMemCapacity());
   sampleMemLen=0;
   romMemCompo=DivMemoryComposition();
   romMemCompo.name="Sample ROM";
@@ -785,7 +787,7 @@ int DivPlatformGBAMinMod::init(DivEngine* p, int channels, int sugRate, const Di
 }
 
 void DivPlatformGBAMinMod::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,getSampleMemCapacity());
   for (int i=0; i<16; i++) {
     delete oscBuf[i];
   }
@@ -651,6 +651,32 @@ void DivPlatformGenesis::acquire(short** buf, size_t len) {
   }
 }
 
+bool DivPlatformGenesis::isIdle() {
+  // only the ymfm core can be skipped
+  if (useYMFM!=1) return false;
+  if (!writes.empty() || dacWrite>=0) return false;
+  // software PCM writes the DAC on every period, and the timers may key on (CSM)
+  if (softPCM || !iface.timersStopped()) return false;
+  if (chan[5].dacMode && chan[5].dacSample!=-1) return false;
+  return fm_ymfm->debug_engine()->is_idle();
+}
+
+void DivPlatformGenesis::skipIdle(size_t len) {
+  // same as processDAC() and the write queue with nothing to do
+  if (interruptSim>0) interruptSim-=MIN((size_t)interruptSim,len);
+  if (delay>0) delay-=MIN((size_t)delay,len);
+  canWriteDAC=true;
+  flushFirst=false;
+
+  fm_ymfm->debug_engine()->skip_idle(len);
+
+  // the oscilloscopes keep the last value
+  for (int i=0; i<7; i++) {
+    oscBuf[i]->begin(len);
+    oscBuf[i]->end(len);
+  }
+}
+
 void DivPlatformGenesis::fillStream(std::vector<DivDelayedWrite>& stream, int sRate, size_t len) {
   writes.clear();
   for (size_t i=0; i<len; i++) {
@@ -103,6 +103,8 @@ class DivPlatformGenesis: public DivPlatformOPN {
     friend void putDispatchChan(void*,int,int);
   public:
     void acquire(short** buf, size_t len);
+    bool isIdle();
+    void skipIdle(size_t len);
     void fillStream(std::vector<DivDelayedWrite>& stream, int sRate, size_t len);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
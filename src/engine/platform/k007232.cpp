@@ -19,6 +19,7 @@
 
 #include "k007232.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -126,7 +127,10 @@ void DivPlatformK007232::acquireDirect(blip_buffer_t** bb, size_t len) {
 
 u8 DivPlatformK007232::read_sample(u8 ne, u32 address) {
   if ((sampleMem!=NULL) && (address<getSampleMemCapacity())) {
-    return sampleMem[((regPool[0x12+(ne&1)]<<17)|(address&0x1ffff))&0xffffff];
+    unsigned int pos=((regPool[0x12+(ne&1)]<<17)|(address&0x1ffff))&0xffffff;
+    // unused memory is left unallocated and reads as end of sample
+    if (pos>=sampleMemLen) return 0xc0;
+    return sampleMem[pos];
   }
   return 0;
 }
@@ -565,7 +569,7 @@ const DivMemoryComposition* DivPlatformK007232::getMemCompo(int index) {
 }
 
 void DivPlatformK007232::renderSamples(int sysID) {
-  memset(sampleMem,0xc0,getSampleMemCapacity());
+  DivLazyMem::clear(sampleMem,getSampleMemCapacity());
   memset(sampleOffK007232,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -587,7 +591,9 @@ void DivPlatformK007232::renderSamples(int sysID) {
         actualLength=131072-2;
       }
       if ((memPos&0xfe0000)!=((memPos+actualLength+1)&0xfe0000)) {
-        memPos=(memPos+0x1ffff)&0xfe0000;
+        size_t nextBank=(memPos+0x1ffff)&0xfe0000;
+        memset(&sampleMem[memPos],0xc0,nextBank-memPos);
+        memPos=nextBank;
       }
       sampleOffK007232[i]=memPos;
       memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+actualLength+1));
@@ -611,6 +617,7 @@ void DivPlatformK007232::renderSamples(int sysID) {
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=16777216;
+  memCompo.resident=DivLazyMem::resident(sampleMem,getSampleMemCapacity());
 }
 
 int DivPlatformK007232::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
@@ -622,7 +629,7 @@ int DivPlatformK007232::init(DivEngine* p, int channels, int sugRate, const DivC
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[getSampleMemCapacity()];
+  sampleMem=DivLazyMem::alloc(getSampleMemCapacity());
   sampleMemLen=0;
   setFlags(flags);
   reset();
@@ -631,7 +638,7 @@ int DivPlatformK007232::init(DivEngine* p, int channels, int sugRate, const DivC
 }
 
 void DivPlatformK007232::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,getSampleMemCapacity());
   for (int i=0; i<2; i++) {
     delete oscBuf[i];
   }
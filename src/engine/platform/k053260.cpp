@@ -19,6 +19,7 @@
 
 #include "k053260.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -480,7 +481,7 @@ const DivMemoryComposition* DivPlatformK053260::getMemCompo(int index) {
 }
 
 void DivPlatformK053260::renderSamples(int sysID) {
-  memset(sampleMem,0,getSampleMemCapacity());
+  DivLazyMem::clear(sampleMem,getSampleMemCapacity());
   memset(sampleOff,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -530,6 +531,7 @@ void DivPlatformK053260::renderSamples(int sysID) {
 
   memCompo.capacity=2097152;
   memCompo.used=sampleMemLen;
+  memCompo.resident=DivLazyMem::resident(sampleMem,getSampleMemCapacity());
 }
 
 int DivPlatformK053260::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
@@ -541,7 +543,7 @@ int DivPlatformK053260::init(DivEngine* p, int channels, int sugRate, const DivC
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[getSampleMemCapacity()];
+  sampleMem=DivLazyMem::alloc(getSampleMemCapacity());
   sampleMemLen=0;
   setFlags(flags);
   reset();
@@ -550,7 +552,7 @@ int DivPlatformK053260::init(DivEngine* p, int channels, int sugRate, const DivC
 }
 
 void DivPlatformK053260::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,getSampleMemCapacity());
   for (int i=0; i<4; i++) {
     delete oscBuf[i];
   }
@@ -19,6 +19,7 @@
 
 #include "msm6295.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <string.h>
 #include <math.h>
@@ -397,7 +398,7 @@ const DivMemoryComposition* DivPlatformMSM6295::getMemCompo(int index) {
 void DivPlatformMSM6295::renderSamples(int sysID) {
   unsigned int* sampleOffVOX=new unsigned int[32768];
 
-  memset(adpcmMem,0,16777216);
+  DivLazyMem::clear(adpcmMem,16777216);
   memset(sampleOffVOX,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
   for (int i=0; i<32768; i++) {
@@ -525,6 +526,7 @@ void DivPlatformMSM6295::renderSamples(int sysID) {
   memCompo.used=adpcmMemLen;
 
   delete[] sampleOffVOX;
+  memCompo.resident=DivLazyMem::resident(adpcmMem,16777216);
 }
 
 void DivPlatformMSM6295::setFlags(const DivConfig& flags) {
@@ -594,7 +596,7 @@ void DivPlatformMSM6295::setFlags(const DivConfig& flags) {
 
 int DivPlatformMSM6295::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
   parent=p;
-  adpcmMem=new unsigned char[16777216];
+  adpcmMem=DivLazyMem::alloc(16777216);
   adpcmMemLen=0;
   dumpWrites=false;
   skipRegisterWrites=false;
@@ -612,7 +614,7 @@ void DivPlatformMSM6295::quit() {
   for (int i=0; i<4; i++) {
     delete oscBuf[i];
   }
-  delete[] adpcmMem;
+  DivLazyMem::free(adpcmMem,16777216);
 }
 
 // initialization of important arrays
@@ -19,6 +19,7 @@
 
 #include "nds.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -541,7 +542,7 @@ const DivMemoryComposition* DivPlatformNDS::getMemCompo(int index) {
 }
 
 void DivPlatformNDS::renderSamples(int sysID) {
-  memset(sampleMem,0,16777216);
+  DivLazyMem::clear(sampleMem,16777216);
   memset(sampleOff,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -592,6 +593,7 @@ void DivPlatformNDS::renderSamples(int sysID) {
 
   memCompo.capacity=(isDSi?16777216:4194304);
   memCompo.used=sampleMemLen;
+  memCompo.resident=DivLazyMem::resident(sampleMem,16777216);
 }
 
 void DivPlatformNDS::setFlags(const DivConfig& flags) {
@@ -614,7 +616,7 @@ int DivPlatformNDS::init(DivEngine* p, int channels, int sugRate, const DivConfi
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[16777216];
+  sampleMem=DivLazyMem::alloc(16777216);
   sampleMemLen=0;
   nds.reset();
   setFlags(flags);
@@ -624,7 +626,7 @@ int DivPlatformNDS::init(DivEngine* p, int channels, int sugRate, const DivConfi
 }
 
 void DivPlatformNDS::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,16777216);
   for (int i=0; i<16; i++) {
     delete oscBuf[i];
   }
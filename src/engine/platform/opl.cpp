@@ -19,6 +19,7 @@
 
 #include "opl.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../bsr.h"
 #include "../../ta-log.h"
 #include <string.h>
@@ -1071,6 +1072,54 @@ void DivPlatformOPL::acquire(short** buf, size_t len) {
   }
 }
 
+bool DivPlatformOPL::isIdle() {
+  // only the ymfm cores without ADPCM or PCM can be skipped
+  if (emuCore!=1) return false;
+  if (!writes.empty()) return false;
+  switch (chipType) {
+    case 1:
+      return fm_ymfm1->debug_fm_engine()->is_idle();
+    case 2:
+      return fm_ymfm2->debug_fm_engine()->is_idle();
+    case 3: case 759:
+      return fm_ymfm3->debug_fm_engine()->is_idle();
+  }
+  return false;
+}
+
+void DivPlatformOPL::skipIdle(size_t len) {
+  switch (chipType) {
+    case 1:
+      fm_ymfm1->debug_fm_engine()->skip_idle(len);
+      break;
+    case 2:
+      fm_ymfm2->debug_fm_engine()->skip_idle(len);
+      break;
+    case 3: case 759: {
+      // the downsampler clocks the chip once more on every overflow
+      size_t clocks=len;
+      if (downsample) {
+        for (size_t h=0; h<len; h++) {
+          downsamplerStep+=5616;
+          while (downsamplerStep>=44100) {
+            downsamplerStep-=44100;
+            downsamplerStep+=5616;
+            clocks++;
+          }
+        }
+      }
+      fm_ymfm3->debug_fm_engine()->skip_idle(clocks);
+      break;
+    }
+  }
+
+  // the oscilloscopes keep the last value
+  for (int i=0; i<totalChans; i++) {
+    oscBuf[i]->begin(len);
+    oscBuf[i]->end(len);
+  }
+}
+
 double DivPlatformOPL::NOTE_ADPCMB(int note) {
   if (adpcmChan<0) return 0;
   if (chan[adpcmChan].sample>=0 && chan[adpcmChan].sample<parent->song.sampleLen) {
@@ -3262,7 +3311,7 @@ void DivPlatformOPL::renderSamples(int sysID) {
     memset(adpcmBMem,0,262144);
   }
   if (pcmChanOffs>=0 && pcmMem!=NULL) {
-    memset(pcmMem,0,4194304);
+    DivLazyMem::clear(pcmMem,4194304);
   }
   memset(sampleOffPCM,0,32768*sizeof(unsigned int));
   memset(sampleOffB,0,32768*sizeof(unsigned int));
@@ -3385,6 +3434,7 @@ void DivPlatformOPL::renderSamples(int sysID) {
     }
 
     memCompo.used=pcmMemLen;
+    memCompo.resident=DivLazyMem::resident(pcmMem,4194304);
   } else if (adpcmChan>=0) { // ADPCM
     size_t memPos=0;
     for (int i=0; i<parent->song.sampleLen; i++) {
@@ -3468,7 +3518,7 @@ int DivPlatformOPL::init(DivEngine* p, int channels, int sugRate, const DivConfi
   }
 
   if (pcmChanOffs>=0) {
-    pcmMem=new unsigned char[4194304];
+    pcmMem=DivLazyMem::alloc(4194304);
     pcmMemLen=0;
     iface.pcmMem=pcmMem;
     iface.sampleBank=0;
@@ -3488,7 +3538,7 @@ void DivPlatformOPL::quit() {
     delete[] adpcmBMem;
   }
   if (pcmChanOffs>=0) {
-    delete[] pcmMem;
+    DivLazyMem::free(pcmMem,4194304);
   }
   if (fm_ymfm1!=NULL) {
     delete fm_ymfm1;
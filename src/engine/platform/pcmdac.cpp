@@ -246,6 +246,16 @@ void DivPlatformPCMDAC::acquire(short** buf, size_t len) {
   oscBuf->end(len);
 }
 
+bool DivPlatformPCMDAC::isIdle() {
+  return !chan[0].active;
+}
+
+void DivPlatformPCMDAC::skipIdle(size_t len) {
+  oscBuf->begin(len);
+  oscBuf->putSample(0,0);
+  oscBuf->end(len);
+}
+
 void DivPlatformPCMDAC::tick(bool sysTick) {
   chan[0].std.next();
   if (chan[0].std.vol.had) {
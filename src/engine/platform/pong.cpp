@@ -44,6 +44,17 @@ void DivPlatformPong::acquire(short** buf, size_t len) {
   oscBuf->end(len);
 }
 
+bool DivPlatformPong::isIdle() {
+  return !on;
+}
+
+void DivPlatformPong::skipIdle(size_t len) {
+  flip=false;
+  oscBuf->begin(len);
+  oscBuf->putSample(0,0);
+  oscBuf->end(len);
+}
+
 void DivPlatformPong::tick(bool sysTick) {
   for (int i=0; i<1; i++) {
     chan[i].std.next();
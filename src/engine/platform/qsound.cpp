@@ -19,6 +19,7 @@
 
 #include "qsound.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -767,7 +768,7 @@ const DivMemoryComposition* DivPlatformQSound::getMemCompo(int index) {
 }
 
 void DivPlatformQSound::renderSamples(int sysID) {
-  memset(sampleMem,0,getSampleMemCapacity());
+  DivLazyMem::clear(sampleMem,getSampleMemCapacity());
   memset(offPCM,0,32768*sizeof(unsigned int));
   memset(offBS,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
@@ -852,6 +853,7 @@ void DivPlatformQSound::renderSamples(int sysID) {
 
   memCompo.used=sampleMemLenBS;
   memCompo.capacity=getSampleMemCapacity(0);
+  memCompo.resident=DivLazyMem::resident(sampleMem,getSampleMemCapacity());
 }
 
 int DivPlatformQSound::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
@@ -867,7 +869,7 @@ int DivPlatformQSound::init(DivEngine* p, int channels, int sugRate, const DivCo
 
   chipClock=60000000;
   rate = qsound_start(&chip, chipClock);
-  sampleMem=new unsigned char[getSampleMemCapacity()];
+  sampleMem=DivLazyMem::alloc(getSampleMemCapacity());
   sampleMemLen=0;
   sampleMemLenBS=0;
   sampleMemUsage=0;
@@ -882,7 +884,7 @@ int DivPlatformQSound::init(DivEngine* p, int channels, int sugRate, const DivCo
 }
 
 void DivPlatformQSound::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,getSampleMemCapacity());
   for (int i=0; i<19; i++) {
     delete oscBuf[i];
   }
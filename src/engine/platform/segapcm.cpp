@@ -19,6 +19,7 @@
 
 #include "segapcm.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <string.h>
 #include <math.h>
@@ -508,7 +509,7 @@ const DivMemoryComposition* DivPlatformSegaPCM::getMemCompo(int index) {
 void DivPlatformSegaPCM::renderSamples(int sysID) {
   size_t memPos=0;
 
-  memset(sampleMem,0,2097152);
+  DivLazyMem::clear(sampleMem,2097152);
   memset(sampleLoaded,0,32768*sizeof(bool));
   memset(sampleOffSegaPCM,0,32768*sizeof(unsigned int));
   memset(sampleEndSegaPCM,0,32768);
@@ -552,6 +553,7 @@ void DivPlatformSegaPCM::renderSamples(int sysID) {
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=getSampleMemCapacity(0);
+  memCompo.resident=DivLazyMem::resident(sampleMem,2097152);
 }
 
 void DivPlatformSegaPCM::setFlags(const DivConfig& flags) {
@@ -577,7 +579,7 @@ int DivPlatformSegaPCM::init(DivEngine* p, int channels, int sugRate, const DivC
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[2097152];
+  sampleMem=DivLazyMem::alloc(2097152);
   pcm.set_bank(segapcm_device::BANK_12M|segapcm_device::BANK_MASKF8);
   pcm.set_read([this](unsigned int addr) -> unsigned char {
     return sampleMem[addr&0x1fffff];
@@ -592,7 +594,7 @@ void DivPlatformSegaPCM::quit() {
   for (int i=0; i<16; i++) {
     delete oscBuf[i];
   }
-  delete sampleMem;
+  DivLazyMem::free(sampleMem,2097152);
 }
 
 // initialization of important arrays
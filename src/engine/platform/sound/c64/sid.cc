@@ -663,15 +663,34 @@ void SID::clock()
 
 
 // ----------------------------------------------------------------------------
-// SID clocking - delta_t cycles.
+// SID clocking - n cycles, producing one sample per cycle.
+// this is the same as calling clock() and output() n times, but in one call.
 // ----------------------------------------------------------------------------
-void SID::clock(cycle_count delta_t)
+void SID::clockTapped(cycle_count n, short* buf, int* taps, int tapRate, unsigned char& tapPos, int& tapCount)
 {
-  int i;
-
-  if (delta_t <= 0) {
-    return;
+  tapCount = 0;
+  for (cycle_count s = 0; s < n; s++) {
+    clock();
+    buf[s] = output();
+    if (++tapPos >= tapRate) {
+      tapPos = 0;
+      taps[0] = s;
+      taps[1] = last_chan_out[0];
+      taps[2] = last_chan_out[1];
+      taps[3] = last_chan_out[2];
+      taps += 4;
+      tapCount++;
+    }
   }
+}
+
+
+// ----------------------------------------------------------------------------
+// Clock bus, envelopes and oscillators - delta_t cycles.
+// ----------------------------------------------------------------------------
+void SID::clock_voices(cycle_count delta_t)
+{
+  int i;
 
   // Age bus value.
   bus_value_ttl -= delta_t;
@@ -732,6 +751,79 @@ void SID::clock(cycle_count delta_t)
 
     delta_t_osc -= delta_t_min;
   }
+}
+
+
+// ----------------------------------------------------------------------------
+// Check whether the SID is idle (for Furnace).
+// once every envelope is frozen at zero the voice outputs are constant, and
+// after the filters have settled on a fixed point, clocking only advances
+// the oscillators and counters.
+// ----------------------------------------------------------------------------
+bool SID::isIdle()
+{
+  int i;
+  sound_sample v[3];
+
+  for (i = 0; i < 3; i++) {
+    if (!voice[i].envelope.hold_zero) {
+      return false;
+    }
+    v[i] = isMuted[i] ? 0 : voice[i].output();
+  }
+
+  // Clock the filters once and check whether their state changes.
+  sound_sample Vhp = filter.Vhp, Vbp = filter.Vbp, Vlp = filter.Vlp, Vnf = filter.Vnf;
+  sound_sample extVlp = extfilt.Vlp, extVhp = extfilt.Vhp, extVo = extfilt.Vo;
+
+  filter.clock(v[0], v[1], v[2], ext_in);
+  extfilt.clock(filter.output());
+
+  bool settled = (filter.Vhp == Vhp && filter.Vbp == Vbp && filter.Vlp == Vlp &&
+                  filter.Vnf == Vnf && extfilt.Vlp == extVlp &&
+                  extfilt.Vhp == extVhp && extfilt.Vo == extVo);
+
+  filter.Vhp = Vhp;
+  filter.Vbp = Vbp;
+  filter.Vlp = Vlp;
+  filter.Vnf = Vnf;
+  extfilt.Vlp = extVlp;
+  extfilt.Vhp = extVhp;
+  extfilt.Vo = extVo;
+
+  return settled;
+}
+
+
+// ----------------------------------------------------------------------------
+// SID clocking while idle - delta_t cycles (for Furnace).
+// this is the same as clocking delta_t times, but the filters are skipped
+// since their state does not change.
+// ----------------------------------------------------------------------------
+void SID::clockIdle(cycle_count delta_t)
+{
+  if (delta_t <= 0) {
+    return;
+  }
+
+  clock_voices(delta_t);
+
+  last_chan_out[0]=isMuted[0]?0:voice[0].output();
+  last_chan_out[1]=isMuted[1]?0:voice[1].output();
+  last_chan_out[2]=isMuted[2]?0:voice[2].output();
+}
+
+
+// ----------------------------------------------------------------------------
+// SID clocking - delta_t cycles.
+// ----------------------------------------------------------------------------
+void SID::clock(cycle_count delta_t)
+{
+  if (delta_t <= 0) {
+    return;
+  }
+
+  clock_voices(delta_t);
 
   // write voice output
   last_chan_out[0]=isMuted[0]?0:voice[0].output();
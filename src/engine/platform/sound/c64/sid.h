@@ -49,6 +49,15 @@ public:
 
   void clock();
   void clock(cycle_count delta_t);
+  // clock n cycles with one output sample per cycle (for Furnace).
+  // every tapRate-th sample, its index and the voice outputs are written to taps.
+  void clockTapped(cycle_count n, short* buf, int* taps, int tapRate, unsigned char& tapPos, int& tapCount);
+  // whether every envelope is frozen at zero and the filters have settled (for
+  // Furnace). while this is true the output is constant, and clockIdle() may be
+  // used instead of clock().
+  bool isIdle();
+  // clock an idle SID for delta_t cycles, leaving the filters alone.
+  void clockIdle(cycle_count delta_t);
   int clock(cycle_count& delta_t, short* buf, int n, int interleave = 1);
   void reset();
   
@@ -91,6 +100,7 @@ public:
 
 protected:
   static double I0(double x);
+  void clock_voices(cycle_count delta_t);
   RESID_INLINE int clock_fast(cycle_count& delta_t, short* buf, int n,
 			      int interleave);
   RESID_INLINE int clock_interpolate(cycle_count& delta_t, short* buf, int n,
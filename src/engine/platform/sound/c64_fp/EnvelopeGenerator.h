@@ -129,6 +129,11 @@ public:
      */
     unsigned int output() const { return envelope_counter; }
 
+    /**
+     * Whether the envelope is frozen at zero until the next gate (for Furnace).
+     */
+    bool isIdle() const { return envelope_counter == 0 && !counter_enabled && state_pipeline == 0; }
+
     /**
      * Constructor.
      */
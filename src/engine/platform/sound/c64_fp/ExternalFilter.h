@@ -82,6 +82,14 @@ public:
      */
     int clock(unsigned short input);
 
+    /**
+     * Check whether clocking with the given input would leave the
+     * filter state unchanged (for Furnace).
+     *
+     * @param input
+     */
+    bool isSettled(unsigned short input) const;
+
     /**
      * Constructor.
      */
@@ -118,6 +126,13 @@ int ExternalFilter::clock(unsigned short input)
     return (Vlp - Vhp) >> 11;
 }
 
+RESID_INLINE
+bool ExternalFilter::isSettled(unsigned short input) const
+{
+    const int Vi = (static_cast<unsigned int>(input)<<11) - (1 << (11+15));
+    return ((w0lp_1_s7 * (Vi - Vlp) >> 7) == 0) && ((w0hp_1_s17 * (Vlp - Vhp) >> 17) == 0);
+}
+
 } // namespace reSIDfp
 
 #endif
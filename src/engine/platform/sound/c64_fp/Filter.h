@@ -129,6 +129,18 @@ public:
      */
     virtual unsigned short clock(int v1, int v2, int v3) = 0;
 
+    /**
+     * Check whether clocking with the given voice outputs would leave the
+     * filter state unchanged (for Furnace).
+     *
+     * @param v1 voice 1 in
+     * @param v2 voice 2 in
+     * @param v3 voice 3 in
+     * @param out receives the filtered output
+     * @return whether the filter has settled
+     */
+    virtual bool isSettled(int v1, int v2, int v3, unsigned short& out) = 0;
+
     /**
      * Enable filter.
      *
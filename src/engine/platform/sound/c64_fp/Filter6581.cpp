@@ -72,4 +72,31 @@ void Filter6581::setFilterCurve(double curvePosition)
     updatedCenterFrequency();
 }
 
+bool Filter6581::isSettled(int voice1, int voice2, int voice3, unsigned short& out)
+{
+    const int hp = Vhp;
+    const int bp = Vbp;
+    const int lp = Vlp;
+    int hpx, hpc, bpx, bpc;
+    hpIntegrator->getState(hpx, hpc);
+    bpIntegrator->getState(bpx, bpc);
+
+    out = clock(voice1, voice2, voice3);
+
+    int hpx1, hpc1, bpx1, bpc1;
+    hpIntegrator->getState(hpx1, hpc1);
+    bpIntegrator->getState(bpx1, bpc1);
+
+    const bool settled = (Vhp == hp) && (Vbp == bp) && (Vlp == lp)
+        && (hpx1 == hpx) && (hpc1 == hpc) && (bpx1 == bpx) && (bpc1 == bpc);
+
+    Vhp = hp;
+    Vbp = bp;
+    Vlp = lp;
+    hpIntegrator->setState(hpx, hpc);
+    bpIntegrator->setState(bpx, bpc);
+
+    return settled;
+}
+
 } // namespace reSIDfp
@@ -332,6 +332,8 @@ public:
 
     unsigned short clock(int voice1, int voice2, int voice3) override;
 
+    bool isSettled(int voice1, int voice2, int voice3, unsigned short& out) override;
+
     void input(int sample) override { ve = (sample * voiceScaleS11 * 3 >> 11) + mixer[0][0]; }
 
     /**
@@ -98,6 +98,13 @@ public:
     }
 
     int solve(int vi) const;
+
+    /**
+     * Get/set the integrator state, to check whether the filter has
+     * settled (for Furnace).
+     */
+    void getState(int& x, int& c) const { x = vx; c = vc; }
+    void setState(int x, int c) { vx = x; vc = c; }
 };
 
 } // namespace reSIDfp
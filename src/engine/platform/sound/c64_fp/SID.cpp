@@ -501,4 +501,73 @@ void SID::clockSilent(unsigned int cycles)
     }
 }
 
+bool SID::isIdle()
+{
+    for (int i = 0; i < 3; i++)
+    {
+        if (!voice[i]->envelope()->isIdle())
+        {
+            return false;
+        }
+    }
+
+    // the voice outputs are zero while the envelopes are
+    unsigned short out;
+    if (!filter->isSettled(0, 0, 0, out) || !externalFilter->isSettled(out))
+    {
+        return false;
+    }
+
+    // the resampler interpolates from the previous input, so it settles
+    // one sample later. clocking the settled external filter leaves it as is.
+    return resampler->isSettled(externalFilter->clock(out));
+}
+
+void SID::clockIdle(unsigned int cycles)
+{
+    // the filter output doesn't change while idle
+    const int sample = externalFilter->clock(filter->clock(0, 0, 0));
+
+    ageBusValue(cycles);
+
+    while (cycles != 0)
+    {
+        int delta_t = std::min(nextVoiceSync, cycles);
+
+        if (delta_t > 0)
+        {
+            for (int i = 0; i < delta_t; i++)
+            {
+                // clock waveform generators
+                voice[0]->wave()->clock();
+                voice[1]->wave()->clock();
+                voice[2]->wave()->clock();
+
+                voice[0]->wave()->output(voice[2]->wave());
+                voice[1]->wave()->output(voice[0]->wave());
+                voice[2]->wave()->output(voice[1]->wave());
+
+                // clock envelope generators
+                voice[0]->envelope()->clock();
+                voice[1]->envelope()->clock();
+                voice[2]->envelope()->clock();
+
+                resampler->input(sample);
+            }
+
+            cycles -= delta_t;
+            nextVoiceSync -= delta_t;
+        }
+
+        if (nextVoiceSync == 0)
+        {
+            voiceSync(true);
+        }
+    }
+
+    lastChanOut[0] = 0;
+    lastChanOut[1] = 0;
+    lastChanOut[2] = 0;
+}
+
 } // namespace reSIDfp
@@ -250,6 +250,20 @@ public:
      */
     int clock(unsigned int cycles, short* buf);
 
+    /**
+     * Clock SID forward like clock(), also saving the voice outputs
+     * every tapRate output samples (for oscilloscopes).
+     *
+     * @param cycles c64 clocks to clock
+     * @param buf audio output buffer
+     * @param taps receives 4 values per tap: output sample index and 3 voice outputs
+     * @param tapRate output samples between taps
+     * @param tapPos output sample counter, carried between calls
+     * @param tapCount receives the number of taps
+     * @return number of samples produced
+     */
+    int clockTapped(unsigned int cycles, short* buf, int* taps, int tapRate, unsigned char& tapPos, int& tapCount);
+
     /**
      * Clock SID forward with no audio production.
      *
@@ -262,6 +276,27 @@ public:
      */
     void clockSilent(unsigned int cycles);
 
+    /**
+     * Check whether the SID is idle (for Furnace).
+     *
+     * The SID is idle once every envelope is frozen at zero (which silences
+     * the voices) and the filters have settled. Until the next register write,
+     * the output is constant and clockIdle() may be used instead of clock().
+     *
+     * @return whether the SID is idle
+     */
+    bool isIdle();
+
+    /**
+     * Clock an idle SID forward with no audio production (for Furnace).
+     *
+     * Unlike clockSilent(), this leaves the SID in the same state as clock()
+     * would. The filters are not clocked since they have settled.
+     *
+     * @param cycles c64 clocks to clock.
+     */
+    void clockIdle(unsigned int cycles);
+
     /**
      * Set filter curve parameter for 6581 model.
      *
@@ -371,6 +406,80 @@ int SID::clock(unsigned int cycles, short* buf)
     return s;
 }
 
+RESID_INLINE
+int SID::clockTapped(unsigned int cycles, short* buf, int* taps, int tapRate, unsigned char& tapPos, int& tapCount)
+{
+    ageBusValue(cycles);
+    int s = 0;
+    int pending = -1;
+    tapCount = 0;
+
+    while (cycles != 0)
+    {
+        unsigned int delta_t = std::min(nextVoiceSync, cycles);
+
+        if (likely(delta_t > 0))
+        {
+            for (unsigned int i = 0; i < delta_t; i++)
+            {
+                // clock waveform generators
+                voice[0]->wave()->clock();
+                voice[1]->wave()->clock();
+                voice[2]->wave()->clock();
+
+                // clock envelope generators
+                voice[0]->envelope()->clock();
+                voice[1]->envelope()->clock();
+                voice[2]->envelope()->clock();
+
+                // a tap holds the voice outputs of the last cycle before the next sample
+                const int last0 = lastChanOut[0];
+                const int last1 = lastChanOut[1];
+                const int last2 = lastChanOut[2];
+
+                if (unlikely(resampler->input(output())))
+                {
+                    if (pending >= 0)
+                    {
+                        taps[0] = pending;
+                        taps[1] = last0;
+                        taps[2] = last1;
+                        taps[3] = last2;
+                        taps += 4;
+                        tapCount++;
+                        pending = -1;
+                    }
+                    if (++tapPos >= tapRate)
+                    {
+                        tapPos = 0;
+                        pending = s;
+                    }
+                    buf[s++] = resampler->getOutput();
+                }
+            }
+
+            cycles -= delta_t;
+            nextVoiceSync -= delta_t;
+        }
+
+        if (unlikely(nextVoiceSync == 0))
+        {
+            voiceSync(true);
+        }
+    }
+
+    if (pending >= 0)
+    {
+        taps[0] = pending;
+        taps[1] = lastChanOut[0];
+        taps[2] = lastChanOut[1];
+        taps[3] = lastChanOut[2];
+        tapCount++;
+    }
+
+    return s;
+}
+
 } // namespace reSIDfp
 
 #endif
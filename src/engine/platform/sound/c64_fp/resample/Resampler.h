@@ -68,6 +68,15 @@ public:
      */
     virtual bool input(int sample) = 0;
 
+    /**
+     * Check whether the output stays the same while the input is constant
+     * (for Furnace).
+     *
+     * @param sample input sample
+     * @return true if every following output is the given sample
+     */
+    virtual bool isSettled(int sample) const { return false; }
+
     /**
      * Output a sample from resampler.
      *
@@ -74,6 +74,11 @@ public:
         return ready;
     }
 
+    bool isSettled(int sample) const override
+    {
+        return (cachedSample == sample) && (outputValue == sample);
+    }
+
     int output() const override { return outputValue; }
 
     void reset() override
@@ -75,6 +75,8 @@ struct opdata_cache
 	uint32_t eg_sustain;              // sustain level, shifted up to envelope values
 	uint8_t eg_rate[EG_STATES];       // envelope rate, including KSR
 	uint8_t eg_shift = 0;             // envelope shift amount
+	uint8_t ssg_eg_enable = 0;        // SSG-EG enable (read every sample)
+	uint8_t lfo_am_enable = 0;        // LFO AM enable (read every sample)
 };
 
 
@@ -202,6 +204,18 @@ public:
 	// key state control
 	void keyonoff(uint32_t on, keyon_type type);
 
+	// furnace: is this operator silent until the next key on? if so, clocking
+	// it only advances the phase
+	bool is_idle() const;
+
+	// furnace: advance the phase of an idle operator by the given number of
+	// clocks; returns false if the phase step depends on the LFO, in which
+	// case the phase has to be advanced on every clock using the step from
+	// idle_phase_step()
+	bool skip_idle(uint32_t clocks);
+	uint32_t idle_phase_step(int32_t lfo_raw_pm) { return m_regs.compute_phase_step(m_choffs, m_opoffs, m_cache, lfo_raw_pm); }
+	void advance_phase(uint32_t phase_step) { m_phase += phase_step; }
+
 	// return a reference to our registers
 	RegisterType &regs() const { return m_regs; }
 
@@ -282,6 +296,9 @@ public:
 	// master clocking function
 	void clock(uint32_t env_counter, int32_t lfo_raw_pm);
 
+	// furnace: is the feedback memory settled? (clocking leaves it unchanged)
+	bool is_idle() const { return m_feedback[0] == m_feedback_in && m_feedback[1] == m_feedback_in; }
+
 	// specific 2-operator and 4-operator output handlers
 	void output_2op(output_data &output, uint32_t rshift, int32_t clipmax) const;
 	void output_4op(output_data &output, uint32_t rshift, int32_t clipmax) const;
@@ -386,9 +403,22 @@ public:
 	// master clocking function
 	uint32_t clock(uint32_t chanmask);
 
+	// furnace: is every operator silent until the next key on or register write?
+	// while this is true, output() doesn't change and skip_idle() may be
+	// called instead of clock()
+	bool is_idle() const;
+
+	// furnace: same as calling clock(ALL_CHANNELS) the given number of times while
+	// idle, but only advances the state which can affect later output (counters,
+	// LFO, noise and phases)
+	void skip_idle(uint32_t clocks);
+
 	// compute sum of channel outputs
 	void output(output_data &output, uint32_t rshift, int32_t clipmax, uint32_t chanmask) const;
 
+	// furnace: compute the output of a single channel (same as output() with 1 << chnum)
+	void output_channel(output_data &output, uint32_t rshift, int32_t clipmax, uint32_t chnum) const;
+
 	// write to the OPN registers
 	void write(uint16_t regnum, uint8_t data);
 
@@ -429,6 +429,11 @@ bool fm_operator<RegisterType>::prepare()
 	// cache the data
 	m_regs.cache_operator_data(m_choffs, m_opoffs, m_cache);
 
+	// furnace: cache register bits which are otherwise read every sample.
+	// every register write marks all channels for preparation, so this is safe.
+	m_cache.ssg_eg_enable = m_regs.op_ssg_eg_enable(m_opoffs);
+	m_cache.lfo_am_enable = m_regs.op_lfo_am_enable(m_opoffs);
+
 	// clock the key state
 	clock_keystate(uint32_t(m_keyon_live != 0));
         if (m_keyon_live & (1<<KEYON_CSM)) {
@@ -452,7 +457,7 @@ template<class RegisterType>
 void fm_operator<RegisterType>::clock(uint32_t env_counter, int32_t lfo_raw_pm)
 {
 	// clock the SSG-EG state (OPN/OPNA)
-	if (m_regs.op_ssg_eg_enable(m_opoffs))
+	if (m_cache.ssg_eg_enable)
 		clock_ssg_eg_state();
 	else
 		m_ssg_inverted = false;
@@ -466,6 +471,38 @@ void fm_operator<RegisterType>::clock(uint32_t env_counter, int32_t lfo_raw_pm)
 }
 
 
+//-------------------------------------------------
+//  is_idle - furnace: return true if the operator
+//  is keyed off and fully released, so that
+//  clocking only changes the phase
+//-------------------------------------------------
+
+template<class RegisterType>
+bool fm_operator<RegisterType>::is_idle() const
+{
+	// SSG-EG may invert or restart the envelope even after release
+	return (m_keyon_live == 0 && m_key_state == 0 && m_env_state >= EG_RELEASE && m_env_attenuation == 0x3ff &&
+		!m_cache.ssg_eg_enable && !m_ssg_inverted && m_cache.eg_shift == 0);
+}
+
+
+//-------------------------------------------------
+//  skip_idle - furnace: advance the phase of an
+//  idle operator by a number of clocks
+//-------------------------------------------------
+
+template<class RegisterType>
+bool fm_operator<RegisterType>::skip_idle(uint32_t clocks)
+{
+	// the phase is still used by OPL rhythm channels and after a key on
+	// without a phase reset, so it has to be kept
+	if (m_cache.phase_step == opdata_cache::PHASE_STEP_DYNAMIC)
+		return false;
+	m_phase += m_cache.phase_step * clocks;
+	return true;
+}
+
+
 //-------------------------------------------------
 //  compute_volume - compute the 14-bit signed
 //  volume of this operator, given a phase
@@ -724,7 +761,7 @@ void fm_operator<RegisterType>::clock_envelope(uint32_t env_counter)
 	else
 	{
 		// non-SSG-EG cases just apply the increment
-		if (!m_regs.op_ssg_eg_enable(m_opoffs))
+		if (!m_cache.ssg_eg_enable)
 			m_env_attenuation += increment;
 
 		// SSG-EG only applies if less than mid-point, and then at 4x
@@ -780,7 +817,7 @@ uint32_t fm_operator<RegisterType>::envelope_attenuation(uint32_t am_offset) con
 		result = (0x200 - result) & 0x3ff;
 
 	// add in LFO AM modulation
-	if (m_regs.op_lfo_am_enable(m_opoffs))
+	if (m_cache.lfo_am_enable)
 		result += am_offset;
 
 	// add in total level and KSL from the cache
@@ -1335,6 +1372,83 @@ uint32_t fm_engine_base<RegisterType>::clock(uint32_t chanmask)
 }
 
 
+//-------------------------------------------------
+//  is_idle - furnace: return true if clocking
+//  would only advance counters and phases
+//-------------------------------------------------
+
+template<class RegisterType>
+bool fm_engine_base<RegisterType>::is_idle() const
+{
+	// a register write is pending (it may key on)
+	if (m_modified_channels != 0)
+		return false;
+	for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
+		if (!m_channel[chnum]->is_idle())
+			return false;
+	for (uint32_t opnum = 0; opnum < OPERATORS; opnum++)
+		if (!m_operator[opnum]->is_idle())
+			return false;
+	return true;
+}
+
+
+//-------------------------------------------------
+//  skip_idle - furnace: advance an idle engine
+//  by a number of clocks
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_engine_base<RegisterType>::skip_idle(uint32_t clocks)
+{
+	// operators with a static phase step are advanced in one go; the others
+	// depend on the LFO, so their step is recomputed whenever the PM changes
+	uint32_t dynamic[OPERATORS];
+	uint32_t dynamic_step[OPERATORS];
+	uint32_t dynamic_count = 0;
+	for (uint32_t opnum = 0; opnum < OPERATORS; opnum++)
+		if (!m_operator[opnum]->skip_idle(clocks))
+			dynamic[dynamic_count++] = opnum;
+	int32_t last_pm = 0;
+	bool have_step = false;
+
+	for (uint32_t clk = 0; clk < clocks; clk++)
+	{
+		// same as clock(), without the envelopes (which stay at maximum attenuation)
+		m_total_clocks++;
+		if (m_prepare_count++ >= 4096)
+		{
+			if (RegisterType::DYNAMIC_OPS)
+				assign_operators();
+			m_active_channels = 0;
+			for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
+				if (m_channel[chnum]->prepare())
+					m_active_channels |= 1 << chnum;
+			m_prepare_count = 0;
+		}
+
+		if (RegisterType::EG_CLOCK_DIVIDER == 1)
+			m_env_counter += 4;
+		else if (bitfield(++m_env_counter, 0, 2) == RegisterType::EG_CLOCK_DIVIDER)
+			m_env_counter += 4 - RegisterType::EG_CLOCK_DIVIDER;
+
+		int32_t lfo_raw_pm = m_regs.clock_noise_and_lfo();
+		if (dynamic_count != 0)
+		{
+			if (!have_step || lfo_raw_pm != last_pm)
+			{
+				for (uint32_t index = 0; index < dynamic_count; index++)
+					dynamic_step[index] = m_operator[dynamic[index]]->idle_phase_step(lfo_raw_pm);
+				last_pm = lfo_raw_pm;
+				have_step = true;
+			}
+			for (uint32_t index = 0; index < dynamic_count; index++)
+				m_operator[dynamic[index]]->advance_phase(dynamic_step[index]);
+		}
+	}
+}
+
+
 //-------------------------------------------------
 //  output - compute a sum over the relevant
 //  channels
@@ -1405,6 +1519,32 @@ void fm_engine_base<RegisterType>::output(output_data &output, uint32_t rshift,
 }
 
 
+//-------------------------------------------------
+//  output_channel - compute the output of a
+//  single channel without scanning the others
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_engine_base<RegisterType>::output_channel(output_data &output, uint32_t rshift, int32_t clipmax, uint32_t chnum) const
+{
+	// the rhythm case needs the full path
+	if (YMFM_DEBUG_LOG_WAVFILES || m_regs.rhythm_enable())
+	{
+		this->output(output, rshift, clipmax, 1 << chnum);
+		return;
+	}
+
+	// mask out inactive channels
+	if (!bitfield(debug::GLOBAL_FM_CHANNEL_MASK & m_active_channels, chnum))
+		return;
+
+	if (m_channel[chnum]->is4op())
+		m_channel[chnum]->output_4op(output, rshift, clipmax);
+	else
+		m_channel[chnum]->output_2op(output, rshift, clipmax);
+}
+
+
 //-------------------------------------------------
 //  write - handle writes to the OPN registers
 //-------------------------------------------------
@@ -2133,7 +2133,13 @@ uint8_t const ds1001::s_default_instruments[] =
 //  EXPLICIT INSTANTIATION
 //*********************************************************
 
+template class opl_registers_base<1>;
+template class opl_registers_base<2>;
+template class opl_registers_base<3>;
 template class opl_registers_base<4>;
+template class fm_engine_base<opl_registers_base<1>>;
+template class fm_engine_base<opl_registers_base<2>>;
+template class fm_engine_base<opl_registers_base<3>>;
 template class fm_engine_base<opl_registers_base<4>>;
 
 }
@@ -2396,7 +2396,7 @@ void ym2612::generate(output_data *output, uint32_t numsamples)
 		int const last_fm_channel = m_dac_enable ? 5 : 6;
 		for (int chan = 0; chan < last_fm_channel; chan++)
 		{
-			m_fm.output(temp.clear(), 5, 256, 1 << chan);
+			m_fm.output_channel(temp.clear(), 5, 256, chan);
 			output->data[0] += dac_discontinuity(temp.data[0]);
 			output->data[1] += dac_discontinuity(temp.data[1]);
 		}
@@ -2486,4 +2486,12 @@ void ymf276::generate(output_data *output, uint32_t numsamples)
 	}
 }
 
+
+//*********************************************************
+//  EXPLICIT INSTANTIATION
+//*********************************************************
+
+template class fm_engine_base<opn_registers>;
+template class fm_engine_base<opna_registers>;
+
 }
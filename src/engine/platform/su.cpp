@@ -161,7 +161,7 @@ void DivPlatformSoundUnit::tick(bool sysTick) {
     }
 
     // run hardware sequence
-    if (chan[i].active) {
+    if (chan[i].active && (!parent->isInputSubTick() || chan[i].hwSeqDelay<=0)) {
       if (--chan[i].hwSeqDelay<=0) {
         chan[i].hwSeqDelay=0;
         DivInstrument* ins=parent->getIns(chan[i].ins,DIV_INS_SU);
@@ -206,7 +206,7 @@ void DivPlatformSoundUnit::tick(bool sysTick) {
               writeControlUpper(i);
               break;
             case DivInstrumentSoundUnit::DIV_SU_HWCMD_WAIT:
-              chan[i].hwSeqDelay=(val+1)*parent->tickMult;
+              chan[i].hwSeqDelay=val+1;
               leave=true;
               break;
             case DivInstrumentSoundUnit::DIV_SU_HWCMD_WAIT_REL:
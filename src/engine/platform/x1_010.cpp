@@ -19,6 +19,7 @@
 
 #include "x1_010.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -1011,7 +1012,7 @@ const DivMemoryComposition* DivPlatformX1_010::getMemCompo(int index) {
 }
 
 void DivPlatformX1_010::renderSamples(int sysID) {
-  memset(sampleMem,0,16777216);
+  DivLazyMem::clear(sampleMem,16777216);
   memset(sampleOffX1,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -1055,6 +1056,7 @@ void DivPlatformX1_010::renderSamples(int sysID) {
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=getSampleMemCapacity(0);
+  memCompo.resident=DivLazyMem::resident(sampleMem,16777216);
 }
 
 int DivPlatformX1_010::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
@@ -1067,7 +1069,7 @@ int DivPlatformX1_010::init(DivEngine* p, int channels, int sugRate, const DivCo
     oscBuf[i]=new DivDispatchOscBuffer;
   }
   setFlags(flags);
-  sampleMem=new unsigned char[16777216];
+  sampleMem=DivLazyMem::alloc(16777216);
   sampleMemLen=0;
   x1_010.reset();
   reset();
@@ -1078,7 +1080,7 @@ void DivPlatformX1_010::quit() {
   for (int i=0; i<16; i++) {
     delete oscBuf[i];
   }
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,16777216);
 }
 
 // initialization of important arrays
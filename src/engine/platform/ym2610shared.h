@@ -22,6 +22,7 @@
 
 #include "fmshared_OPN.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include "ay.h"
 #include "sound/ymfm/ymfm.h"
@@ -225,7 +226,7 @@ class DivPlatformYM2610Base: public DivPlatformOPN {
     }
 
     void renderSamples(int sysID) {
-      memset(adpcmAMem,0,getSampleMemCapacity(0));
+      DivLazyMem::clear(adpcmAMem,getSampleMemCapacity(0));
       memset(sampleOffA,0,32768*sizeof(unsigned int));
       memset(sampleOffB,0,32768*sizeof(unsigned int));
       memset(sampleLoaded[0],0,32768*sizeof(bool));
@@ -267,9 +268,10 @@ class DivPlatformYM2610Base: public DivPlatformOPN {
       adpcmAMemLen=memPos+256;
 
       memCompoA.used=adpcmAMemLen;
+      memCompoA.resident=DivLazyMem::resident(adpcmAMem,getSampleMemCapacity(0));
       memCompoA.capacity=getSampleMemCapacity(0);
 
-      memset(adpcmBMem,0,getSampleMemCapacity(1));
+      DivLazyMem::clear(adpcmBMem,getSampleMemCapacity(1));
 
       memPos=0;
       for (int i=0; i<parent->song.sampleLen; i++) {
@@ -301,6 +303,7 @@ class DivPlatformYM2610Base: public DivPlatformOPN {
       adpcmBMemLen=memPos+256;
 
       memCompoB.used=adpcmBMemLen;
+      memCompoB.resident=DivLazyMem::resident(adpcmBMem,getSampleMemCapacity(1));
       memCompoB.capacity=getSampleMemCapacity(1);
     }
 
@@ -337,9 +340,9 @@ class DivPlatformYM2610Base: public DivPlatformOPN {
         isMuted[i]=false;
         oscBuf[i]=new DivDispatchOscBuffer;
       }
-      adpcmAMem=new unsigned char[getSampleMemCapacity(0)];
+      adpcmAMem=DivLazyMem::alloc(getSampleMemCapacity(0));
       adpcmAMemLen=0;
-      adpcmBMem=new unsigned char[getSampleMemCapacity(1)];
+      adpcmBMem=DivLazyMem::alloc(getSampleMemCapacity(1));
       adpcmBMemLen=0;
       iface.adpcmAMem=adpcmAMem;
       iface.adpcmBMem=adpcmBMem;
@@ -361,8 +364,8 @@ class DivPlatformYM2610Base: public DivPlatformOPN {
       }
       ay->quit();
       delete ay;
-      delete[] adpcmAMem;
-      delete[] adpcmBMem;
+      DivLazyMem::free(adpcmAMem,getSampleMemCapacity(0));
+      DivLazyMem::free(adpcmBMem,getSampleMemCapacity(1));
     }
 
     DivPlatformYM2610Base(int ext, int psg, int adpcmA, int adpcmB, int chanCount):
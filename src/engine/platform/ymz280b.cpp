@@ -19,6 +19,7 @@
 
 #include "ymz280b.h"
 #include "../engine.h"
+#include "../lazyMem.h"
 #include "../../ta-log.h"
 #include <math.h>
 
@@ -459,7 +460,7 @@ const DivMemoryComposition* DivPlatformYMZ280B::getMemCompo(int index) {
 }
 
 void DivPlatformYMZ280B::renderSamples(int sysID) {
-  memset(sampleMem,0,getSampleMemCapacity());
+  DivLazyMem::clear(sampleMem,getSampleMemCapacity());
   memset(sampleOff,0,32768*sizeof(unsigned int));
   memset(sampleLoaded,0,32768*sizeof(bool));
 
@@ -503,6 +504,7 @@ void DivPlatformYMZ280B::renderSamples(int sysID) {
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=getSampleMemCapacity(0);
+  memCompo.resident=DivLazyMem::resident(sampleMem,getSampleMemCapacity());
 }
 
 void DivPlatformYMZ280B::setChipModel(int type) {
@@ -555,7 +557,7 @@ int DivPlatformYMZ280B::init(DivEngine* p, int channels, int sugRate, const DivC
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[getSampleMemCapacity()];
+  sampleMem=DivLazyMem::alloc(getSampleMemCapacity());
   sampleMemLen=0;
   ymz280b.device_start(sampleMem);
   setFlags(flags);
@@ -565,7 +567,7 @@ int DivPlatformYMZ280B::init(DivEngine* p, int channels, int sugRate, const DivC
 }
 
 void DivPlatformYMZ280B::quit() {
-  delete[] sampleMem;
+  DivLazyMem::free(sampleMem,getSampleMemCapacity());
   for (int i=0; i<8; i++) {
     delete oscBuf[i];
   }
@@ -25,6 +25,11 @@
 #include "workPool.h"
 #include "../ta-log.h"
 #include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 void DivEngine::nextOrder() {
   curRow=0;
@@ -450,71 +455,50 @@ int DivEngine::dispatchCmd(DivCommand c) {
   return disCont[dispatchOfChan[c.dis]].dispatch->dispatch(c);
 }
 
-bool DivEngine::perSystemEffect(int ch, unsigned char effect, unsigned char effectVal) {
-  DivSysDef* sysDef=sysDefs[sysOfChan[ch]];
-  if (sysDef==NULL) return false;
-  auto iter=sysDef->effectHandlers.find(effect);
-  if (iter==sysDef->effectHandlers.end()) return false;
-  EffectHandler handler=iter->second;
+bool DivEngine::runEffectHandler(int ch, const EffectHandler* handler, unsigned char effect, unsigned char effectVal, bool notHandledResult) {
+  if (handler==NULL) return false;
   int val=0;
   int val2=0;
   try {
-    val=handler.val?handler.val(effect,effectVal):effectVal;
-    val2=handler.val2?handler.val2(effect,effectVal):0;
+    val=handler->val?handler->val(effect,effectVal):effectVal;
+    val2=handler->val2?handler->val2(effect,effectVal):0;
   } catch (DivDoNotHandleEffect& e) {
-    return false;
+    return notHandledResult;
   }
   // wouldn't this cause problems if it were to return 0?
-  return dispatchCmd(DivCommand(handler.dispatchCmd,ch,val,val2));
+  return dispatchCmd(DivCommand(handler->dispatchCmd,ch,val,val2));
 }
 
-bool DivEngine::perSystemPostEffect(int ch, unsigned char effect, unsigned char effectVal) {
+void DivEngine::compileRow(int ch, DivPattern* pat, int row, DivRowProgram& prog) {
   DivSysDef* sysDef=sysDefs[sysOfChan[ch]];
-  if (sysDef==NULL) return false;
-  auto iter=sysDef->postEffectHandlers.find(effect);
-  if (iter==sysDef->postEffectHandlers.end()) return false;
-  EffectHandler handler=iter->second;
-  int val=0;
-  int val2=0;
-  try {
-    val=handler.val?handler.val(effect,effectVal):effectVal;
-    val2=handler.val2?handler.val2(effect,effectVal):0;
-  } catch (DivDoNotHandleEffect& e) {
-    return true;
-  }
-  // wouldn't this cause problems if it were to return 0?
-  return dispatchCmd(DivCommand(handler.dispatchCmd,ch,val,val2));
-}
+  prog.fxLen=0;
+  for (int j=0; j<curPat[ch].effectCols; j++) {
+    short effect=pat->data[row][4+(j<<1)];
+    if (effect==-1) continue;
+    short effectVal=pat->data[row][5+(j<<1)];
+    if (effectVal==-1) effectVal=0;
 
-bool DivEngine::perSystemPreEffect(int ch, unsigned char effect, unsigned char effectVal) {
-  DivSysDef* sysDef=sysDefs[sysOfChan[ch]];
-  if (sysDef==NULL) return false;
-  auto iter=sysDef->preEffectHandlers.find(effect);
-  if (iter==sysDef->preEffectHandlers.end()) return false;
-  EffectHandler handler=iter->second;
-  int val=0;
-  int val2=0;
-  try {
-    val=handler.val?handler.val(effect,effectVal):effectVal;
-    val2=handler.val2?handler.val2(effect,effectVal):0;
-  } catch (DivDoNotHandleEffect& e) {
-    return false;
+    DivRowEffect& fx=prog.fx[prog.fxLen++];
+    fx.effect=effect;
+    fx.val=effectVal&255;
+    if (sysDef==NULL) {
+      fx.handler=NULL;
+      fx.postHandler=NULL;
+      fx.preHandler=NULL;
+    } else {
+      fx.handler=sysDef->effectHandlerTable[(unsigned char)effect];
+      fx.postHandler=sysDef->postEffectHandlerTable[(unsigned char)effect];
+      fx.preHandler=sysDef->preEffectHandlerTable[(unsigned char)effect];
+    }
   }
-  // wouldn't this cause problems if it were to return 0?
-  return dispatchCmd(DivCommand(handler.dispatchCmd,ch,val,val2));
 }
 
 void DivEngine::processRowPre(int i) {
-  int whatOrder=curOrder;
-  int whatRow=curRow;
-  DivPattern* pat=curPat[i].getPattern(curOrders->ord[i][whatOrder],false);
-  for (int j=0; j<curPat[i].effectCols; j++) {
-    short effect=pat->data[whatRow][4+(j<<1)];
-    short effectVal=pat->data[whatRow][5+(j<<1)];
-
-    if (effectVal==-1) effectVal=0;
-    effectVal&=255;
-    perSystemPreEffect(i,effect,effectVal);
+  DivPattern* pat=curPat[i].getPattern(curOrders->ord[i][curOrder],false);
+  DivRowProgram& prog=rowProgram[i];
+  compileRow(i,pat,curRow,prog);
+  for (int j=0; j<prog.fxLen; j++) {
+    runEffectHandler(i,prog.fx[j].preHandler,prog.fx[j].effect,prog.fx[j].val,false);
   }
 }
 
@@ -522,15 +506,15 @@ void DivEngine::processRow(int i, bool afterDelay) {
   int whatOrder=afterDelay?chan[i].delayOrder:curOrder;
   int whatRow=afterDelay?chan[i].delayRow:curRow;
   DivPattern* pat=curPat[i].getPattern(curOrders->ord[i][whatOrder],false);
+  // the current row was compiled by processRowPre()
+  DivRowProgram& prog=rowProgram[i];
+  if (afterDelay) compileRow(i,pat,whatRow,prog);
   // pre effects
   if (!afterDelay) {
     bool returnAfterPre=false;
-    for (int j=0; j<curPat[i].effectCols; j++) {
-      short effect=pat->data[whatRow][4+(j<<1)];
-      short effectVal=pat->data[whatRow][5+(j<<1)];
-
-      if (effectVal==-1) effectVal=0;
-      effectVal&=255;
+    for (int j=0; j<prog.fxLen; j++) {
+      short effect=prog.fx[j].effect;
+      short effectVal=prog.fx[j].val;
 
       switch (effect) {
         case 0x09: // select groove pattern/speed 1
@@ -697,14 +681,12 @@ void DivEngine::processRow(int i, bool afterDelay) {
   // volume
   int volPortaTarget=-1;
   bool noApplyVolume=false;
-  for (int j=0; j<curPat[i].effectCols; j++) {
-    short effect=pat->data[whatRow][4+(j<<1)];
+  for (int j=0; j<prog.fxLen; j++) {
+    short effect=prog.fx[j].effect;
     if (effect==0xd3 || effect==0xd4) { // vol porta
       volPortaTarget=pat->data[whatRow][3]<<8; // can be -256
 
-      short effectVal=pat->data[whatRow][5+(j<<1)];
-      if (effectVal==-1) effectVal=0;
-      effectVal&=255;
+      short effectVal=prog.fx[j].val;
 
       noApplyVolume=effectVal>0; // "D3.." or "D300" shouldn't stop volume from applying
       break; // technically you could have both D3 and D4... let's not care
@@ -731,15 +713,12 @@ void DivEngine::processRow(int i, bool afterDelay) {
   bool sampleOffSet=false;
 
   // effects
-  for (int j=0; j<curPat[i].effectCols; j++) {
-    short effect=pat->data[whatRow][4+(j<<1)];
-    short effectVal=pat->data[whatRow][5+(j<<1)];
-
-    if (effectVal==-1) effectVal=0;
-    effectVal&=255;
+  for (int j=0; j<prog.fxLen; j++) {
+    short effect=prog.fx[j].effect;
+    short effectVal=prog.fx[j].val;
 
     // per-system effect
-    if (!perSystemEffect(i,effect,effectVal)) switch (effect) {
+    if (!runEffectHandler(i,prog.fx[j].handler,effect,effectVal,false)) switch (effect) {
       case 0x08: // panning (split 4-bit)
         chan[i].panL=(effectVal>>4)|(effectVal&0xf0);
         chan[i].panR=(effectVal&15)|((effectVal&15)<<4);
@@ -1011,7 +990,6 @@ void DivEngine::processRow(int i, bool afterDelay) {
         if (divider<1) divider=1;
         cycles=got.rate/divider;
         clockDrift=0;
-        subticks=0;
         break;
       case 0xdc: // delayed mute
         if (effectVal>0 && (song.delayBehavior==2 || effectVal<nextSpeed)) {
@@ -1165,7 +1143,6 @@ void DivEngine::processRow(int i, bool afterDelay) {
         if (divider<1) divider=1;
         cycles=got.rate/divider;
         clockDrift=0;
-        subticks=0;
         break;
       case 0xf3: // fine volume ramp up
         // tremolo and vol slides are incompatible
@@ -1305,13 +1282,10 @@ void DivEngine::processRow(int i, bool afterDelay) {
   chan[i].noteOnInhibit=false;
 
   // post effects
-  for (int j=0; j<curPat[i].effectCols; j++) {
-    short effect=pat->data[whatRow][4+(j<<1)];
-    short effectVal=pat->data[whatRow][5+(j<<1)];
-
-    if (effectVal==-1) effectVal=0;
-    effectVal&=255;
-    if (!perSystemPostEffect(i,effect,effectVal)) {
+  for (int j=0; j<prog.fxLen; j++) {
+    short effect=prog.fx[j].effect;
+    short effectVal=prog.fx[j].val;
+    if (!runEffectHandler(i,prog.fx[j].postHandler,effect,effectVal,true)) {
       switch (effect) {
         case 0xf1: // single pitch ramp up
         case 0xf2: // single pitch ramp down
@@ -1484,6 +1458,8 @@ void DivEngine::nextRow() {
     if (!(pat->data[curRow][0]==0 && pat->data[curRow][1]==0)) {
       if (pat->data[curRow][0]!=100 && pat->data[curRow][0]!=101 && pat->data[curRow][0]!=102) {
         if (!chan[i].legato) {
+          DivRowProgram& prog=rowProgram[i];
+          compileRow(i,pat,curRow,prog);
           bool wantPreNote=false;
           if (disCont[dispatchOfChan[i]].dispatch!=NULL) {
             wantPreNote=disCont[dispatchOfChan[i]].dispatch->getWantPreNote();
@@ -1491,26 +1467,27 @@ void DivEngine::nextRow() {
               bool doPreparePreNote=true;
               int addition=0;
 
-              for (int j=0; j<curPat[i].effectCols; j++) {
+              for (int j=0; j<prog.fxLen; j++) {
+                const DivRowEffect& fx=prog.fx[j];
                 if (!song.preNoteNoEffect) {
-                  if (pat->data[curRow][4+(j<<1)]==0x03 && pat->data[curRow][5+(j<<1)]!=0 && pat->data[curRow][5+(j<<1)]!=-1) {
+                  if (fx.effect==0x03 && fx.val!=0) {
                     doPreparePreNote=false;
                     break;
                   }
-                  if (pat->data[curRow][4+(j<<1)]==0x06 && pat->data[curRow][5+(j<<1)]!=0 && pat->data[curRow][5+(j<<1)]!=-1) {
+                  if (fx.effect==0x06 && fx.val!=0) {
                     doPreparePreNote=false;
                     break;
                   }
-                  if (pat->data[curRow][4+(j<<1)]==0xea) {
-                    if (pat->data[curRow][5+(j<<1)]>0) {
+                  if (fx.effect==0xea) {
+                    if (fx.val>0) {
                       doPreparePreNote=false;
                       break;
                     }
                   }
                 }
-                if (pat->data[curRow][4+(j<<1)]==0xed) {
-                  if (pat->data[curRow][5+(j<<1)]>0) {
-                    addition=pat->data[curRow][5+(j<<1)]&255;
+                if (fx.effect==0xed) {
+                  if (fx.val>0) {
+                    addition=fx.val;
                     break;
                   }
                 }
@@ -1523,24 +1500,25 @@ void DivEngine::nextRow() {
             bool doPrepareCut=true;
             int addition=0;
 
-            for (int j=0; j<curPat[i].effectCols; j++) {
-              if (pat->data[curRow][4+(j<<1)]==0x03 && pat->data[curRow][5+(j<<1)]!=0 && pat->data[curRow][5+(j<<1)]!=-1) {
+            for (int j=0; j<prog.fxLen; j++) {
+              const DivRowEffect& fx=prog.fx[j];
+              if (fx.effect==0x03 && fx.val!=0) {
                 doPrepareCut=false;
                 break;
               }
-              if (pat->data[curRow][4+(j<<1)]==0x06 && pat->data[curRow][5+(j<<1)]!=0 && pat->data[curRow][5+(j<<1)]!=-1) {
+              if (fx.effect==0x06 && fx.val!=0) {
                 doPrepareCut=false;
                 break;
               }
-              if (pat->data[curRow][4+(j<<1)]==0xea) {
-                if (pat->data[curRow][5+(j<<1)]>0) {
+              if (fx.effect==0xea) {
+                if (fx.val>0) {
                   doPrepareCut=false;
                   break;
                 }
               }
-              if (pat->data[curRow][4+(j<<1)]==0xed) {
-                if (pat->data[curRow][5+(j<<1)]>0) {
-                  addition=pat->data[curRow][5+(j<<1)]&255;
+              if (fx.effect==0xed) {
+                if (fx.val>0) {
+                  addition=fx.val;
                   break;
                 }
               }
@@ -1559,24 +1537,7 @@ void DivEngine::nextRow() {
   firstTick=true;
 }
 
-bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
-  bool ret=false;
-  if (divider<1) divider=1;
-
-  if (lowLatency && !skipping && !inhibitLowLat) {
-    tickMult=1000/divider;
-    if (tickMult<1) tickMult=1;
-  } else {
-    tickMult=1;
-  }
-  
-  cycles=got.rate/(divider*tickMult);
-  clockDrift+=fmod(got.rate,(double)(divider*tickMult));
-  if (clockDrift>=(divider*tickMult)) {
-    clockDrift-=(divider*tickMult);
-    cycles++;
-  }
-
+void DivEngine::processPendingNotes() {
   // don't let user play anything during export
   if (exporting) pendingNotes.clear();
 
@@ -1637,353 +1598,379 @@ bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
     }
     pendingNotes.pop_front();
   }
+}
+
+// in low-latency mode live notes don't wait for the next tick. instead they are
+// sent as soon as they arrive, followed by a sub-tick of the affected systems so
+// the note reaches the chip right away.
+void DivEngine::nextSubTick() {
+  bool affected[DIV_MAX_CHIPS];
+  memset(affected,0,DIV_MAX_CHIPS*sizeof(bool));
+  for (size_t i=0; i<pendingNotes.size(); i++) {
+    int ch=pendingNotes[i].channel;
+    if (ch<0 || ch>=chans) continue;
+    affected[dispatchOfChan[ch]]=true;
+  }
+
+  processPendingNotes();
+
+  inputSubTick=true;
+  for (int i=0; i<song.systemLen; i++) {
+    if (affected[i]) disCont[i].dispatch->tick(false);
+  }
+  inputSubTick=false;
+}
+
+bool DivEngine::nextTick(bool noAccum) {
+  bool ret=false;
+  if (divider<1) divider=1;
+
+  cycles=got.rate/divider;
+  clockDrift+=fmod(got.rate,(double)divider);
+  if (clockDrift>=divider) {
+    clockDrift-=divider;
+    cycles++;
+  }
+
+  processPendingNotes();
 
   if (!freelance) {
-    if (--subticks<=0) {
-      subticks=tickMult;
-
-      // apply delayed rows before potentially advancing to a new row, which would overwrite the
-      // delayed row's state before it has a chance to do anything. a typical example would be
-      // a delay scheduling a note-on to be simultaneous with the next row, and the next row also
-      // containing a delayed note. if we don't apply the delayed row first, 
-      for (int i=0; i<chans; i++) {
-        // delay effects
-        if (chan[i].rowDelay>0) {
-          if (--chan[i].rowDelay==0) {
-            processRow(i,true);
-          }
+    // apply delayed rows before potentially advancing to a new row, which would overwrite the
+    // delayed row's state before it has a chance to do anything. a typical example would be
+    // a delay scheduling a note-on to be simultaneous with the next row, and the next row also
+    // containing a delayed note. if we don't apply the delayed row first, 
+    for (int i=0; i<chans; i++) {
+      // delay effects
+      if (chan[i].rowDelay>0) {
+        if (--chan[i].rowDelay==0) {
+          processRow(i,true);
         }
       }
+    }
 
-      if (stepPlay!=1) {
-        tempoAccum+=(skipping && virtualTempoN<virtualTempoD)?virtualTempoD:virtualTempoN;
-        while (tempoAccum>=virtualTempoD) {
-          tempoAccum-=virtualTempoD;
-          if (--ticks<=0) {
-            ret=endOfSong;
-            if (shallStopSched) {
-              logV("acknowledging scheduled stop");
-              shallStop=true;
-              break;
-            } else if (endOfSong) {
-              if (song.loopModality!=2) {
-                playSub(true);
-              }
-            }
-            endOfSong=false;
-            if (stepPlay==2) {
-              stepPlay=1;
-              playPosLock.lock();
-              prevOrder=curOrder;
-              prevRow=curRow;
-              playPosLock.unlock();
-            }
-            nextRow();
+    if (stepPlay!=1) {
+      tempoAccum+=(skipping && virtualTempoN<virtualTempoD)?virtualTempoD:virtualTempoN;
+      while (tempoAccum>=virtualTempoD) {
+        tempoAccum-=virtualTempoD;
+        if (--ticks<=0) {
+          ret=endOfSong;
+          if (shallStopSched) {
+            logV("acknowledging scheduled stop");
+            shallStop=true;
             break;
+          } else if (endOfSong) {
+            if (song.loopModality!=2) {
+              playSub(true);
+            }
           }
+          endOfSong=false;
+          if (stepPlay==2) {
+            stepPlay=1;
+            playPosLock.lock();
+            prevOrder=curOrder;
+            prevRow=curRow;
+            playPosLock.unlock();
+          }
+          nextRow();
+          break;
         }
-        // under no circumstances shall the accumulator become this large
-        if (tempoAccum>1023) tempoAccum=1023;
       }
+      // under no circumstances shall the accumulator become this large
+      if (tempoAccum>1023) tempoAccum=1023;
+    }
 
-      // process stuff
-      if (!shallStop) for (int i=0; i<chans; i++) {
-        // retrigger
-        if (chan[i].retrigSpeed) {
-          if (--chan[i].retrigTick<0) {
-            chan[i].retrigTick=chan[i].retrigSpeed-1;
-            dispatchCmd(DivCommand(DIV_CMD_NOTE_ON,i,DIV_NOTE_NULL));
-            keyHit[i]=true;
-          }
+    // process stuff
+    if (!shallStop) for (int i=0; i<chans; i++) {
+      // retrigger
+      if (chan[i].retrigSpeed) {
+        if (--chan[i].retrigTick<0) {
+          chan[i].retrigTick=chan[i].retrigSpeed-1;
+          dispatchCmd(DivCommand(DIV_CMD_NOTE_ON,i,DIV_NOTE_NULL));
+          keyHit[i]=true;
         }
+      }
+
+      // volume slides and tremolo
+      if (!song.noSlidesOnFirstTick || !firstTick) {
+        if (chan[i].volSpeed!=0) {
+          chan[i].volume=(chan[i].volume&0xff)|(dispatchCmd(DivCommand(DIV_CMD_GET_VOLUME,i))<<8);
+          int preSpeedVol=chan[i].volume;
+          chan[i].volume+=chan[i].volSpeed;
+          if (chan[i].volSpeedTarget!=-1) {
+            bool atTarget=false;
+            if (chan[i].volSpeed>0) {
+              atTarget=(chan[i].volume>=chan[i].volSpeedTarget);
+            } else if (chan[i].volSpeed<0) {
+              atTarget=(chan[i].volume<=chan[i].volSpeedTarget);
+            } else {
+              atTarget=true;
+              chan[i].volSpeedTarget=chan[i].volume;
+            }
 
-        // volume slides and tremolo
-        if (!song.noSlidesOnFirstTick || !firstTick) {
-          if (chan[i].volSpeed!=0) {
-            chan[i].volume=(chan[i].volume&0xff)|(dispatchCmd(DivCommand(DIV_CMD_GET_VOLUME,i))<<8);
-            int preSpeedVol=chan[i].volume;
-            chan[i].volume+=chan[i].volSpeed;
-            if (chan[i].volSpeedTarget!=-1) {
-              bool atTarget=false;
+            if (atTarget) {
               if (chan[i].volSpeed>0) {
-                atTarget=(chan[i].volume>=chan[i].volSpeedTarget);
+                chan[i].volume=MAX(preSpeedVol,chan[i].volSpeedTarget);
               } else if (chan[i].volSpeed<0) {
-                atTarget=(chan[i].volume<=chan[i].volSpeedTarget);
-              } else {
-                atTarget=true;
-                chan[i].volSpeedTarget=chan[i].volume;
-              }
-
-              if (atTarget) {
-                if (chan[i].volSpeed>0) {
-                  chan[i].volume=MAX(preSpeedVol,chan[i].volSpeedTarget);
-                } else if (chan[i].volSpeed<0) {
-                  chan[i].volume=MIN(preSpeedVol,chan[i].volSpeedTarget);
-                }
-                chan[i].volSpeed=0;
-                chan[i].volSpeedTarget=-1;
-                dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
-                dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-                dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
+                chan[i].volume=MIN(preSpeedVol,chan[i].volSpeedTarget);
               }
-            }
-            if (chan[i].volume>chan[i].volMax) {
-              chan[i].volume=chan[i].volMax;
               chan[i].volSpeed=0;
               chan[i].volSpeedTarget=-1;
               dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
               dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
               dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
-            } else if (chan[i].volume<0) {
-              chan[i].volSpeed=0;
-              dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
-              if (song.legacyVolumeSlides) {
-                chan[i].volume=chan[i].volMax+1;
-              } else {
-                chan[i].volume=0;
-              }
-              chan[i].volSpeedTarget=-1;
-              dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-              dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+            }
+          }
+          if (chan[i].volume>chan[i].volMax) {
+            chan[i].volume=chan[i].volMax;
+            chan[i].volSpeed=0;
+            chan[i].volSpeedTarget=-1;
+            dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+            dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
+          } else if (chan[i].volume<0) {
+            chan[i].volSpeed=0;
+            dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
+            if (song.legacyVolumeSlides) {
+              chan[i].volume=chan[i].volMax+1;
             } else {
-              dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+              chan[i].volume=0;
             }
-          } else if (chan[i].tremoloDepth>0) {
-            chan[i].tremoloPos+=chan[i].tremoloRate;
-            chan[i].tremoloPos&=127;
-            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,MAX(0,chan[i].volume-(tremTable[chan[i].tremoloPos]*chan[i].tremoloDepth))>>8));
+            chan[i].volSpeedTarget=-1;
+            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+            dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+          } else {
+            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
           }
+        } else if (chan[i].tremoloDepth>0) {
+          chan[i].tremoloPos+=chan[i].tremoloRate;
+          chan[i].tremoloPos&=127;
+          dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,MAX(0,chan[i].volume-(tremTable[chan[i].tremoloPos]*chan[i].tremoloDepth))>>8));
         }
+      }
 
-        // panning slides
-        if (chan[i].panSpeed!=0) {
-          int newPanL=chan[i].panL;
-          int newPanR=chan[i].panR;
-          if (chan[i].panSpeed>0) { // right
-            if (newPanR>=0xff) {
-              newPanL-=chan[i].panSpeed;
-            } else {
-              newPanR+=chan[i].panSpeed;
-            }
-          } else { // left
-            if (newPanL>=0xff) {
-              newPanR+=chan[i].panSpeed;
-            } else {
-              newPanL-=chan[i].panSpeed;
-            }
+      // panning slides
+      if (chan[i].panSpeed!=0) {
+        int newPanL=chan[i].panL;
+        int newPanR=chan[i].panR;
+        if (chan[i].panSpeed>0) { // right
+          if (newPanR>=0xff) {
+            newPanL-=chan[i].panSpeed;
+          } else {
+            newPanR+=chan[i].panSpeed;
           }
+        } else { // left
+          if (newPanL>=0xff) {
+            newPanR+=chan[i].panSpeed;
+          } else {
+            newPanL-=chan[i].panSpeed;
+          }
+        }
 
-          if (newPanL<0) newPanL=0;
-          if (newPanL>0xff) newPanL=0xff;
-          if (newPanR<0) newPanR=0;
-          if (newPanR>0xff) newPanR=0xff;
+        if (newPanL<0) newPanL=0;
+        if (newPanL>0xff) newPanL=0xff;
+        if (newPanR<0) newPanR=0;
+        if (newPanR>0xff) newPanR=0xff;
 
-          chan[i].panL=newPanL;
-          chan[i].panR=newPanR;
+        chan[i].panL=newPanL;
+        chan[i].panR=newPanR;
 
-          dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
-        } else if (chan[i].panDepth>0) {
-          chan[i].panPos+=chan[i].panRate;
-          chan[i].panPos&=255;
+        dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
+      } else if (chan[i].panDepth>0) {
+        chan[i].panPos+=chan[i].panRate;
+        chan[i].panPos&=255;
 
-          // calculate inverted...
-          switch (chan[i].panPos&0xc0) {
-            case 0: // center -> right
-              chan[i].panL=((chan[i].panPos&0x3f)<<2);
-              chan[i].panR=0;
-              break;
-            case 0x40: // right -> center
-              chan[i].panL=0xff-((chan[i].panPos&0x3f)<<2);
-              chan[i].panR=0;
-              break;
-            case 0x80: // center -> left
-              chan[i].panL=0;
-              chan[i].panR=((chan[i].panPos&0x3f)<<2);
-              break;
-            case 0xc0: // left -> center
-              chan[i].panL=0;
-              chan[i].panR=0xff-((chan[i].panPos&0x3f)<<2);
-              break;
-          }
+        // calculate inverted...
+        switch (chan[i].panPos&0xc0) {
+          case 0: // center -> right
+            chan[i].panL=((chan[i].panPos&0x3f)<<2);
+            chan[i].panR=0;
+            break;
+          case 0x40: // right -> center
+            chan[i].panL=0xff-((chan[i].panPos&0x3f)<<2);
+            chan[i].panR=0;
+            break;
+          case 0x80: // center -> left
+            chan[i].panL=0;
+            chan[i].panR=((chan[i].panPos&0x3f)<<2);
+            break;
+          case 0xc0: // left -> center
+            chan[i].panL=0;
+            chan[i].panR=0xff-((chan[i].panPos&0x3f)<<2);
+            break;
+        }
 
-          // multiply by depth
-          chan[i].panL=(chan[i].panL*chan[i].panDepth)/15;
-          chan[i].panR=(chan[i].panR*chan[i].panDepth)/15;
+        // multiply by depth
+        chan[i].panL=(chan[i].panL*chan[i].panDepth)/15;
+        chan[i].panR=(chan[i].panR*chan[i].panDepth)/15;
 
-          // then invert it to get final panning
-          chan[i].panL^=0xff;
-          chan[i].panR^=0xff;
+        // then invert it to get final panning
+        chan[i].panL^=0xff;
+        chan[i].panR^=0xff;
 
-          dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
-        }
+        dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
+      }
 
-        // vibrato
-        if (chan[i].vibratoDepth>0) {
-          chan[i].vibratoPos+=chan[i].vibratoRate;
-          while (chan[i].vibratoPos>=64) chan[i].vibratoPos-=64;
+      // vibrato
+      if (chan[i].vibratoDepth>0) {
+        chan[i].vibratoPos+=chan[i].vibratoRate;
+        while (chan[i].vibratoPos>=64) chan[i].vibratoPos-=64;
 
-          chan[i].vibratoPosGiant+=chan[i].vibratoRate;
-          while (chan[i].vibratoPosGiant>=512) chan[i].vibratoPosGiant-=512;
+        chan[i].vibratoPosGiant+=chan[i].vibratoRate;
+        while (chan[i].vibratoPosGiant>=512) chan[i].vibratoPosGiant-=512;
 
-          int vibratoOut=0;
-          switch (chan[i].vibratoShape) {
-            case 1: // sine, up only
-              vibratoOut=MAX(0,vibTable[chan[i].vibratoPos]);
-              break;
-            case 2: // sine, down only
-              vibratoOut=MIN(0,vibTable[chan[i].vibratoPos]);
-              break;
-            case 3: // triangle
-              vibratoOut=(chan[i].vibratoPos&31);
-              if (chan[i].vibratoPos&16) {
-                vibratoOut=32-(chan[i].vibratoPos&31);
-              }
-              if (chan[i].vibratoPos&32) {
-                vibratoOut=-vibratoOut;
-              }
-              vibratoOut<<=3;
-              break;
-            case 4: // ramp up
-              vibratoOut=chan[i].vibratoPos<<1;
-              break;
-            case 5: // ramp down
-              vibratoOut=-chan[i].vibratoPos<<1;
-              break;
-            case 6: // square
-              vibratoOut=(chan[i].vibratoPos>=32)?-127:127;
-              break;
-            case 7: // random (TODO: use LFSR)
-              vibratoOut=(rand()&255)-128;
-              break;
-            case 8: // square up
-              vibratoOut=(chan[i].vibratoPos>=32)?0:127;
-              break;
-            case 9: // square down
-              vibratoOut=(chan[i].vibratoPos>=32)?0:-127;
-              break;
-            case 10: // half sine up
-              vibratoOut=vibTable[chan[i].vibratoPos>>1];
-              break;
-            case 11: // half sine down
-              vibratoOut=vibTable[32|(chan[i].vibratoPos>>1)];
-              break;
-            default: // sine
-              vibratoOut=vibTable[chan[i].vibratoPos];
-              break;
-          }
-          dispatchCmd(DivCommand(DIV_CMD_PITCH,i,chan[i].pitch+(((chan[i].vibratoDepth*vibratoOut*chan[i].vibratoFine)>>4)/15)));
+        int vibratoOut=0;
+        switch (chan[i].vibratoShape) {
+          case 1: // sine, up only
+            vibratoOut=MAX(0,vibTable[chan[i].vibratoPos]);
+            break;
+          case 2: // sine, down only
+            vibratoOut=MIN(0,vibTable[chan[i].vibratoPos]);
+            break;
+          case 3: // triangle
+            vibratoOut=(chan[i].vibratoPos&31);
+            if (chan[i].vibratoPos&16) {
+              vibratoOut=32-(chan[i].vibratoPos&31);
+            }
+            if (chan[i].vibratoPos&32) {
+              vibratoOut=-vibratoOut;
+            }
+            vibratoOut<<=3;
+            break;
+          case 4: // ramp up
+            vibratoOut=chan[i].vibratoPos<<1;
+            break;
+          case 5: // ramp down
+            vibratoOut=-chan[i].vibratoPos<<1;
+            break;
+          case 6: // square
+            vibratoOut=(chan[i].vibratoPos>=32)?-127:127;
+            break;
+          case 7: // random (TODO: use LFSR)
+            vibratoOut=(rand()&255)-128;
+            break;
+          case 8: // square up
+            vibratoOut=(chan[i].vibratoPos>=32)?0:127;
+            break;
+          case 9: // square down
+            vibratoOut=(chan[i].vibratoPos>=32)?0:-127;
+            break;
+          case 10: // half sine up
+            vibratoOut=vibTable[chan[i].vibratoPos>>1];
+            break;
+          case 11: // half sine down
+            vibratoOut=vibTable[32|(chan[i].vibratoPos>>1)];
+            break;
+          default: // sine
+            vibratoOut=vibTable[chan[i].vibratoPos];
+            break;
         }
+        dispatchCmd(DivCommand(DIV_CMD_PITCH,i,chan[i].pitch+(((chan[i].vibratoDepth*vibratoOut*chan[i].vibratoFine)>>4)/15)));
+      }
 
-        // delayed legato
-        if (chan[i].legatoDelay>0) {
-          if (--chan[i].legatoDelay<1) {
-            chan[i].note+=chan[i].legatoTarget;
-            dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-            dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
-            chan[i].legatoDelay=-1;
-            chan[i].legatoTarget=0;
-          }
+      // delayed legato
+      if (chan[i].legatoDelay>0) {
+        if (--chan[i].legatoDelay<1) {
+          chan[i].note+=chan[i].legatoTarget;
+          dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+          dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
+          chan[i].legatoDelay=-1;
+          chan[i].legatoTarget=0;
         }
+      }
 
-        // portamento and pitch slides
-        if (!song.noSlidesOnFirstTick || !firstTick) {
-          if ((chan[i].keyOn || chan[i].keyOff) && chan[i].portaSpeed>0) {
-            if (dispatchCmd(DivCommand(DIV_CMD_NOTE_PORTA,i,chan[i].portaSpeed*(song.linearPitch==2?song.pitchSlideSpeed:1),chan[i].portaNote))==2 && chan[i].portaStop && song.targetResetsSlides) {
-              chan[i].portaSpeed=0;
-              dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
-              chan[i].oldNote=chan[i].note;
-              chan[i].note=chan[i].portaNote;
-              chan[i].inPorta=false;
-              dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-              dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
-            }
+      // portamento and pitch slides
+      if (!song.noSlidesOnFirstTick || !firstTick) {
+        if ((chan[i].keyOn || chan[i].keyOff) && chan[i].portaSpeed>0) {
+          if (dispatchCmd(DivCommand(DIV_CMD_NOTE_PORTA,i,chan[i].portaSpeed*(song.linearPitch==2?song.pitchSlideSpeed:1),chan[i].portaNote))==2 && chan[i].portaStop && song.targetResetsSlides) {
+            chan[i].portaSpeed=0;
+            dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
+            chan[i].oldNote=chan[i].note;
+            chan[i].note=chan[i].portaNote;
+            chan[i].inPorta=false;
+            dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+            dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
           }
         }
+      }
 
-        // note cut
-        if (chan[i].cut>0) {
-          if (--chan[i].cut<1) {
-            if (chan[i].cutType==2) {
-              dispatchCmd(DivCommand(DIV_CMD_ENV_RELEASE,i));
-              chan[i].releasing=true;
-            } else {
-              chan[i].oldNote=chan[i].note;
-              //chan[i].note=-1;
-              if (chan[i].inPorta && song.noteOffResetsSlides) {
-                chan[i].keyOff=true;
-                chan[i].keyOn=false;
-                if (chan[i].stopOnOff) {
-                  chan[i].portaNote=-1;
-                  chan[i].portaSpeed=-1;
-                  dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
-                  chan[i].stopOnOff=false;
-                }
-                if (disCont[dispatchOfChan[i]].dispatch->keyOffAffectsPorta(dispatchChanOfChan[i])) {
-                  chan[i].portaNote=-1;
-                  chan[i].portaSpeed=-1;
-                  dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
-                }
-                dispatchCmd(DivCommand(DIV_CMD_PRE_PORTA,i,false,0));
-                chan[i].scheduledSlideReset=true;
+      // note cut
+      if (chan[i].cut>0) {
+        if (--chan[i].cut<1) {
+          if (chan[i].cutType==2) {
+            dispatchCmd(DivCommand(DIV_CMD_ENV_RELEASE,i));
+            chan[i].releasing=true;
+          } else {
+            chan[i].oldNote=chan[i].note;
+            //chan[i].note=-1;
+            if (chan[i].inPorta && song.noteOffResetsSlides) {
+              chan[i].keyOff=true;
+              chan[i].keyOn=false;
+              if (chan[i].stopOnOff) {
+                chan[i].portaNote=-1;
+                chan[i].portaSpeed=-1;
+                dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
+                chan[i].stopOnOff=false;
               }
-              if (chan[i].cutType==1) {
-                dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF_ENV,i));
-              } else {
-                dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF,i));
+              if (disCont[dispatchOfChan[i]].dispatch->keyOffAffectsPorta(dispatchChanOfChan[i])) {
+                chan[i].portaNote=-1;
+                chan[i].portaSpeed=-1;
+                dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
               }
-              chan[i].releasing=true;
+              dispatchCmd(DivCommand(DIV_CMD_PRE_PORTA,i,false,0));
+              chan[i].scheduledSlideReset=true;
             }
+            if (chan[i].cutType==1) {
+              dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF_ENV,i));
+            } else {
+              dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF,i));
+            }
+            chan[i].releasing=true;
           }
         }
+      }
 
-        // volume cut/mute
-        if (chan[i].volCut>0) {
-          if (--chan[i].volCut<1) {
-            chan[i].volume=0;
-            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-            dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
-          }
+      // volume cut/mute
+      if (chan[i].volCut>0) {
+        if (--chan[i].volCut<1) {
+          chan[i].volume=0;
+          dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+          dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
         }
+      }
 
-        // arpeggio
-        if (chan[i].resetArp) {
-          dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-          dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
-          chan[i].resetArp=false;
-        }
-        if (song.rowResetsArpPos && firstTick) {
-          chan[i].arpStage=-1;
-        }
-        if (chan[i].arp!=0 && !chan[i].arpYield && chan[i].portaSpeed<1) {
-          if (--chan[i].arpTicks<1) {
-            chan[i].arpTicks=curSubSong->arpLen;
-            chan[i].arpStage++;
-            if (chan[i].arpStage>2) chan[i].arpStage=0;
-            switch (chan[i].arpStage) {
-              case 0:
-                dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-                break;
-              case 1:
-                dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp>>4)));
-                break;
-              case 2:
-                dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp&15)));
-                break;
-            }
+      // arpeggio
+      if (chan[i].resetArp) {
+        dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+        dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
+        chan[i].resetArp=false;
+      }
+      if (song.rowResetsArpPos && firstTick) {
+        chan[i].arpStage=-1;
+      }
+      if (chan[i].arp!=0 && !chan[i].arpYield && chan[i].portaSpeed<1) {
+        if (--chan[i].arpTicks<1) {
+          chan[i].arpTicks=curSubSong->arpLen;
+          chan[i].arpStage++;
+          if (chan[i].arpStage>2) chan[i].arpStage=0;
+          switch (chan[i].arpStage) {
+            case 0:
+              dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+              break;
+            case 1:
+              dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp>>4)));
+              break;
+            case 2:
+              dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp&15)));
+              break;
           }
-        } else {
-          chan[i].arpYield=false;
         }
+      } else {
+        chan[i].arpYield=false;
       }
     }
-  } else {
-    // still tick the subtick counter
-    if (--subticks<=0) {
-      subticks=tickMult;
-    }
   }
 
-  if (subticks==tickMult && cmdStreamInt) {
+  if (cmdStreamInt) {
     if (!cmdStreamInt->tick()) {
       // !!!
     }
@@ -2016,12 +2003,23 @@ bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
   }
 
   // system tick
-  for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->tick(subticks==tickMult);
+  // systems share no tick state, so they can run in parallel on the render pool.
+  if (renderPool!=NULL && song.systemLen>1) {
+    for (int i=0; i<song.systemLen; i++) {
+      renderPool->push([](void* d) {
+        DivDispatchContainer* dc=(DivDispatchContainer*)d;
+        dc->dispatch->tick(true);
+      },&disCont[i]);
+    }
+    renderPool->wait();
+  } else {
+    for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->tick(true);
+  }
 
   if (!freelance) {
     if (stepPlay!=1) {
       if (!noAccum) {
-        double dt=divider*tickMult;
+        double dt=divider;
         if (skipping) {
           dt*=(double)virtualTempoN/(double)MAX(1,virtualTempoD);
         }
@@ -2041,7 +2039,7 @@ bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
       }
     }
 
-    if (consoleMode && !disableStatusOut && subticks<=1 && !skipping) fprintf(stderr,"\x1b[2K> %d:%.2d:%.2d.%.2d  %.2x/%.2x:%.3d/%.3d  %4dcmd/s\x1b[G",totalSeconds/3600,(totalSeconds/60)%60,totalSeconds%60,totalTicks/10000,curOrder,curSubSong->ordersLen,curRow,curSubSong->patLen,cmdsPerSecond);
+    if (consoleMode && !disableStatusOut && !skipping) fprintf(stderr,"\x1b[2K> %d:%.2d:%.2d.%.2d  %.2x/%.2x:%.3d/%.3d  %4dcmd/s\x1b[G",totalSeconds/3600,(totalSeconds/60)%60,totalSeconds%60,totalTicks/10000,curOrder,curSubSong->ordersLen,curRow,curSubSong->patLen,cmdsPerSecond);
   }
 
   if (haltOn==DIV_HALT_TICK) halted=true;
@@ -2205,6 +2203,173 @@ void _runDispatch2(void* d) {
 
 }
 
+// out+=in*vol, with in being 16-bit
+static inline void mixShorts(float* out, const short* in, float vol, size_t len) {
+  size_t i=0;
+  vol/=32768.0f;
+#ifdef __SSE2__
+  const __m128 v=_mm_set1_ps(vol);
+  for (; i+8<=len; i+=8) {
+    __m128i s=_mm_loadu_si128((const __m128i*)(in+i));
+    __m128 lo=_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s,s),16));
+    __m128 hi=_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s,s),16));
+    _mm_storeu_ps(out+i,_mm_add_ps(_mm_loadu_ps(out+i),_mm_mul_ps(lo,v)));
+    _mm_storeu_ps(out+i+4,_mm_add_ps(_mm_loadu_ps(out+i+4),_mm_mul_ps(hi,v)));
+  }
+#elif defined(__ARM_NEON)
+  const float32x4_t v=vdupq_n_f32(vol);
+  for (; i+8<=len; i+=8) {
+    int16x8_t s=vld1q_s16(in+i);
+    float32x4_t lo=vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+    float32x4_t hi=vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+    vst1q_f32(out+i,vmlaq_f32(vld1q_f32(out+i),lo,v));
+    vst1q_f32(out+i+4,vmlaq_f32(vld1q_f32(out+i+4),hi,v));
+  }
+#endif
+  for (; i<len; i++) {
+    out[i]+=(float)in[i]*vol;
+  }
+}
+
+static inline void mixFloats(float* out, const float* in, float vol, size_t len) {
+  for (size_t i=0; i<len; i++) {
+    out[i]+=in[i]*vol;
+  }
+}
+
+void DivEngine::updatePatchbayMatrix(int outChans) {
+  // check whether anything changed
+  float params[DIV_MAX_CHIPS*5+1];
+  int paramCount=0;
+  for (int i=0; i<song.systemLen; i++) {
+    params[paramCount++]=song.systemVol[i];
+    params[paramCount++]=song.systemPan[i];
+    params[paramCount++]=song.systemPanFR[i];
+    params[paramCount++]=(disCont[i].dispatch==NULL)?0.0f:disCont[i].dispatch->getPostAmp();
+    params[paramCount++]=(disCont[i].dispatch==NULL)?0.0f:disCont[i].dispatch->getOutputCount();
+  }
+  params[paramCount++]=song.masterVol;
+  if (patchMatrix.valid &&
+      patchMatrix.systemLen==song.systemLen &&
+      patchMatrix.outChans==outChans &&
+      patchMatrix.patchbay==song.patchbay &&
+      memcmp(patchMatrix.params,params,paramCount*sizeof(float))==0) {
+    return;
+  }
+
+  // compile
+  memset(patchMatrix.gain,0,sizeof(patchMatrix.gain));
+  for (unsigned int i: song.patchbay) {
+    const unsigned short srcPort=i>>16;
+    const unsigned short destPort=i&0xffff;
+
+    const unsigned short srcPortSet=srcPort>>4;
+    const unsigned short destPortSet=destPort>>4;
+    const unsigned char srcSubPort=srcPort&15;
+    const unsigned char destSubPort=destPort&15;
+
+    // only system outputs are valid destinations
+    if (destPortSet!=0x000) continue;
+    if (destSubPort>=outChans) continue;
+
+    if (srcPortSet<song.systemLen) {
+      // chip outputs
+      if (disCont[srcPortSet].dispatch==NULL) continue;
+      if (srcSubPort>=disCont[srcPortSet].dispatch->getOutputCount()) continue;
+      float vol=song.systemVol[srcPortSet]*disCont[srcPortSet].dispatch->getPostAmp()*song.masterVol;
+
+      switch (destSubPort&3) {
+        case 0:
+          vol*=MIN(1.0f,1.0f-song.systemPan[srcPortSet])*MIN(1.0f,1.0f+song.systemPanFR[srcPortSet]);
+          break;
+        case 1:
+          vol*=MIN(1.0f,1.0f+song.systemPan[srcPortSet])*MIN(1.0f,1.0f+song.systemPanFR[srcPortSet]);
+          break;
+        case 2:
+          vol*=MIN(1.0f,1.0f-song.systemPan[srcPortSet])*MIN(1.0f,1.0f-song.systemPanFR[srcPortSet]);
+          break;
+        case 3:
+          vol*=MIN(1.0f,1.0f+song.systemPan[srcPortSet])*MIN(1.0f,1.0f-song.systemPanFR[srcPortSet]);
+          break;
+      }
+      patchMatrix.gain[destSubPort][srcPortSet*DIV_MAX_OUTPUTS+srcSubPort]+=vol;
+    } else if (srcPortSet==0xffd) {
+      // sample preview (previewVol is applied while mixing)
+      patchMatrix.gain[destSubPort][DIV_PATCH_PREVIEW]+=1.0f;
+    } else if (srcPortSet==0xffe) {
+      // metronome
+      patchMatrix.gain[destSubPort][DIV_PATCH_METRONOME]+=1.0f;
+    }
+  }
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    patchMatrix.activeLen[i]=0;
+    for (int j=0; j<DIV_PATCH_SOURCES; j++) {
+      if (patchMatrix.gain[i][j]!=0.0f) {
+        patchMatrix.active[i][patchMatrix.activeLen[i]++]=j;
+      }
+    }
+  }
+
+  patchMatrix.patchbay=song.patchbay;
+  memcpy(patchMatrix.params,params,paramCount*sizeof(float));
+  patchMatrix.systemLen=song.systemLen;
+  patchMatrix.outChans=outChans;
+  patchMatrix.valid=true;
+}
+
+void DivEngine::runLoadGovernor(size_t size) {
+  uint64_t heaviestTime=0;
+  int heaviest=-1;
+  int lastLowCost=-1;
+  for (int i=0; i<song.systemLen; i++) {
+    if (disCont[i].lowCost) {
+      lastLowCost=i;
+    } else if (disCont[i].acquireTime>heaviestTime && DivDispatchContainer::setLowCost(song.system[i],NULL)) {
+      heaviestTime=disCont[i].acquireTime;
+      heaviest=i;
+    }
+    disCont[i].acquireTime=0;
+  }
+
+  if (!loadGovernor || exporting || freelance || got.rate<1 || size<1) {
+    governorOver=0;
+    governorUnder=0;
+    return;
+  }
+  // let a swap settle
+  if (governorHold>0) {
+    governorHold--;
+    return;
+  }
+
+  double deadline=1000000000.0*(double)size/(double)got.rate;
+  double load=(double)processTime/deadline;
+  if (load>0.85) {
+    governorUnder=0;
+    governorOver++;
+  } else if (load<0.4) {
+    governorOver=0;
+    governorUnder++;
+  } else {
+    governorOver=0;
+    governorUnder=0;
+  }
+
+  if (governorOver>=8 && heaviest>=0) {
+    // switch the chip which took the longest to a cheaper core
+    logW("load governor: audio load at %d%%. requesting a cheaper core for chip %d",(int)(load*100.0),heaviest+1);
+    governorRequest=(heaviest<<1)|1;
+    governorOver=0;
+    governorHold=100;
+  } else if (governorUnder>=1000 && lastLowCost>=0) {
+    // restore chips one by one after enough headroom
+    logI("load governor: restoring the configured core for chip %d",lastLowCost+1);
+    governorRequest=(lastLowCost<<1);
+    governorUnder=0;
+    governorHold=100;
+  }
+}
+
 void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsigned int size) {
   lastNBIns=inChans;
   lastNBOuts=outChans;
@@ -2234,6 +2399,11 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
 
   std::chrono::steady_clock::time_point ts_processBegin=std::chrono::steady_clock::now();
 
+  // pick up copy-on-write asset edits
+  applyAssetSwaps();
+
+  runLoadGovernor(size);
+
   if (renderPool==NULL) {
     unsigned int howManyThreads=song.systemLen;
     if (howManyThreads<2) howManyThreads=0;
@@ -2476,6 +2646,10 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
       if (runLeftG<=0) break;
 
       // 2. check whether we gonna tick
+      if (lowLatency && !exporting && cycles>0 && !pendingNotes.empty()) {
+        // play live notes now rather than on the next tick
+        nextSubTick();
+      }
       if (cycles<=0) {
         // we have to tick
         if (nextTick()) {
@@ -2638,62 +2812,23 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
   }
 
   // resolve patchbay
-  for (unsigned int i: song.patchbay) {
-    const unsigned short srcPort=i>>16;
-    const unsigned short destPort=i&0xffff;
-
-    const unsigned short srcPortSet=srcPort>>4;
-    const unsigned short destPortSet=destPort>>4;
-    const unsigned char srcSubPort=srcPort&15;
-    const unsigned char destSubPort=destPort&15;
-
-    // null portset
-    if (destPortSet==0xfff) continue;
-
-    // system outputs
-    if (destPortSet==0x000) {
-      if (destSubPort>=outChans) continue;
-
-      // chip outputs
-      if (srcPortSet<song.systemLen && playing && !halted) {
-        if (srcSubPort<disCont[srcPortSet].dispatch->getOutputCount()) {
-          float vol=song.systemVol[srcPortSet]*disCont[srcPortSet].dispatch->getPostAmp()*song.masterVol;
-
-          switch (destSubPort&3) {
-            case 0:
-              vol*=MIN(1.0f,1.0f-song.systemPan[srcPortSet])*MIN(1.0f,1.0f+song.systemPanFR[srcPortSet]);
-              break;
-            case 1:
-              vol*=MIN(1.0f,1.0f+song.systemPan[srcPortSet])*MIN(1.0f,1.0f+song.systemPanFR[srcPortSet]);
-              break;
-            case 2:
-              vol*=MIN(1.0f,1.0f-song.systemPan[srcPortSet])*MIN(1.0f,1.0f-song.systemPanFR[srcPortSet]);
-              break;
-            case 3:
-              vol*=MIN(1.0f,1.0f+song.systemPan[srcPortSet])*MIN(1.0f,1.0f-song.systemPanFR[srcPortSet]);
-              break;
-          }
-
-          for (size_t j=0; j<size; j++) {
-            out[destSubPort][j]+=((float)disCont[srcPortSet].bbOut[srcSubPort][j]/32768.0)*vol;
-          }
-        }
-      } else if (srcPortSet==0xffd) {
+  updatePatchbayMatrix(outChans);
+  for (int i=0; i<outChans; i++) {
+    for (int j=0; j<patchMatrix.activeLen[i]; j++) {
+      const unsigned short src=patchMatrix.active[i][j];
+      const float vol=patchMatrix.gain[i][src];
+      if (src<DIV_PATCH_PREVIEW) {
+        // chip outputs
+        if (!playing || halted) continue;
+        mixShorts(out[i],disCont[src/DIV_MAX_OUTPUTS].bbOut[src%DIV_MAX_OUTPUTS],vol,size);
+      } else if (src==DIV_PATCH_PREVIEW) {
         // sample preview
-        for (size_t j=0; j<size; j++) {
-          out[destSubPort][j]+=previewVol*(samp_bbOut[j]/32768.0);
-        }
-      } else if (srcPortSet==0xffe && playing && !halted) {
+        mixShorts(out[i],samp_bbOut,vol*previewVol,size);
+      } else if (src==DIV_PATCH_METRONOME && playing && !halted) {
         // metronome
-        for (size_t j=0; j<size; j++) {
-          out[destSubPort][j]+=metroBuf[j];
-        }
+        mixFloats(out[i],metroBuf,vol,size);
       }
-
-      // nothing/invalid
     }
-
-    // nothing/invalid
   }
 
   // dump to oscillator buffer
@@ -22,11 +22,19 @@
 #include "../fileutils.h"
 #include <math.h>
 #include <string.h>
+#include <unordered_set>
 #ifdef HAVE_SNDFILE
 #include "sfWrapper.h"
 #endif
 #include "filter.h"
 #include "bsr.h"
+#include "workPool.h"
+#include <thread>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 extern "C" {
 #include "../../extern/adpcm/bs_codec.h"
@@ -38,10 +46,6 @@ extern "C" {
 #include "../../extern/adpcm-xq-s/adpcm-lib.h"
 #include "brrUtils.h"
 
-DivSampleHistory::~DivSampleHistory() {
-  if (data!=NULL) delete[] data;
-}
-
 void DivSample::putSampleData(SafeWriter* w) {
   size_t blockStartSeek, blockEndSeek;
 
@@ -904,6 +908,10 @@ void DivSample::convert(DivSampleDepth newDepth, unsigned int formatMask) {
     return false; \
   }
 
+// report progress every 64K samples and stop if cancelled
+#define RESAMPLE_PROGRESS \
+  if (!(i&0xffff) && !setProgress((double)i/(double)finalCount)) break;
+
 #define RESAMPLE_END \
   if (loopStart>=0) loopStart=(double)loopStart*(tRate/sRate); \
   if (loopEnd>=0) loopEnd=(double)loopEnd*(tRate/sRate); \
@@ -921,6 +929,7 @@ bool DivSample::resampleNone(double sRate, double tRate) {
 
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS;
       unsigned int pos=(unsigned int)((double)i*(sRate/tRate));
       if (pos>=samples) {
         data16[i]=0;
@@ -930,6 +939,7 @@ bool DivSample::resampleNone(double sRate, double tRate) {
     }
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS;
       unsigned int pos=(unsigned int)((double)i*(sRate/tRate));
       if (pos>=samples) {
         data8[i]=0;
@@ -952,6 +962,7 @@ bool DivSample::resampleLinear(double sRate, double tRate) {
 
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS;
       short s1=(posInt>=samples)?0:oldData16[posInt];
       short s2=(posInt+1>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData16[loopStart]:0):oldData16[posInt+1];
 
@@ -965,6 +976,7 @@ bool DivSample::resampleLinear(double sRate, double tRate) {
     }
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS;
       short s1=(posInt>=samples)?0:oldData8[posInt];
       short s2=(posInt+1>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData8[loopStart]:0):oldData8[posInt+1];
 
@@ -992,6 +1004,7 @@ bool DivSample::resampleCubic(double sRate, double tRate) {
 
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS;
       unsigned int n=((unsigned int)(posFrac*1024.0))&1023;
       float* t=&cubicTable[n<<2];
       float s0=(posInt<1)?0:oldData16[posInt-1];
@@ -1012,6 +1025,7 @@ bool DivSample::resampleCubic(double sRate, double tRate) {
     }
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS;
       unsigned int n=((unsigned int)(posFrac*1024.0))&1023;
       float* t=&cubicTable[n<<2];
       float s0=(posInt<1)?0:oldData8[posInt-1];
@@ -1050,6 +1064,7 @@ bool DivSample::resampleBlep(double sRate, double tRate) {
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
     memset(data16,0,finalCount*sizeof(short));
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS;
       if (posInt<samples) {
         data16[i]=oldData16[posInt];
       }
@@ -1083,6 +1098,7 @@ bool DivSample::resampleBlep(double sRate, double tRate) {
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
     memset(data8,0,finalCount);
     for (int i=0; i<finalCount; i++) {
+      RESAMPLE_PROGRESS;
       if (posInt<samples) {
         data8[i]=oldData8[posInt];
       }
@@ -1120,69 +1136,122 @@ bool DivSample::resampleBlep(double sRate, double tRate) {
   return true;
 }
 
-bool DivSample::resampleSinc(double sRate, double tRate) {
-  RESAMPLE_BEGIN;
+// outputs per block of the parallel sinc resampler
+#define SINC_BLOCK 16384
 
-  double posFrac=0;
-  unsigned int posInt=0;
-  double factor=sRate/tRate;
-  float* sincTable=DivFilterTables::getSincTable();
-  float s[16];
+struct DivSincBlock {
+  DivSample* sample;
+  const float* src;
+  double factor;
+  int start, end;
+  std::atomic<int>* done;
+  int total;
+};
 
-  memset(s,0,16*sizeof(float));
+// 16-tap sinc at a position. x points to the first tap.
+static inline float sincDot(const float* x, const float* t1, const float* t2) {
+#ifdef __SSE2__
+  __m128 t2lo=_mm_loadu_ps(t2);
+  __m128 t2hi=_mm_loadu_ps(t2+4);
+  __m128 sum=_mm_mul_ps(_mm_loadu_ps(x),_mm_shuffle_ps(t2hi,t2hi,_MM_SHUFFLE(0,1,2,3)));
+  sum=_mm_add_ps(sum,_mm_mul_ps(_mm_loadu_ps(x+4),_mm_shuffle_ps(t2lo,t2lo,_MM_SHUFFLE(0,1,2,3))));
+  sum=_mm_add_ps(sum,_mm_mul_ps(_mm_loadu_ps(x+8),_mm_loadu_ps(t1)));
+  sum=_mm_add_ps(sum,_mm_mul_ps(_mm_loadu_ps(x+12),_mm_loadu_ps(t1+4)));
+  sum=_mm_add_ps(sum,_mm_movehl_ps(sum,sum));
+  sum=_mm_add_ss(sum,_mm_shuffle_ps(sum,sum,1));
+  return _mm_cvtss_f32(sum);
+#elif defined(__ARM_NEON)
+  float32x4_t t2lo=vrev64q_f32(vld1q_f32(t2));
+  float32x4_t t2hi=vrev64q_f32(vld1q_f32(t2+4));
+  float32x4_t sum=vmulq_f32(vld1q_f32(x),vcombine_f32(vget_high_f32(t2hi),vget_low_f32(t2hi)));
+  sum=vmlaq_f32(sum,vld1q_f32(x+4),vcombine_f32(vget_high_f32(t2lo),vget_low_f32(t2lo)));
+  sum=vmlaq_f32(sum,vld1q_f32(x+8),vld1q_f32(t1));
+  sum=vmlaq_f32(sum,vld1q_f32(x+12),vld1q_f32(t1+4));
+  float32x2_t r=vadd_f32(vget_low_f32(sum),vget_high_f32(sum));
+  return vget_lane_f32(vpadd_f32(r,r),0);
+#else
+  float result=0;
+  for (int j=0; j<8; j++) {
+    result+=x[j]*t2[7-j];
+    result+=x[8+j]*t1[j];
+  }
+  return result;
+#endif
+}
 
-  if (depth==DIV_SAMPLE_DEPTH_16BIT) {
-    for (int i=0; i<finalCount+8; i++) {
-      unsigned int n=((unsigned int)(posFrac*8192.0))&8191;
-      float result=0;
-      float* t1=&sincTable[(8191-n)<<3];
-      float* t2=&sincTable[n<<3];
-      for (int j=0; j<8; j++) {
-        result+=s[j]*t2[7-j];
-        result+=s[8+j]*t1[j];
-      }
+static void resampleSincBlock(void* arg, unsigned int index) {
+  DivSincBlock* b=&((DivSincBlock*)arg)[index];
+  DivSample* s=b->sample;
+  if (s->progress!=NULL && s->progress->cancel) return;
+  float* sincTable=DivFilterTables::getSincTable();
+
+  for (int i=b->start; i<b->end; i++) {
+    // the filter delays by 8 samples
+    double pos=(double)(i+8)*b->factor;
+    unsigned int posInt=(unsigned int)pos;
+    unsigned int n=((unsigned int)((pos-(double)posInt)*8192.0))&8191;
+    // taps cover posInt-15 to posInt. the source is padded by 16.
+    float result=sincDot(&b->src[posInt+1],&sincTable[(8191-n)<<3],&sincTable[n<<3]);
+    if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
       if (result<-32768) result=-32768;
       if (result>32767) result=32767;
-      if (i>=8) {
-        data16[i-8]=result;
-      }
-      
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
-
-        for (int j=0; j<15; j++) s[j]=s[j+1];
-        s[15]=(posInt>=samples)?0:oldData16[posInt];
-      }
-    }
-  } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
-    for (int i=0; i<finalCount+8; i++) {
-      unsigned int n=((unsigned int)(posFrac*8192.0))&8191;
-      float result=0;
-      float* t1=&sincTable[(8191-n)<<3];
-      float* t2=&sincTable[n<<3];
-      for (int j=0; j<8; j++) {
-        result+=s[j]*t2[7-j];
-        result+=s[8+j]*t1[j];
-      }
+      s->data16[i]=result;
+    } else {
       if (result<-128) result=-128;
       if (result>127) result=127;
-      if (i>=8) {
-        data8[i-8]=result;
-      }
-      
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
+      s->data8[i]=result;
+    }
+  }
 
-        for (int j=0; j<15; j++) s[j]=s[j+1];
-        s[15]=(posInt>=samples)?0:oldData8[posInt];
-      }
+  s->setProgress((double)(b->done->fetch_add(1)+1)/(double)b->total);
+}
+
+bool DivSample::resampleSinc(double sRate, double tRate) {
+  RESAMPLE_BEGIN;
+
+  double factor=sRate/tRate;
+  // make sure the table is ready before the workers start
+  DivFilterTables::getSincTable();
+
+  // convert the source to float, with silence on both ends
+  size_t srcLen=(size_t)((double)(finalCount+8)*factor)+32;
+  if (srcLen<(size_t)samples+32) srcLen=(size_t)samples+32;
+  float* src=new float[srcLen];
+  memset(src,0,srcLen*sizeof(float));
+  if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+    for (unsigned int i=0; i<samples; i++) {
+      src[16+i]=oldData16[i];
     }
+  } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
+    for (unsigned int i=0; i<samples; i++) {
+      src[16+i]=oldData8[i];
+    }
+  }
+
+  // every output depends on the source only, so blocks run in parallel
+  int blockCount=(finalCount+SINC_BLOCK-1)/SINC_BLOCK;
+  std::atomic<int> done(0);
+  DivSincBlock* blocks=new DivSincBlock[blockCount];
+  for (int i=0; i<blockCount; i++) {
+    blocks[i].sample=this;
+    blocks[i].src=src;
+    blocks[i].factor=factor;
+    blocks[i].start=i*SINC_BLOCK;
+    blocks[i].end=MIN(finalCount,(i+1)*SINC_BLOCK);
+    blocks[i].done=&done;
+    blocks[i].total=blockCount;
+  }
+
+  unsigned int threads=(blockCount>1)?MIN(64,MIN((unsigned int)blockCount,std::thread::hardware_concurrency())):0;
+  if (threads<2) threads=0;
+  {
+    DivWorkPool pool(threads);
+    pool.parallelFor(blockCount,resampleSincBlock,blocks);
   }
 
+  delete[] blocks;
+  delete[] src;
+
   RESAMPLE_END;
   return true;
 }
@@ -1190,31 +1259,227 @@ bool DivSample::resampleSinc(double sRate, double tRate) {
 bool DivSample::resample(double sRate, double tRate, int filter) {
   if (depth!=DIV_SAMPLE_DEPTH_8BIT && depth!=DIV_SAMPLE_DEPTH_16BIT) return false;
   if (tRate<100) return false;
+  bool ret=false;
   switch (filter) {
     case DIV_RESAMPLE_NONE:
-      return resampleNone(sRate,tRate);
+      ret=resampleNone(sRate,tRate);
       break;
     case DIV_RESAMPLE_LINEAR:
-      return resampleLinear(sRate,tRate);
+      ret=resampleLinear(sRate,tRate);
       break;
     case DIV_RESAMPLE_CUBIC:
-      return resampleCubic(sRate,tRate);
+      ret=resampleCubic(sRate,tRate);
       break;
     case DIV_RESAMPLE_BLEP:
-      return resampleBlep(sRate,tRate);
+      ret=resampleBlep(sRate,tRate);
       break;
     case DIV_RESAMPLE_SINC:
-      return resampleSinc(sRate,tRate);
+      ret=resampleSinc(sRate,tRate);
       break;
     case DIV_RESAMPLE_BEST:
       if (tRate>sRate) {
-        return resampleSinc(sRate,tRate);
+        ret=resampleSinc(sRate,tRate);
       } else {
-        return resampleBlep(sRate,tRate);
+        ret=resampleBlep(sRate,tRate);
       }
       break;
   }
-  return false;
+  // the result of a cancelled operation is incomplete
+  if (progress!=NULL && progress->cancel) return false;
+  return ret;
+}
+
+float DivSample::getPeak(unsigned int start, unsigned int end) {
+  if (end>samples) end=samples;
+  if (start>=end) return 0.0f;
+  int maxVal=0;
+  int minVal=0;
+  unsigned int i=start;
+
+  if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+#ifdef __SSE2__
+    __m128i vMax=_mm_setzero_si128();
+    __m128i vMin=_mm_setzero_si128();
+    for (; i+8<=end; i+=8) {
+      __m128i x=_mm_loadu_si128((const __m128i*)(data16+i));
+      vMax=_mm_max_epi16(vMax,x);
+      vMin=_mm_min_epi16(vMin,x);
+    }
+    short lanes[16];
+    _mm_storeu_si128((__m128i*)lanes,vMax);
+    _mm_storeu_si128((__m128i*)(lanes+8),vMin);
+    for (int j=0; j<8; j++) {
+      if (lanes[j]>maxVal) maxVal=lanes[j];
+      if (lanes[8+j]<minVal) minVal=lanes[8+j];
+    }
+#elif defined(__ARM_NEON)
+    int16x8_t vMax=vdupq_n_s16(0);
+    int16x8_t vMin=vdupq_n_s16(0);
+    for (; i+8<=end; i+=8) {
+      int16x8_t x=vld1q_s16(data16+i);
+      vMax=vmaxq_s16(vMax,x);
+      vMin=vminq_s16(vMin,x);
+    }
+    short lanes[16];
+    vst1q_s16(lanes,vMax);
+    vst1q_s16(lanes+8,vMin);
+    for (int j=0; j<8; j++) {
+      if (lanes[j]>maxVal) maxVal=lanes[j];
+      if (lanes[8+j]<minVal) minVal=lanes[8+j];
+    }
+#endif
+    for (; i<end; i++) {
+      if (data16[i]>maxVal) maxVal=data16[i];
+      if (data16[i]<minVal) minVal=data16[i];
+    }
+    float ret=(float)MAX(maxVal,-minVal)/32767.0f;
+    return MIN(1.0f,ret);
+  } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
+    for (; i<end; i++) {
+      if (data8[i]>maxVal) maxVal=data8[i];
+      if (data8[i]<minVal) minVal=data8[i];
+    }
+    float ret=(float)MAX(maxVal,-minVal)/127.0f;
+    return MIN(1.0f,ret);
+  }
+  return 0.0f;
+}
+
+bool DivSample::applyGain(unsigned int start, unsigned int end, float from, float to) {
+  if (depth!=DIV_SAMPLE_DEPTH_8BIT && depth!=DIV_SAMPLE_DEPTH_16BIT) return false;
+  if (end>samples) end=samples;
+  if (start>=end) return true;
+  float step=(to-from)/(float)(end-start);
+  float minVal=(depth==DIV_SAMPLE_DEPTH_16BIT)?-32768.0f:-128.0f;
+  float maxVal=(depth==DIV_SAMPLE_DEPTH_16BIT)?32767.0f:127.0f;
+  unsigned int i=start;
+
+  // 8 samples at a time. 8-bit samples are widened to 16-bit.
+#ifdef __SSE2__
+  const __m128 vStep=_mm_set1_ps(step*4.0f);
+  const __m128 vMin=_mm_set1_ps(minVal);
+  const __m128 vMax=_mm_set1_ps(maxVal);
+  for (; i+8<=end; i+=8) {
+    __m128i x;
+    if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+      x=_mm_loadu_si128((const __m128i*)(data16+i));
+    } else {
+      x=_mm_loadl_epi64((const __m128i*)(data8+i));
+      x=_mm_srai_epi16(_mm_unpacklo_epi8(x,x),8);
+    }
+    float g=from+step*(float)(i-start);
+    __m128 gLo=_mm_set_ps(g+step*3.0f,g+step*2.0f,g+step,g);
+    __m128 gHi=_mm_add_ps(gLo,vStep);
+    __m128 lo=_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x,x),16));
+    __m128 hi=_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x,x),16));
+    lo=_mm_min_ps(_mm_max_ps(_mm_mul_ps(lo,gLo),vMin),vMax);
+    hi=_mm_min_ps(_mm_max_ps(_mm_mul_ps(hi,gHi),vMin),vMax);
+    x=_mm_packs_epi32(_mm_cvttps_epi32(lo),_mm_cvttps_epi32(hi));
+    if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+      _mm_storeu_si128((__m128i*)(data16+i),x);
+    } else {
+      _mm_storel_epi64((__m128i*)(data8+i),_mm_packs_epi16(x,x));
+    }
+  }
+#elif defined(__ARM_NEON)
+  const float32x4_t vStep=vdupq_n_f32(step*4.0f);
+  const float32x4_t vMin=vdupq_n_f32(minVal);
+  const float32x4_t vMax=vdupq_n_f32(maxVal);
+  for (; i+8<=end; i+=8) {
+    int16x8_t x;
+    if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+      x=vld1q_s16(data16+i);
+    } else {
+      x=vmovl_s8(vld1_s8(data8+i));
+    }
+    float g=from+step*(float)(i-start);
+    float gInit[4]={g,g+step,g+step*2.0f,g+step*3.0f};
+    float32x4_t gLo=vld1q_f32(gInit);
+    float32x4_t gHi=vaddq_f32(gLo,vStep);
+    float32x4_t lo=vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+    float32x4_t hi=vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+    lo=vminq_f32(vmaxq_f32(vmulq_f32(lo,gLo),vMin),vMax);
+    hi=vminq_f32(vmaxq_f32(vmulq_f32(hi,gHi),vMin),vMax);
+    x=vcombine_s16(vqmovn_s32(vcvtq_s32_f32(lo)),vqmovn_s32(vcvtq_s32_f32(hi)));
+    if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+      vst1q_s16(data16+i,x);
+    } else {
+      vst1_s8(data8+i,vqmovn_s16(x));
+    }
+  }
+#endif
+  for (; i<end; i++) {
+    float val=from+step*(float)(i-start);
+    if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+      val*=data16[i];
+      if (val<minVal) val=minVal;
+      if (val>maxVal) val=maxVal;
+      data16[i]=val;
+    } else {
+      val*=data8[i];
+      if (val<minVal) val=minVal;
+      if (val>maxVal) val=maxVal;
+      data8[i]=val;
+    }
+  }
+  return true;
+}
+
+bool DivSample::mixIn(unsigned int pos, const short* data, unsigned int len) {
+  if (depth!=DIV_SAMPLE_DEPTH_8BIT && depth!=DIV_SAMPLE_DEPTH_16BIT) return false;
+  if (pos>=samples) return true;
+  if (len>samples-pos) len=samples-pos;
+  unsigned int i=0;
+
+  // saturating adds match clipping to the sample range
+  if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+    short* out=data16+pos;
+#ifdef __SSE2__
+    for (; i+8<=len; i+=8) {
+      __m128i x=_mm_loadu_si128((const __m128i*)(out+i));
+      __m128i y=_mm_loadu_si128((const __m128i*)(data+i));
+      _mm_storeu_si128((__m128i*)(out+i),_mm_adds_epi16(x,y));
+    }
+#elif defined(__ARM_NEON)
+    for (; i+8<=len; i+=8) {
+      vst1q_s16(out+i,vqaddq_s16(vld1q_s16(out+i),vld1q_s16(data+i)));
+    }
+#endif
+    for (; i<len; i++) {
+      int val=out[i]+data[i];
+      if (val>32767) val=32767;
+      if (val<-32768) val=-32768;
+      out[i]=val;
+    }
+  } else {
+    signed char* out=data8+pos;
+#ifdef __SSE2__
+    for (; i+16<=len; i+=16) {
+      __m128i x=_mm_loadu_si128((const __m128i*)(out+i));
+      __m128i yLo=_mm_srai_epi16(_mm_loadu_si128((const __m128i*)(data+i)),8);
+      __m128i yHi=_mm_srai_epi16(_mm_loadu_si128((const __m128i*)(data+i+8)),8);
+      _mm_storeu_si128((__m128i*)(out+i),_mm_adds_epi8(x,_mm_packs_epi16(yLo,yHi)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i+16<=len; i+=16) {
+      int8x16_t y=vcombine_s8(vshrn_n_s16(vld1q_s16(data+i),8),vshrn_n_s16(vld1q_s16(data+i+8),8));
+      vst1q_s8(out+i,vqaddq_s8(vld1q_s8(out+i),y));
+    }
+#endif
+    for (; i<len; i++) {
+      int val=out[i]+(data[i]>>8);
+      if (val>127) val=127;
+      if (val<-128) val=-128;
+      out[i]=val;
+    }
+  }
+  return true;
+}
+
+bool DivSample::setProgress(double amount) {
+  if (progress==NULL) return true;
+  progress->amount=amount;
+  return !progress->cancel;
 }
 
 #define NOT_IN_FORMAT(x) (depth!=x && formatMask&(1U<<(unsigned int)x))
@@ -1566,6 +1831,42 @@ void DivSample::render(unsigned int formatMask) {
   }
 }
 
+bool DivSample::copyFrom(DivSample* other) {
+  name=other->name;
+  rate=other->rate;
+  centerRate=other->centerRate;
+  loopStart=other->loopStart;
+  loopEnd=other->loopEnd;
+  depth=other->depth;
+  loop=other->loop;
+  brrEmphasis=other->brrEmphasis;
+  brrNoFilter=other->brrNoFilter;
+  dither=other->dither;
+  loopMode=other->loopMode;
+  memcpy(renderOn,other->renderOn,DIV_MAX_SAMPLE_TYPE*DIV_MAX_CHIPS*sizeof(bool));
+
+  if (!init(other->samples)) return false;
+  if (getCurBuf()!=NULL && other->getCurBuf()!=NULL) {
+    memcpy(getCurBuf(),other->getCurBuf(),MIN(getCurBufLen(),other->getCurBufLen()));
+  }
+  return true;
+}
+
+void DivSample::takeHistory(DivSample* other) {
+  while (!undoHist.empty()) {
+    delete undoHist.back();
+    undoHist.pop_back();
+  }
+  while (!redoHist.empty()) {
+    delete redoHist.back();
+    redoHist.pop_back();
+  }
+  undoHist=other->undoHist;
+  redoHist=other->redoHist;
+  other->undoHist.clear();
+  other->redoHist.clear();
+}
+
 void* DivSample::getCurBuf() {
   switch (depth) {
     case DIV_SAMPLE_DEPTH_1BIT:
@@ -1646,17 +1947,35 @@ unsigned int DivSample::getCurBufLen() {
   return 0;
 }
 
+// returns a chunk of the last undo/redo step if it is equal to the given data
+static std::shared_ptr<DivSampleChunk> findEqualChunk(const DivSampleHistory* h, DivSampleDepth depth, size_t index, const unsigned char* buf, unsigned int len) {
+  if (h==NULL) return NULL;
+  if (!h->hasSample || h->depth!=depth) return NULL;
+  if (index>=h->data.size()) return NULL;
+  const std::shared_ptr<DivSampleChunk>& c=h->data[index];
+  if (c->len!=len) return NULL;
+  if (memcmp(c->data,buf,len)!=0) return NULL;
+  return c;
+}
+
 DivSampleHistory* DivSample::prepareUndo(bool data, bool doNotPush) {
   DivSampleHistory* h;
   if (data) {
-    unsigned char* duplicate;
-    if (getCurBuf()==NULL) {
-      duplicate=NULL;
-    } else {
-      duplicate=new unsigned char[getCurBufLen()];
-      memcpy(duplicate,getCurBuf(),getCurBufLen());
+    h=new DivSampleHistory(getCurBufLen(),samples,depth,rate,centerRate,loopStart,loopEnd,loop,brrEmphasis,brrNoFilter,dither,loopMode);
+    const unsigned char* buf=(const unsigned char*)getCurBuf();
+    if (buf!=NULL) {
+      // only copy the chunks which differ from the last step
+      const DivSampleHistory* lastUndo=undoHist.empty()?NULL:undoHist.back();
+      const DivSampleHistory* lastRedo=redoHist.empty()?NULL:redoHist.back();
+      size_t index=0;
+      for (unsigned int pos=0; pos<h->length; pos+=DIV_SAMPLE_UNDO_CHUNK, index++) {
+        unsigned int len=MIN(DIV_SAMPLE_UNDO_CHUNK,h->length-pos);
+        std::shared_ptr<DivSampleChunk> c=findEqualChunk(lastUndo,depth,index,buf+pos,len);
+        if (!c) c=findEqualChunk(lastRedo,depth,index,buf+pos,len);
+        if (!c) c=std::make_shared<DivSampleChunk>(buf+pos,len);
+        h->data.push_back(c);
+      }
     }
-    h=new DivSampleHistory(duplicate,getCurBufLen(),samples,depth,rate,centerRate,loopStart,loopEnd,loop,brrEmphasis,brrNoFilter,dither,loopMode);
   } else {
     h=new DivSampleHistory(depth,rate,centerRate,loopStart,loopEnd,loop,brrEmphasis,brrNoFilter,dither,loopMode);
   }
@@ -1682,8 +2001,13 @@ DivSampleHistory* DivSample::prepareUndo(bool data, bool doNotPush) {
 \
     void* buf=getCurBuf(); \
 \
-    if (buf!=NULL && h->data!=NULL) { \
-      memcpy(buf,h->data,h->length); \
+    if (buf!=NULL) { \
+      unsigned int pos=0; \
+      for (const std::shared_ptr<DivSampleChunk>& c: h->data) { \
+        if (pos+c->len>getCurBufLen()) break; \
+        memcpy((unsigned char*)buf+pos,c->data,c->len); \
+        pos+=c->len; \
+      } \
     } \
   } \
   rate=h->rate; \
@@ -1697,6 +2021,36 @@ DivSampleHistory* DivSample::prepareUndo(bool data, bool doNotPush) {
   loopMode=h->loopMode;
 
 
+size_t DivSample::getHistoryMemory() {
+  std::unordered_set<const DivSampleChunk*> counted;
+  size_t ret=0;
+  for (size_t i=0; i<undoHist.size(); i++) {
+    for (const std::shared_ptr<DivSampleChunk>& c: undoHist[i]->data) {
+      if (counted.insert(c.get()).second) ret+=c->len;
+    }
+  }
+  for (size_t i=0; i<redoHist.size(); i++) {
+    for (const std::shared_ptr<DivSampleChunk>& c: redoHist[i]->data) {
+      if (counted.insert(c.get()).second) ret+=c->len;
+    }
+  }
+  return ret;
+}
+
+bool DivSample::dropOldestHistory() {
+  if (!undoHist.empty()) {
+    delete undoHist.front();
+    undoHist.pop_front();
+    return true;
+  }
+  if (!redoHist.empty()) {
+    delete redoHist.front();
+    redoHist.pop_front();
+    return true;
+  }
+  return false;
+}
+
 int DivSample::undo() {
   if (undoHist.empty()) return 0;
   DivSampleHistory* h=undoHist.back();
@@ -1727,6 +2081,11 @@ int DivSample::redo() {
   return ret;
 }
 
+unsigned int DivSample::newSerial() {
+  static std::atomic<unsigned int> nextSerial(0);
+  return ++nextSerial;
+}
+
 DivSample::~DivSample() {
   while (!undoHist.empty()) {
     DivSampleHistory* h=undoHist.back();
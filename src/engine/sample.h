@@ -25,6 +25,9 @@
 #include "safeWriter.h"
 #include "dataErrors.h"
 #include "../fixedQueue.h"
+#include <atomic>
+#include <memory>
+#include <vector>
 
 enum DivSampleLoopMode: unsigned char {
   DIV_SAMPLE_LOOP_FORWARD=0,
@@ -62,16 +65,42 @@ enum DivResampleFilters {
   DIV_RESAMPLE_BEST
 };
 
-struct DivSampleHistory {
+// size of a piece of sample data in the undo history
+#define DIV_SAMPLE_UNDO_CHUNK 65536
+
+// a piece of sample data in the undo history.
+// pieces which did not change are shared between history steps.
+struct DivSampleChunk {
   unsigned char* data;
+  unsigned int len;
+  DivSampleChunk(const unsigned char* d, unsigned int l):
+    data(new unsigned char[l]),
+    len(l) {
+    memcpy(data,d,l);
+  }
+  ~DivSampleChunk() {
+    delete[] data;
+  }
+};
+
+// progress of a sample operation running in the background
+struct DivSampleProgress {
+  std::atomic<float> amount;
+  std::atomic<bool> cancel;
+  DivSampleProgress():
+    amount(0.0f),
+    cancel(false) {}
+};
+
+struct DivSampleHistory {
+  std::vector<std::shared_ptr<DivSampleChunk>> data;
   unsigned int length, samples;
   DivSampleDepth depth;
   int rate, centerRate, loopStart, loopEnd;
   bool loop, brrEmphasis, brrNoFilter, dither;
   DivSampleLoopMode loopMode;
   bool hasSample;
-  DivSampleHistory(void* d, unsigned int l, unsigned int s, DivSampleDepth de, int r, int cr, int ls, int le, bool lp, bool be, bool bf, bool di, DivSampleLoopMode lm):
-    data((unsigned char*)d),
+  DivSampleHistory(unsigned int l, unsigned int s, DivSampleDepth de, int r, int cr, int ls, int le, bool lp, bool be, bool bf, bool di, DivSampleLoopMode lm):
     length(l),
     samples(s),
     depth(de),
@@ -86,7 +115,6 @@ struct DivSampleHistory {
     loopMode(lm),
     hasSample(true) {}
   DivSampleHistory(DivSampleDepth de, int r, int cr, int ls, int le, bool lp, bool be, bool bf, bool di, DivSampleLoopMode lm):
-    data(NULL),
     length(0),
     samples(0),
     depth(de),
@@ -100,7 +128,6 @@ struct DivSampleHistory {
     dither(di),
     loopMode(lm),
     hasSample(false) {}
-  ~DivSampleHistory();
 };
 
 struct DivSample {
@@ -157,6 +184,19 @@ struct DivSample {
   FixedQueue<DivSampleHistory*,128> undoHist;
   FixedQueue<DivSampleHistory*,128> redoHist;
 
+  // set while a background job runs on this sample.
+  // long operations report their progress here and stop early if cancelled.
+  DivSampleProgress* progress;
+
+  // unique to every sample object, so that a sample allocated at the address of a deleted one
+  // isn't mistaken for it.
+  unsigned int serial;
+
+  /**
+   * get a new sample serial.
+   */
+  static unsigned int newSerial();
+
   /**
    * put sample data.
    * @param w a SafeWriter.
@@ -290,6 +330,41 @@ struct DivSample {
    */
   bool resample(double sRate, double tRate, int filter);
 
+  /**
+   * get the peak level of part of the sample (8/16-bit only).
+   * @param start the beginning.
+   * @param end the end.
+   * @return the peak level, from 0.0 to 1.0.
+   */
+  float getPeak(unsigned int start, unsigned int end);
+
+  /**
+   * apply a linear gain ramp to part of the sample (8/16-bit only).
+   * use the same gain on both ends to amplify.
+   * @param start the beginning.
+   * @param end the end.
+   * @param from gain at the beginning.
+   * @param to gain at the end.
+   * @return whether it was successful.
+   */
+  bool applyGain(unsigned int start, unsigned int end, float from, float to);
+
+  /**
+   * mix 16-bit data into the sample with clipping (8/16-bit only).
+   * @param pos the position.
+   * @param data the data to mix in.
+   * @param len length of data. clipped to the end of the sample.
+   * @return whether it was successful.
+   */
+  bool mixIn(unsigned int pos, const short* data, unsigned int len);
+
+  /**
+   * report the progress of a long operation (see `progress`).
+   * @param amount progress from 0.0 to 1.0.
+   * @return false if the operation was cancelled.
+   */
+  bool setProgress(double amount);
+
   /**
    * convert sample depth.
    * @warning do not attempt to do this outside of a synchronized block!
@@ -297,6 +372,20 @@ struct DivSample {
    */
   void convert(DivSampleDepth newDepth, unsigned int formatMask=0xffffffff);
 
+  /**
+   * copy sample parameters and data (in the current depth) from another sample.
+   * undo/redo history is not copied.
+   * @param other the source sample.
+   * @return whether it was successful.
+   */
+  bool copyFrom(DivSample* other);
+
+  /**
+   * move the undo/redo history of another sample to this one.
+   * @param other the source sample. its history will be empty afterwards.
+   */
+  void takeHistory(DivSample* other);
+
   /**
    * initialize the rest of sample formats for this sample.
    */
@@ -322,6 +411,19 @@ struct DivSample {
    */
   DivSampleHistory* prepareUndo(bool data, bool doNotPush=false);
 
+  /**
+   * get the memory used by the undo/redo history of this sample.
+   * chunks shared between steps are only counted once.
+   * @return the size in bytes.
+   */
+  size_t getHistoryMemory();
+
+  /**
+   * free the oldest undo step (or the furthest redo step if there are no undo steps).
+   * @return whether a step was freed.
+   */
+  bool dropOldestHistory();
+
   /**
    * undo. you may need to call DivEngine::renderSamples afterwards.
    * @warning do not attempt to undo outside of a synchronized block!
@@ -379,7 +481,9 @@ struct DivSample {
     lengthIMA(0),
     length12(0),
     length4(0),
-    samples(0) {
+    samples(0),
+    progress(NULL),
+    serial(newSerial()) {
     for (int i=0; i<DIV_MAX_CHIPS; i++) {
       for (int j=0; j<DIV_MAX_SAMPLE_TYPE; j++) {
         renderOn[j][i]=true;
@@ -168,6 +168,9 @@ struct DivGroovePattern {
     }
 };
 
+// get the length of a row in seconds at the given speeds and tick rate
+double calcRowLenInSeconds(const DivGroovePattern& speeds, float hz, int vN, int vD, int timeBaseFromSong);
+
 struct DivSubSong {
   String name, notes;
   unsigned char hilightA, hilightB;
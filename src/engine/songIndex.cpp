@@ -0,0 +1,209 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "songIndex.h"
+#include <algorithm>
+
+const int DivSongIndex::kindSize[DIV_INDEX_MAX]={
+  183, 256, 256, 256
+};
+
+// subsong: 7 bits, channel: 7 bits, pattern: 8 bits, row: 8 bits
+unsigned int DivSongIndex::pack(int subsong, int chan, int pat, int row) {
+  return ((unsigned int)subsong<<23)|((unsigned int)chan<<16)|((unsigned int)pat<<8)|(unsigned int)row;
+}
+
+int DivSongIndex::noteValue(short note, short octave) {
+  if (note==100 || note==101 || note==102) return 80+note;
+  if (note==0) return -1;
+  int ret=note+((signed char)octave)*12+60;
+  if (ret<0 || ret>=180) return -1;
+  return ret;
+}
+
+void DivSongIndex::addValue(DivSongIndexKind kind, int val, unsigned int loc) {
+  hits[kind][val][loc]++;
+}
+
+void DivSongIndex::removeValue(DivSongIndexKind kind, int val, unsigned int loc) {
+  Hits& h=hits[kind][val];
+  auto it=h.find(loc);
+  if (it==h.end()) return;
+  if (--it->second==0) h.erase(it);
+}
+
+void DivSongIndex::indexPattern(DivPattern* pat, unsigned int key) {
+  std::vector<unsigned int> list;
+  for (int i=0; i<DIV_MAX_ROWS; i++) {
+    const short* row=pat->data[i];
+    unsigned int rowEntry=(unsigned int)i<<16;
+
+    int note=noteValue(row[0],row[1]);
+    if (note>=0) {
+      list.push_back(rowEntry|(DIV_INDEX_NOTE<<8)|note);
+    }
+    if (row[2]>=0 && row[2]<256) {
+      list.push_back(rowEntry|(DIV_INDEX_INS<<8)|row[2]);
+    }
+    if (row[3]>=0 && row[3]<256) {
+      list.push_back(rowEntry|(DIV_INDEX_VOL<<8)|row[3]);
+    }
+    for (int j=0; j<DIV_MAX_EFFECTS; j++) {
+      short effect=row[4+(j<<1)];
+      if (effect>=0 && effect<256) {
+        list.push_back(rowEntry|(DIV_INDEX_EFFECT<<8)|effect);
+      }
+    }
+  }
+  if (list.empty()) return;
+
+  for (unsigned int i: list) {
+    addValue((DivSongIndexKind)((i>>8)&255),i&255,key|(i>>16));
+  }
+  entries[key]=std::move(list);
+}
+
+void DivSongIndex::unindexPattern(unsigned int key) {
+  auto it=entries.find(key);
+  if (it==entries.end()) return;
+  for (unsigned int i: it->second) {
+    removeValue((DivSongIndexKind)((i>>8)&255),i&255,key|(i>>16));
+  }
+  entries.erase(it);
+}
+
+void DivSongIndex::refresh(DivSong& song, int chans) {
+  if (chans>DIV_MAX_CHANS) chans=DIV_MAX_CHANS;
+
+  if (full || chans!=indexedChans) {
+    clear();
+    for (size_t i=0; i<song.subsong.size() && i<128; i++) {
+      DivSubSong* sub=song.subsong[i];
+      for (int j=0; j<chans; j++) {
+        for (int k=0; k<DIV_MAX_PATTERNS; k++) {
+          DivPattern* pat=sub->pat[j].data[k];
+          if (pat==NULL) continue;
+          indexPattern(pat,pack(i,j,k,0));
+        }
+      }
+    }
+    full=false;
+    indexedChans=chans;
+    return;
+  }
+
+  if (dirty.empty()) return;
+  std::sort(dirty.begin(),dirty.end());
+  dirty.erase(std::unique(dirty.begin(),dirty.end()),dirty.end());
+  for (unsigned int key: dirty) {
+    unindexPattern(key);
+    size_t sub=key>>23;
+    int chan=(key>>16)&127;
+    int pat=(key>>8)&255;
+    if (sub>=song.subsong.size() || chan>=chans) continue;
+    DivPattern* p=song.subsong[sub]->pat[chan].data[pat];
+    if (p==NULL) continue;
+    indexPattern(p,key);
+  }
+  dirty.clear();
+}
+
+void DivSongIndex::markDirty(int subsong, int chan, int pat) {
+  if (full) return;
+  if (subsong<0 || subsong>=128) return;
+  if (chan<0 || chan>=DIV_MAX_CHANS) return;
+  if (pat<0 || pat>=DIV_MAX_PATTERNS) return;
+  unsigned int key=pack(subsong,chan,pat,0);
+  // edits usually come in runs on the same pattern
+  if (!dirty.empty() && dirty.back()==key) return;
+  dirty.push_back(key);
+}
+
+void DivSongIndex::markAllDirty() {
+  full=true;
+  dirty.clear();
+}
+
+void DivSongIndex::find(DivSongIndexKind kind, int val, int subsong, std::vector<DivSongIndexLoc>& ret) {
+  if (kind<0 || kind>=DIV_INDEX_MAX) return;
+  if (val<0 || val>=kindSize[kind]) return;
+  for (auto& i: hits[kind][val]) {
+    int s=i.first>>23;
+    if (subsong>=0 && s!=subsong) continue;
+    ret.push_back(DivSongIndexLoc(s,(i.first>>16)&127,(i.first>>8)&255,i.first&255));
+  }
+}
+
+bool DivSongIndex::isUsed(DivSongIndexKind kind, int val, DivSong& song, int subsong) {
+  if (kind<0 || kind>=DIV_INDEX_MAX) return false;
+  if (val<0 || val>=kindSize[kind]) return false;
+  for (auto& i: hits[kind][val]) {
+    size_t s=i.first>>23;
+    if (subsong>=0 && s!=(size_t)subsong) continue;
+    if (s>=song.subsong.size()) continue;
+    if ((int)(i.first&255)<song.subsong[s]->patLen) return true;
+  }
+  return false;
+}
+
+void DivSongIndex::replace(DivSongIndexKind kind, int from, int to, const DivSongIndexLoc& loc) {
+  if (kind<0 || kind>=DIV_INDEX_MAX) return;
+  if (from<0 || from>=kindSize[kind]) return;
+  if (to<0 || to>=kindSize[kind]) return;
+  unsigned int key=pack(loc.subsong,loc.chan,loc.pat,0);
+  auto it=entries.find(key);
+  if (it==entries.end()) return;
+
+  // entries are sorted by row
+  std::vector<unsigned int>& list=it->second;
+  unsigned int old=((unsigned int)loc.row<<16)|(kind<<8)|from;
+  for (auto i=std::lower_bound(list.begin(),list.end(),(unsigned int)loc.row<<16); i!=list.end() && ((*i)>>16)==(unsigned int)loc.row; ++i) {
+    if (*i!=old) continue;
+    *i=((unsigned int)loc.row<<16)|(kind<<8)|to;
+    removeValue(kind,from,key|loc.row);
+    addValue(kind,to,key|loc.row);
+    break;
+  }
+}
+
+void DivSongIndex::clear() {
+  for (int i=0; i<DIV_INDEX_MAX; i++) {
+    for (int j=0; j<kindSize[i]; j++) {
+      hits[i][j].clear();
+    }
+  }
+  entries.clear();
+  dirty.clear();
+  full=true;
+}
+
+DivSongIndex::DivSongIndex():
+  full(true),
+  indexedChans(0) {
+  for (int i=0; i<DIV_INDEX_MAX; i++) {
+    hits[i]=new Hits[kindSize[i]];
+  }
+}
+
+DivSongIndex::~DivSongIndex() {
+  clear();
+  for (int i=0; i<DIV_INDEX_MAX; i++) {
+    delete[] hits[i];
+  }
+}
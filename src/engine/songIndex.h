@@ -0,0 +1,144 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _SONG_INDEX_H
+#define _SONG_INDEX_H
+
+#include "song.h"
+#include <unordered_map>
+
+enum DivSongIndexKind {
+  DIV_INDEX_NOTE=0,
+  DIV_INDEX_INS,
+  DIV_INDEX_VOL,
+  DIV_INDEX_EFFECT,
+
+  DIV_INDEX_MAX
+};
+
+// a row containing a value.
+struct DivSongIndexLoc {
+  int subsong, chan, pat, row;
+  DivSongIndexLoc(int s, int c, int p, int r):
+    subsong(s),
+    chan(c),
+    pat(p),
+    row(r) {}
+};
+
+/**
+ * an inverted index of pattern contents.
+ * maps notes, instruments, volumes and effects to the rows which contain them.
+ * pattern edits must be reported through markDirty()/markAllDirty(); refresh() then re-indexes the marked patterns only.
+ */
+class DivSongIndex {
+  // key: location (see pack()), value: number of occurrences in that row
+  typedef std::unordered_map<unsigned int,unsigned char> Hits;
+
+  Hits* hits[DIV_INDEX_MAX];
+  // the values indexed for each pattern (key: location of row 0), so that they can be removed without the old data.
+  // an entry is row<<16|kind<<8|value, sorted by row.
+  std::unordered_map<unsigned int,std::vector<unsigned int>> entries;
+  // patterns which changed since the last refresh (may contain duplicates)
+  std::vector<unsigned int> dirty;
+  // whether the index must be rebuilt from scratch
+  bool full;
+  // the channel count at the last refresh
+  int indexedChans;
+
+  static unsigned int pack(int subsong, int chan, int pat, int row);
+  void addValue(DivSongIndexKind kind, int val, unsigned int loc);
+  void removeValue(DivSongIndexKind kind, int val, unsigned int loc);
+  void indexPattern(DivPattern* pat, unsigned int key);
+  void unindexPattern(unsigned int key);
+
+  public:
+    /**
+     * the number of values of each kind.
+     * notes are stored as note+octave*12+60 (0-179), and note off/release/macro release as 180/181/182.
+     */
+    static const int kindSize[DIV_INDEX_MAX];
+
+    /**
+     * get the note index value of a pattern cell.
+     * @return the value, or -1 if the cell has no valid note.
+     */
+    static int noteValue(short note, short octave);
+
+    /**
+     * bring the index up to date with the song.
+     * only re-indexes the patterns marked dirty, unless the whole index was invalidated or the channel count changed.
+     * not thread-safe! do not edit the song while this runs.
+     * @param song the song.
+     * @param chans the total channel count.
+     */
+    void refresh(DivSong& song, int chans);
+
+    /**
+     * mark a pattern as changed (or created/deleted).
+     * @param subsong the subsong.
+     * @param chan the channel.
+     * @param pat the pattern index.
+     */
+    void markDirty(int subsong, int chan, int pat);
+
+    /**
+     * invalidate the whole index (song loaded, subsongs moved, channels rearranged...).
+     */
+    void markAllDirty();
+
+    /**
+     * get the locations of a value.
+     * @param kind the kind of value.
+     * @param val the value.
+     * @param subsong only return locations in this subsong, or -1 for all.
+     * @param ret the vector to append locations to (unsorted).
+     */
+    void find(DivSongIndexKind kind, int val, int subsong, std::vector<DivSongIndexLoc>& ret);
+
+    /**
+     * check whether a value is used.
+     * @param kind the kind of value.
+     * @param val the value.
+     * @param song the song (rows beyond a subsong's pattern length are ignored).
+     * @param subsong only look in this subsong, or -1 for all.
+     * @return whether it is used.
+     */
+    bool isUsed(DivSongIndexKind kind, int val, DivSong& song, int subsong=-1);
+
+    /**
+     * update the index after a value in a row was changed in place (e.g. instrument renumbering).
+     * the index must be up to date, and the row must have contained the old value.
+     * @param kind the kind of value.
+     * @param from the old value.
+     * @param to the new value.
+     * @param loc the row.
+     */
+    void replace(DivSongIndexKind kind, int from, int to, const DivSongIndexLoc& loc);
+
+    /**
+     * clear the index.
+     */
+    void clear();
+
+    DivSongIndex();
+    ~DivSongIndex();
+};
+
+#endif
@@ -2652,7 +2652,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
     songTick++;
     tickPos.push_back(w->tell());
     tickSample.push_back(tickCount);
-    if (nextTick(false,true)) {
+    if (nextTick()) {
       if (trailing) beenOneLoopAlready=true;
       trailing=true;
       if (!loop) countDown=0;
@@ -22,8 +22,226 @@
 #ifdef HAVE_SNDFILE
 #include "sfWrapper.h"
 #endif
+#include <condition_variable>
 
 #define EXPORT_BUFSIZE 2048
+// blocks of EXPORT_BUFSIZE frames which may be waiting for the encoder
+#define EXPORT_PIPE_BLOCKS 64
+
+#ifdef HAVE_SNDFILE
+// hands rendered blocks over to an encoder thread, so that rendering doesn't
+// stall on disk writes or compression.
+// acquire() blocks while the ring is full (backpressure).
+class DivExportPipe {
+  struct Block {
+    void* buf[DIV_MAX_CHIPS];
+    size_t frames;
+  };
+  SNDFILE* sf[DIV_MAX_CHIPS];
+  int chans[DIV_MAX_CHIPS];
+  int files;
+  bool asShort;
+  Block blocks[EXPORT_PIPE_BLOCKS];
+  int readPos, writePos, queued;
+  bool quit, failed;
+  std::mutex lock;
+  std::condition_variable canRead, canWrite;
+  std::thread* thread;
+  std::atomic<int>& queuedStat;
+  std::atomic<size_t>& writtenStat;
+
+  public:
+    void run() {
+      std::unique_lock<std::mutex> l(lock);
+      while (true) {
+        while (queued==0 && !quit) canRead.wait(l);
+        if (queued==0) break;
+        Block& b=blocks[readPos];
+        l.unlock();
+        bool ok=true;
+        for (int i=0; i<files; i++) {
+          sf_count_t written=asShort?sf_writef_short(sf[i],(short*)b.buf[i],b.frames):sf_writef_float(sf[i],(float*)b.buf[i],b.frames);
+          if (written!=(sf_count_t)b.frames) {
+            logE("error: failed to write entire buffer! (%d: %s)",i,sf_strerror(sf[i]));
+            ok=false;
+            break;
+          }
+        }
+        writtenStat+=b.frames;
+        l.lock();
+        if (!ok) failed=true;
+        if (++readPos>=EXPORT_PIPE_BLOCKS) readPos=0;
+        queued--;
+        queuedStat=queued;
+        canWrite.notify_one();
+      }
+    }
+
+    // wait for a free block. returns false if the encoder has failed.
+    bool acquire() {
+      std::unique_lock<std::mutex> l(lock);
+      while (queued>=EXPORT_PIPE_BLOCKS && !failed) canWrite.wait(l);
+      return !failed;
+    }
+
+    float* getBuf(int file) {
+      return (float*)blocks[writePos].buf[file];
+    }
+
+    short* getBufShort(int file) {
+      return (short*)blocks[writePos].buf[file];
+    }
+
+    // queue the acquired block for writing
+    void submit(size_t frames) {
+      std::unique_lock<std::mutex> l(lock);
+      blocks[writePos].frames=frames;
+      if (++writePos>=EXPORT_PIPE_BLOCKS) writePos=0;
+      queued++;
+      queuedStat=queued;
+      canRead.notify_one();
+    }
+
+    // write all pending blocks and stop the encoder thread. returns false if writing failed.
+    bool finish() {
+      if (thread!=NULL) {
+        {
+          std::unique_lock<std::mutex> l(lock);
+          quit=true;
+          canRead.notify_one();
+        }
+        thread->join();
+        delete thread;
+        thread=NULL;
+      }
+      return !failed;
+    }
+
+    DivExportPipe(SNDFILE** s, const int* c, int f, bool sh, std::atomic<int>& qs, std::atomic<size_t>& ws):
+      files(f),
+      asShort(sh),
+      readPos(0),
+      writePos(0),
+      queued(0),
+      quit(false),
+      failed(false),
+      thread(NULL),
+      queuedStat(qs),
+      writtenStat(ws) {
+      memset(sf,0,sizeof(sf));
+      memset(chans,0,sizeof(chans));
+      for (int i=0; i<files; i++) {
+        sf[i]=s[i];
+        chans[i]=c[i];
+      }
+      for (int i=0; i<EXPORT_PIPE_BLOCKS; i++) {
+        memset(blocks[i].buf,0,sizeof(blocks[i].buf));
+        blocks[i].frames=0;
+        for (int j=0; j<files; j++) {
+          if (asShort) {
+            blocks[i].buf[j]=new short[EXPORT_BUFSIZE*chans[j]];
+          } else {
+            blocks[i].buf[j]=new float[EXPORT_BUFSIZE*chans[j]];
+          }
+        }
+      }
+      queuedStat=0;
+      thread=new std::thread([this]() {
+        run();
+      });
+    }
+
+    ~DivExportPipe() {
+      finish();
+      for (int i=0; i<EXPORT_PIPE_BLOCKS; i++) {
+        for (int j=0; j<files; j++) {
+          if (asShort) {
+            delete[] (short*)blocks[i].buf[j];
+          } else {
+            delete[] (float*)blocks[i].buf[j];
+          }
+        }
+      }
+      queuedStat=0;
+    }
+};
+
+static int getExportSFFormat(DivAudioExportFormats format) {
+  switch (format) {
+    case DIV_EXPORT_FORMAT_S16:
+      return SF_FORMAT_WAV|SF_FORMAT_PCM_16;
+    case DIV_EXPORT_FORMAT_F32:
+      return SF_FORMAT_WAV|SF_FORMAT_FLOAT;
+    case DIV_EXPORT_FORMAT_FLAC:
+      return SF_FORMAT_FLAC|SF_FORMAT_PCM_16;
+    case DIV_EXPORT_FORMAT_OPUS:
+      return SF_FORMAT_OGG|SF_FORMAT_OPUS;
+  }
+  return SF_FORMAT_WAV|SF_FORMAT_PCM_16;
+}
+#endif
+
+const char* DivEngine::getAudioExportExt(DivAudioExportFormats format) {
+  switch (format) {
+    case DIV_EXPORT_FORMAT_FLAC:
+      return ".flac";
+    case DIV_EXPORT_FORMAT_OPUS:
+      return ".opus";
+    default:
+      break;
+  }
+  return ".wav";
+}
+
+bool DivEngine::isAudioExportFormatAvailable(DivAudioExportFormats format, int rate, int chans) {
+#ifdef HAVE_SNDFILE
+  SF_INFO si;
+  memset(&si,0,sizeof(SF_INFO));
+  si.format=getExportSFFormat(format);
+  si.samplerate=MAX(0,rate);
+  si.channels=chans;
+  if (!sf_format_check(&si)) return false;
+
+  // sf_format_check() doesn't know what libsndfile was built with,
+  // but only those major formats and codecs are listed
+  int major=si.format&SF_FORMAT_TYPEMASK;
+  int sub=si.format&SF_FORMAT_SUBMASK;
+  int count=0;
+  bool found=false;
+  sf_command(NULL,SFC_GET_FORMAT_MAJOR_COUNT,&count,sizeof(int));
+  for (int i=0; i<count; i++) {
+    SF_FORMAT_INFO info;
+    info.format=i;
+    if (sf_command(NULL,SFC_GET_FORMAT_MAJOR,&info,sizeof(info))!=0) continue;
+    if (info.format==major) {
+      found=true;
+      break;
+    }
+  }
+  if (!found) return false;
+  count=0;
+  found=false;
+  sf_command(NULL,SFC_GET_FORMAT_SUBTYPE_COUNT,&count,sizeof(int));
+  for (int i=0; i<count; i++) {
+    SF_FORMAT_INFO info;
+    info.format=i;
+    if (sf_command(NULL,SFC_GET_FORMAT_SUBTYPE,&info,sizeof(info))!=0) continue;
+    if (info.format==sub) {
+      found=true;
+      break;
+    }
+  }
+  if (!found) return false;
+
+  if (format==DIV_EXPORT_FORMAT_OPUS && rate>0) {
+    // Opus only supports these rates
+    if (rate!=8000 && rate!=12000 && rate!=16000 && rate!=24000 && rate!=48000) return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
 
 void _runExportThread(DivEngine* caller) {
   caller->runExportThread();
@@ -110,6 +328,12 @@ bool DivEngine::getIsFadingOut() {
   return isFadingOut;
 }
 
+void DivEngine::getExportQueue(int& queued, int& capacity, double& written) {
+  queued=exportQueued;
+  capacity=EXPORT_PIPE_BLOCKS;
+  written=(got.rate>0)?((double)exportFramesWritten/(double)got.rate):0.0;
+}
+
 #ifdef HAVE_SNDFILE
 void DivEngine::runExportThread() {
   size_t fadeOutSamples=got.rate*exportFadeOut;
@@ -123,11 +347,7 @@ void DivEngine::runExportThread() {
       SFWrapper sfWrap;
       si.samplerate=got.rate;
       si.channels=exportOutputs;
-      if (exportFormat==DIV_EXPORT_FORMAT_S16) {
-        si.format=SF_FORMAT_WAV|SF_FORMAT_PCM_16;
-      } else {
-        si.format=SF_FORMAT_WAV|SF_FORMAT_FLOAT;
-      }
+      si.format=getExportSFFormat(exportFormat);
 
       sf=sfWrap.doOpen(exportPath.c_str(),SFM_WRITE,&si);
       if (sf==NULL) {
@@ -137,11 +357,10 @@ void DivEngine::runExportThread() {
       }
 
       float* outBuf[DIV_MAX_OUTPUTS];
-      float* outBufFinal;
       for (int i=0; i<exportOutputs; i++) {
         outBuf[i]=new float[EXPORT_BUFSIZE];
       }
-      outBufFinal=new float[EXPORT_BUFSIZE*exportOutputs];
+      DivExportPipe* pipe=new DivExportPipe(&sf,&exportOutputs,1,false,exportQueued,exportFramesWritten);
 
       // take control of audio output
       deinitAudioBackend();
@@ -158,6 +377,8 @@ void DivEngine::runExportThread() {
           logE("error: total processed is bigger than export bufsize! %d>%d",totalProcessed,EXPORT_BUFSIZE);
           totalProcessed=EXPORT_BUFSIZE;
         }
+        if (!pipe->acquire()) break;
+        float* outBufFinal=pipe->getBuf(0);
         int fi=0;
         for (int i=0; i<(int)totalProcessed; i++) {
           total++;
@@ -181,14 +402,12 @@ void DivEngine::runExportThread() {
             }
           }
         }
-        
-        if (sf_writef_float(sf,outBufFinal,total)!=(int)total) {
-          logE("error: failed to write entire buffer!");
-          break;
-        }
+
+        pipe->submit(total);
       }
 
-      delete[] outBufFinal;
+      pipe->finish();
+      delete pipe;
       for (int i=0; i<exportOutputs; i++) {
         delete[] outBuf[i];
       }
@@ -214,23 +433,28 @@ void DivEngine::runExportThread() {
       SNDFILE* sf[DIV_MAX_CHIPS];
       SF_INFO si[DIV_MAX_CHIPS];
       String fname[DIV_MAX_CHIPS];
+      int sysChans[DIV_MAX_CHIPS];
       SFWrapper sfWrap[DIV_MAX_CHIPS];
+      // per-chip files are always 16-bit
+      DivAudioExportFormats sysFormat=(exportFormat==DIV_EXPORT_FORMAT_F32)?DIV_EXPORT_FORMAT_S16:exportFormat;
       for (int i=0; i<song.systemLen; i++) {
         sf[i]=NULL;
         si[i].samplerate=got.rate;
         si[i].channels=disCont[i].dispatch->getOutputCount();
-        si[i].format=SF_FORMAT_WAV|SF_FORMAT_PCM_16;
+        si[i].format=getExportSFFormat(sysFormat);
+        sysChans[i]=si[i].channels;
       }
 
       for (int i=0; i<song.systemLen; i++) {
-        fname[i]=fmt::sprintf("%s_s%02d.wav",exportPath,i+1);
+        fname[i]=fmt::sprintf("%s_s%02d%s",exportPath,i+1,getAudioExportExt(sysFormat));
         logI("- %s",fname[i].c_str());
         sf[i]=sfWrap[i].doOpen(fname[i].c_str(),SFM_WRITE,&si[i]);
         if (sf[i]==NULL) {
           logE("could not open file for writing! (%s)",sf_strerror(NULL));
           for (int j=0; j<i; j++) {
-            sfWrap[i].doClose();
+            sfWrap[j].doClose();
           }
+          exporting=false;
           return;
         }
       }
@@ -239,10 +463,8 @@ void DivEngine::runExportThread() {
       memset(outBuf,0,sizeof(void*)*DIV_MAX_OUTPUTS);
       outBuf[0]=new float[EXPORT_BUFSIZE];
       outBuf[1]=new float[EXPORT_BUFSIZE];
+      DivExportPipe* pipe=new DivExportPipe(sf,sysChans,song.systemLen,true,exportQueued,exportFramesWritten);
       short* sysBuf[DIV_MAX_CHIPS];
-      for (int i=0; i<song.systemLen; i++) {
-        sysBuf[i]=new short[EXPORT_BUFSIZE*disCont[i].dispatch->getOutputCount()];
-      }
 
       // take control of audio output
       deinitAudioBackend();
@@ -259,6 +481,10 @@ void DivEngine::runExportThread() {
           logE("error: total processed is bigger than export bufsize! %d>%d",totalProcessed,EXPORT_BUFSIZE);
           totalProcessed=EXPORT_BUFSIZE;
         }
+        if (!pipe->acquire()) break;
+        for (int i=0; i<song.systemLen; i++) {
+          sysBuf[i]=pipe->getBufShort(i);
+        }
         for (int j=0; j<(int)totalProcessed; j++) {
           total++;
           if (isFadingOut) {
@@ -293,19 +519,15 @@ void DivEngine::runExportThread() {
             }
           }
         }
-        for (int i=0; i<song.systemLen; i++) {
-          if (sf_writef_short(sf[i],sysBuf[i],total)!=(int)total) {
-            logE("error: failed to write entire buffer! (%d)",i);
-            break;
-          }
-        }
+        pipe->submit(total);
       }
 
+      pipe->finish();
+      delete pipe;
       delete[] outBuf[0];
       delete[] outBuf[1];
 
       for (int i=0; i<song.systemLen; i++) {
-        delete[] sysBuf[i];
         if (sfWrap[i].doClose()!=0) {
           logE("could not close audio file!");
         }
@@ -331,11 +553,9 @@ void DivEngine::runExportThread() {
       curExportChan=0;
 
       float* outBuf[DIV_MAX_OUTPUTS];
-      float* outBufFinal;
       for (int i=0; i<exportOutputs; i++) {
         outBuf[i]=new float[EXPORT_BUFSIZE];
       }
-      outBufFinal=new float[EXPORT_BUFSIZE*exportOutputs];
 
       logI("rendering to files...");
       
@@ -345,15 +565,11 @@ void DivEngine::runExportThread() {
         SNDFILE* sf;
         SF_INFO si;
         SFWrapper sfWrap;
-        String fname=fmt::sprintf("%s_c%02d.wav",exportPath,i+1);
+        String fname=fmt::sprintf("%s_c%02d%s",exportPath,i+1,getAudioExportExt(exportFormat));
         logI("- %s",fname.c_str());
         si.samplerate=got.rate;
         si.channels=exportOutputs;
-        if (exportFormat==DIV_EXPORT_FORMAT_S16) {
-          si.format=SF_FORMAT_WAV|SF_FORMAT_PCM_16;
-        } else {
-          si.format=SF_FORMAT_WAV|SF_FORMAT_FLOAT;
-        }
+        si.format=getExportSFFormat(exportFormat);
 
         sf=sfWrap.doOpen(fname.c_str(),SFM_WRITE,&si);
         if (sf==NULL) {
@@ -388,6 +604,7 @@ void DivEngine::runExportThread() {
         playSub(false);
         freelance=false;
 
+        DivExportPipe* pipe=new DivExportPipe(&sf,&exportOutputs,1,false,exportQueued,exportFramesWritten);
         while (playing) {
           size_t total=0;
           nextBuf(NULL,outBuf,0,exportOutputs,EXPORT_BUFSIZE);
@@ -395,6 +612,8 @@ void DivEngine::runExportThread() {
             logE("error: total processed is bigger than export bufsize! %d>%d",totalProcessed,EXPORT_BUFSIZE);
             totalProcessed=EXPORT_BUFSIZE;
           }
+          if (!pipe->acquire()) break;
+          float* outBufFinal=pipe->getBuf(0);
           int fi=0;
           for (int j=0; j<(int)totalProcessed; j++) {
             total++;
@@ -418,11 +637,10 @@ void DivEngine::runExportThread() {
               }
             }
           }
-          if (sf_writef_float(sf,outBufFinal,total)!=(int)total) {
-            logE("error: failed to write entire buffer!");
-            break;
-          }
+          pipe->submit(total);
         }
+        pipe->finish();
+        delete pipe;
 
         curExportChan++;
 
@@ -443,7 +661,6 @@ void DivEngine::runExportThread() {
         if (stopExport) break;
       }
 
-      delete[] outBufFinal;
       for (int i=0; i<exportOutputs; i++) {
         delete[] outBuf[i];
       }
@@ -492,19 +709,35 @@ bool DivEngine::saveAudio(const char* path, DivAudioExportOptions options) {
   exportFormat=options.format;
   exportFadeOut=options.fadeOut;
   memcpy(exportChannelMask,options.channelMask,DIV_MAX_CHANS*sizeof(bool));
+  if (!isAudioExportFormatAvailable(exportFormat,options.sampleRate,options.chans)) {
+    if (exportFormat==DIV_EXPORT_FORMAT_OPUS && isAudioExportFormatAvailable(exportFormat,0,options.chans)) {
+      logE("Opus only supports 8000, 12000, 16000, 24000 and 48000Hz!");
+      lastError=_("Opus only supports 8000, 12000, 16000, 24000 and 48000Hz");
+    } else if (isAudioExportFormatAvailable(exportFormat,options.sampleRate)) {
+      logE("this audio format does not support %d channels!",options.chans);
+      lastError=fmt::sprintf(_("this audio format does not support %d channels"),options.chans);
+    } else {
+      logE("this audio format is not available in this build!");
+      lastError=_("this audio format is not available in this build");
+    }
+    return false;
+  }
   if (exportMode!=DIV_EXPORT_MODE_ONE) {
     // remove extension
     String lowerCase=exportPath;
     for (char& i: lowerCase) {
       if (i>='A' && i<='Z') i+='a'-'A';
     }
-    size_t extPos=lowerCase.rfind(".wav");
+    size_t extPos=lowerCase.rfind(getAudioExportExt(exportFormat));
+    if (extPos==String::npos) extPos=lowerCase.rfind(".wav");
     if (extPos!=String::npos) {
       exportPath=exportPath.substr(0,extPos);
     }
   }
   exporting=true;
   stopExport=false;
+  exportQueued=0;
+  exportFramesWritten=0;
   stop();
   repeatPattern=false;
   setOrder(0);
@@ -53,11 +53,12 @@ bool DivWaveSynth::activeChanged() {
 bool DivWaveSynth::tick(bool skipSubDiv) {
   bool updated=first;
   first=false;
-  if (--subDivCounter>0 && !skipSubDiv) {
+  // don't run the effect on input sub-ticks, unless it has just been started
+  if (subDivCounter>0 && e->isInputSubTick() && !skipSubDiv) {
     return updated;
   }
 
-  subDivCounter=e->tickMult;
+  subDivCounter=1;
   if (!state.enabled) return updated;
   if (width<1) return false;
 
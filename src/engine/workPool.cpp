@@ -19,6 +19,7 @@
 
 #include "workPool.h"
 #include "../ta-log.h"
+#include "../ta-utils.h"
 #include <thread>
 
 void* _workThread(void* inst) {
@@ -174,6 +175,48 @@ void DivWorkPool::wait() {
   pos=0;
 }
 
+struct DivParallelFor {
+  void (*func)(void*,unsigned int);
+  void* funcArg;
+  unsigned int jobs;
+  std::atomic<unsigned int> next;
+};
+
+static void _parallelForWorker(void* inst) {
+  DivParallelFor* pf=(DivParallelFor*)inst;
+  while (true) {
+    unsigned int i=pf->next.fetch_add(1);
+    if (i>=pf->jobs) break;
+    pf->func(pf->funcArg,i);
+  }
+}
+
+void DivWorkPool::parallelFor(unsigned int jobs, void (*what)(void*,unsigned int), void* arg) {
+  if (!threaded || jobs<2) {
+    for (unsigned int i=0; i<jobs; i++) {
+      what(arg,i);
+    }
+    return;
+  }
+
+  DivParallelFor pf;
+  pf.func=what;
+  pf.funcArg=arg;
+  pf.jobs=jobs;
+  pf.next=0;
+
+  // one worker per thread. each one pulls indices until none are left
+  unsigned int workers=MIN(count,jobs);
+  for (unsigned int i=0; i<workers; i++) {
+    push(_parallelForWorker,&pf);
+  }
+  wait();
+}
+
+unsigned int DivWorkPool::getThreads() {
+  return threaded?count:0;
+}
+
 DivWorkPool::DivWorkPool(unsigned int threads):
   threaded(threads>0),
   count(threads),
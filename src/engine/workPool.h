@@ -93,6 +93,18 @@ class DivWorkPool {
      */
     void wait();
 
+    /**
+     * run what(arg,i) for every i in [0,jobs) and wait for all of them.
+     * indices are handed out one at a time, so jobs of uneven size balance out.
+     * runs inline if this work pool has no threads.
+     */
+    void parallelFor(unsigned int jobs, void (*what)(void*,unsigned int), void* arg);
+
+    /**
+     * get the number of work threads (0 if not threaded).
+     */
+    unsigned int getThreads();
+
     DivWorkPool(unsigned int threads=0);
     ~DivWorkPool();
 };
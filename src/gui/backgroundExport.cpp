@@ -0,0 +1,90 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "gui.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include <fmt/printf.h>
+
+static void _runBackgroundExport(FurnaceGUIBackgroundExport* job, std::function<SafeWriter*(DivEngine*)> what, String errorFormat) {
+  SafeWriter* w=what(job->snapshot);
+  if (w!=NULL) {
+    FILE* f=ps_fopen(job->path.c_str(),"wb");
+    if (f!=NULL) {
+      fwrite(w->getFinalBuf(),1,w->size(),f);
+      fclose(f);
+    } else {
+      job->error=_("could not open file!");
+    }
+    w->finish();
+    delete w;
+    job->warnings=job->snapshot->getWarnings();
+  } else {
+    job->error=fmt::sprintf(errorFormat,job->snapshot->getLastError());
+  }
+  job->done=true;
+}
+
+bool FurnaceGUI::startBackgroundExport(const String& path, std::function<SafeWriter*(DivEngine*)> what, const char* errorFormat) {
+  // the export works on its own copy of the song, so playback and editing go on
+  DivEngine* snap=e->createSnapshot();
+  if (snap==NULL) {
+    showError(fmt::sprintf(errorFormat,e->getLastError()));
+    return false;
+  }
+
+  FurnaceGUIBackgroundExport* job=new FurnaceGUIBackgroundExport(snap,path);
+  try {
+    job->thread=new std::thread(_runBackgroundExport,job,what,String(errorFormat));
+  } catch (std::system_error& err) {
+    logW("could not start export thread! exporting in foreground. (%s)",err.what());
+    _runBackgroundExport(job,what,String(errorFormat));
+  }
+  backgroundExports.push_back(job);
+  return true;
+}
+
+void FurnaceGUI::pollBackgroundExports(bool wait) {
+  for (size_t i=0; i<backgroundExports.size(); i++) {
+    FurnaceGUIBackgroundExport* job=backgroundExports[i];
+    if (!job->done && !wait) {
+      // keep the loop going until the export finishes
+      WAKE_UP;
+      continue;
+    }
+    if (job->thread!=NULL) {
+      job->thread->join();
+      delete job->thread;
+    }
+    DivEngine::destroySnapshot(job->snapshot);
+    if (!wait) {
+      if (!job->error.empty()) {
+        showError(job->error);
+      } else {
+        pushRecentSys(job->path.c_str());
+        if (!job->warnings.empty()) {
+          showWarning(job->warnings,GUI_WARN_GENERIC);
+        }
+      }
+    }
+    delete job;
+    backgroundExports.erase(backgroundExports.begin()+i);
+    i--;
+  }
+}
@@ -41,6 +41,39 @@ const char* chanOscRefs[]={
   _N("Note Trigger")
 };
 
+// a period is kept if the correlation stays above this
+#define FURNACE_PERIOD_KEEP 0.9
+
+static float chanOscWindow[FURNACE_FFT_SIZE];
+static bool chanOscWindowReady=false;
+
+// normalized correlation of the signal against itself delayed by lag
+static double _corrAt(const float* data, int lag) {
+  double xy=0.0;
+  double xx=0.0;
+  double yy=0.0;
+  for (int j=0; j+lag<FURNACE_FFT_SIZE; j++) {
+    xy+=data[j]*data[j+lag];
+    xx+=data[j]*data[j];
+    yy+=data[j+lag]*data[j+lag];
+  }
+  if (xx<=0.0 || yy<=0.0) return 0.0;
+  return xy/sqrt(xx*yy);
+}
+
+// cheap check which tells whether the previous period still fits.
+// the period must still be a peak, and half of it must not (otherwise
+// the pitch went up an octave).
+static bool _periodStillValid(const float* data, int period) {
+  if (period<4 || period>=(FURNACE_FFT_SIZE>>1)-1) return false;
+  double here=_corrAt(data,period);
+  if (here<FURNACE_PERIOD_KEEP) return false;
+  if (_corrAt(data,period-1)>here) return false;
+  if (_corrAt(data,period+1)>here) return false;
+  if (_corrAt(data,period>>1)>=FURNACE_PERIOD_KEEP) return false;
+  return true;
+}
+
 const char* autoColsTypes[]={
   _N("Off"),
   _N("Mode 1"),
@@ -247,6 +280,7 @@ void FurnaceGUI::drawChanOsc() {
               chanOscGrad.render();
               if (rend->updateTexture(chanOscGradTex,chanOscGrad.grad.get(),chanOscGrad.width*4)) {
                 updateChanOscGradTex=false;
+                frameDamaged=true;
               } else {
                 logE(_("error while updating gradient texture!"));
               }
@@ -426,6 +460,13 @@ void FurnaceGUI::drawChanOsc() {
           }
         }
 
+        if (!chanOscWindowReady) {
+          for (int j=0; j<FURNACE_FFT_SIZE; j++) {
+            chanOscWindow[j]=0.55-0.45*cos(M_PI*(double)j/(double)(FURNACE_FFT_SIZE>>1));
+          }
+          chanOscWindowReady=true;
+        }
+
         // process
         for (size_t i=0; i<oscBufs.size(); i++) {
           ChanOscStatus* fft_=oscFFTs[i];
@@ -442,16 +483,17 @@ void FurnaceGUI::drawChanOsc() {
             // check FFT status existence
             if (!fft_->ready) {
               logD(_("creating FFT plan for channel %d"),fft_->relatedCh);
-              fft_->inBuf=(double*)fftw_malloc(FURNACE_FFT_SIZE*sizeof(double));
-              fft_->outBuf=(fftw_complex*)fftw_malloc(FURNACE_FFT_SIZE*sizeof(fftw_complex));
-              fft_->corrBuf=(double*)fftw_malloc(FURNACE_FFT_SIZE*sizeof(double));
-              fft_->plan=fftw_plan_dft_r2c_1d(FURNACE_FFT_SIZE,fft_->inBuf,fft_->outBuf,FFTW_ESTIMATE);
-              fft_->planI=fftw_plan_dft_c2r_1d(FURNACE_FFT_SIZE,fft_->outBuf,fft_->corrBuf,FFTW_ESTIMATE);
+              fft_->sampleBuf=(float*)fftwf_malloc(FURNACE_FFT_SIZE*sizeof(float));
+              fft_->inBuf=(float*)fftwf_malloc(FURNACE_FFT_SIZE*sizeof(float));
+              fft_->outBuf=(fftwf_complex*)fftwf_malloc(FURNACE_FFT_SIZE*sizeof(fftwf_complex));
+              fft_->corrBuf=(float*)fftwf_malloc(FURNACE_FFT_SIZE*sizeof(float));
+              fft_->plan=fftwf_plan_dft_r2c_1d(FURNACE_FFT_SIZE,fft_->inBuf,fft_->outBuf,FFTW_ESTIMATE);
+              fft_->planI=fftwf_plan_dft_c2r_1d(FURNACE_FFT_SIZE,fft_->outBuf,fft_->corrBuf,FFTW_ESTIMATE);
               if (fft_->plan==NULL) {
                 logE(_("failed to create plan!"));
               } else if (fft_->planI==NULL) {
                 logE(_("failed to create inverse plan!"));
-              } else if (fft_->inBuf==NULL || fft_->outBuf==NULL || fft_->corrBuf==NULL) {
+              } else if (fft_->sampleBuf==NULL || fft_->inBuf==NULL || fft_->outBuf==NULL || fft_->corrBuf==NULL) {
                 logE(_("failed to create FFT buffers"));
               } else {
                 fft_->ready=true;
@@ -479,36 +521,58 @@ void FurnaceGUI::drawChanOsc() {
                 double phase=0.0;
                 int displaySize=65536.0f*(fft->windowSize/1000.0f);
                 int displaySize2=65536.0f*(fft->windowSize/500.0f);
+                unsigned short curNeedle=buf->needle>>16;
+
+                // nothing was written since last time and the settings are the same
+                // the previous result is still good
+                if (fft->cacheValid &&
+                    fft->cacheNeedle==curNeedle &&
+                    fft->cacheDisplaySize==displaySize &&
+                    fft->cacheWaveCorr==fft->waveCorr &&
+                    fft->cachePhaseOff==fft->phaseOff) {
+                  fft->needle=fft->cacheResult;
+                  return;
+                }
+
                 fft->loudEnough=false;
-                fft->needle=buf->needle>>16;
+                fft->needle=curNeedle;
 
-                // first FFT
+                // fill buffer
                 int k=0;
                 short lastSample=0;
-                memset(fft->inBuf,0,FURNACE_FFT_SIZE*sizeof(double));
+                memset(fft->sampleBuf,0,FURNACE_FFT_SIZE*sizeof(float));
                 if (displaySize2<FURNACE_FFT_SIZE) {
                   for (int j=-FURNACE_FFT_SIZE; j<FURNACE_FFT_SIZE; j++) {
                     const short newData=buf->data[(unsigned short)(fft->needle-displaySize2+((j*displaySize2)/(FURNACE_FFT_SIZE)))];
                     if (newData!=-1) lastSample=newData;
                     if (j<0) continue;
-                    fft->inBuf[j]=(double)lastSample/32768.0;
-                    if (fft->inBuf[j]>0.001 || fft->inBuf[j]<-0.001) fft->loudEnough=true;
-                    fft->inBuf[j]*=0.55-0.45*cos(M_PI*(double)j/(double)(FURNACE_FFT_SIZE>>1));
+                    fft->sampleBuf[j]=(float)lastSample/32768.0f;
+                    if (fft->sampleBuf[j]>0.001f || fft->sampleBuf[j]<-0.001f) fft->loudEnough=true;
                   }
                 } else {
                   for (unsigned short j=fft->needle-displaySize2; j!=fft->needle; j++, k++) {
                     const int kIn=(k*FURNACE_FFT_SIZE)/displaySize2;
                     if (kIn>=FURNACE_FFT_SIZE) break;
                     if (buf->data[j]!=-1) lastSample=buf->data[j];
-                    fft->inBuf[kIn]=(double)lastSample/32768.0;
-                    if (fft->inBuf[kIn]>0.001 || fft->inBuf[kIn]<-0.001) fft->loudEnough=true;
-                    fft->inBuf[kIn]*=0.55-0.45*cos(M_PI*(double)kIn/(double)(FURNACE_FFT_SIZE>>1));
+                    fft->sampleBuf[kIn]=(float)lastSample/32768.0f;
+                    if (fft->sampleBuf[kIn]>0.001f || fft->sampleBuf[kIn]<-0.001f) fft->loudEnough=true;
                   }
                 }
 
+                for (int j=0; j<FURNACE_FFT_SIZE; j++) {
+                  fft->inBuf[j]=fft->sampleBuf[j]*chanOscWindow[j];
+                }
+
                 // only proceed if not quiet
-                if (fft->loudEnough) {
-                  fftw_execute(fft->plan);
+                if (!fft->loudEnough) {
+                  fft->lastPeriod=0;
+                } else if (fft->cacheValid && fft->cacheDisplaySize==displaySize && _periodStillValid(fft->sampleBuf,fft->lastPeriod)) {
+                  // pitch did not change - skip the FFTs
+                  fft->waveLen=fft->lastPeriod;
+                  fft->waveLenTop=fft->lastPeriod;
+                } else {
+                  // first FFT
+                  fftwf_execute(fft->plan);
 
                   // auto-correlation and second FFT
                   for (int j=0; j<FURNACE_FFT_SIZE; j++) {
@@ -521,11 +585,11 @@ void FurnaceGUI::drawChanOsc() {
                   fft->outBuf[0][1]=0;
                   fft->outBuf[1][0]=0;
                   fft->outBuf[1][1]=0;
-                  fftw_execute(fft->planI);
+                  fftwf_execute(fft->planI);
 
                   // window
                   for (int j=0; j<(FURNACE_FFT_SIZE>>1); j++) {
-                    fft->corrBuf[j]*=1.0-((double)j/(double)(FURNACE_FFT_SIZE<<1));
+                    fft->corrBuf[j]*=1.0f-((float)j/(float)(FURNACE_FFT_SIZE<<1));
                   }
 
                   // find size of period
@@ -551,7 +615,10 @@ void FurnaceGUI::drawChanOsc() {
                     }
                   }
                   fft->waveLenTop=fft->waveLen;
+                  fft->lastPeriod=(fft->waveLen<(FURNACE_FFT_SIZE-32))?(int)fft->waveLen:0;
+                }
 
+                if (fft->loudEnough) {
                   // did we find the period size?
                   if (fft->waveLen<(FURNACE_FFT_SIZE-32)) {
                     // we got pitch
@@ -585,6 +652,13 @@ void FurnaceGUI::drawChanOsc() {
                 }
 
                 fft->needle-=displaySize;
+
+                fft->cacheNeedle=curNeedle;
+                fft->cacheResult=fft->needle;
+                fft->cacheDisplaySize=displaySize;
+                fft->cacheWaveCorr=fft->waveCorr;
+                fft->cachePhaseOff=fft->phaseOff;
+                fft->cacheValid=true;
               },fft_);
             }
           }
@@ -813,6 +887,8 @@ void FurnaceGUI::drawChanOsc() {
                 fft->drawOp.color=ImGui::ColorConvertU32ToFloat4(color);
                 fft->drawOp.lineSize=dpiScale*chanOscLineSize;
 
+                damageVisualizer(fft->oscTex,precision*sizeof(float));
+                damageVisualizer(&fft->drawOp.color,sizeof(ImVec4));
                 dl->AddCallback(_drawOsc,&fft->drawOp);
                 dl->AddCallback(ImDrawCallback_ResetRenderState,NULL);
               } else {
@@ -735,6 +735,7 @@ void FurnaceGUI::drawDebug() {
           _debugDo.color=ImVec4(1.0,1.0,1.0,1.0);
           _debugDo.lineSize=dpiScale*oscDebugLineSize;
 
+          damageVisualizer(oscDebugData,oscDebugLen*sizeof(float));
           dl->AddCallback(_drawOsc,&_debugDo);
           dl->AddCallback(ImDrawCallback_ResetRenderState,NULL);
         }
@@ -1162,14 +1162,12 @@ void FurnaceGUI::doAction(int what) {
       break;
     case GUI_ACTION_SAMPLE_CUT: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
       SAMPLE_OP_BEGIN;
 
       if (end-start<1) break;
 
-      sample->prepareUndo(true);
-
       if (sampleClipboard!=NULL) {
         delete[] sampleClipboard;
       }
@@ -1177,11 +1175,12 @@ void FurnaceGUI::doAction(int what) {
       sampleClipboardLen=end-start;
       memcpy(sampleClipboard,&(sample->data16[start]),sizeof(short)*(end-start));
 
-      e->lockEngine([this,sample,start,end]() {
+      e->editSample(curSample,[this,start,end](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
         sample->strip(start,end);
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=-1;
       sampleSelEnd=-1;
@@ -1191,7 +1190,7 @@ void FurnaceGUI::doAction(int what) {
     }
     case GUI_ACTION_SAMPLE_COPY: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       SAMPLE_OP_BEGIN;
 
       if (end-start<1) break;
@@ -1207,17 +1206,18 @@ void FurnaceGUI::doAction(int what) {
     case GUI_ACTION_SAMPLE_PASTE: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
       if (sampleClipboard==NULL || sampleClipboardLen<1) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
       int pos=(sampleSelStart==-1 || sampleSelStart==sampleSelEnd)?sample->samples:sampleSelStart;
       if (pos>=(int)sample->samples) pos=sample->samples-1;
       if (pos<0) pos=0;
       logV("paste position: %d",pos);
 
-      e->lockEngine([this,sample,pos]() {
+      e->editSample(curSample,[this,pos](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
         if (!sample->insert(pos,sampleClipboardLen)) {
           showError(_("couldn't paste! make sure your sample is 8 or 16-bit."));
+          return false;
         } else {
           if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
             for (size_t i=0; i<sampleClipboardLen; i++) {
@@ -1227,7 +1227,7 @@ void FurnaceGUI::doAction(int what) {
             memcpy(&(sample->data16[pos]),sampleClipboard,sizeof(short)*sampleClipboardLen);
           }
         }
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=pos;
       sampleSelEnd=pos+sampleClipboardLen;
@@ -1238,14 +1238,14 @@ void FurnaceGUI::doAction(int what) {
     case GUI_ACTION_SAMPLE_PASTE_REPLACE: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
       if (sampleClipboard==NULL || sampleClipboardLen<1) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
       int pos=(sampleSelStart==-1 || sampleSelStart==sampleSelEnd)?0:sampleSelStart;
       if (pos>=(int)sample->samples) pos=sample->samples-1;
       if (pos<0) pos=0;
 
-      e->lockEngine([this,sample,pos]() {
+      e->editSample(curSample,[this,pos](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
         if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
           for (size_t i=0; i<sampleClipboardLen; i++) {
             if (pos+i>=sample->samples) break;
@@ -1257,7 +1257,7 @@ void FurnaceGUI::doAction(int what) {
             sample->data16[pos+i]=sampleClipboard[i];
           }
         }
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=pos;
       sampleSelEnd=pos+sampleClipboardLen;
@@ -1269,43 +1269,27 @@ void FurnaceGUI::doAction(int what) {
     case GUI_ACTION_SAMPLE_PASTE_MIX: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
       if (sampleClipboard==NULL || sampleClipboardLen<1) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
       int pos=(sampleSelStart==-1 || sampleSelStart==sampleSelEnd)?0:sampleSelStart;
       if (pos>=(int)sample->samples) pos=sample->samples-1;
       if (pos<0) pos=0;
 
-      e->lockEngine([this,sample,pos]() {
-        if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-          for (size_t i=0; i<sampleClipboardLen; i++) {
-            if (pos+i>=sample->samples) break;
-            int val=sample->data8[pos+i]+(sampleClipboard[i]>>8);
-            if (val>127) val=127;
-            if (val<-128) val=-128;
-            sample->data8[pos+i]=val;
-          }
-        } else {
-          for (size_t i=0; i<sampleClipboardLen; i++) {
-            if (pos+i>=sample->samples) break;
-            int val=sample->data16[pos+i]+sampleClipboard[i];
-            if (val>32767) val=32767;
-            if (val<-32768) val=-32768;
-            sample->data16[pos+i]=val;
-          }
-        }
-        e->renderSamples(curSample);
-      });
+      // the clipboard may change while the job runs
+      std::vector<short> clip(sampleClipboard,sampleClipboard+sampleClipboardLen);
+      if (!e->editSampleAsync(curSample,_("Mixing"),[pos,clip](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
+        return sample->mixIn(pos,clip.data(),clip.size());
+      })) break;
       sampleSelStart=pos;
       sampleSelEnd=pos+sampleClipboardLen;
       if (sampleSelEnd>(int)sample->samples) sampleSelEnd=sample->samples;
-      updateSampleTex=true;
       MARK_MODIFIED;
       break;
     }
     case GUI_ACTION_SAMPLE_SELECT_ALL: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       sampleDragActive=false;
       sampleSelStart=0;
       sampleSelEnd=sample->samples;
@@ -1325,111 +1309,41 @@ void FurnaceGUI::doAction(int what) {
       break;
     case GUI_ACTION_SAMPLE_NORMALIZE: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
-        SAMPLE_OP_BEGIN;
-        float maxVal=0.0f;
-
-        if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
-          for (unsigned int i=start; i<end; i++) {
-            float val=fabs((float)sample->data16[i]/32767.0f);
-            if (val>maxVal) maxVal=val;
-          }
-          if (maxVal>1.0f) maxVal=1.0f;
-          if (maxVal>0.0f) {
-            float vol=1.0f/maxVal;
-            for (unsigned int i=start; i<end; i++) {
-              float val=sample->data16[i]*vol;
-              if (val<-32768) val=-32768;
-              if (val>32767) val=32767;
-              sample->data16[i]=val;
-            }
-          }
-        } else if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-          for (unsigned int i=start; i<end; i++) {
-            float val=fabs((float)sample->data8[i]/127.0f);
-            if (val>maxVal) maxVal=val;
-          }
-          if (maxVal>1.0f) maxVal=1.0f;
-          if (maxVal>0.0f) {
-            float vol=1.0f/maxVal;
-            for (unsigned int i=start; i<end; i++) {
-              float val=sample->data8[i]*vol;
-              if (val<-128) val=-128;
-              if (val>127) val=127;
-              sample->data8[i]=val;
-            }
-          }
+      SAMPLE_OP_BEGIN;
+      if (!e->editSampleAsync(curSample,_("Normalizing"),[start,end](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
+        float maxVal=sample->getPeak(start,end);
+        if (maxVal>0.0f) {
+          sample->applyGain(start,end,1.0f/maxVal,1.0f/maxVal);
         }
-
-        updateSampleTex=true;
-
-        e->renderSamples(curSample);
-      });
+        return true;
+      })) break;
       MARK_MODIFIED;
       break;
     }
     case GUI_ACTION_SAMPLE_FADE_IN: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
-        SAMPLE_OP_BEGIN;
-
-        if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
-          for (unsigned int i=start; i<end; i++) {
-            float val=sample->data16[i]*float(i-start)/float(end-start);
-            if (val<-32768) val=-32768;
-            if (val>32767) val=32767;
-            sample->data16[i]=val;
-          }
-        } else if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-          for (unsigned int i=start; i<end; i++) {
-            float val=sample->data8[i]*float(i-start)/float(end-start);
-            if (val<-128) val=-128;
-            if (val>127) val=127;
-            sample->data8[i]=val;
-          }
-        }
-
-        updateSampleTex=true;
-
-        e->renderSamples(curSample);
-      });
+      SAMPLE_OP_BEGIN;
+      if (!e->editSampleAsync(curSample,_("Fading in"),[start,end](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
+        return sample->applyGain(start,end,0.0f,1.0f);
+      })) break;
       MARK_MODIFIED;
       break;
     }
     case GUI_ACTION_SAMPLE_FADE_OUT: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
-        SAMPLE_OP_BEGIN;
-
-        if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
-          for (unsigned int i=start; i<end; i++) {
-            float val=sample->data16[i]*float(end-i)/float(end-start);
-            if (val<-32768) val=-32768;
-            if (val>32767) val=32767;
-            sample->data16[i]=val;
-          }
-        } else if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-          for (unsigned int i=start; i<end; i++) {
-            float val=sample->data8[i]*float(end-i)/float(end-start);
-            if (val<-128) val=-128;
-            if (val>127) val=127;
-            sample->data8[i]=val;
-          }
-        }
-
-        updateSampleTex=true;
-
-        e->renderSamples(curSample);
-      });
+      SAMPLE_OP_BEGIN;
+      if (!e->editSampleAsync(curSample,_("Fading out"),[start,end](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
+        return sample->applyGain(start,end,1.0f,0.0f);
+      })) break;
       MARK_MODIFIED;
       break;
     }
@@ -1439,10 +1353,10 @@ void FurnaceGUI::doAction(int what) {
       break;
     case GUI_ACTION_SAMPLE_SILENCE: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
         SAMPLE_OP_BEGIN;
 
         if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -1457,23 +1371,23 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
     }
     case GUI_ACTION_SAMPLE_DELETE: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
         SAMPLE_OP_BEGIN;
 
         sample->strip(start,end);
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=-1;
       sampleSelEnd=-1;
@@ -1482,16 +1396,16 @@ void FurnaceGUI::doAction(int what) {
     }
     case GUI_ACTION_SAMPLE_TRIM: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
         SAMPLE_OP_BEGIN;
 
         sample->trim(start,end);
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=-1;
       sampleSelEnd=-1;
@@ -1500,10 +1414,10 @@ void FurnaceGUI::doAction(int what) {
     }
     case GUI_ACTION_SAMPLE_REVERSE: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
         SAMPLE_OP_BEGIN;
 
         if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -1526,17 +1440,17 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
     }
     case GUI_ACTION_SAMPLE_INVERT: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
         SAMPLE_OP_BEGIN;
 
         if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -1553,17 +1467,17 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
     }
     case GUI_ACTION_SAMPLE_SIGN: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
-      sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
         SAMPLE_OP_BEGIN;
 
         if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -1578,7 +1492,7 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
@@ -1683,7 +1597,7 @@ void FurnaceGUI::doAction(int what) {
         insType=makeInsTypeList[0];
       }
 
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       curIns=e->addInstrument(cursor.xCoarse);
       if (curIns==-1) {
         showError(_("too many instruments!"));
@@ -1701,9 +1615,9 @@ void FurnaceGUI::doAction(int what) {
     }
     case GUI_ACTION_SAMPLE_SET_LOOP: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
-      sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      DivSample* sample=e->getLatestSample(curSample);
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
+        sample->prepareUndo(true);
         SAMPLE_OP_BEGIN;
 
         sample->loopStart=start;
@@ -1711,14 +1625,14 @@ void FurnaceGUI::doAction(int what) {
         sample->loop=true;
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
     }
     case GUI_ACTION_SAMPLE_CREATE_WAVE: {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
-      DivSample* sample=e->song.sample[curSample];
+      DivSample* sample=e->getLatestSample(curSample);
       SAMPLE_OP_BEGIN;
       if (end-start<1) {
         showError(_("select at least one sample!"));
@@ -253,6 +253,9 @@ void FurnaceGUI::makeUndo(ActionType action, UndoRegion region) {
   }
   if (doPush) {
     MARK_MODIFIED;
+    for (UndoPatternData& i: s.pat) {
+      e->notifyPatternChange(i.subSong,i.chan,i.pat);
+    }
     undoHist.push_back(s);
     redoHist.clear();
     if (undoHist.size()>settings.maxUndoSteps) undoHist.pop_front();
@@ -1875,6 +1878,9 @@ void FurnaceGUI::doCollapseSong(int divider) {
   }
 
   if (!us.pat.empty()) {
+    for (UndoPatternData& i: us.pat) {
+      e->notifyPatternChange(i.subSong,i.chan,i.pat);
+    }
     undoHist.push_back(us);
     redoHist.clear();
     if (undoHist.size()>settings.maxUndoSteps) undoHist.pop_front();
@@ -1958,6 +1964,9 @@ void FurnaceGUI::doExpandSong(int multiplier) {
   }
 
   if (!us.pat.empty()) {
+    for (UndoPatternData& i: us.pat) {
+      e->notifyPatternChange(i.subSong,i.chan,i.pat);
+    }
     undoHist.push_back(us);
     redoHist.clear();
     if (undoHist.size()>settings.maxUndoSteps) undoHist.pop_front();
@@ -2199,6 +2208,7 @@ void FurnaceGUI::doUndo() {
         e->changeSongP(i.subSong);
         DivPattern* p=e->curPat[i.chan].getPattern(i.pat,true);
         p->data[i.row][i.col]=i.oldVal;
+        e->notifyPatternChange(i.subSong,i.chan,i.pat);
       }
       if (us.type!=GUI_UNDO_REPLACE) {
         if (!e->isPlaying() || !followPattern) {
@@ -2277,6 +2287,7 @@ void FurnaceGUI::doRedo() {
         e->changeSongP(i.subSong);
         DivPattern* p=e->curPat[i.chan].getPattern(i.pat,true);
         p->data[i.row][i.col]=i.newVal;
+        e->notifyPatternChange(i.subSong,i.chan,i.pat);
       }
       if (us.type!=GUI_UNDO_REPLACE) {
         if (!e->isPlaying() || !followPattern) {
@@ -40,17 +40,37 @@ void FurnaceGUI::drawExportAudio(bool onWindow) {
   }
   ImGui::Unindent();
 
+  ImGui::Text(_("Format:"));
+  ImGui::Indent();
   if (audioExportOptions.mode!=DIV_EXPORT_MODE_MANY_SYS) {
-    ImGui::Text(_("Bit depth:"));
-    ImGui::Indent();
-    if (ImGui::RadioButton(_("16-bit integer"),audioExportOptions.format==DIV_EXPORT_FORMAT_S16)) {
+    if (ImGui::RadioButton(_("WAV (16-bit integer)"),audioExportOptions.format==DIV_EXPORT_FORMAT_S16)) {
       audioExportOptions.format=DIV_EXPORT_FORMAT_S16;
     }
-    if (ImGui::RadioButton(_("32-bit float"),audioExportOptions.format==DIV_EXPORT_FORMAT_F32)) {
+    if (ImGui::RadioButton(_("WAV (32-bit float)"),audioExportOptions.format==DIV_EXPORT_FORMAT_F32)) {
       audioExportOptions.format=DIV_EXPORT_FORMAT_F32;
     }
-    ImGui::Unindent();
+  } else {
+    if (ImGui::RadioButton(_("WAV (16-bit integer)"),audioExportOptions.format==DIV_EXPORT_FORMAT_S16 || audioExportOptions.format==DIV_EXPORT_FORMAT_F32)) {
+      audioExportOptions.format=DIV_EXPORT_FORMAT_S16;
+    }
+  }
+  ImGui::BeginDisabled(!DivEngine::isAudioExportFormatAvailable(DIV_EXPORT_FORMAT_FLAC));
+  if (ImGui::RadioButton(_("FLAC"),audioExportOptions.format==DIV_EXPORT_FORMAT_FLAC)) {
+    audioExportOptions.format=DIV_EXPORT_FORMAT_FLAC;
+  }
+  ImGui::EndDisabled();
+  ImGui::BeginDisabled(!DivEngine::isAudioExportFormatAvailable(DIV_EXPORT_FORMAT_OPUS));
+  if (ImGui::RadioButton(_("Ogg Opus"),audioExportOptions.format==DIV_EXPORT_FORMAT_OPUS)) {
+    audioExportOptions.format=DIV_EXPORT_FORMAT_OPUS;
+    audioExportOptions.sampleRate=48000;
   }
+  ImGui::EndDisabled();
+  if (!DivEngine::isAudioExportFormatAvailable(DIV_EXPORT_FORMAT_FLAC)) {
+    ImGui::TextDisabled(_("FLAC/Opus are not available in this build."));
+  } else if (audioExportOptions.format==DIV_EXPORT_FORMAT_OPUS && !DivEngine::isAudioExportFormatAvailable(DIV_EXPORT_FORMAT_OPUS,audioExportOptions.sampleRate)) {
+    ImGui::TextColored(uiColors[GUI_COLOR_WARNING],_("Opus only supports 8000, 12000, 16000, 24000 and 48000Hz."));
+  }
+  ImGui::Unindent();
 
   if (ImGui::InputInt(_("Sample rate"),&audioExportOptions.sampleRate,100,10000)) {
     if (audioExportOptions.sampleRate<8000) audioExportOptions.sampleRate=8000;
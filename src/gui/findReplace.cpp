@@ -24,6 +24,7 @@
 #include "guiConst.h"
 #include "intConst.h"
 #include "../ta-log.h"
+#include <algorithm>
 
 const char* queryModes[GUI_QUERY_MAX]={
   _N("ignore"),
@@ -90,6 +91,48 @@ bool checkCondition(int mode, int arg, int argMax, int val, bool noteMode=false)
   return false;
 }
 
+// add the rows which may match a query to ret.
+// returns false if the query may match empty cells (in which case the index cannot help).
+static bool addQueryCandidates(DivSongIndex& index, const FurnaceGUIFindQuery& q, int subsong, std::vector<DivSongIndexLoc>& ret) {
+  if (q.noteMode==GUI_QUERY_MATCH || q.noteMode==GUI_QUERY_RANGE) {
+    int noteMax=(q.noteMode==GUI_QUERY_MATCH)?q.note:q.noteMax;
+    for (int i=q.note; i<=noteMax; i++) {
+      if (i>=120 && i<128) continue;
+      // -61 is the empty note
+      if (i<-60 || i>130) return false;
+    }
+    for (int i=q.note; i<=noteMax; i++) {
+      if (i>=120 && i<128) continue;
+      index.find(DIV_INDEX_NOTE,(i>=128)?(i+52):(i+60),subsong,ret);
+    }
+    return true;
+  }
+  if (q.insMode==GUI_QUERY_MATCH || q.insMode==GUI_QUERY_RANGE) {
+    int insMax=(q.insMode==GUI_QUERY_MATCH)?q.ins:q.insMax;
+    for (int i=q.ins; i<=insMax; i++) {
+      index.find(DIV_INDEX_INS,i,subsong,ret);
+    }
+    return true;
+  }
+  if (q.volMode==GUI_QUERY_MATCH || q.volMode==GUI_QUERY_RANGE) {
+    int volMax=(q.volMode==GUI_QUERY_MATCH)?q.vol:q.volMax;
+    for (int i=q.vol; i<=volMax; i++) {
+      index.find(DIV_INDEX_VOL,i,subsong,ret);
+    }
+    return true;
+  }
+  for (int m=0; m<q.effectCount && m<8; m++) {
+    if (q.effectMode[m]==GUI_QUERY_MATCH || q.effectMode[m]==GUI_QUERY_RANGE) {
+      int effectMax=(q.effectMode[m]==GUI_QUERY_MATCH)?q.effect[m]:q.effectMax[m];
+      for (int i=q.effect[m]; i<=effectMax; i++) {
+        index.find(DIV_INDEX_EFFECT,i,subsong,ret);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
 void FurnaceGUI::doFind() {
   int firstOrder=0;
   int lastOrder=e->curSubSong->ordersLen-1;
@@ -128,96 +171,143 @@ void FurnaceGUI::doFind() {
 
   signed char effectPos[8];
 
-  for (int i=firstOrder; i<=lastOrder; i++) {
-    for (int j=firstRow; j<=lastRow; j++) {
-      for (int k=firstChan; k<=lastChan; k++) {
-        DivPattern* p=e->curPat[k].getPattern(e->curOrders->ord[k][i],false);
-        bool matched=false;
-        memset(effectPos,-1,8);
-        for (FurnaceGUIFindQuery& l: curQuery) {
-          if (matched) break;
-
-          if (!checkCondition(l.noteMode,l.note,l.noteMax,queryNote(p->data[j][0],p->data[j][1]),true)) continue;
-          if (!checkCondition(l.insMode,l.ins,l.insMax,p->data[j][2])) continue;
-          if (!checkCondition(l.volMode,l.vol,l.volMax,p->data[j][3])) continue;
-
-          if (l.effectCount>0) {
-            bool notMatched=false;
-            switch (curQueryEffectPos) {
-              case 0: // no
-                for (int m=0; m<l.effectCount; m++) {
-                  bool allGood=false;
-                  for (int n=0; n<e->curPat[k].effectCols; n++) {
-                    if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->data[j][4+n*2])) continue;
-                    if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->data[j][5+n*2])) continue;
-                    allGood=true;
-                    effectPos[m]=n;
-                    break;
-                  }
-                  if (!allGood) {
-                    notMatched=true;
-                    break;
-                  }
-                }
+  // check whether a row matches any query
+  auto matchRow=[this,&effectPos](DivPattern* p, int j, int effectCols) -> bool {
+    bool matched=false;
+    memset(effectPos,-1,8);
+    for (FurnaceGUIFindQuery& l: curQuery) {
+      if (matched) break;
+
+      if (!checkCondition(l.noteMode,l.note,l.noteMax,queryNote(p->data[j][0],p->data[j][1]),true)) continue;
+      if (!checkCondition(l.insMode,l.ins,l.insMax,p->data[j][2])) continue;
+      if (!checkCondition(l.volMode,l.vol,l.volMax,p->data[j][3])) continue;
+
+      if (l.effectCount>0) {
+        bool notMatched=false;
+        switch (curQueryEffectPos) {
+          case 0: // no
+            for (int m=0; m<l.effectCount; m++) {
+              bool allGood=false;
+              for (int n=0; n<effectCols; n++) {
+                if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->data[j][4+n*2])) continue;
+                if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->data[j][5+n*2])) continue;
+                allGood=true;
+                effectPos[m]=n;
                 break;
-              case 1: { // lax
-                // locate first effect
-                int posOfFirst=-1;
-                for (int m=0; m<e->curPat[k].effectCols; m++) {
-                  if (!checkCondition(l.effectMode[0],l.effect[0],l.effectMax[0],p->data[j][4+m*2])) continue;
-                  if (!checkCondition(l.effectValMode[0],l.effectVal[0],l.effectValMax[0],p->data[j][5+m*2])) continue;
-                  posOfFirst=m;
-                  break;
-                }
-                if (posOfFirst<0) {
+              }
+              if (!allGood) {
+                notMatched=true;
+                break;
+              }
+            }
+            break;
+          case 1: { // lax
+            // locate first effect
+            int posOfFirst=-1;
+            for (int m=0; m<effectCols; m++) {
+              if (!checkCondition(l.effectMode[0],l.effect[0],l.effectMax[0],p->data[j][4+m*2])) continue;
+              if (!checkCondition(l.effectValMode[0],l.effectVal[0],l.effectValMax[0],p->data[j][5+m*2])) continue;
+              posOfFirst=m;
+              break;
+            }
+            if (posOfFirst<0) {
+              notMatched=true;
+              break;
+            }
+            // make sure we aren't too far to the right
+            if ((posOfFirst+l.effectCount)>effectCols) {
+              notMatched=true;
+              break;
+            }
+            // search from first effect location
+            for (int m=0; m<l.effectCount; m++) {
+              if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->data[j][4+(m+posOfFirst)*2])) {
+                notMatched=true;
+                break;
+              }
+              if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->data[j][5+(m+posOfFirst)*2])) {
+                notMatched=true;
+                break;
+              }
+              effectPos[m]=m+posOfFirst;
+            }
+            break;
+          }
+          case 2: // strict
+            int effectMax=l.effectCount;
+            if (effectMax>effectCols) {
+              notMatched=true;
+            } else {
+              for (int m=0; m<effectMax; m++) {
+                if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->data[j][4+m*2])) {
                   notMatched=true;
                   break;
                 }
-                // make sure we aren't too far to the right
-                if ((posOfFirst+l.effectCount)>e->curPat[k].effectCols) {
+                if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->data[j][5+m*2])) {
                   notMatched=true;
                   break;
                 }
-                // search from first effect location
-                for (int m=0; m<l.effectCount; m++) {
-                  if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->data[j][4+(m+posOfFirst)*2])) {
-                    notMatched=true;
-                    break;
-                  }
-                  if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->data[j][5+(m+posOfFirst)*2])) {
-                    notMatched=true;
-                    break;
-                  }
-                  effectPos[m]=m+posOfFirst;
-                }
-                break;
+                effectPos[m]=m;
               }
-              case 2: // strict
-                int effectMax=l.effectCount;
-                if (effectMax>e->curPat[k].effectCols) {
-                  notMatched=true;
-                } else {
-                  for (int m=0; m<effectMax; m++) {
-                    if (!checkCondition(l.effectMode[m],l.effect[m],l.effectMax[m],p->data[j][4+m*2])) {
-                      notMatched=true;
-                      break;
-                    }
-                    if (!checkCondition(l.effectValMode[m],l.effectVal[m],l.effectValMax[m],p->data[j][5+m*2])) {
-                      notMatched=true;
-                      break;
-                    }
-                    effectPos[m]=m;
-                  }
-                }
-                break;
             }
-            if (notMatched) continue;
-          }
+            break;
+        }
+        if (notMatched) continue;
+      }
+
+      matched=true;
+    }
+    return matched;
+  };
+
+  // if every query has a condition which rules out empty cells, only visit the rows the song index lists
+  std::vector<DivSongIndexLoc> candidates;
+  bool useIndex=!curQuery.empty();
+  DivSongIndex& index=e->getSongIndex();
+  for (FurnaceGUIFindQuery& l: curQuery) {
+    if (!addQueryCandidates(index,l,e->getCurrentSubSong(),candidates)) {
+      useIndex=false;
+      break;
+    }
+  }
+
+  if (useIndex) {
+    // channel/pattern -> candidate rows
+    std::unordered_map<int,std::vector<int>> candRows;
+    for (DivSongIndexLoc& i: candidates) {
+      candRows[(i.chan<<8)|i.pat].push_back(i.row);
+    }
+    for (auto& i: candRows) {
+      std::sort(i.second.begin(),i.second.end());
+      i.second.erase(std::unique(i.second.begin(),i.second.end()),i.second.end());
+    }
 
-          matched=true;
+    for (int i=firstOrder; i<=lastOrder; i++) {
+      for (int k=firstChan; k<=lastChan; k++) {
+        auto rows=candRows.find((k<<8)|e->curOrders->ord[k][i]);
+        if (rows==candRows.end()) continue;
+        DivPattern* p=e->curPat[k].getPattern(e->curOrders->ord[k][i],false);
+        for (int j: rows->second) {
+          if (j<firstRow || j>lastRow) continue;
+          if (matchRow(p,j,e->curPat[k].effectCols)) {
+            curQueryResults.push_back(FurnaceGUIQueryResult(e->getCurrentSubSong(),i,k,j,effectPos));
+          }
         }
-        if (matched) {
-          curQueryResults.push_back(FurnaceGUIQueryResult(e->getCurrentSubSong(),i,k,j,effectPos));
+      }
+    }
+    // same order as a full scan (order, row, channel)
+    std::stable_sort(curQueryResults.begin(),curQueryResults.end(),[](const FurnaceGUIQueryResult& a, const FurnaceGUIQueryResult& b) {
+      if (a.order!=b.order) return a.order<b.order;
+      return a.y<b.y;
+    });
+  } else {
+    for (int i=firstOrder; i<=lastOrder; i++) {
+      for (int j=firstRow; j<=lastRow; j++) {
+        for (int k=firstChan; k<=lastChan; k++) {
+          DivPattern* p=e->curPat[k].getPattern(e->curOrders->ord[k][i],false);
+          if (matchRow(p,j,e->curPat[k].effectCols)) {
+            curQueryResults.push_back(FurnaceGUIQueryResult(e->getCurrentSubSong(),i,k,j,effectPos));
+          }
         }
       }
     }
@@ -499,6 +589,9 @@ void FurnaceGUI::doReplace() {
   }
 
   if (!us.pat.empty()) {
+    for (UndoPatternData& i: us.pat) {
+      e->notifyPatternChange(i.subSong,i.chan,i.pat);
+    }
     undoHist.push_back(us);
     redoHist.clear();
     if (undoHist.size()>settings.maxUndoSteps) undoHist.pop_front();
@@ -0,0 +1,136 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "gui.h"
+#include "imgui_internal.h"
+
+// windows whose changes alone are subject to the visualizer redraw rate limit
+static const char* visualizerWindows[]={
+  "Oscilloscope",
+  "Oscilloscope (per-channel)",
+  "Oscilloscope (X-Y)",
+  "Volume Meter",
+  NULL
+};
+
+// not a cryptographic hash. it only has to be fast and spread bits well enough.
+static uint64_t hashBlock(uint64_t hash, const void* data, size_t len) {
+  const unsigned char* bytes=(const unsigned char*)data;
+  uint64_t word;
+  for (; len>=8; len-=8, bytes+=8) {
+    memcpy(&word,bytes,8);
+    hash=(hash^word)*0x100000001b3ULL;
+    hash^=hash>>29;
+  }
+  for (; len>0; len--, bytes++) {
+    hash=(hash^(*bytes))*0x100000001b3ULL;
+  }
+  return hash;
+}
+
+void FurnaceGUI::damageVisualizer(const void* data, size_t len) {
+  frameHashExtra=hashBlock(frameHashExtra,data,len);
+}
+
+bool FurnaceGUI::checkFrameDamage(ImDrawData* drawData) {
+  uint64_t mainHash=0xcbf29ce484222325ULL;
+  uint64_t visHash=frameHashExtra;
+  frameHashExtra=0xcbf29ce484222325ULL;
+
+  if (drawData==NULL) return true;
+
+  // pending texture changes must reach the backend
+  if (drawData->Textures!=NULL) {
+    for (ImTextureData* i: *drawData->Textures) {
+      if (i->Status!=ImTextureStatus_OK) frameDamaged=true;
+    }
+  }
+
+  // find the draw lists of visualizer windows
+  visualizerDrawLists.clear();
+  if (settings.visualizerFrameRate>0) {
+    ImGuiContext& g=*GImGui;
+    for (int i=0; visualizerWindows[i]; i++) {
+      ImGuiWindow* root=ImGui::FindWindowByName(visualizerWindows[i]);
+      if (root==NULL) continue;
+      if (!root->Active) continue;
+      for (ImGuiWindow* w: g.Windows) {
+        if (w->RootWindow==root) visualizerDrawLists.push_back(w->DrawList);
+      }
+    }
+  }
+
+  ImVec4 clearColor=uiColors[GUI_COLOR_BACKGROUND];
+  mainHash=hashBlock(mainHash,&clearColor,sizeof(ImVec4));
+  mainHash=hashBlock(mainHash,&drawData->DisplayPos,sizeof(ImVec2));
+  mainHash=hashBlock(mainHash,&drawData->DisplaySize,sizeof(ImVec2));
+  mainHash=hashBlock(mainHash,&drawData->FramebufferScale,sizeof(ImVec2));
+
+  for (ImDrawList* dl: drawData->CmdLists) {
+    bool isVisualizer=false;
+    for (ImDrawList* j: visualizerDrawLists) {
+      if (j==dl) {
+        isVisualizer=true;
+        break;
+      }
+    }
+
+    uint64_t hash=isVisualizer?visHash:mainHash;
+    hash=hashBlock(hash,dl->VtxBuffer.Data,dl->VtxBuffer.Size*sizeof(ImDrawVert));
+    hash=hashBlock(hash,dl->IdxBuffer.Data,dl->IdxBuffer.Size*sizeof(ImDrawIdx));
+    for (const ImDrawCmd& cmd: dl->CmdBuffer) {
+      // not GetTexID(): pending textures are only uploaded in renderGUI()
+      hash=hashBlock(hash,&cmd.ClipRect,sizeof(ImVec4));
+      hash=hashBlock(hash,&cmd.TexRef._TexData,sizeof(ImTextureData*));
+      hash=hashBlock(hash,&cmd.TexRef._TexID,sizeof(ImTextureID));
+      hash=hashBlock(hash,&cmd.VtxOffset,sizeof(unsigned int));
+      hash=hashBlock(hash,&cmd.IdxOffset,sizeof(unsigned int));
+      hash=hashBlock(hash,&cmd.ElemCount,sizeof(unsigned int));
+      hash=hashBlock(hash,&cmd.UserCallback,sizeof(ImDrawCallback));
+      hash=hashBlock(hash,&cmd.UserCallbackData,sizeof(void*));
+    }
+    if (isVisualizer) {
+      visHash=hash;
+    } else {
+      mainHash=hash;
+    }
+  }
+
+  bool mainChanged=(mainHash!=frameHashMain);
+  bool visChanged=(visHash!=frameHashVis);
+  bool render=frameDamaged || mainChanged;
+
+  // visualizers may only cause a redraw so often
+  uint64_t now=SDL_GetPerformanceCounter();
+  if (visChanged) {
+    if (settings.visualizerFrameRate<=0 || render) {
+      render=true;
+    } else if ((now-visualizerLastRedraw)>=(SDL_GetPerformanceFrequency()/settings.visualizerFrameRate)) {
+      render=true;
+    }
+  }
+
+  if (render) {
+    frameHashMain=mainHash;
+    frameHashVis=visHash;
+    if (visChanged) visualizerLastRedraw=now;
+    frameDamaged=false;
+  }
+  return render;
+}
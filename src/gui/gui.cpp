@@ -27,6 +27,7 @@
 #include "util.h"
 #include "../ta-log.h"
 #include "../fileutils.h"
+#include "../startupProfile.h"
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "ImGuiFileDialog.h"
@@ -757,6 +758,8 @@ void FurnaceGUI::autoDetectSystem() {
     logV("%s: %d",e->getSystemName(k.first),k.second);
   }
 
+  ensureSystemPresets();
+
   bool isMatch=false;
   std::map<DivSystem,int> defCountMap;
   std::map<DivSystem,DivConfig> defConfMap;
@@ -1187,6 +1190,7 @@ void FurnaceGUI::play(int row) {
   memset(chanOscVol,0,DIV_MAX_CHANS*sizeof(float));
   for (int i=0; i<DIV_MAX_CHANS; i++) {
     chanOscChan[i].pitch=0.0f;
+    chanOscChan[i].cacheValid=false;
   }
   memset(chanOscBright,0,DIV_MAX_CHANS*sizeof(float));
   e->walkSong(loopOrder,loopRow,loopEnd);
@@ -2014,7 +2018,7 @@ void FurnaceGUI::openFileDialog(FurnaceGUIFileDialogs type) {
       if (!dirExists(workingDirAudioExport)) workingDirAudioExport=getHomeDir();
       hasOpened=fileDialog->openSave(
         _("Export Audio"),
-        {_("Wave file"), "*.wav"},
+        audioExportFilter(),
         workingDirAudioExport,
         dpiScale,
         (settings.autoFillSave)?shortName:""
@@ -2024,7 +2028,7 @@ void FurnaceGUI::openFileDialog(FurnaceGUIFileDialogs type) {
       if (!dirExists(workingDirAudioExport)) workingDirAudioExport=getHomeDir();
       hasOpened=fileDialog->openSave(
         _("Export Audio"),
-        {_("Wave file"), "*.wav"},
+        audioExportFilter(),
         workingDirAudioExport,
         dpiScale,
         (settings.autoFillSave)?shortName:""
@@ -2034,7 +2038,7 @@ void FurnaceGUI::openFileDialog(FurnaceGUIFileDialogs type) {
       if (!dirExists(workingDirAudioExport)) workingDirAudioExport=getHomeDir();
       hasOpened=fileDialog->openSave(
         _("Export Audio"),
-        {_("Wave file"), "*.wav"},
+        audioExportFilter(),
         workingDirAudioExport,
         dpiScale,
         (settings.autoFillSave)?shortName:""
@@ -2639,7 +2643,10 @@ void FurnaceGUI::exportAudio(String path, DivAudioExportModes mode) {
   }
   songLoopedSectionLength-=loopRow;
 
-  e->saveAudio(path.c_str(),audioExportOptions);
+  if (!e->saveAudio(path.c_str(),audioExportOptions)) {
+    showError(fmt::sprintf(_("could not export audio! (%s)"),e->getLastError()));
+    return;
+  }
 
   totalFiles=0;
   e->getTotalAudioFiles(totalFiles);
@@ -2661,6 +2668,18 @@ void FurnaceGUI::exportAudio(String path, DivAudioExportModes mode) {
   displayExporting=true;
 }
 
+std::vector<String> FurnaceGUI::audioExportFilter() {
+  switch (audioExportOptions.format) {
+    case DIV_EXPORT_FORMAT_FLAC:
+      return {_("FLAC file"), "*.flac"};
+    case DIV_EXPORT_FORMAT_OPUS:
+      return {_("Opus file"), "*.opus"};
+    default:
+      break;
+  }
+  return {_("Wave file"), "*.wav"};
+}
+
 void FurnaceGUI::exportCmdStream(bool target, String path) {
   csExportPath=path;
   csExportTarget=target;
@@ -3832,6 +3851,7 @@ bool FurnaceGUI::loop() {
               logV("portrait: %d (%dx%d)",portrait,scrW,scrH);
               logD("window resized to %dx%d",scrW,scrH);
               updateWindow=true;
+              frameDamaged=true;
               rend->resized(ev);
               break;
             case SDL_WINDOWEVENT_MOVED:
@@ -3855,6 +3875,7 @@ bool FurnaceGUI::loop() {
             case SDL_WINDOWEVENT_RESTORED:
               scrMax=false;
               updateWindow=true;
+              frameDamaged=true;
               logV("window restored");
               break;
             case SDL_WINDOWEVENT_SHOWN:
@@ -3865,6 +3886,8 @@ bool FurnaceGUI::loop() {
               break;
             case SDL_WINDOWEVENT_EXPOSED:
               logV("window exposed");
+              rend->invalidate();
+              frameDamaged=true;
               break;
           }
           break;
@@ -4220,9 +4243,11 @@ bool FurnaceGUI::loop() {
 #ifndef NO_INTRO
     if (firstFrame && !safeMode && renderBackend!=GUI_BACKEND_SOFTWARE) {
       if (!tutorial.introPlayed || settings.alwaysPlayIntro==3 || (settings.alwaysPlayIntro==2 && curFileName.empty())) {
+        startupProfileBegin("intro tune");
         unsigned char* introTemp=new unsigned char[intro_fur_len];
         memcpy(introTemp,intro_fur,intro_fur_len);
         e->load(introTemp,intro_fur_len);
+        startupProfileEnd();
       }
     }
 #endif
@@ -4232,6 +4257,7 @@ bool FurnaceGUI::loop() {
       memset(chanOscVol,0,DIV_MAX_CHANS*sizeof(float));
       for (int i=0; i<DIV_MAX_CHANS; i++) {
         chanOscChan[i].pitch=0.0f;
+        chanOscChan[i].cacheValid=false;
       }
       memset(chanOscBright,0,DIV_MAX_CHANS*sizeof(float));
 
@@ -4250,6 +4276,7 @@ bool FurnaceGUI::loop() {
     // recover from dead graphics
     if (rend->isDead() || killGraphics) {
       killGraphics=false;
+      frameDamaged=true;
 
       logW("graphics are dead! restarting...");
       
@@ -4387,6 +4414,19 @@ bool FurnaceGUI::loop() {
     curWindow=GUI_WINDOW_NOTHING;
     editOptsVisible=false;
 
+    // carry out core swaps requested by the load governor
+    e->updateLoadGovernor();
+
+    // free sample versions replaced by copy-on-write edits
+    if (e->collectAssets()) {
+      updateSampleTex=true;
+    }
+
+    // publish background sample edits which finished
+    if (e->pollSampleJob()) {
+      updateSampleTex=true;
+    }
+
     int nextPlayOrder=0;
     int nextOldRow=0;
     e->getPlayPos(nextPlayOrder,nextOldRow);
@@ -5170,11 +5210,13 @@ bool FurnaceGUI::loop() {
           if (curFileDialog==GUI_FILE_SAVE_DMF_LEGACY) {
             checkExtension(".dmf");
           }
-          if (curFileDialog==GUI_FILE_SAMPLE_SAVE ||
-              curFileDialog==GUI_FILE_EXPORT_AUDIO_ONE ||
+          if (curFileDialog==GUI_FILE_SAMPLE_SAVE) {
+            checkExtension(".wav");
+          }
+          if (curFileDialog==GUI_FILE_EXPORT_AUDIO_ONE ||
               curFileDialog==GUI_FILE_EXPORT_AUDIO_PER_SYS ||
               curFileDialog==GUI_FILE_EXPORT_AUDIO_PER_CHANNEL) {
-            checkExtension(".wav");
+            checkExtension(DivEngine::getAudioExportExt(audioExportOptions.format));
           }
           if (curFileDialog==GUI_FILE_INS_SAVE) {
             checkExtension(".fui");
@@ -5476,7 +5518,7 @@ bool FurnaceGUI::loop() {
               break;
             case GUI_FILE_SAMPLE_SAVE:
               if (curSample>=0 && curSample<(int)e->song.sample.size()) {
-                if (!e->song.sample[curSample]->save(copyOfName.c_str())) {
+                if (!e->getLatestSample(curSample)->save(copyOfName.c_str())) {
                   showError(_("could not save sample! open Log Viewer for more information."));
                 } else {
                   pushRecentSys(copyOfName.c_str());
@@ -5485,7 +5527,7 @@ bool FurnaceGUI::loop() {
               break;
             case GUI_FILE_SAMPLE_SAVE_RAW:
               if (curSample>=0 && curSample<(int)e->song.sample.size()) {
-                if (!e->song.sample[curSample]->saveRaw(copyOfName.c_str())) {
+                if (!e->getLatestSample(curSample)->saveRaw(copyOfName.c_str())) {
                   showError(_("could not save sample! open Log Viewer for more information."));
                 } else {
                   pushRecentSys(copyOfName.c_str());
@@ -5645,24 +5687,18 @@ bool FurnaceGUI::loop() {
               break;
             }
             case GUI_FILE_EXPORT_VGM: {
-              SafeWriter* w=e->saveVGM(willExport,vgmExportLoop,vgmExportVersion,vgmExportPatternHints,vgmExportDirectStream,vgmExportTrailingTicks,vgmExportDPCM07,vgmExportCorrectedRate);
-              if (w!=NULL) {
-                FILE* f=ps_fopen(copyOfName.c_str(),"wb");
-                if (f!=NULL) {
-                  fwrite(w->getFinalBuf(),1,w->size(),f);
-                  fclose(f);
-                  pushRecentSys(copyOfName.c_str());
-                } else {
-                  showError(_("could not open file!"));
-                }
-                w->finish();
-                delete w;
-                if (!e->getWarnings().empty()) {
-                  showWarning(e->getWarnings(),GUI_WARN_GENERIC);
-                }
-              } else {
-                showError(fmt::sprintf(_("could not write VGM! (%s)"),e->getLastError()));
-              }
+              bool exportChips[DIV_MAX_CHIPS];
+              memcpy(exportChips,willExport,DIV_MAX_CHIPS*sizeof(bool));
+              bool loop=vgmExportLoop;
+              int version=vgmExportVersion;
+              bool patternHints=vgmExportPatternHints;
+              bool directStream=vgmExportDirectStream;
+              int trailingTicks=vgmExportTrailingTicks;
+              bool dpcm07=vgmExportDPCM07;
+              int correctedRate=vgmExportCorrectedRate;
+              startBackgroundExport(copyOfName,[=](DivEngine* eng) mutable {
+                return eng->saveVGM(exportChips,loop,version,patternHints,directStream,trailingTicks,dpcm07,correctedRate);
+              },_("could not write VGM! (%s)"));
               break;
             }
             case GUI_FILE_EXPORT_ROM:
@@ -5671,34 +5707,31 @@ bool FurnaceGUI::loop() {
               if (pendingExport==NULL) {
                 showError("could not create exporter! you may want to report this issue...");
               } else {
+                // the exporter drives a snapshot so that playback is not interrupted
+                pendingExportEngine=e->createSnapshot();
+                if (pendingExportEngine==NULL) {
+                  showError(fmt::sprintf(_("could not begin exporting process! (%s)"),e->getLastError()));
+                  delete pendingExport;
+                  pendingExport=NULL;
+                  break;
+                }
                 pendingExport->setConf(romConfig);
-                if (pendingExport->go(e)) {
+                if (pendingExport->go(pendingExportEngine)) {
                   displayExportingROM=true;
                   romExportSave=true;
                 } else {
                   showError("could not begin exporting process! TODO: elaborate");
+                  DivEngine::destroySnapshot(pendingExportEngine);
+                  pendingExportEngine=NULL;
+                  delete pendingExport;
+                  pendingExport=NULL;
                 }
               }
               break;
             case GUI_FILE_EXPORT_TEXT: {
-              SafeWriter* w=e->saveText(false);
-              if (w!=NULL) {
-                FILE* f=ps_fopen(copyOfName.c_str(),"wb");
-                if (f!=NULL) {
-                  fwrite(w->getFinalBuf(),1,w->size(),f);
-                  fclose(f);
-                  pushRecentSys(copyOfName.c_str());
-                } else {
-                  showError(_("could not open file!"));
-                }
-                w->finish();
-                delete w;
-                if (!e->getWarnings().empty()) {
-                  showWarning(e->getWarnings(),GUI_WARN_GENERIC);
-                }
-              } else {
-                showError(fmt::sprintf(_("could not write text! (%s)"),e->getLastError()));
-              }
+              startBackgroundExport(copyOfName,[](DivEngine* eng) {
+                return eng->saveText(false);
+              },_("could not write text! (%s)"));
               break;
             }
             case GUI_FILE_EXPORT_CMDSTREAM: {
@@ -5943,6 +5976,13 @@ bool FurnaceGUI::loop() {
 
       ImGui::Text(_("Row %d of %d"),curPosInRows+((totalLoops)-(loopsLeft))*songLength,lengthOfOneFile);
       if (audioExportOptions.mode==DIV_EXPORT_MODE_MANY_CHAN) ImGui::Text(_("Channel %d of %d"),curFile+1,totalFiles);
+      if (e->isExporting()) {
+        int queued=0;
+        int queueCapacity=1;
+        double written=0.0;
+        e->getExportQueue(queued,queueCapacity,written);
+        ImGui::Text(_("Written: %.1fs (encoder queue: %d%%)"),written,(100*queued)/MAX(1,queueCapacity));
+      }
 
       ImGui::ProgressBar(curProgress,ImVec2(320.0f*dpiScale,0),fmt::sprintf("%.2f%%",curProgress*100.0f).c_str());
 
@@ -5961,6 +6001,8 @@ bool FurnaceGUI::loop() {
     ImVec2 romExportMinSize=mobileUI?ImVec2(canvasW-(portrait?0:(60.0*dpiScale)),canvasH-60.0*dpiScale):ImVec2(400.0f*dpiScale,200.0f*dpiScale);
     ImVec2 romExportMaxSize=ImVec2(canvasW-((mobileUI && !portrait)?(60.0*dpiScale):0),canvasH-(mobileUI?(60.0*dpiScale):0));
 
+    pollBackgroundExports();
+
     centerNextWindow(_("ROM Export Progress"),canvasW,canvasH);
     ImGui::SetNextWindowSizeConstraints(romExportMinSize,romExportMaxSize);
     if (ImGui::BeginPopupModal(_("ROM Export Progress"),NULL)) {
@@ -6001,6 +6043,8 @@ bool FurnaceGUI::loop() {
             pendingExport->abort();
             delete pendingExport;
             pendingExport=NULL;
+            DivEngine::destroySnapshot(pendingExportEngine);
+            pendingExportEngine=NULL;
             romExportSave=false;
             ImGui::CloseCurrentPopup();
           }
@@ -6039,6 +6083,8 @@ bool FurnaceGUI::loop() {
           if (ImGui::Button(_("OK"),ImVec2(ImGui::GetContentRegionAvail().x,0.0f))) {
             delete pendingExport;
             pendingExport=NULL;
+            DivEngine::destroySnapshot(pendingExportEngine);
+            pendingExportEngine=NULL;
             ImGui::CloseCurrentPopup();
           }
         }
@@ -6396,6 +6442,7 @@ bool FurnaceGUI::loop() {
               stop();
               e->lockEngine([this]() {
                 e->curSubSong->clearData();
+                e->notifyAllPatternsChange();
               });
               e->setOrder(0);
               curOrder=0;
@@ -6429,6 +6476,7 @@ bool FurnaceGUI::loop() {
                     pat->data[j][0]=0;
                     pat->data[j][1]=0;
                   }
+                  e->notifyPatternChange(e->getCurrentSubSong(),i,e->curOrders->ord[i][curOrder]);
                 }
               });
               MARK_MODIFIED;
@@ -6473,6 +6521,7 @@ bool FurnaceGUI::loop() {
               e->lockEngine([this]() {
                 e->curSubSong->optimizePatterns();
                 e->curSubSong->rearrangePatterns();
+                e->notifyAllPatternsChange();
               });
               MARK_MODIFIED;
               ImGui::CloseCurrentPopup();
@@ -7307,54 +7356,76 @@ bool FurnaceGUI::loop() {
       }
     }
 
-    if (!settings.renderClearPos || renderBackend==GUI_BACKEND_METAL) {
-      rend->clear(uiColors[GUI_COLOR_BACKGROUND]);
-    }
     renderTimeBegin=SDL_GetPerformanceCounter();
     ImGui::Render();
     renderTimeEnd=SDL_GetPerformanceCounter();
+
+    // don't draw or present the frame if it looks exactly like the last one
+    if (mustClear || initialScreenWipe>0.0f || !settings.skipIdleFrames) frameDamaged=true;
+    bool frameChanged=checkFrameDamage(ImGui::GetDrawData());
+
     drawTimeBegin=SDL_GetPerformanceCounter();
-    rend->renderGUI();
-    if (mustClear) {
-      rend->clear(ImVec4(0,0,0,0));
-      mustClear--;
-      if (mustClear==0) e->everythingOK();
-    } else {
-      if (initialScreenWipe>0.0f && !settings.disableFadeIn) {
-        WAKE_UP;
-        initialScreenWipe-=ImGui::GetIO().DeltaTime*5.0f;
-        if (initialScreenWipe>0.0f) {
-          rend->wipe(pow(initialScreenWipe,2.0f));
+    if (frameChanged) {
+      if (!settings.renderClearPos || renderBackend==GUI_BACKEND_METAL) {
+        rend->clear(uiColors[GUI_COLOR_BACKGROUND]);
+      }
+      rend->renderGUI();
+      if (mustClear) {
+        rend->clear(ImVec4(0,0,0,0));
+        mustClear--;
+        if (mustClear==0) e->everythingOK();
+      } else {
+        if (initialScreenWipe>0.0f && !settings.disableFadeIn) {
+          WAKE_UP;
+          initialScreenWipe-=ImGui::GetIO().DeltaTime*5.0f;
+          if (initialScreenWipe>0.0f) {
+            rend->wipe(pow(initialScreenWipe,2.0f));
+          }
+        } else if (settings.disableFadeIn) {
+          initialScreenWipe=0.0f;
         }
-      } else if (settings.disableFadeIn) {
-        initialScreenWipe=0.0f;
       }
     }
     drawTimeEnd=SDL_GetPerformanceCounter();
     swapTimeBegin=SDL_GetPerformanceCounter();
+    int frameRate=0;
     if (!settings.vsync || !rend->canVSync()) {
-      if (settings.frameRateLimit>0) {
-        unsigned int presentDelay=SDL_GetPerformanceFrequency()/settings.frameRateLimit;
-        if ((nextPresentTime-swapTimeBegin)<presentDelay) {
+      frameRate=settings.frameRateLimit;
+    } else if (!frameChanged) {
+      // there is no swap to wait on, so wait for as long as it would take
+      SDL_DisplayMode displayMode;
+      if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(sdlWin),&displayMode)==0 && displayMode.refresh_rate>0) {
+        frameRate=displayMode.refresh_rate;
+      } else {
+        frameRate=60;
+      }
+    }
+    if (frameRate>0) {
+      unsigned int presentDelay=SDL_GetPerformanceFrequency()/frameRate;
+      if ((nextPresentTime-swapTimeBegin)<presentDelay) {
 #ifdef _WIN32
-          unsigned int mDivider=SDL_GetPerformanceFrequency()/1000;
-          Sleep((unsigned int)(nextPresentTime-swapTimeBegin)/mDivider);
+        unsigned int mDivider=SDL_GetPerformanceFrequency()/1000;
+        Sleep((unsigned int)(nextPresentTime-swapTimeBegin)/mDivider);
 #else
-          unsigned int mDivider=SDL_GetPerformanceFrequency()/1000000;
-          usleep((unsigned int)(nextPresentTime-swapTimeBegin)/mDivider);
+        unsigned int mDivider=SDL_GetPerformanceFrequency()/1000000;
+        usleep((unsigned int)(nextPresentTime-swapTimeBegin)/mDivider);
 #endif
-          nextPresentTime+=presentDelay;
-        } else {
-          nextPresentTime=swapTimeBegin+presentDelay;
-        }
+        nextPresentTime+=presentDelay;
+      } else {
+        nextPresentTime=swapTimeBegin+presentDelay;
       }
     }
-    rend->present();
-    if (settings.renderClearPos && renderBackend!=GUI_BACKEND_METAL) {
-      rend->clear(uiColors[GUI_COLOR_BACKGROUND]);
+    if (frameChanged) {
+      rend->present();
+      if (settings.renderClearPos && renderBackend!=GUI_BACKEND_METAL) {
+        rend->clear(uiColors[GUI_COLOR_BACKGROUND]);
+      }
     }
     swapTimeEnd=SDL_GetPerformanceCounter();
 
+    // no-op after the first frame
+    startupProfileFinish("first frame presented");
+
     layoutTimeDelta=layoutTimeEnd-layoutTimeBegin;
     renderTimeDelta=renderTimeEnd-renderTimeBegin;
     drawTimeDelta=drawTimeEnd-drawTimeBegin;
@@ -7445,9 +7516,11 @@ bool FurnaceGUI::init() {
 
   opTouched=new bool[DIV_MAX_PATTERNS*DIV_MAX_ROWS];
 
+  startupProfileBegin("settings");
   syncState();
   syncSettings();
   syncTutorial();
+  startupProfileEnd();
 
   recentFile.clear();
   for (int i=0; i<settings.maxRecentFile; i++) {
@@ -7462,8 +7535,6 @@ bool FurnaceGUI::init() {
     audioExportOptions.fadeOut=settings.exportFadeOut;
   }
 
-  initSystemPresets();
-
   e->setAutoNotePoly(noteInputPoly);
 
   SDL_SetHint(SDL_HINT_VIDEO_ALLOW_SCREENSAVER,"1");
@@ -7482,10 +7553,12 @@ bool FurnaceGUI::init() {
 
   // initialize SDL
   logD("initializing video...");
+  startupProfileBegin("video");
   if (SDL_Init(SDL_INIT_VIDEO)!=0) {
     logE("could not initialize video! %s",SDL_GetError());
     return false;
   }
+  startupProfileEnd();
 
 #ifdef IS_MOBILE
   logD("initializing haptic...");
@@ -7702,6 +7775,7 @@ bool FurnaceGUI::init() {
   }
 
   logD("starting render backend...");
+  startupProfileBegin("render backend");
   if (!rend->init(sdlWin,settings.vsync)) {
     logE("it failed...");
     if (settings.renderBackend!="Software") {
@@ -7720,6 +7794,7 @@ bool FurnaceGUI::init() {
     return false;
   }
   logV("render backend started");
+  startupProfileEnd();
 
   // set best texture format
   unsigned int availTexFormats=rend->getTextureFormats();
@@ -7838,9 +7913,9 @@ bool FurnaceGUI::init() {
     }
   }
 
-  loadUserPresets(true);
-
+  startupProfileBegin("UI settings and fonts");
   applyUISettings();
+  startupProfileEnd();
 
   logD("building font...");
   if (rend->areTexturesSquare()) {
@@ -8352,6 +8427,15 @@ bool FurnaceGUI::finish(bool saveConfig) {
       e->saveConf();
     }
   }
+  pollBackgroundExports(true);
+  if (pendingExport!=NULL) {
+    pendingExport->abort();
+    delete pendingExport;
+    pendingExport=NULL;
+    DivEngine::destroySnapshot(pendingExportEngine);
+    pendingExportEngine=NULL;
+  }
+
   rend->quitGUI();
   ImGui_ImplSDL2_Shutdown();
   quitRender();
@@ -8468,6 +8552,11 @@ FurnaceGUI::FurnaceGUI():
   vgmExportTrailingTicks(-1),
   vgmExportCorrectedRate(44100),
   drawHalt(10),
+  frameDamaged(true),
+  frameHashMain(0),
+  frameHashVis(0),
+  frameHashExtra(0xcbf29ce484222325ULL),
+  visualizerLastRedraw(0),
   macroPointSize(16),
   waveEditStyle(0),
   displayInsTypeListMakeInsSample(-1),
@@ -8973,6 +9062,7 @@ FurnaceGUI::FurnaceGUI():
   romMultiFile(false),
   romExportSave(false),
   pendingExport(NULL),
+  pendingExportEngine(NULL),
   romExportExists(false) {
   // value keys
   valueKeys[SDLK_0]=0;
@@ -9023,6 +9113,8 @@ FurnaceGUI::FurnaceGUI():
   memset(lastIns,-1,sizeof(int)*DIV_MAX_CHANS);
   memset(oscValues,0,sizeof(void*)*DIV_MAX_OUTPUTS);
 
+  sysPresetsReady=false;
+
   memset(chanOscLP0,0,sizeof(float)*DIV_MAX_CHANS);
   memset(chanOscLP1,0,sizeof(float)*DIV_MAX_CHANS);
   memset(chanOscVol,0,sizeof(float)*DIV_MAX_CHANS);
@@ -1557,6 +1557,21 @@ struct FurnaceGUIBackupEntry {
   }
 };
 
+// an export running on a snapshot of the song in another thread
+struct FurnaceGUIBackgroundExport {
+  DivEngine* snapshot;
+  std::thread* thread;
+  std::atomic<bool> done;
+  String path;
+  String error;
+  String warnings;
+  FurnaceGUIBackgroundExport(DivEngine* snap, const String& p):
+    snapshot(snap),
+    thread(NULL),
+    done(false),
+    path(p) {}
+};
+
 enum FurnaceGUIBlendMode {
   GUI_BLEND_MODE_NONE=0,
   GUI_BLEND_MODE_BLEND,
@@ -1579,6 +1594,7 @@ class FurnaceGUIRender {
     virtual void setTextureBlendMode(FurnaceGUITexture* which, FurnaceGUIBlendMode mode);
     virtual void setBlendMode(FurnaceGUIBlendMode mode);
     virtual void resized(const SDL_Event& ev);
+    virtual void invalidate();
     virtual void clear(ImVec4 color);
     virtual void newFrame();
     virtual bool canVSync();
@@ -1713,6 +1729,11 @@ class FurnaceGUI {
   int vgmExportCorrectedRate;
   int cvHiScore;
   int drawHalt;
+  // frame damage tracking
+  bool frameDamaged;
+  uint64_t frameHashMain, frameHashVis, frameHashExtra;
+  uint64_t visualizerLastRedraw;
+  std::vector<ImDrawList*> visualizerDrawLists;
   int macroPointSize;
   int waveEditStyle;
   int displayInsTypeListMakeInsSample;
@@ -1859,6 +1880,7 @@ class FurnaceGUI {
     int pnQualityRender;
     int saaQualityRender;
     int pcSpeakerOutMethod;
+    int loadGovernor;
     String yrw801Path;
     String tg100Path;
     String mu5Path;
@@ -1950,6 +1972,7 @@ class FurnaceGUI {
     int effectValCellSpacing;
     int doubleClickColumn;
     int blankIns;
+    int sampleUndoMemory;
     int dragMovesSelection;
     int draggableDataView;
     int cursorFollowsOrder;
@@ -2020,6 +2043,8 @@ class FurnaceGUI {
     int vsync;
     int frameRateLimit;
     int displayRenderTime;
+    int skipIdleFrames;
+    int visualizerFrameRate;
     int inputRepeat;
     int glRedSize;
     int glGreenSize;
@@ -2114,6 +2139,7 @@ class FurnaceGUI {
       pnQualityRender(3),
       saaQualityRender(3),
       pcSpeakerOutMethod(0),
+      loadGovernor(0),
       yrw801Path(""),
       tg100Path(""),
       mu5Path(""),
@@ -2203,6 +2229,7 @@ class FurnaceGUI {
       effectValCellSpacing(0),
       doubleClickColumn(1),
       blankIns(0),
+      sampleUndoMemory(256),
       dragMovesSelection(1),
       draggableDataView(1),
       cursorFollowsOrder(1),
@@ -2272,6 +2299,8 @@ class FurnaceGUI {
       vsync(1),
       frameRateLimit(60),
       displayRenderTime(0),
+      skipIdleFrames(1),
+      visualizerFrameRate(0),
       inputRepeat(1),
       glRedSize(8),
       glGreenSize(8),
@@ -2468,6 +2497,8 @@ class FurnaceGUI {
   std::vector<std::pair<DivSample*,bool>> pendingSamples;
 
   std::vector<FurnaceGUISysCategory> sysCategories;
+  // system presets are built on first use
+  bool sysPresetsReady;
 
   std::vector<String> audioLoadFormats;
 
@@ -2652,22 +2683,31 @@ class FurnaceGUI {
   unsigned short lastNeedlePos[DIV_MAX_CHANS];
   unsigned short lastCorrPos[DIV_MAX_CHANS];
   struct ChanOscStatus {
-    double* inBuf;
-    fftw_complex* outBuf;
-    double* corrBuf;
+    float* sampleBuf;
+    float* inBuf;
+    fftwf_complex* outBuf;
+    float* corrBuf;
     DivDispatchOscBuffer* relatedBuf;
     size_t inBufPos;
     double inBufPosFrac;
     double waveLen;
     int waveLenBottom, waveLenTop, relatedCh;
+    // period (in FFT bins) found in the previous run, or 0
+    int lastPeriod;
+    // cache key and result of the previous run
+    int cacheDisplaySize;
+    float cachePhaseOff;
+    unsigned short cacheNeedle, cacheResult;
+    bool cacheValid, cacheWaveCorr;
     float pitch, windowSize, phaseOff, debugPhase, dcOff;
     unsigned short needle;
     bool ready, loudEnough, waveCorr;
-    fftw_plan plan;
-    fftw_plan planI;
+    fftwf_plan plan;
+    fftwf_plan planI;
     PendingDrawOsc drawOp;
     float oscTex[2048];
     ChanOscStatus():
+      sampleBuf(NULL),
       inBuf(NULL),
       outBuf(NULL),
       corrBuf(NULL),
@@ -2678,6 +2718,13 @@ class FurnaceGUI {
       waveLenBottom(0),
       waveLenTop(0),
       relatedCh(0),
+      lastPeriod(0),
+      cacheDisplaySize(0),
+      cachePhaseOff(0.0f),
+      cacheNeedle(0),
+      cacheResult(0),
+      cacheValid(false),
+      cacheWaveCorr(false),
       pitch(0.0f),
       windowSize(1.0f),
       phaseOff(0.0f),
@@ -2798,9 +2845,11 @@ class FurnaceGUI {
   DivConfig romConfig;
   bool romMultiFile;
   bool romExportSave;
+  std::vector<FurnaceGUIBackgroundExport*> backgroundExports;
   String romFilterName, romFilterExt;
   String romExportPath;
   DivROMExport* pendingExport;
+  DivEngine* pendingExportEngine;
   bool romExportAvail[DIV_ROM_MAX];
   bool romExportExists;
 
@@ -3082,7 +3131,10 @@ class FurnaceGUI {
   void pushRecentFile(String path);
   void pushRecentSys(const char* path);
   void exportAudio(String path, DivAudioExportModes mode);
+  std::vector<String> audioExportFilter();
   void exportCmdStream(bool target, String path);
+  bool startBackgroundExport(const String& path, std::function<SafeWriter*(DivEngine*)> what, const char* errorFormat);
+  void pollBackgroundExports(bool wait=false);
   void delFirstBackup(String name);
 
   bool parseSysEx(unsigned char* data, size_t len);
@@ -3091,6 +3143,7 @@ class FurnaceGUI {
   void decompileNoteKeys();
   void compileNoteKeys();
   void initSystemPresets();
+  void ensureSystemPresets();
 
   void initRandomDemoSong();
   bool loadRandomDemoSong();
@@ -3132,6 +3185,10 @@ class FurnaceGUI {
     void pushPartBlend();
     void popPartBlend();
     void runPendingDrawOsc(PendingDrawOsc* which);
+    // feeds data which affects the output without changing the draw lists (e.g. shader oscilloscopes)
+    void damageVisualizer(const void* data, size_t len);
+    // returns whether the current frame differs from the last presented one
+    bool checkFrameDamage(ImDrawData* drawData);
     bool detectOutOfBoundsWindow(SDL_Rect& failing);
     int processEvent(SDL_Event* ev);
     bool loop();
@@ -86,6 +86,7 @@ FurnaceGUITexture* FurnaceGUI::getTexture(FurnaceGUIImages image, FurnaceGUIBlen
     if (!rend->updateTexture(img->tex,img->data,img->width*4)) {
       logE("error while updating texture of image %d! %s",(int)image,SDL_GetError());
     }
+    frameDamaged=true;
   }
 
   return img->tex;
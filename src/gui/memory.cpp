@@ -52,6 +52,10 @@ void FurnaceGUI::drawMemory() {
         } else {
           ImGui::Text("%d/%d (%.1f%%)",(int)mc->used,(int)mc->capacity,100.0*(double)mc->used/(double)mc->capacity);
         }
+        if (mc->resident>0) {
+          ImGui::SameLine();
+          ImGui::TextDisabled(_("(%dK in RAM)"),(int)(mc->resident>>10));
+        }
 
         ImVec2 size=ImVec2(ImGui::GetContentRegionAvail().x,36.0f*dpiScale);
         ImVec2 minArea=window->DC.CursorPos;
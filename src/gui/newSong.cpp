@@ -122,6 +122,8 @@ void FurnaceGUI::drawNewSong() {
   bool accepted=false;
   std::vector<int> sysDefStack;
 
+  ensureSystemPresets();
+
   ImGui::PushFont(bigFont);
   ImGui::SetCursorPosX((ImGui::GetContentRegionAvail().x-ImGui::CalcTextSize(_("Choose a System!")).x)*0.5);
   ImGui::Text(_("Choose a System!"));
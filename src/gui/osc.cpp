@@ -310,6 +310,8 @@ void FurnaceGUI::drawOsc() {
             _do.color=isClipping?uiColors[GUI_COLOR_OSC_WAVE_PEAK]:uiColors[GUI_COLOR_OSC_WAVE];
             _do.lineSize=dpiScale*settings.oscLineSize;
 
+            damageVisualizer(_do.data,_do.len*sizeof(float));
+            damageVisualizer(&_do.color,sizeof(ImVec4));
             dl->AddCallback(_drawOsc,&_do);
             dl->AddCallback(ImDrawCallback_ResetRenderState,NULL);
           } else {
@@ -346,6 +348,8 @@ void FurnaceGUI::drawOsc() {
               _do.color=isClipping?uiColors[GUI_COLOR_OSC_WAVE_PEAK]:uiColors[GUI_COLOR_OSC_WAVE_CH0+ch];
               _do.lineSize=dpiScale*settings.oscLineSize;
 
+              damageVisualizer(_do.data,_do.len*sizeof(float));
+              damageVisualizer(&_do.color,sizeof(ImVec4));
               dl->AddCallback(_drawOsc,&_do);
               dl->AddCallback(ImDrawCallback_ResetRenderState,NULL);
             } else {
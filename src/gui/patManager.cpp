@@ -36,6 +36,7 @@ void FurnaceGUI::drawPatManager() {
     if (ImGui::Button(_("De-duplicate patterns"))) {
       e->lockEngine([this]() {
         e->curSubSong->optimizePatterns();
+        e->notifyAllPatternsChange();
       });
       MARK_MODIFIED;
     }
@@ -43,6 +44,7 @@ void FurnaceGUI::drawPatManager() {
     if (ImGui::Button(_("Re-arrange patterns"))) {
       e->lockEngine([this]() {
         e->curSubSong->rearrangePatterns();
+        e->notifyAllPatternsChange();
       });
       MARK_MODIFIED;
     }
@@ -50,6 +52,7 @@ void FurnaceGUI::drawPatManager() {
     if (ImGui::Button(_("Sort orders"))) {
       e->lockEngine([this]() {
         e->curSubSong->sortOrders();
+        e->notifyAllPatternsChange();
       });
       MARK_MODIFIED;
     }
@@ -57,6 +60,7 @@ void FurnaceGUI::drawPatManager() {
     if (ImGui::Button(_("Make patterns unique"))) {
       e->lockEngine([this]() {
         e->curSubSong->makePatUnique();
+        e->notifyAllPatternsChange();
       });
       MARK_MODIFIED;
     }
@@ -111,6 +115,7 @@ void FurnaceGUI::drawPatManager() {
             e->lockEngine([this,i,k]() {
               delete e->curSubSong->pat[i].data[k];
               e->curSubSong->pat[i].data[k]=NULL;
+              e->notifyPatternChange(e->getCurrentSubSong(),i,k);
             });
             MARK_MODIFIED;
           }
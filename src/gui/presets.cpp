@@ -3952,6 +3952,15 @@ void FurnaceGUI::initSystemPresets() {
   CATEGORY_END;
 }
 
+void FurnaceGUI::ensureSystemPresets() {
+  if (sysPresetsReady) return;
+  sysPresetsReady=true;
+
+  logD("building system presets...");
+  initSystemPresets();
+  loadUserPresets(true);
+}
+
 void FurnaceGUISysDef::bake() {
   int index=0;
   definition="";
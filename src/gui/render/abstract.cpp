@@ -68,6 +68,9 @@ void FurnaceGUIRender::setBlendMode(FurnaceGUIBlendMode mode) {
 void FurnaceGUIRender::resized(const SDL_Event& ev) {
 }
 
+void FurnaceGUIRender::invalidate() {
+}
+
 void FurnaceGUIRender::clear(ImVec4 color) {
 }
 
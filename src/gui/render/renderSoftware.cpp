@@ -20,6 +20,7 @@
 #include "renderSoftware.h"
 #include "imgui_sw.hpp"
 #include "../../ta-log.h"
+#include <thread>
 
 class FurnaceSoftwareTexture: public FurnaceGUITexture {
   public:
@@ -49,6 +50,8 @@ bool FurnaceGUIRenderSoftware::lockTexture(FurnaceGUITexture* which, void** data
 }
 
 bool FurnaceGUIRenderSoftware::unlockTexture(FurnaceGUITexture* which) {
+  FurnaceSoftwareTexture* t=(FurnaceSoftwareTexture*)which;
+  ImGui_ImplSW_TouchTexture(t->tex);
   return true;
 }
 
@@ -56,6 +59,7 @@ bool FurnaceGUIRenderSoftware::updateTexture(FurnaceGUITexture* which, void* dat
   FurnaceSoftwareTexture* t=(FurnaceSoftwareTexture*)which;
   if (!t->tex->managed) return false;
   memcpy(t->tex->pixels,data,pitch*t->tex->height);
+  ImGui_ImplSW_TouchTexture(t->tex);
   return true;
 }
 
@@ -66,6 +70,7 @@ FurnaceGUITexture* FurnaceGUIRenderSoftware::createTexture(bool dynamic, int wid
   }
   FurnaceSoftwareTexture* ret=new FurnaceSoftwareTexture;
   ret->tex=new SWTexture(width,height);
+  ImGui_ImplSW_TouchTexture(ret->tex);
   ret->format=format;
   return ret;
 }
@@ -86,23 +91,16 @@ void FurnaceGUIRenderSoftware::setBlendMode(FurnaceGUIBlendMode mode) {
   // TODO
 }
 
+// the clear is deferred: renderGUI() clears each tile it paints.
+// if nothing is rendered before present(), the whole surface is cleared there.
 void FurnaceGUIRenderSoftware::clear(ImVec4 color) {
-  SDL_Surface* surf=SDL_GetWindowSurface(sdlWin);
-  if (!surf) return;
   ImU32 clearToWhat=ImGui::ColorConvertFloat4ToU32(color);
-  clearToWhat=(clearToWhat&0xff00ff00)|((clearToWhat&0xff)<<16)|((clearToWhat&0xff0000)>>16);
+  clearColor=(clearToWhat&0xff00ff00)|((clearToWhat&0xff)<<16)|((clearToWhat&0xff0000)>>16);
+  clearPending=true;
+}
 
-  bool mustLock=SDL_MUSTLOCK(surf);
-  if (mustLock) {
-    if (SDL_LockSurface(surf)!=0) return;
-  }
-  unsigned int* pixels=(unsigned int*)surf->pixels;
-  for (size_t total=surf->w*surf->h; total; total--) {
-    *(pixels++)=clearToWhat;
-  }
-  if (mustLock) {
-    SDL_UnlockSurface(surf);
-  }
+static void _rasterizeTiles(void* arg) {
+  ImGui_ImplSW_RasterizeTiles();
 }
 
 void FurnaceGUIRenderSoftware::newFrame() {
@@ -114,7 +112,28 @@ bool FurnaceGUIRenderSoftware::canVSync() {
 }
 
 void FurnaceGUIRenderSoftware::renderGUI() {
-  ImGui_ImplSW_RenderDrawData(ImGui::GetDrawData());
+  ImGui_ImplSW_SetClearColor(clearColor);
+  clearPending=false;
+
+  int tiles=ImGui_ImplSW_PrepareDrawData(ImGui::GetDrawData());
+  if (tiles>0) {
+    if (rasterPool!=NULL && tiles>1) {
+      // each job paints tiles until there are none left
+      for (int i=0; i<rasterThreads; i++) {
+        rasterPool->push(_rasterizeTiles,NULL);
+      }
+      rasterPool->wait();
+    } else {
+      ImGui_ImplSW_RasterizeTiles();
+    }
+  }
+  ImGui_ImplSW_FinishDrawData();
+}
+
+void FurnaceGUIRenderSoftware::invalidate() {
+  // the window contents were lost. repaint and present everything
+  ImGui_ImplSW_Invalidate();
+  presentAll=true;
 }
 
 void FurnaceGUIRenderSoftware::wipe(float alpha) {
@@ -122,7 +141,40 @@ void FurnaceGUIRenderSoftware::wipe(float alpha) {
 }
 
 void FurnaceGUIRenderSoftware::present() {
-  SDL_UpdateWindowSurface(sdlWin);
+  if (clearPending) {
+    // cleared after (or without) rendering
+    SDL_Surface* surf=SDL_GetWindowSurface(sdlWin);
+    if (!surf) return;
+
+    bool mustLock=SDL_MUSTLOCK(surf);
+    if (mustLock) {
+      if (SDL_LockSurface(surf)!=0) return;
+    }
+    unsigned int* pixels=(unsigned int*)surf->pixels;
+    for (size_t total=surf->w*surf->h; total; total--) {
+      *(pixels++)=clearColor;
+    }
+    if (mustLock) {
+      SDL_UnlockSurface(surf);
+    }
+    clearPending=false;
+    ImGui_ImplSW_Invalidate();
+    SDL_UpdateWindowSurface(sdlWin);
+    return;
+  }
+
+  if (presentAll) {
+    presentAll=false;
+    SDL_UpdateWindowSurface(sdlWin);
+    return;
+  }
+
+  // only present tiles which changed
+  const SDL_Rect* rects=NULL;
+  int rectCount=ImGui_ImplSW_GetDirtyRects(&rects);
+  if (rectCount>0) {
+    SDL_UpdateWindowSurfaceRects(sdlWin,rects,rectCount);
+  }
 }
 
 bool FurnaceGUIRenderSoftware::getOutputSize(int& w, int& h) {
@@ -169,10 +221,20 @@ void FurnaceGUIRenderSoftware::setSwapInterval(int swapInterval) {
 }
 
 void FurnaceGUIRenderSoftware::preInit(const DivConfig& conf) {
+  rasterThreads=conf.getInt("swRenderThreads",0);
+  if (rasterThreads<=0) {
+    rasterThreads=std::thread::hardware_concurrency();
+    if (rasterThreads>8) rasterThreads=8;
+  }
+  if (rasterThreads>32) rasterThreads=32;
 }
 
 bool FurnaceGUIRenderSoftware::init(SDL_Window* win, int swapInterval) {
   sdlWin=win;
+  if (rasterThreads>1) {
+    logV("software renderer: using %d threads",rasterThreads);
+    rasterPool=new DivWorkPool(rasterThreads);
+  }
   return true;
 }
 
@@ -187,5 +249,9 @@ void FurnaceGUIRenderSoftware::quitGUI() {
 }
 
 bool FurnaceGUIRenderSoftware::quit() {
+  if (rasterPool!=NULL) {
+    delete rasterPool;
+    rasterPool=NULL;
+  }
   return true;
 }
@@ -21,6 +21,11 @@
 
 class FurnaceGUIRenderSoftware: public FurnaceGUIRender {
   SDL_Window* sdlWin;
+  DivWorkPool* rasterPool;
+  int rasterThreads;
+  unsigned int clearColor;
+  bool clearPending;
+  bool presentAll;
   public:
     ImTextureID getTextureID(FurnaceGUITexture* which);
     FurnaceGUITextureFormat getTextureFormat(FurnaceGUITexture* which);
@@ -31,6 +36,7 @@ class FurnaceGUIRenderSoftware: public FurnaceGUIRender {
     bool destroyTexture(FurnaceGUITexture* which);
     void setTextureBlendMode(FurnaceGUITexture* which, FurnaceGUIBlendMode mode);
     void setBlendMode(FurnaceGUIBlendMode mode);
+    void invalidate();
     void clear(ImVec4 color);
     void newFrame();
     bool canVSync();
@@ -53,5 +59,10 @@ class FurnaceGUIRenderSoftware: public FurnaceGUIRender {
     void quitGUI();
     bool quit();
     FurnaceGUIRenderSoftware():
-      sdlWin(NULL) {}
+      sdlWin(NULL),
+      rasterPool(NULL),
+      rasterThreads(1),
+      clearColor(0xff000000),
+      clearPending(false),
+      presentAll(false) {}
 };
@@ -141,7 +141,18 @@ void FurnaceGUI::drawSampleEdit() {
         ImGui::EndTable();
       }
     } else {
-      DivSample* sample=e->song.sample[curSample];
+      // edit the newest version, even if the audio thread hasn't picked it up yet
+      DivSample* sample=e->getLatestSample(curSample);
+      if (e->isSampleJobRunning(curSample)) {
+        ImGui::AlignTextToFramePadding();
+        ImGui::TextUnformatted(e->getSampleJobName().c_str());
+        ImGui::SameLine();
+        ImGui::ProgressBar(e->getSampleJobProgress(),ImVec2(ImGui::GetContentRegionAvail().x-ImGui::CalcTextSize(_("Cancel")).x-ImGui::GetStyle().ItemSpacing.x-ImGui::GetStyle().FramePadding.x*2.0f,0));
+        ImGui::SameLine();
+        if (ImGui::Button(_("Cancel"))) {
+          e->cancelSampleJob();
+        }
+      }
       String sampleType=_("Invalid");
       if (sample->depth<DIV_SAMPLE_DEPTH_MAX) {
         if (sampleDepths[sample->depth]!=NULL) {
@@ -163,7 +174,7 @@ void FurnaceGUI::drawSampleEdit() {
           name=fmt::sprintf("%d: %s##_SMPS%d",i,e->song.sample[i]->name,i);
           if (ImGui::Selectable(name.c_str(),curSample==(int)i)) {
             curSample=i;
-            sample=e->song.sample[curSample];
+            sample=e->getLatestSample(curSample);
             updateSampleTex=true;
           }
         }
@@ -666,10 +677,10 @@ void FurnaceGUI::drawSampleEdit() {
             for (int i=0; i<DIV_SAMPLE_DEPTH_MAX; i++) {
               if (sampleDepths[i]==NULL) continue;
               if (ImGui::Selectable(sampleDepths[i])) {
-                sample->prepareUndo(true);
-                e->lockEngine([this,sample,i]() {
+                e->editSample(curSample,[this,i](DivSample* sample) -> bool {
+                  sample->prepareUndo(true);
                   sample->convert((DivSampleDepth)i,e->getSampleFormatMask());
-                  e->renderSamples(curSample);
+                  return true;
                 });
                 updateSampleTex=true;
                 MARK_MODIFIED;
@@ -1088,12 +1099,13 @@ void FurnaceGUI::drawSampleEdit() {
           if (resizeSize>16777215) resizeSize=16777215;
         }
         if (ImGui::Button(_("Resize"))) {
-          sample->prepareUndo(true);
-          e->lockEngine([this,sample]() {
+          e->editSample(curSample,[this](DivSample* sample) -> bool {
+            sample->prepareUndo(true);
             if (!sample->resize(resizeSize)) {
               showError(_("couldn't resize! make sure your sample is 8 or 16-bit."));
+              return false;
             }
-            e->renderSamples(curSample);
+            return true;
           });
           updateSampleTex=true;
           sampleSelStart=-1;
@@ -1152,17 +1164,18 @@ void FurnaceGUI::drawSampleEdit() {
         }
         ImGui::Combo(_("Filter"),&resampleStrat,LocalizedComboGetter,resampleStrats,6);
         if (ImGui::Button(_("Resample"))) {
-          sample->prepareUndo(true);
-          e->lockEngine([this,sample,targetRate]() {
-            if (!sample->resample(targetRate,resampleTarget,resampleStrat)) {
-              showError(_("couldn't resample! make sure your sample is 8 or 16-bit and that the target rate is at least 100Hz."));
-            }
-            e->renderSamples(curSample);
-          });
-          updateSampleTex=true;
-          sampleSelStart=-1;
-          sampleSelEnd=-1;
-          MARK_MODIFIED;
+          double target=resampleTarget;
+          int strat=resampleStrat;
+          if ((sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) || target<100) {
+            showError(_("couldn't resample! make sure your sample is 8 or 16-bit and that the target rate is at least 100Hz."));
+          } else if (e->editSampleAsync(curSample,_("Resampling"),[targetRate,target,strat](DivSample* sample) -> bool {
+            sample->prepareUndo(true);
+            return sample->resample(targetRate,target,strat);
+          })) {
+            sampleSelStart=-1;
+            sampleSelEnd=-1;
+            MARK_MODIFIED;
+          }
           ImGui::CloseCurrentPopup();
         }
         ImGui::EndPopup();
@@ -1205,32 +1218,15 @@ void FurnaceGUI::drawSampleEdit() {
         ImGui::SameLine();
         ImGui::Text("(%.1fdB)",20.0*log10(amplifyVol/100.0f));
         if (ImGui::Button(_("Apply"))) {
-          sample->prepareUndo(true);
-          e->lockEngine([this,sample]() {
-            SAMPLE_OP_BEGIN;
-            float vol=amplifyVol/100.0f;
-
-            if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
-              for (unsigned int i=start; i<end; i++) {
-                float val=sample->data16[i]*vol;
-                if (val<-32768) val=-32768;
-                if (val>32767) val=32767;
-                sample->data16[i]=val;
-              }
-            } else if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-              for (unsigned int i=start; i<end; i++) {
-                float val=sample->data8[i]*vol;
-                if (val<-128) val=-128;
-                if (val>127) val=127;
-                sample->data8[i]=val;
-              }
-            }
-
-            updateSampleTex=true;
-
-            e->renderSamples(curSample);
-          });
-          MARK_MODIFIED;
+          SAMPLE_OP_BEGIN;
+          float vol=amplifyVol/100.0f;
+          if (e->editSampleAsync(curSample,_("Amplifying"),[start,end,vol](DivSample* sample) -> bool {
+            sample->prepareUndo(true);
+            sample->applyGain(start,end,vol,vol);
+            return true;
+          })) {
+            MARK_MODIFIED;
+          }
           ImGui::CloseCurrentPopup();
         }
         ImGui::EndPopup();
@@ -1272,12 +1268,13 @@ void FurnaceGUI::drawSampleEdit() {
         }
         if (ImGui::Button(_("Go"))) {
           int pos=(sampleSelStart==-1 || sampleSelStart==sampleSelEnd)?sample->samples:sampleSelStart;
-          sample->prepareUndo(true);
-          e->lockEngine([this,sample,pos]() {
+          e->editSample(curSample,[this,pos](DivSample* sample) -> bool {
+            sample->prepareUndo(true);
             if (!sample->insert(pos,silenceSize)) {
               showError(_("couldn't insert! make sure your sample is 8 or 16-bit."));
+              return false;
             }
-            e->renderSamples(curSample);
+            return true;
           });
           updateSampleTex=true;
           sampleSelStart=pos;
@@ -1405,60 +1402,69 @@ void FurnaceGUI::drawSampleEdit() {
         }
 
         if (ImGui::Button(_("Apply"))) {
-          sample->prepareUndo(true);
-          e->lockEngine([this,sample]() {
-            SAMPLE_OP_BEGIN;
-            float res=1.0-pow(sampleFilterRes,0.5f);
+          if (sampleFilterCutStart<0.0) sampleFilterCutStart=0.0;
+          if (sampleFilterCutStart>sample->centerRate*0.5) sampleFilterCutStart=sample->centerRate*0.5;
+          if (sampleFilterCutEnd<0.0) sampleFilterCutEnd=0.0;
+          if (sampleFilterCutEnd>sample->centerRate*0.5) sampleFilterCutEnd=sample->centerRate*0.5;
+
+          SAMPLE_OP_BEGIN;
+          float res=1.0-pow(sampleFilterRes,0.5f);
+          double cutStart=sampleFilterCutStart;
+          double cutEnd=sampleFilterCutEnd;
+          bool sweep=sampleFilterSweep;
+          int filterPower=sampleFilterPower;
+          float filterL=sampleFilterL;
+          float filterB=sampleFilterB;
+          float filterH=sampleFilterH;
+          bool started=e->editSampleAsync(curSample,_("Filtering"),[start,end,res,cutStart,cutEnd,sweep,filterPower,filterL,filterB,filterH](DivSample* sample) -> bool {
+            sample->prepareUndo(true);
             float low=0;
             float band=0;
             float high=0;
 
-            if (sampleFilterCutStart<0.0) sampleFilterCutStart=0.0;
-            if (sampleFilterCutStart>sample->centerRate*0.5) sampleFilterCutStart=sample->centerRate*0.5;
-            if (sampleFilterCutEnd<0.0) sampleFilterCutEnd=0.0;
-            if (sampleFilterCutEnd>sample->centerRate*0.5) sampleFilterCutEnd=sample->centerRate*0.5;
-
-            double power=(sampleFilterCutStart>sampleFilterCutEnd)?0.5:2.0;
+            double power=(cutStart>cutEnd)?0.5:2.0;
 
             if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
               for (unsigned int i=start; i<end; i++) {
-                double freq=sampleFilterCutStart+(sampleFilterSweep?((sampleFilterCutEnd-sampleFilterCutStart)*pow(double(i-start)/double(end-start),power)):0);
+                if (!((i-start)&0xffff) && !sample->setProgress(double(i-start)/double(end-start))) return false;
+                double freq=cutStart+(sweep?((cutEnd-cutStart)*pow(double(i-start)/double(end-start),power)):0);
                 double cut=sin((freq/double(sample->centerRate))*M_PI);
 
-                for (int j=0; j<sampleFilterPower; j++) {
+                for (int j=0; j<filterPower; j++) {
                   low=low+cut*band;
                   high=float(sample->data16[i])-low-(res*band);
                   band=cut*high+band;
                 }
 
-                float val=low*sampleFilterL+band*sampleFilterB+high*sampleFilterH;
+                float val=low*filterL+band*filterB+high*filterH;
                 if (val<-32768) val=-32768;
                 if (val>32767) val=32767;
                 sample->data16[i]=val;
               }
             } else if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
               for (unsigned int i=start; i<end; i++) {
-                double freq=sampleFilterCutStart+(sampleFilterSweep?((sampleFilterCutEnd-sampleFilterCutStart)*pow(double(i-start)/double(end-start),power)):0);
+                if (!((i-start)&0xffff) && !sample->setProgress(double(i-start)/double(end-start))) return false;
+                double freq=cutStart+(sweep?((cutEnd-cutStart)*pow(double(i-start)/double(end-start),power)):0);
                 double cut=sin((freq/double(sample->centerRate))*M_PI);
 
-                for (int j=0; j<sampleFilterPower; j++) {
+                for (int j=0; j<filterPower; j++) {
                   low=low+cut*band;
                   high=float(sample->data8[i])-low-(res*band);
                   band=cut*high+band;
                 }
 
-                float val=low*sampleFilterL+band*sampleFilterB+high*sampleFilterH;
+                float val=low*filterL+band*filterB+high*filterH;
                 if (val<-128) val=-128;
                 if (val>127) val=127;
                 sample->data8[i]=val;
               }
             }
 
-            updateSampleTex=true;
-
-            e->renderSamples(curSample);
+            return true;
           });
-          MARK_MODIFIED;
+          if (started) {
+            MARK_MODIFIED;
+          }
           ImGui::CloseCurrentPopup();
         }
 
@@ -1505,8 +1511,8 @@ void FurnaceGUI::drawSampleEdit() {
             showError(_("Crossfade: length would overflow loopStart. Try a smaller random value."));
             ImGui::CloseCurrentPopup();
           } else {
-            sample->prepareUndo(true);
-            e->lockEngine([this,sample] {
+            e->editSample(curSample,[this](DivSample* sample) -> bool {
+              sample->prepareUndo(true);
               SAMPLE_OP_BEGIN;
               double l=1.0/(double)sampleCrossFadeLoopLength;
               double evar=1.0-sampleCrossFadeLoopLaw/200.0;
@@ -1535,7 +1541,7 @@ void FurnaceGUI::drawSampleEdit() {
               }
               updateSampleTex=true;
 
-              e->renderSamples(curSample);
+              return true;
             });
             MARK_MODIFIED;
             ImGui::CloseCurrentPopup();
@@ -1859,6 +1865,7 @@ void FurnaceGUI::drawSampleEdit() {
             }
             rend->unlockTexture(sampleTex);
             delete[] data;
+            frameDamaged=true;
           }
           updateSampleTex=false;
         }
@@ -2491,8 +2498,9 @@ void FurnaceGUI::drawSampleEdit() {
 void FurnaceGUI::doUndoSample() {
   if (!sampleEditOpen) return;
   if (curSample<0 || curSample>=(int)e->song.sample.size()) return;
-  DivSample* sample=e->song.sample[curSample];
-  e->lockEngine([this,sample]() {
+  e->lockEngine([this]() {
+    // fetch the sample here in case a pending edit was just swapped in
+    DivSample* sample=e->song.sample[curSample];
     if (sample->undo()==2) {
       e->renderSamples(curSample);
       updateSampleTex=true;
@@ -2503,8 +2511,9 @@ void FurnaceGUI::doUndoSample() {
 void FurnaceGUI::doRedoSample() {
   if (!sampleEditOpen) return;
   if (curSample<0 || curSample>=(int)e->song.sample.size()) return;
-  DivSample* sample=e->song.sample[curSample];
-  e->lockEngine([this,sample]() {
+  e->lockEngine([this]() {
+    // fetch the sample here in case a pending edit was just swapped in
+    DivSample* sample=e->song.sample[curSample];
     if (sample->redo()==2) {
       e->renderSamples(curSample);
       updateSampleTex=true;
@@ -775,6 +775,26 @@ void FurnaceGUI::drawSettings() {
           }
         }
 
+        bool skipIdleFramesB=settings.skipIdleFrames;
+        if (ImGui::Checkbox(_("Skip unchanged frames"),&skipIdleFramesB)) {
+          settings.skipIdleFrames=skipIdleFramesB;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("does not render or present a frame if it looks exactly like the previous one."));
+        }
+
+        if (settings.skipIdleFrames) {
+          if (ImGui::SliderInt(_("Visualizer redraw rate limit"),&settings.visualizerFrameRate,0,250,settings.visualizerFrameRate==0?_("Unlimited"):"%d")) {
+            settingsChanged=true;
+          }
+          if (settings.visualizerFrameRate<0) settings.visualizerFrameRate=0;
+          if (settings.visualizerFrameRate>1000) settings.visualizerFrameRate=1000;
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(_("limits how often changes in the oscilloscopes and volume meter alone cause a redraw."));
+          }
+        }
+
         bool powerSaveB=settings.powerSave;
         if (ImGui::Checkbox(_("Power-saving mode"),&powerSaveB)) {
           settings.powerSave=powerSaveB;
@@ -1208,6 +1228,14 @@ void FurnaceGUI::drawSettings() {
           settings.blankIns=blankInsB;
           settingsChanged=true;
         }
+        if (ImGui::InputInt(_("Sample undo memory limit (MB)"),&settings.sampleUndoMemory,16,64)) {
+          if (settings.sampleUndoMemory<16) settings.sampleUndoMemory=16;
+          if (settings.sampleUndoMemory>4096) settings.sampleUndoMemory=4096;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("the oldest sample undo steps are discarded when the song's sample history exceeds this size."));
+        }
         // SUBSECTION CONFIGURATION
         CONFIG_SUBSECTION(_("Configuration"));
         if (ImGui::Button(_("Import"))) {
@@ -2127,6 +2155,15 @@ void FurnaceGUI::drawSettings() {
         ImGui::SameLine();
         if (ImGui::Combo("##PCSOutMethod",&settings.pcSpeakerOutMethod,LocalizedComboGetter,pcspkrOutMethods,5)) settingsChanged=true;
 
+        bool loadGovernorB=settings.loadGovernor;
+        if (ImGui::Checkbox(_("Switch to cheaper cores when overloaded"),&loadGovernorB)) {
+          settings.loadGovernor=loadGovernorB;
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("when the audio load stays close to 100%%, the heaviest chip is switched to its cheapest core.\nthe configured core is restored once there is enough headroom.\nthis causes a short glitch, as the song position is sought again."));
+        }
+
         ImGui::Separator();
         ImGui::Text(_("Sample ROMs:"));
 
@@ -4833,6 +4870,8 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     settings.vsync=conf.getInt("vsync",1);
     settings.frameRateLimit=conf.getInt("frameRateLimit",100);
     settings.displayRenderTime=conf.getInt("displayRenderTime",0);
+    settings.skipIdleFrames=conf.getInt("skipIdleFrames",1);
+    settings.visualizerFrameRate=conf.getInt("visualizerFrameRate",0);
 
     settings.chanOscThreads=conf.getInt("chanOscThreads",0);
     settings.renderPoolThreads=conf.getInt("renderPoolThreads",0);
@@ -4851,6 +4890,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     settings.displayPartial=conf.getInt("displayPartial",0);
 
     settings.blankIns=conf.getInt("blankIns",0);
+    settings.sampleUndoMemory=conf.getInt("sampleUndoMemory",256);
 
     settings.saveWindowPos=conf.getInt("saveWindowPos",1);
 
@@ -5165,6 +5205,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     settings.saaQualityRender=conf.getInt("saaQualityRender",3);
 
     settings.pcSpeakerOutMethod=conf.getInt("pcSpeakerOutMethod",0);
+    settings.loadGovernor=conf.getInt("loadGovernor",0);
 
     settings.yrw801Path=conf.getString("yrw801Path","");
     settings.tg100Path=conf.getString("tg100Path","");
@@ -5224,6 +5265,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.pnQualityRender,0,5);
   clampSetting(settings.saaQualityRender,0,5);
   clampSetting(settings.pcSpeakerOutMethod,0,4);
+  clampSetting(settings.loadGovernor,0,1);
   clampSetting(settings.mainFont,0,6);
   clampSetting(settings.patFont,0,6);
   clampSetting(settings.patRowsBase,0,1);
@@ -5301,6 +5343,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.effectValCellSpacing,0,32);
   clampSetting(settings.doubleClickColumn,0,1);
   clampSetting(settings.blankIns,0,1);
+  clampSetting(settings.sampleUndoMemory,16,4096);
   clampSetting(settings.dragMovesSelection,0,5);
   clampSetting(settings.draggableDataView,0,1);
   clampSetting(settings.unsignedDetune,0,1);
@@ -5371,6 +5414,8 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.vsync,0,4);
   clampSetting(settings.frameRateLimit,0,1000);
   clampSetting(settings.displayRenderTime,0,1);
+  clampSetting(settings.skipIdleFrames,0,1);
+  clampSetting(settings.visualizerFrameRate,0,1000);
   clampSetting(settings.vibrationStrength,0.0f,1.0f);
   clampSetting(settings.vibrationLength,10,500);
   clampSetting(settings.inputRepeat,0,1);
@@ -5427,6 +5472,8 @@ void FurnaceGUI::writeConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     conf.set("vsync",settings.vsync);
     conf.set("frameRateLimit",settings.frameRateLimit);
     conf.set("displayRenderTime",settings.displayRenderTime);
+    conf.set("skipIdleFrames",settings.skipIdleFrames);
+    conf.set("visualizerFrameRate",settings.visualizerFrameRate);
 
     conf.set("chanOscThreads",settings.chanOscThreads);
     conf.set("renderPoolThreads",settings.renderPoolThreads);
@@ -5445,6 +5492,7 @@ void FurnaceGUI::writeConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     conf.set("displayPartial",settings.displayPartial);
 
     conf.set("blankIns",settings.blankIns);
+    conf.set("sampleUndoMemory",settings.sampleUndoMemory);
 
     conf.set("saveWindowPos",settings.saveWindowPos);
 
@@ -5749,6 +5797,7 @@ void FurnaceGUI::writeConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     conf.set("saaQualityRender",settings.saaQualityRender);
 
     conf.set("pcSpeakerOutMethod",settings.pcSpeakerOutMethod);
+    conf.set("loadGovernor",settings.loadGovernor);
 
     conf.set("yrw801Path",settings.yrw801Path);
     conf.set("tg100Path",settings.tg100Path);
@@ -37,6 +37,7 @@ void FurnaceGUI::drawStats() {
     ImGui::ProgressBar((double)lastProcTime/maxGot,ImVec2(ImGui::GetContentRegionAvail().x-ImGui::CalcTextSize("100.0%").x,0),"");
     ImGui::SameLine();
     ImGui::Text("%.1f%%",100.0*((double)lastProcTime/(double)maxGot));
+    ImGui::Text(_("Sample undo memory: %.1f/%.0f MB"),(double)e->getSampleHistoryMemory()/1048576.0,(double)e->getSampleHistoryLimit()/1048576.0);
     if (ImGui::GetContentRegionAvail().y>8.0f*dpiScale) {
       // draw a chart
       lastAudioLoads[lastAudioLoadsPos]=(double)lastProcTime/maxGot;
@@ -46,6 +47,11 @@ void FurnaceGUI::drawStats() {
       ImGui::PlotLines("##ALChart",lastAudioLoads,120,lastAudioLoadsPos,NULL,0.0f,1.0f,ImGui::GetContentRegionAvail());
       ImGui::PopStyleColor();
     }
+    for (int i=0; i<e->song.systemLen; i++) {
+      if (e->isLowCostCore(i)) {
+        ImGui::TextColored(uiColors[GUI_COLOR_WARNING],_("%d. %s: using cheapest core"),i+1,e->getSystemName(e->song.system[i]));
+      }
+    }
   }
   if (ImGui::IsWindowFocused(ImGuiFocusedFlags_ChildWindows)) curWindow=GUI_WINDOW_STATS;
   ImGui::End();
@@ -1079,6 +1079,7 @@ void FurnaceGUI::drawTutorial() {
         SDL_LockSurface(cv->surface);
         rend->updateTexture(cvTex,cv->surface->pixels,320*4);
         SDL_UnlockSurface(cv->surface);
+        frameDamaged=true;
 
         ImDrawList* dl=ImGui::GetForegroundDrawList();
 
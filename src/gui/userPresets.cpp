@@ -49,6 +49,7 @@ std::vector<FurnaceGUISysDef>* digDeep(std::vector<FurnaceGUISysDef>& entries, i
 }
 
 bool FurnaceGUI::loadUserPresets(bool redundancy, String path, bool append) {
+  ensureSystemPresets();
   if (path.empty()) path=e->getConfigPath()+PRESETS_FILE;
   String line, lineStr;
   logD("opening user presets: %s",path);
@@ -222,6 +223,7 @@ void writeSubEntries(FILE* f, std::vector<FurnaceGUISysDef>& entries, int depth)
 }
 
 bool FurnaceGUI::saveUserPresets(bool redundancy, String path) {
+  ensureSystemPresets();
   if (path.empty()) path=e->getConfigPath()+PRESETS_FILE;
   FurnaceGUISysCategory* userCategory=NULL;
 
@@ -333,6 +335,7 @@ void FurnaceGUI::drawUserPresets() {
     nextWindow=GUI_WINDOW_NOTHING;
   }
   if (!userPresetsOpen) return;
+  ensureSystemPresets();
   if (ImGui::Begin("User Systems",&userPresetsOpen,globalWinFlags,_("User Systems"))) {
     FurnaceGUISysCategory* userCategory=NULL;
     for (FurnaceGUISysCategory& i: sysCategories) {
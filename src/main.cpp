@@ -19,13 +19,16 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <algorithm>
 #include "pch.h"
 #ifdef HAVE_SDL2
 #include "SDL_events.h"
 #endif
 #include "ta-log.h"
 #include "fileutils.h"
+#include "startupProfile.h"
 #include "engine/engine.h"
+#include "audio/pipe.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -73,6 +76,7 @@ struct sigaction termsa;
 #endif
 
 #include "cli/cli.h"
+#include "cli/server.h"
 
 #ifdef HAVE_GUI
 #include "gui/gui.h"
@@ -91,6 +95,9 @@ String vgmOutName;
 String cmdOutName;
 String romOutName;
 String txtOutName;
+String csProfileName;
+String serveTarget;
+int serveWorkers;
 int benchMode=0;
 int subsong=-1;
 DivCSOptions csExportOptions;
@@ -188,6 +195,46 @@ TAParamResult pAudio(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pPipeFormat(String val) {
+  if (val=="s16") {
+    e.setPipeOptions(TA_PIPE_FORMAT_S16,-1,-1);
+  } else if (val=="s24") {
+    e.setPipeOptions(TA_PIPE_FORMAT_S24,-1,-1);
+  } else if (val=="f32") {
+    e.setPipeOptions(TA_PIPE_FORMAT_F32,-1,-1);
+  } else {
+    logE("invalid value for pipeformat! valid values are: s16, s24 and f32.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pPipeHeader(String val) {
+  if (val=="none") {
+    e.setPipeOptions(-1,TA_PIPE_HEADER_NONE,-1);
+  } else if (val=="wav") {
+    e.setPipeOptions(-1,TA_PIPE_HEADER_WAV,-1);
+  } else if (val=="au") {
+    e.setPipeOptions(-1,TA_PIPE_HEADER_AU,-1);
+  } else {
+    logE("invalid value for pipeheader! valid values are: none, wav and au.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pPipePace(String val) {
+  if (val=="fast") {
+    e.setPipeOptions(-1,-1,0);
+  } else if (val=="realtime") {
+    e.setPipeOptions(-1,-1,1);
+  } else {
+    logE("invalid value for pipepace! valid values are: fast and realtime.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pView(String val) {
   if (val=="pattern") {
     e.setView(DIV_STATUS_PATTERN);
@@ -271,6 +318,11 @@ TAParamResult pLogLevel(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pProfileStartup(String) {
+  startupProfileEnable();
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pVersion(String) {
   printf("Furnace version " DIV_VERSION ".\n\n");
   printf("copyright (C) 2021-2025 tildearrow and contributors.\n");
@@ -414,19 +466,68 @@ TAParamResult pOutMode(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pOutFormat(String val) {
+  if (val=="s16") {
+    exportOptions.format=DIV_EXPORT_FORMAT_S16;
+  } else if (val=="f32") {
+    exportOptions.format=DIV_EXPORT_FORMAT_F32;
+  } else if (val=="flac") {
+    exportOptions.format=DIV_EXPORT_FORMAT_FLAC;
+  } else if (val=="opus") {
+    exportOptions.format=DIV_EXPORT_FORMAT_OPUS;
+    exportOptions.sampleRate=48000;
+  } else {
+    logE("invalid value for outformat! valid values are: s16, f32, flac and opus.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pBenchmark(String val) {
   if (val=="render") {
     benchMode=1;
   } else if (val=="seek") {
     benchMode=2;
+  } else if (val=="tiuna") {
+    benchMode=3;
   } else {
-    logE("invalid value for benchmark! valid values are: render and seek.");
+    logE("invalid value for benchmark! valid values are: render, seek and tiuna.");
     return TA_PARAM_ERROR;
   }
   e.setAudio(DIV_AUDIO_DUMMY);
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pCSProfile(String val) {
+  csProfileName=val;
+  benchMode=4;
+  e.setAudio(DIV_AUDIO_DUMMY);
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pServe(String val) {
+  serveTarget=val;
+  e.setAudio(DIV_AUDIO_DUMMY);
+  // keep stdout clean for responses
+  changeLogOutput(stderr);
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pServeWorkers(String val) {
+  try {
+    int v=std::stoi(val);
+    if (v<0) {
+      logE("worker count shall be 0 or higher.");
+      return TA_PARAM_ERROR;
+    }
+    serveWorkers=v;
+  } catch (std::exception& e) {
+    logE("worker count shall be a number.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pOutput(String val) {
   outName=val;
   e.setAudio(DIV_AUDIO_DUMMY);
@@ -482,6 +583,9 @@ void initParams() {
   params.push_back(TAParam("h","help",false,pHelp,"","display this help"));
 
   params.push_back(TAParam("a","audio",true,pAudio,"jack|sdl|portaudio|pipe","set audio engine (SDL by default)"));
+  params.push_back(TAParam("","pipeformat",true,pPipeFormat,"s16|s24|f32","set sample format of pipe output (s16 by default)"));
+  params.push_back(TAParam("","pipeheader",true,pPipeHeader,"none|wav|au","write a header before pipe output (none by default)"));
+  params.push_back(TAParam("","pipepace",true,pPipePace,"fast|realtime","set pacing of pipe output (fast by default)"));
   params.push_back(TAParam("o","output",true,pOutput,"<filename>","output audio to file"));
   params.push_back(TAParam("O","vgmout",true,pVGMOut,"<filename>","output .vgm data"));
   params.push_back(TAParam("D","direct",false,pDirect,"","set VGM export direct stream mode"));
@@ -500,10 +604,15 @@ void initParams() {
   params.push_back(TAParam("l","loops",true,pLoops,"<count>","set number of loops"));
   params.push_back(TAParam("s","subsong",true,pSubSong,"<number>","set sub-song"));
   params.push_back(TAParam("o","outmode",true,pOutMode,"one|persys|perchan","set file output mode"));
+  params.push_back(TAParam("F","outformat",true,pOutFormat,"s16|f32|flac|opus","set audio output format"));
   params.push_back(TAParam("S","safemode",false,pSafeMode,"","enable safe mode (software rendering and no audio)"));
   params.push_back(TAParam("A","safeaudio",false,pSafeModeAudio,"","enable safe mode (with audio"));
 
-  params.push_back(TAParam("B","benchmark",true,pBenchmark,"render|seek","run performance test"));
+  params.push_back(TAParam("B","benchmark",true,pBenchmark,"render|seek|tiuna","run performance test (use -romconf to configure tiuna)"));
+  params.push_back(TAParam("Z","serve",true,pServe,"stdio|<socket path>","run as a headless render server, reading JSON requests line by line"));
+  params.push_back(TAParam("","serveworkers",true,pServeWorkers,"<count>","number of socket clients the render server handles at once (0 for one per CPU core; default is 0)"));
+  params.push_back(TAParam("P","csprofile",true,pCSProfile,"<player.bin>","profile the command stream on a 6502 player (needs player.sym; use -romconf to configure)"));
+  params.push_back(TAParam("","profile-startup",false,pProfileStartup,"","report how long each phase of startup takes"));
 
   params.push_back(TAParam("V","version",false,pVersion,"","view information about Furnace."));
   params.push_back(TAParam("W","warranty",false,pWarranty,"","view warranty disclaimer."));
@@ -542,6 +651,104 @@ static void handleTermGUI(int) {
 #endif
 #endif
 
+static bool readWholeFile(const String& path, std::vector<unsigned char>& out) {
+  FILE* f=ps_fopen(path.c_str(),"rb");
+  if (f==NULL) return false;
+  unsigned char buf[4096];
+  size_t got;
+  while ((got=fread(buf,1,4096,f))>0) {
+    out.insert(out.end(),buf,buf+got);
+  }
+  fclose(f);
+  return true;
+}
+
+// run the exported command stream on the 6502 player and print a cycle report
+static bool runCSProfile() {
+  std::vector<unsigned char> player;
+  std::vector<unsigned char> symbols;
+  String symName=csProfileName;
+  size_t dot=symName.rfind('.');
+  size_t slash=symName.find_last_of("/\\");
+  if (dot!=String::npos && (slash==String::npos || dot>slash)) {
+    symName=symName.substr(0,dot);
+  }
+  symName+=".sym";
+
+  if (!readWholeFile(csProfileName,player)) {
+    reportError(fmt::sprintf(_("could not open file! (%s)"),strerror(errno)));
+    return false;
+  }
+  if (!readWholeFile(symName,symbols)) {
+    reportError(fmt::sprintf(_("could not open symbol file %s! (%s)"),symName,strerror(errno)));
+    return false;
+  }
+
+  DivCSProfile prof;
+  if (!e.profileCommandStream(player.data(),player.size(),String((const char*)symbols.data(),symbols.size()),romExportConfig,prof)) {
+    reportError(fmt::sprintf(_("could not profile command stream! (%s)"),e.getLastError()));
+    return false;
+  }
+
+  size_t ticks=prof.tickCycles.size();
+  unsigned long long total=0;
+  unsigned int worst=0;
+  size_t worstTick=0;
+  size_t overBudget=0;
+  unsigned int histogram[10];
+  memset(histogram,0,10*sizeof(unsigned int));
+  for (size_t i=0; i<ticks; i++) {
+    unsigned int c=prof.tickCycles[i];
+    total+=c;
+    if (c>worst) {
+      worst=c;
+      worstTick=i;
+    }
+    if (c>prof.budget) {
+      overBudget++;
+      histogram[9]++;
+    } else if (prof.budget>0) {
+      histogram[MIN(8,(int)(((unsigned long long)c*9)/prof.budget))]++;
+    }
+  }
+
+  printf("command stream profile: %d ticks, budget %d cycles/tick\n",(int)ticks,prof.budget);
+  printf("init: %d cycles\n",prof.initCycles);
+  if (ticks==0) return true;
+  printf("average: %.1f cycles (%.1f%%)\n",(double)total/ticks,prof.budget?(100.0*total/ticks/prof.budget):0.0);
+  printf("worst: %d cycles (%.1f%%) at tick %d\n",worst,prof.budget?(100.0*worst/prof.budget):0.0,(int)worstTick);
+  printf("over budget: %d ticks\n",(int)overBudget);
+
+  std::vector<size_t> order(ticks);
+  for (size_t i=0; i<ticks; i++) order[i]=i;
+  size_t topCount=MIN((size_t)10,ticks);
+  std::partial_sort(order.begin(),order.begin()+topCount,order.end(),[&prof](size_t a, size_t b) {
+    if (prof.tickCycles[a]!=prof.tickCycles[b]) return prof.tickCycles[a]>prof.tickCycles[b];
+    return a<b;
+  });
+  printf("\nworst ticks:\n");
+  for (size_t i=0; i<topCount; i++) {
+    printf("  tick %8d: %d cycles\n",(int)order[i],prof.tickCycles[order[i]]);
+  }
+
+  printf("\nhistogram (fraction of budget):\n");
+  for (int i=0; i<10; i++) {
+    if (i==9) {
+      printf("       >100%%: %8d\n",histogram[i]);
+    } else {
+      printf("  %3d%%-%3d%%: %8d\n",(i*100)/9,((i+1)*100)/9,histogram[i]);
+    }
+  }
+
+  printf("\nper channel (average/max):\n");
+  for (size_t i=0; i<prof.chanTotal.size(); i++) {
+    printf("  %3d: %8.1f %8d\n",(int)i,(double)prof.chanTotal[i]/ticks,prof.chanMax[i]);
+  }
+  printf("loop overhead: %.1f cycles/tick\n",(double)prof.overhead/ticks);
+  printf("dispatch stubs: %.1f cycles/tick\n",(double)prof.stubTotal/ticks);
+  return true;
+}
+
 // TODO: CoInitializeEx on Windows?
 // TODO: add crash log
 int main(int argc, char** argv) {
@@ -588,9 +795,14 @@ int main(int argc, char** argv) {
   cmdOutName="";
   romOutName="";
   txtOutName="";
+  csProfileName="";
+  serveTarget="";
+  serveWorkers=0;
 
   // load config for locale
+  startupProfileBegin("config");
   e.prePreInit();
+  startupProfileEnd();
 
 #ifdef HAVE_LOCALE
   String reqLocale=e.getConfString("locale","");
@@ -756,6 +968,7 @@ int main(int argc, char** argv) {
   }
 
   const bool outputMode = outName!="" || vgmOutName!="" || cmdOutName!="" || romOutName!="" || txtOutName!="";
+  const bool serveMode = serveTarget!="";
 
   if (fileName.empty() && (benchMode || infoMode || outputMode)) {
     logE("provide a file!");
@@ -768,9 +981,10 @@ int main(int argc, char** argv) {
   }
 #endif
 
+  startupProfileBegin("engine pre-init");
 #ifdef HAVE_GUI
-  if (e.preInit(consoleMode || benchMode || infoMode || outputMode)) {
-    if (consoleMode || benchMode || infoMode || outputMode) {
+  if (e.preInit(consoleMode || benchMode || infoMode || outputMode || serveMode)) {
+    if (consoleMode || benchMode || infoMode || outputMode || serveMode) {
       logW("engine wants safe mode, but Furnace GUI is not going to start.");
     } else {
       safeMode=true;
@@ -781,8 +995,9 @@ int main(int argc, char** argv) {
     logW("engine wants safe mode, but Furnace GUI is not available.");
   }
 #endif
+  startupProfileEnd();
 
-  if (safeMode && (consoleMode || benchMode || infoMode || outputMode)) {
+  if (safeMode && (consoleMode || benchMode || infoMode || outputMode || serveMode)) {
     logE("you can't use safe mode and console/export mode together.");
     return 1;
   }
@@ -798,8 +1013,9 @@ int main(int argc, char** argv) {
   }
 #endif
 
-  if (!fileName.empty() && ((!e.getConfBool("tutIntroPlayed",TUT_INTRO_PLAYED)) || e.getConfInt("alwaysPlayIntro",0)!=3 || consoleMode || benchMode || infoMode || outputMode)) {
+  if (!fileName.empty() && ((!e.getConfBool("tutIntroPlayed",TUT_INTRO_PLAYED)) || e.getConfInt("alwaysPlayIntro",0)!=3 || consoleMode || benchMode || infoMode || outputMode || serveMode)) {
     logI("loading module...");
+    startupProfileBegin("load module");
     FILE* f=ps_fopen(fileName.c_str(),"rb");
     if (f==NULL) {
       reportError(fmt::sprintf(_("couldn't open file! (%s)"),strerror(errno)));
@@ -857,15 +1073,20 @@ int main(int argc, char** argv) {
       finishLogFile();
       return 1;
     }
+    startupProfileEnd();
   }
   if (infoMode) {
+    startupProfileFinish("song loaded");
     e.dumpSongInfo();
     finishLogFile();
     return 0;
   }
 
-  if (!e.init()) {
-    if (consoleMode) {
+  startupProfileBegin("engine init");
+  bool engineReady=e.init();
+  startupProfileEnd();
+  if (!engineReady) {
+    if (consoleMode || serveMode) {
       reportError(_("could not initialize engine!"));
       finishLogFile();
       return 1;
@@ -879,9 +1100,24 @@ int main(int argc, char** argv) {
     e.changeSongP(subsong);
   }
 
+  if (consoleMode || benchMode || outputMode || serveMode) {
+    startupProfileFinish("engine ready");
+  }
+
   if (benchMode) {
     logI("starting benchmark!");
-    if (benchMode==2) {
+    if (benchMode==4) {
+      if (!runCSProfile()) {
+        finishLogFile();
+        return 1;
+      }
+    } else if (benchMode==3) {
+      if (e.isROMExportViable(DIV_ROM_TIUNA)) {
+        e.benchmarkROMExport(DIV_ROM_TIUNA,romExportConfig);
+      } else {
+        reportError(_("TIunA export is not available for this song."));
+      }
+    } else if (benchMode==2) {
       e.benchmarkSeek();
     } else {
       e.benchmarkPlayback();
@@ -890,6 +1126,15 @@ int main(int argc, char** argv) {
     return 0;
   }
 
+  if (serveMode) {
+    FurnaceServer server;
+    server.bindEngine(&e);
+    bool serveSuccess=server.serve(serveTarget,serveWorkers);
+    e.quit();
+    finishLogFile();
+    return serveSuccess?0:1;
+  }
+
   if (outputMode) {
     if (cmdOutName!="") {
       SafeWriter* w=e.saveCommand(NULL);
@@ -925,8 +1170,11 @@ int main(int argc, char** argv) {
     }
     if (outName!="") {
       e.setConsoleMode(true);
-      e.saveAudio(outName.c_str(),exportOptions);
-      e.waitAudioFile();
+      if (e.saveAudio(outName.c_str(),exportOptions)) {
+        e.waitAudioFile();
+      } else {
+        reportError(fmt::sprintf(_("could not export audio! (%s)"),e.getLastError()));
+      }
     }
     if (romOutName!="") {
       e.setConsoleMode(true);
@@ -1053,7 +1301,10 @@ int main(int argc, char** argv) {
 #ifdef HAVE_GUI
   if (safeMode) g.enableSafeMode();
   g.bindEngine(&e);
-  if (!g.init()) {
+  startupProfileBegin("GUI init");
+  bool guiReady=g.init();
+  startupProfileEnd();
+  if (!guiReady) {
     reportError(g.getLastError());
     finishLogFile();
     e.everythingOK();
@@ -0,0 +1,81 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "startupProfile.h"
+#include "ta-log.h"
+#include <chrono>
+#include <vector>
+
+typedef std::chrono::high_resolution_clock StartupClock;
+
+struct StartupPhase {
+  const char* name;
+  int depth;
+  StartupClock::time_point start, end;
+  bool done;
+};
+
+static StartupClock::time_point startupBegin=StartupClock::now();
+static std::vector<StartupPhase> startupPhases;
+static std::vector<size_t> startupStack;
+static bool startupRecording=true;
+static bool startupReport=false;
+
+void startupProfileEnable() {
+  startupReport=true;
+}
+
+void startupProfileBegin(const char* phase) {
+  if (!startupRecording) return;
+  StartupPhase p;
+  p.name=phase;
+  p.depth=startupStack.size();
+  p.start=StartupClock::now();
+  p.end=p.start;
+  p.done=false;
+  startupStack.push_back(startupPhases.size());
+  startupPhases.push_back(p);
+}
+
+void startupProfileEnd() {
+  if (!startupRecording) return;
+  if (startupStack.empty()) return;
+  StartupPhase& p=startupPhases[startupStack.back()];
+  p.end=StartupClock::now();
+  p.done=true;
+  startupStack.pop_back();
+}
+
+void startupProfileFinish(const char* state) {
+  if (!startupRecording) return;
+  startupRecording=false;
+  StartupClock::time_point now=StartupClock::now();
+
+  if (startupReport) {
+    logI("startup profile:");
+    for (StartupPhase& i: startupPhases) {
+      if (!i.done) i.end=now;
+      logI("%s- %s: %dµs",std::string(i.depth*2,' '),i.name,(int)std::chrono::duration_cast<std::chrono::microseconds>(i.end-i.start).count());
+    }
+    logI("%s after %dµs",state,(int)std::chrono::duration_cast<std::chrono::microseconds>(now-startupBegin).count());
+  }
+
+  startupPhases.clear();
+  startupStack.clear();
+}
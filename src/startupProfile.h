@@ -0,0 +1,42 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2025 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _STARTUP_PROFILE_H
+#define _STARTUP_PROFILE_H
+
+// startup profiler.
+// phases are always recorded (it's only a few clock reads) until
+// startupProfileFinish() is called. they are only printed if enabled
+// (--profile-startup).
+
+void startupProfileEnable();
+void startupProfileBegin(const char* phase);
+void startupProfileEnd();
+void startupProfileFinish(const char* state);
+
+struct StartupProfileScope {
+  StartupProfileScope(const char* phase) {
+    startupProfileBegin(phase);
+  }
+  ~StartupProfileScope() {
+    startupProfileEnd();
+  }
+};
+
+#endif